@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//
+// Created by dingjing on 24-11-20.
+//
+#include "bench.h"
+
+/**
+ * 多线程读多写少负载: 全局锁 + CHashTable 与分片的 CConcurrentHashTable 对比
+ *
+ * 用法: bench-concurrent-hash-table [元素个数] [每线程操作次数]
+ * 覆盖: 1..N 线程；每 16 次操作中 1 次 replace，其余为命中查找
+ */
+
+#define BENCH_CHT_NODES         (1 << 16)
+#define BENCH_CHT_OPS           (1 << 20)
+
+typedef struct _BenchConcurrent BenchConcurrent;
+
+struct _BenchConcurrent
+{
+    CMutex                  lock;
+    CHashTable*             table;
+    CConcurrentHashTable*   ctable;
+    cint64                  nodes;
+};
+
+static inline cuint bench_key (const BenchConcurrent* bc, cint thread, cint64 i)
+{
+    return (cuint) (((cuint64) i * 7919 + (cuint64) thread * 104729) % (cuint64) bc->nodes) + 1;
+}
+
+static void bench_global_lock (cint thread, cint64 i, void* udata)
+{
+    BenchConcurrent* bc = (BenchConcurrent*) udata;
+    void* key = C_UINT_TO_POINTER (bench_key (bc, thread, i));
+
+    c_mutex_lock (&bc->lock);
+    if (0 == (i & 15)) {
+        c_hash_table_replace (bc->table, key, key);
+    }
+    else if (c_hash_table_lookup (bc->table, key) == NULL) {
+        fprintf (stderr, "bench: lookup failed\n");
+        exit (1);
+    }
+    c_mutex_unlock (&bc->lock);
+}
+
+static void bench_sharded (cint thread, cint64 i, void* udata)
+{
+    BenchConcurrent* bc = (BenchConcurrent*) udata;
+    void* key = C_UINT_TO_POINTER (bench_key (bc, thread, i));
+
+    if (0 == (i & 15)) {
+        c_concurrent_hash_table_replace (bc->ctable, key, key);
+    }
+    else if (c_concurrent_hash_table_lookup (bc->ctable, key) == NULL) {
+        fprintf (stderr, "bench: lookup failed\n");
+        exit (1);
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    cint64 k = 0;
+    char name[64];
+    const cint64 nodes = (argc > 1) ? atoll (argv[1]) : BENCH_CHT_NODES;
+    const cint64 ops = (argc > 2) ? atoll (argv[2]) : BENCH_CHT_OPS;
+    const cint maxThreads = bench_max_threads ();
+
+    bench_init ();
+
+    BenchConcurrent bc = { .nodes = nodes };
+    c_mutex_init (&bc.lock);
+    bc.table = c_hash_table_new_flat (c_direct_hash, c_direct_equal);
+    bc.ctable = c_concurrent_hash_table_new (c_direct_hash, c_direct_equal, 0);
+    for (k = 1; k <= nodes; ++k) {
+        c_hash_table_insert (bc.table, C_UINT_TO_POINTER ((cuint) k), C_UINT_TO_POINTER ((cuint) k));
+        c_concurrent_hash_table_insert (bc.ctable, C_UINT_TO_POINTER ((cuint) k), C_UINT_TO_POINTER ((cuint) k));
+    }
+
+    for (cint threads = 1; threads <= maxThreads; threads *= 2) {
+        BenchCase c = {
+            .bench = "concurrent-hash-table",
+            .name = name,
+            .threads = threads,
+            .msgSize = sizeof (void*),
+            .records = ops,
+            .func = bench_global_lock,
+            .udata = &bc,
+        };
+
+        snprintf (name, sizeof (name), "global-lock");
+        bench_run (&c);
+
+        c.func = bench_sharded;
+        snprintf (name, sizeof (name), "sharded");
+        bench_run (&c);
+    }
+
+    c_concurrent_hash_table_destroy (bc.ctable);
+    c_hash_table_unref (bc.table);
+    c_mutex_clear (&bc.lock);
+
+    return 0;
+}
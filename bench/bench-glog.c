@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//
+// Created by dingjing on 24-6-20.
+//
+#include "bench.h"
+
+#include "glib/glog.h"
+
+/**
+ * glib 日志桥接(c_glog_handler)吞吐与单次调用延迟
+ *
+ * 用法: bench-glog [每线程记录数] [最大线程数]
+ */
+
+#define BENCH_GLOG_DIR          "/tmp/clib-bench-glog"
+#define BENCH_GLOG_RECORDS      20000
+
+static const csize gsMsgSize[] = { 16, 128, 1024 };
+
+
+static void bench_glog (cint thread, cint64 i, void* udata)
+{
+    C_GLOG_INFO ("thread %d record %lld: %s", thread, (long long) i, (const char*) udata);
+}
+
+int main (int argc, char* argv[])
+{
+    cuint s = 0;
+    cint threads = 0;
+    const cint64 records = (argc > 1) ? atoll (argv[1]) : BENCH_GLOG_RECORDS;
+    const cint maxThreads = (argc > 2) ? atoi (argv[2]) : bench_max_threads ();
+
+    bench_init ();
+
+    // 日志处理函数只能设置一次，之后每个用例只重新初始化 c_log
+#ifdef GLIB_VERSION_2_50
+    g_log_set_writer_func (c_glog_handler, NULL, NULL);
+#else
+    g_log_set_handler (NULL, G_LOG_LEVEL_MASK, c_glog_handler, NULL);
+#endif
+
+    for (s = 0; s < C_N_ELEMENTS (gsMsgSize); ++s) {
+        char* msg = bench_message (gsMsgSize[s]);
+        for (threads = 1; threads <= maxThreads; threads *= 2) {
+            bench_clean_dir (BENCH_GLOG_DIR);
+            if (!c_log_init (C_LOG_LEVEL_INFO, 1ULL << 40, BENCH_GLOG_DIR, "bench", "log", false)) {
+                fprintf (stderr, "bench: log init failed\n");
+                return 1;
+            }
+
+            BenchCase bc = {
+                .bench = "glog",
+                .name = "file",
+                .threads = threads,
+                .msgSize = gsMsgSize[s],
+                .records = records,
+                .func = bench_glog,
+                .udata = msg,
+            };
+            bench_run (&bc);
+
+            c_log_destroy ();
+        }
+        free (msg);
+    }
+
+    bench_clean_dir (BENCH_GLOG_DIR);
+
+    return 0;
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//
+// Created by dingjing on 24-6-21.
+//
+#include "bench.h"
+
+/**
+ * CHashTable 插入与查找
+ *
+ * 用法: bench-hash-table [元素个数] [查找次数]
+ * 覆盖: 普通表/flat 表；int64 key 与 URL 形式的字符串 key；插入、命中查找、未命中查找；
+ *       渐进式扩容(+incr)对插入延迟(p999/max)的影响
+ */
+
+#define BENCH_HT_NODES          (1 << 20)
+#define BENCH_HT_LOOKUPS        (1 << 20)
+#define BENCH_HT_BATCH          16
+
+typedef struct _BenchHashTable  BenchHashTable;
+
+struct _BenchHashTable
+{
+    CHashTable*         table;
+    void**              keys;
+    void**              missKeys;
+    cint64              nodes;
+    bool                flat;
+    bool                str;
+    bool                incremental;
+};
+
+C_DEFINE_HASH_MAP (BenchMap, int_map, cint64, cint64, c_hash_map_int64_hash, c_hash_map_int64_equal)
+
+typedef struct _BenchIntMap     BenchIntMap;
+
+struct _BenchIntMap
+{
+    BenchMap            map;
+    cint64*             keys;
+    cint64*             missKeys;
+    cint64              nodes;
+};
+
+static cuint64 gsRand = 88172645463325252ULL;
+
+static cuint64 bench_rand (void)
+{
+    gsRand ^= gsRand << 13;
+    gsRand ^= gsRand >> 7;
+    gsRand ^= gsRand << 17;
+
+    return gsRand;
+}
+
+static void* bench_make_key (bool str, cint64 i, bool miss)
+{
+    if (str) {
+        return c_strdup_printf ("https://www.example.com/static/%s/%lld/index-%llu.html", miss ? "miss" : "hit", (long long) i, (unsigned long long) (bench_rand () % 100000));
+    }
+
+    cint64* key = c_malloc0 (sizeof (cint64));
+    *key = (cint64) (bench_rand () & ~1ULL) | (miss ? 1 : 0);
+
+    return key;
+}
+
+static void bench_insert (C_UNUSED cint thread, cint64 i, void* udata)
+{
+    BenchHashTable* bt = (BenchHashTable*) udata;
+
+    c_hash_table_insert (bt->table, bt->keys[i], bt->keys[i]);
+}
+
+static void bench_lookup_hit (C_UNUSED cint thread, cint64 i, void* udata)
+{
+    BenchHashTable* bt = (BenchHashTable*) udata;
+
+    if (c_hash_table_lookup (bt->table, bt->keys[(i * 7919) % bt->nodes]) == NULL) {
+        fprintf (stderr, "bench: lookup failed\n");
+        exit (1);
+    }
+}
+
+static void bench_lookup_miss (C_UNUSED cint thread, cint64 i, void* udata)
+{
+    BenchHashTable* bt = (BenchHashTable*) udata;
+
+    if (c_hash_table_lookup (bt->table, bt->missKeys[i % bt->nodes]) != NULL) {
+        fprintf (stderr, "bench: lookup failed\n");
+        exit (1);
+    }
+}
+
+/* 每条记录批量查找 BENCH_HT_BATCH 个键 */
+static void bench_lookup_many (C_UNUSED cint thread, cint64 i, void* udata)
+{
+    void* values[BENCH_HT_BATCH];
+    BenchHashTable* bt = (BenchHashTable*) udata;
+    void** keys = bt->keys + (i * BENCH_HT_BATCH * 7919) % (bt->nodes - BENCH_HT_BATCH + 1);
+
+    if (c_hash_table_lookup_many (bt->table, keys, BENCH_HT_BATCH, values) != BENCH_HT_BATCH) {
+        fprintf (stderr, "bench: lookup failed\n");
+        exit (1);
+    }
+}
+
+static void bench_map_insert (C_UNUSED cint thread, cint64 i, void* udata)
+{
+    BenchIntMap* bm = (BenchIntMap*) udata;
+
+    int_map_insert (&bm->map, bm->keys[i], bm->keys[i]);
+}
+
+static void bench_map_lookup_hit (C_UNUSED cint thread, cint64 i, void* udata)
+{
+    BenchIntMap* bm = (BenchIntMap*) udata;
+
+    if (int_map_lookup (&bm->map, bm->keys[(i * 7919) % bm->nodes]) == NULL) {
+        fprintf (stderr, "bench: lookup failed\n");
+        exit (1);
+    }
+}
+
+static void bench_map_lookup_miss (C_UNUSED cint thread, cint64 i, void* udata)
+{
+    BenchIntMap* bm = (BenchIntMap*) udata;
+
+    if (int_map_lookup (&bm->map, bm->missKeys[i % bm->nodes]) != NULL) {
+        fprintf (stderr, "bench: lookup failed\n");
+        exit (1);
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    cint i = 0;
+    cint64 k = 0;
+    char name[64];
+    const cint64 nodes = (argc > 1) ? atoll (argv[1]) : BENCH_HT_NODES;
+    const cint64 lookups = (argc > 2) ? atoll (argv[2]) : BENCH_HT_LOOKUPS;
+
+    bench_init ();
+
+    for (i = 0; i < 8; ++i) {
+        BenchHashTable bt = {
+            .nodes = nodes,
+            .flat = (i & 1),
+            .str = (i & 2),
+            .incremental = (i & 4),
+        };
+        const char* type = bt.incremental ? (bt.flat ? "flat+incr" : "classic+incr") : (bt.flat ? "flat" : "classic");
+        const char* keyType = bt.str ? "str" : "int64";
+
+        bt.keys = c_malloc0 (sizeof (void*) * (csize) nodes);
+        bt.missKeys = c_malloc0 (sizeof (void*) * (csize) nodes);
+        for (k = 0; k < nodes; ++k) {
+            bt.keys[k] = bench_make_key (bt.str, k, false);
+            bt.missKeys[k] = bench_make_key (bt.str, k, true);
+        }
+
+        if (bt.flat) {
+            bt.table = bt.str ? c_hash_table_new_flat (c_str_hash, c_str_equal) : c_hash_table_new_flat (c_int64_hash, c_int64_equal);
+        }
+        else {
+            bt.table = bt.str ? c_hash_table_new (c_str_hash, c_str_equal) : c_hash_table_new (c_int64_hash, c_int64_equal);
+        }
+        c_hash_table_set_incremental_resize (bt.table, bt.incremental);
+
+        BenchCase bc = {
+            .bench = "hash-table",
+            .name = name,
+            .threads = 1,
+            .msgSize = bt.str ? strlen ((const char*) bt.keys[0]) : sizeof (cint64),
+            .records = nodes,
+            .func = bench_insert,
+            .udata = &bt,
+        };
+
+        snprintf (name, sizeof (name), "%s/%s/insert", type, keyType);
+        bench_run (&bc);
+
+        bc.records = lookups;
+        bc.func = bench_lookup_hit;
+        snprintf (name, sizeof (name), "%s/%s/lookup-hit", type, keyType);
+        bench_run (&bc);
+
+        bc.func = bench_lookup_miss;
+        snprintf (name, sizeof (name), "%s/%s/lookup-miss", type, keyType);
+        bench_run (&bc);
+
+        if (nodes >= BENCH_HT_BATCH) {
+            bc.records = lookups / BENCH_HT_BATCH;
+            bc.func = bench_lookup_many;
+            snprintf (name, sizeof (name), "%s/%s/lookup-hit-x%d", type, keyType, BENCH_HT_BATCH);
+            bench_run (&bc);
+        }
+
+        c_hash_table_unref (bt.table);
+        for (k = 0; k < nodes; ++k) {
+            c_free (bt.keys[k]);
+            c_free (bt.missKeys[k]);
+        }
+        c_free (bt.keys);
+        c_free (bt.missKeys);
+    }
+
+    /* C_DEFINE_HASH_MAP 生成的 int64 表，与上面的 flat/int64 对比 */
+    BenchIntMap bm = { .nodes = nodes, };
+    int_map_init (&bm.map);
+    bm.keys = c_malloc0 (sizeof (cint64) * (csize) nodes);
+    bm.missKeys = c_malloc0 (sizeof (cint64) * (csize) nodes);
+    for (k = 0; k < nodes; ++k) {
+        bm.keys[k] = (cint64) (bench_rand () & ~1ULL);
+        bm.missKeys[k] = (cint64) (bench_rand () | 1ULL);
+    }
+
+    BenchCase bc = {
+        .bench = "hash-table",
+        .name = name,
+        .threads = 1,
+        .msgSize = sizeof (cint64),
+        .records = nodes,
+        .func = bench_map_insert,
+        .udata = &bm,
+    };
+
+    snprintf (name, sizeof (name), "map/int64/insert");
+    bench_run (&bc);
+
+    bc.records = lookups;
+    bc.func = bench_map_lookup_hit;
+    snprintf (name, sizeof (name), "map/int64/lookup-hit");
+    bench_run (&bc);
+
+    bc.func = bench_map_lookup_miss;
+    snprintf (name, sizeof (name), "map/int64/lookup-miss");
+    bench_run (&bc);
+
+    int_map_clear (&bm.map);
+    c_free (bm.keys);
+    c_free (bm.missKeys);
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//
+// Created by dingjing on 24-6-22.
+//
+#include "bench.h"
+
+#include <math.h>
+
+/**
+ * hash 函数吞吐与冲突率
+ *
+ * 用法: bench-hash [key 个数]
+ * 覆盖: URL/路径/短标识符字符串、连续与按页对齐的 int64、堆指针；
+ *       新实现(wyhash/mix64)与旧实现(djb2/低位异或/指针原值)对比
+ *
+ * 每条结果一行:
+ * {"bench":"hash","case":"wyhash/url","keys":...,"key_len":...,"ns_per_key":...,"collisions":...,"expected_collisions":...}
+ * collisions 为把 hash 低位作为下标放入 2^k(>= key 个数)个桶时落入已占用桶的 key 个数，
+ * expected_collisions 为完全随机的 hash 的期望值
+ */
+
+#define BENCH_HASH_KEYS         (1 << 20)
+#define BENCH_HASH_MIN_CALLS    (16 << 20)
+
+typedef cuint (*BenchHashFunc) (const void* key);
+
+typedef struct _BenchHash       BenchHash;
+typedef struct _BenchKeySet     BenchKeySet;
+
+struct _BenchHash
+{
+    const char*         name;
+    BenchHashFunc       func;
+};
+
+struct _BenchKeySet
+{
+    const char*         name;
+    void**              keys;
+    csize               keyLen;         // 平均长度
+    bool                str;
+};
+
+static cuint bench_djb2_hash (const void* v)
+{
+    const signed char* p;
+    cuint32 h = 5381;
+
+    for (p = v; *p != '\0'; p++) {
+        h = (h << 5) + h + *p;
+    }
+
+    return h;
+}
+
+static cuint bench_fold_hash (const void* v)
+{
+    const cuint64 bits = *(const cuint64*) v;
+
+    return (cuint) ((bits >> 32) ^ (bits & 0xffffffffU));
+}
+
+static cuint bench_identity_hash (const void* v)
+{
+    return C_POINTER_TO_UINT (v);
+}
+
+static const BenchHash gsStrHashes[] = {
+    { "djb2",       bench_djb2_hash },
+    { "wyhash",     c_str_hash },
+};
+
+static const BenchHash gsIntHashes[] = {
+    { "fold",       bench_fold_hash },
+    { "mix64",      c_int64_hash },
+};
+
+static const BenchHash gsPtrHashes[] = {
+    { "identity",   bench_identity_hash },
+    { "mix64",      c_direct_hash },
+};
+
+static void bench_hash_run (const BenchKeySet* ks, const BenchHash* hash, cint64 n)
+{
+    cint64 i = 0;
+    cint64 calls = 0;
+    cuint sink = 0;
+    cuint64 collisions = 0;
+    csize buckets = 1;
+
+    while (buckets < (csize) n) {
+        buckets <<= 1;
+    }
+
+    cuint8* used = c_malloc0 (buckets);
+    for (i = 0; i < n; ++i) {
+        const cuint h = hash->func (ks->keys[i]) & (cuint) (buckets - 1);
+        collisions += used[h];
+        used[h] = 1;
+    }
+    c_free (used);
+
+    const cint64 start = bench_now_ns ();
+    do {
+        for (i = 0; i < n; ++i) {
+            sink += hash->func (ks->keys[i]);
+        }
+        calls += n;
+    } while (calls < BENCH_HASH_MIN_CALLS);
+    const cint64 end = bench_now_ns ();
+
+    const double expected = (double) n - (double) buckets * (1.0 - pow (1.0 - 1.0 / (double) buckets, (double) n));
+
+    fprintf (gsBenchOut, "{\"bench\":\"hash\",\"case\":\"%s/%s\",\"keys\":%lld,\"key_len\":%zu,\"ns_per_key\":%.2f,"
+            "\"collisions\":%llu,\"expected_collisions\":%.0f,\"sink\":%u}\n",
+            hash->name, ks->name, (long long) n, ks->keyLen, (double) (end - start) / (double) calls,
+            (unsigned long long) collisions, expected, sink & 1);
+    fflush (gsBenchOut);
+}
+
+static void bench_key_set_free (BenchKeySet* ks, cint64 n, bool freeKeys)
+{
+    cint64 i = 0;
+
+    for (i = 0; freeKeys && i < n; ++i) {
+        c_free (ks->keys[i]);
+    }
+    c_free (ks->keys);
+}
+
+int main (int argc, char* argv[])
+{
+    cint s = 0;
+    cuint h = 0;
+    cint64 i = 0;
+    const cint64 n = (argc > 1) ? atoll (argv[1]) : BENCH_HASH_KEYS;
+
+    bench_init ();
+
+    // 字符串 key
+    static const char* strSets[] = { "url", "path", "ident" };
+    for (s = 0; s < (cint) C_N_ELEMENTS (strSets); ++s) {
+        csize total = 0;
+        BenchKeySet ks = { .name = strSets[s], .str = true };
+        ks.keys = c_malloc0 (sizeof (void*) * (csize) n);
+        for (i = 0; i < n; ++i) {
+            switch (s) {
+                case 0: {
+                    ks.keys[i] = c_strdup_printf ("https://www.example.com/api/v2/users/%lld/orders?page=%lld&lang=zh_CN", (long long) (i / 16), (long long) (i % 16));
+                    break;
+                }
+                case 1: {
+                    ks.keys[i] = c_strdup_printf ("/usr/share/icons/hicolor/%dx%d/apps/application-%lld.png", 16 << (i % 4), 16 << (i % 4), (long long) (i / 4));
+                    break;
+                }
+                default: {
+                    ks.keys[i] = c_strdup_printf ("key_%lld", (long long) i);
+                    break;
+                }
+            }
+            total += strlen (ks.keys[i]);
+        }
+        ks.keyLen = total / (csize) n;
+        for (h = 0; h < C_N_ELEMENTS (gsStrHashes); ++h) {
+            bench_hash_run (&ks, &gsStrHashes[h], n);
+        }
+        bench_key_set_free (&ks, n, true);
+    }
+
+    // 整数 key: 连续值与按 4096 对齐的值(低位全为 0)
+    static const char* intSets[] = { "int64-seq", "int64-page" };
+    for (s = 0; s < (cint) C_N_ELEMENTS (intSets); ++s) {
+        BenchKeySet ks = { .name = intSets[s], .keyLen = sizeof (cint64) };
+        cint64* values = c_malloc0 (sizeof (cint64) * (csize) n);
+        ks.keys = c_malloc0 (sizeof (void*) * (csize) n);
+        for (i = 0; i < n; ++i) {
+            values[i] = (0 == s) ? i : i * 4096;
+            ks.keys[i] = &values[i];
+        }
+        for (h = 0; h < C_N_ELEMENTS (gsIntHashes); ++h) {
+            bench_hash_run (&ks, &gsIntHashes[h], n);
+        }
+        bench_key_set_free (&ks, n, false);
+        c_free (values);
+    }
+
+    // 指针 key: 堆上分配的对象地址
+    {
+        BenchKeySet ks = { .name = "pointer", .keyLen = sizeof (void*) };
+        ks.keys = c_malloc0 (sizeof (void*) * (csize) n);
+        for (i = 0; i < n; ++i) {
+            ks.keys[i] = c_malloc0 (48);
+        }
+        for (h = 0; h < C_N_ELEMENTS (gsPtrHashes); ++h) {
+            bench_hash_run (&ks, &gsPtrHashes[h], n);
+        }
+        bench_key_set_free (&ks, n, true);
+    }
+
+    return 0;
+}
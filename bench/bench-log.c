@@ -0,0 +1,130 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//
+// Created by dingjing on 24-6-20.
+//
+#include "bench.h"
+
+/**
+ * c_log 吞吐与单次调用延迟
+ *
+ * 用法: bench-log [每线程记录数] [最大线程数]
+ * 覆盖: 同步/异步/线程缓冲/mmap 文件日志、跨越切分边界、控制台、c_log_raw；1..N 线程；16/128/1024 字节消息
+ */
+
+#define BENCH_LOG_DIR           "/tmp/clib-bench-log"
+#define BENCH_LOG_RECORDS       20000
+#define BENCH_LOG_ROTATE_SIZE   (4 << 20)
+#define BENCH_LOG_MMAP_SIZE     (64 << 20)
+
+typedef enum
+{
+    BENCH_LOG_FILE = 0,
+    BENCH_LOG_FILE_ASYNC,
+    BENCH_LOG_FILE_BUFFERED,
+    BENCH_LOG_FILE_ROTATE,
+    BENCH_LOG_FILE_MMAP,
+    BENCH_LOG_CONSOLE,
+    BENCH_LOG_RAW,
+} BenchLogMode;
+
+static const char* gsModeName[] = {
+    "file",
+    "file-async",
+    "file-buffered",
+    "file-rotate",
+    "file-mmap",
+    "console",
+    "raw",
+};
+
+static const csize gsMsgSize[] = { 16, 128, 1024 };
+
+
+static void bench_log_file (cint thread, cint64 i, void* udata)
+{
+    c_log_print (C_LOG_LEVEL_INFO, C_LOG_TAG, __FILE__, __LINE__, __func__, "thread %d record %lld: %s", thread, (long long) i, (const char*) udata);
+}
+
+static void bench_log_console (cint thread, cint64 i, void* udata)
+{
+    c_log_print_console (C_LOG_LEVEL_INFO, C_LOG_TAG, __FILE__, __LINE__, __func__, "thread %d record %lld: %s", thread, (long long) i, (const char*) udata);
+}
+
+static void bench_log_raw (cint thread, cint64 i, void* udata)
+{
+    c_log_raw (C_LOG_LEVEL_INFO, "thread %d record %lld: %s", thread, (long long) i, (const char*) udata);
+}
+
+static bool bench_log_init (BenchLogMode mode)
+{
+    bench_clean_dir (BENCH_LOG_DIR);
+
+    switch (mode) {
+        case BENCH_LOG_FILE_ASYNC: {
+            return c_log_init_async (C_LOG_LEVEL_INFO, 1ULL << 40, BENCH_LOG_DIR, "bench", "log", false, 0, C_LOG_ASYNC_BLOCK);
+        }
+        case BENCH_LOG_FILE_BUFFERED: {
+            return c_log_init_buffered (C_LOG_LEVEL_INFO, 1ULL << 40, BENCH_LOG_DIR, "bench", "log", false, 0);
+        }
+        case BENCH_LOG_FILE_ROTATE: {
+            c_log_set_rotate (C_LOG_ROTATE_NUMBERED, 2, false);
+            return c_log_init (C_LOG_LEVEL_INFO, BENCH_LOG_ROTATE_SIZE, BENCH_LOG_DIR, "bench", "log", false);
+        }
+        case BENCH_LOG_FILE_MMAP: {
+            // 段大小需要预先分配，不能像其它模式一样用一个不会写满的大小
+            c_log_set_rotate (C_LOG_ROTATE_NUMBERED, 2, false);
+            return c_log_init_mmap (C_LOG_LEVEL_INFO, BENCH_LOG_MMAP_SIZE, BENCH_LOG_DIR, "bench", "log", false);
+        }
+        default: {
+            return c_log_init (C_LOG_LEVEL_INFO, 1ULL << 40, BENCH_LOG_DIR, "bench", "log", false);
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    cuint m = 0;
+    cuint s = 0;
+    cint threads = 0;
+    const cint64 records = (argc > 1) ? atoll (argv[1]) : BENCH_LOG_RECORDS;
+    const cint maxThreads = (argc > 2) ? atoi (argv[2]) : bench_max_threads ();
+
+    bench_init ();
+
+    for (m = 0; m < C_N_ELEMENTS (gsModeName); ++m) {
+        for (s = 0; s < C_N_ELEMENTS (gsMsgSize); ++s) {
+            char* msg = bench_message (gsMsgSize[s]);
+            for (threads = 1; threads <= maxThreads; threads *= 2) {
+                if (!bench_log_init ((BenchLogMode) m)) {
+                    fprintf (stderr, "bench: log init failed\n");
+                    return 1;
+                }
+
+                BenchCase bc = {
+                    .bench = "log",
+                    .name = gsModeName[m],
+                    .threads = threads,
+                    .msgSize = gsMsgSize[s],
+                    .records = records,
+                    .func = (BENCH_LOG_CONSOLE == m) ? bench_log_console : ((BENCH_LOG_RAW == m) ? bench_log_raw : bench_log_file),
+                    .udata = msg,
+                };
+                bench_run (&bc);
+
+                c_log_destroy ();
+                c_log_set_rotate (C_LOG_ROTATE_NUMBERED, 5, false);
+            }
+            free (msg);
+        }
+    }
+
+    bench_clean_dir (BENCH_LOG_DIR);
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+//
+// Created by dingjing on 24-6-20.
+//
+#include "bench.h"
+
+#include "qt5/qlog.h"
+
+/**
+ * Qt 日志桥接(c_qlog_handler)吞吐与单次调用延迟
+ *
+ * 用法: bench-qlog [每线程记录数] [最大线程数]
+ */
+
+#define BENCH_QLOG_DIR          "/tmp/clib-bench-qlog"
+#define BENCH_QLOG_RECORDS      20000
+
+static const csize gsMsgSize[] = { 16, 128, 1024 };
+
+
+static void bench_qlog (cint thread, cint64 i, void* udata)
+{
+    qInfo ("thread %d record %lld: %s", thread, (long long) i, (const char*) udata);
+}
+
+int main (int argc, char* argv[])
+{
+    cuint s = 0;
+    cint threads = 0;
+    const cint64 records = (argc > 1) ? atoll (argv[1]) : BENCH_QLOG_RECORDS;
+    const cint maxThreads = (argc > 2) ? atoi (argv[2]) : bench_max_threads ();
+
+    bench_init ();
+    qInstallMessageHandler (c_qlog_handler);
+
+    for (s = 0; s < C_N_ELEMENTS (gsMsgSize); ++s) {
+        char* msg = bench_message (gsMsgSize[s]);
+        for (threads = 1; threads <= maxThreads; threads *= 2) {
+            bench_clean_dir (BENCH_QLOG_DIR);
+            if (!c_log_init (C_LOG_LEVEL_INFO, 1ULL << 40, BENCH_QLOG_DIR, "bench", "log", false)) {
+                fprintf (stderr, "bench: log init failed\n");
+                return 1;
+            }
+
+            BenchCase bc;
+            bc.bench = "qlog";
+            bc.name = "file";
+            bc.threads = threads;
+            bc.msgSize = gsMsgSize[s];
+            bc.records = records;
+            bc.func = bench_qlog;
+            bc.udata = msg;
+            bench_run (&bc);
+
+            c_log_destroy ();
+        }
+        free (msg);
+    }
+
+    bench_clean_dir (BENCH_QLOG_DIR);
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-6-20.
+//
+
+#ifndef CLIBRARY_BENCH_H
+#define CLIBRARY_BENCH_H
+#include <c/clib.h>
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+/**
+ * 基准测试公共部分: 多线程执行、逐次计时、统计分位数，结果以 JSON Lines 输出到标准输出
+ *
+ * 每条结果一行:
+ * {"bench":"log","case":"file","threads":4,"msg_size":128,"records":80000,"records_per_sec":...,"p50_ns":...,"p99_ns":...,"p999_ns":...,"max_ns":...}
+ */
+
+typedef void (*BenchFunc) (cint thread, cint64 i, void* udata);
+
+static FILE* gsBenchOut = NULL;                 // 测试结果输出，标准输出被重定向到 /dev/null
+
+typedef struct _BenchCase       BenchCase;
+typedef struct _BenchThread     BenchThread;
+
+struct _BenchCase
+{
+    const char*         bench;
+    const char*         name;
+    cint                threads;
+    csize               msgSize;
+    cint64              records;                // 每个线程执行次数
+    BenchFunc           func;
+    void*               udata;
+};
+
+struct _BenchThread
+{
+    cint                id;
+    const BenchCase*    bcase;
+    pthread_barrier_t*  barrier;
+    cint64*             lat;
+    cint64              start;
+    cint64              end;
+};
+
+/**
+ * @brief 保留原标准输出用于输出结果，之后写入 STDOUT_FILENO 的内容(如控制台日志)全部丢弃
+ */
+static inline void bench_init (void)
+{
+    const int out = dup (STDOUT_FILENO);
+    const int null = open ("/dev/null", O_WRONLY);
+
+    fflush (stdout);
+    gsBenchOut = (out >= 0) ? fdopen (out, "w") : NULL;
+    if (NULL == gsBenchOut || null < 0) {
+        fprintf (stderr, "bench: redirect stdout failed\n");
+        exit (1);
+    }
+    dup2 (null, STDOUT_FILENO);
+    close (null);
+}
+
+/**
+ * @brief 默认线程数上限
+ */
+static inline cint bench_max_threads (void)
+{
+    const long n = sysconf (_SC_NPROCESSORS_ONLN);
+
+    return (cint) C_MIN (C_MAX (n, 1), 8);
+}
+
+static inline cint64 bench_now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ((cint64) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static inline int bench_cmp_i64 (const void* a, const void* b)
+{
+    const cint64 x = *(const cint64*) a;
+    const cint64 y = *(const cint64*) b;
+
+    return (x > y) - (x < y);
+}
+
+static void* bench_thread (void* udata)
+{
+    cint64 i = 0;
+    BenchThread* th = (BenchThread*) udata;
+    const BenchCase* bc = th->bcase;
+
+    pthread_barrier_wait (th->barrier);
+    th->start = bench_now_ns ();
+    for (i = 0; i < bc->records; ++i) {
+        const cint64 t = bench_now_ns ();
+        bc->func (th->id, i, bc->udata);
+        th->lat[i] = bench_now_ns () - t;
+    }
+    th->end = bench_now_ns ();
+
+    return NULL;
+}
+
+/**
+ * @brief 执行一个测试用例并输出一行 JSON
+ *
+ * @note 单次耗时包含一次 clock_gettime 的开销(约 20ns)
+ */
+static inline void bench_run (const BenchCase* bc)
+{
+    cint i = 0;
+    cint64 start = 0;
+    cint64 end = 0;
+    const cint64 total = bc->records * bc->threads;
+    pthread_barrier_t barrier;
+    pthread_t* tids = (pthread_t*) calloc ((csize) bc->threads, sizeof (pthread_t));
+    BenchThread* ths = (BenchThread*) calloc ((csize) bc->threads, sizeof (BenchThread));
+    cint64* lat = (cint64*) malloc (sizeof (cint64) * (csize) total);
+
+    if (NULL == tids || NULL == ths || NULL == lat) {
+        fprintf (stderr, "bench: out of memory\n");
+        exit (1);
+    }
+
+    pthread_barrier_init (&barrier, NULL, (cuint) bc->threads);
+    for (i = 0; i < bc->threads; ++i) {
+        ths[i].id = i;
+        ths[i].bcase = bc;
+        ths[i].barrier = &barrier;
+        ths[i].lat = lat + bc->records * i;
+        pthread_create (&tids[i], NULL, bench_thread, &ths[i]);
+    }
+    for (i = 0; i < bc->threads; ++i) {
+        pthread_join (tids[i], NULL);
+        if (0 == i || ths[i].start < start) {
+            start = ths[i].start;
+        }
+        if (ths[i].end > end) {
+            end = ths[i].end;
+        }
+    }
+    pthread_barrier_destroy (&barrier);
+
+    qsort (lat, (csize) total, sizeof (cint64), bench_cmp_i64);
+
+    fprintf (gsBenchOut, "{\"bench\":\"%s\",\"case\":\"%s\",\"threads\":%d,\"msg_size\":%zu,\"records\":%lld,"
+            "\"records_per_sec\":%.0f,\"p50_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld,\"max_ns\":%lld}\n",
+            bc->bench, bc->name, bc->threads, bc->msgSize, (long long) total,
+            (double) total * 1e9 / (double) C_MAX (end - start, 1),
+            (long long) lat[total * 50 / 100], (long long) lat[total * 99 / 100],
+            (long long) lat[total * 999 / 1000], (long long) lat[total - 1]);
+    fflush (gsBenchOut);
+
+    free (lat);
+    free (ths);
+    free (tids);
+}
+
+/**
+ * @brief 构造指定长度的日志内容
+ */
+static inline char* bench_message (csize size)
+{
+    csize i = 0;
+    char* msg = (char*) malloc (size + 1);
+
+    for (i = 0; NULL != msg && i < size; ++i) {
+        msg[i] = (char) ('a' + i % 26);
+    }
+    if (NULL != msg) {
+        msg[size] = '\0';
+    }
+
+    return msg;
+}
+
+/**
+ * @brief 删除目录及其中的日志文件，不跟随符号链接
+ */
+static inline void bench_clean_dir (const char* dir)
+{
+    DIR* d = NULL;
+    struct stat st;
+    struct dirent* ent = NULL;
+    char path[512];
+
+    if (NULL == (d = opendir (dir))) {
+        if (ENOENT != errno) {
+            fprintf (stderr, "bench: clean '%s' failed: %s\n", dir, strerror (errno));
+        }
+        return;
+    }
+
+    while (NULL != (ent = readdir (d))) {
+        if (0 == strcmp (ent->d_name, ".") || 0 == strcmp (ent->d_name, "..")) {
+            continue;
+        }
+        snprintf (path, sizeof (path), "%s/%s", dir, ent->d_name);
+        if (0 == lstat (path, &st) && S_ISDIR (st.st_mode)) {
+            bench_clean_dir (path);
+        }
+        else if (0 != unlink (path) && ENOENT != errno) {
+            fprintf (stderr, "bench: remove '%s' failed: %s\n", path, strerror (errno));
+        }
+    }
+    closedir (d);
+
+    if (0 != rmdir (dir)) {
+        fprintf (stderr, "bench: clean '%s' failed: %s\n", dir, strerror (errno));
+    }
+}
+
+#endif // CLIBRARY_BENCH_H
@@ -15,6 +15,12 @@
 #include "bytes.h"
 #include "atomic.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 
 #define MIN_ARRAY_SIZE  16
 
@@ -28,6 +34,21 @@
 } C_STMT_END
 
 
+/**
+ * 按元素值查找/计数/删除的向量化实现: 元素宽度为 1、2、4、8 字节时每次比较一个向量寄存器宽的数据块，
+ * 匹配位图中每个匹配元素占 w 位；其它宽度或没有 SSE2 时逐个 memcmp
+ */
+#if defined(__AVX2__)
+#define ARRAY_SIMD_WIDTH            32
+typedef __m256i                     ArrayVec;
+#elif defined(__SSE2__)
+#define ARRAY_SIMD_WIDTH            16
+typedef __m128i                     ArrayVec;
+#endif
+
+#define ARRAY_SIMD_ELEMENT(w)       (1 == (w) || 2 == (w) || 4 == (w) || 8 == (w))
+
+
 typedef struct _CRealArray      CRealArray;
 typedef enum _ArrayFreeFlags    ArrayFreeFlags;
 typedef struct _CRealPtrArray   CRealPtrArray;
@@ -71,6 +92,10 @@ static void ptr_array_maybe_null_terminate (CRealPtrArray* rarray);
 static void c_ptr_array_maybe_expand (CRealPtrArray* array, cuint len);
 static void* ptr_array_remove_index (CPtrArray* array, cuint index, bool fast, bool freeElement);
 static CPtrArray* ptr_array_new (cuint reservedSize, CDestroyNotify elementFreeFunc, bool nullTerminated);
+static csize array_find_value (const cuint8* data, csize n, const void* value, csize w);
+static csize array_count_value (const cuint8* data, csize n, const void* value, csize w);
+static csize array_compact_value (cuint8* data, csize n, const void* value, csize w);
+static csize array_eytzinger_fill (const CRealArray* sorted, CRealArray* out, csize i, csize k);
 
 
 
@@ -391,44 +416,212 @@ void c_array_sort_with_data (CArray* farray, CCompareDataFunc compareFunc, void*
     }
 }
 
+void c_array_sort_unstable_with_data (CArray* farray, CCompareDataFunc compareFunc, void* udata)
+{
+    CRealArray* array = (CRealArray*) farray;
+
+    c_return_if_fail (array != NULL);
+
+    if (array->len > 0) {
+        c_qsort_unstable_with_data (array->data, array->len, array->eltSize, compareFunc, udata);
+    }
+}
+
+void c_array_sort_parallel_with_data (CArray* farray, CCompareDataFunc compareFunc, void* udata)
+{
+    CRealArray* array = (CRealArray*) farray;
+
+    c_return_if_fail (array != NULL);
+
+    if (array->len > 0) {
+        c_qsort_parallel_with_data (array->data, array->len, array->eltSize, compareFunc, udata);
+    }
+}
+
+void c_array_sort_by_key (CArray* farray, CSortKeyFunc keyFunc, void* udata)
+{
+    CRealArray* array = (CRealArray*) farray;
+
+    c_return_if_fail (array != NULL);
+
+    if (array->len > 0) {
+        c_radix_sort (array->data, array->len, array->eltSize, keyFunc, udata);
+    }
+}
+
 bool c_array_binary_search (CArray* array, const void* target, CCompareFunc compareFunc, cuint* outMatchIndex)
 {
-    bool result = false;
     CRealArray* _array = (CRealArray *) array;
-    cuint left, middle = 0, right;
-    cint val;
 
     c_return_val_if_fail (_array != NULL, false);
     c_return_val_if_fail (compareFunc != NULL, false);
 
-    if (C_LIKELY(_array->len)) {
-        left = 0;
-        right = _array->len - 1;
-        while (left <= right) {
-            middle = left + (right - left) / 2;
-            val = compareFunc (_array->data + (_array->eltSize * middle), (void*) target);
-            if (val == 0) {
-                result = true;
-                break;
-            }
-            else if (val < 0) {
-                left = middle + 1;
-            }
-            else if (middle > 0) {
-                right = middle - 1;
-            }
-            else {
-                break;  /* element not found */
+    if (C_UNLIKELY (0 == _array->len)) {
+        return false;
+    }
+
+    // 无分支的 lower bound: 用比较结果计算区间起点的偏移，循环次数只取决于元素个数
+    const csize eltSize = _array->eltSize;
+    const cuint8* base = _array->data;
+    cuint n = _array->len;
+    while (n > 1) {
+        const cuint half = n / 2;
+        // 没有分支预测去提前加载，预取下一轮两个可能的中点
+        __builtin_prefetch (base + eltSize * (half / 2));
+        __builtin_prefetch (base + eltSize * (half + half / 2));
+        base += (csize) (compareFunc ((void*) (base + eltSize * half), (void*) target) < 0) * half * eltSize;
+        n -= half;
+    }
+
+    cint cmp = compareFunc ((void*) base, (void*) target);
+    if (cmp < 0) {
+        base += eltSize;
+        if (base >= _array->data + eltSize * _array->len) {
+            return false;
+        }
+        cmp = compareFunc ((void*) base, (void*) target);
+    }
+
+    if (0 != cmp) {
+        return false;
+    }
+
+    const cuint index = (cuint) ((csize) (base - _array->data) / eltSize);
+    if (outMatchIndex != NULL) {
+        *outMatchIndex = index;
+    }
+
+    return true;
+}
+
+bool c_array_find (CArray* farray, const void* value, cuint* index)
+{
+    CRealArray* array = (CRealArray*) farray;
+
+    c_return_val_if_fail (array != NULL, false);
+    c_return_val_if_fail (value != NULL, false);
+
+    const csize i = array_find_value (array->data, array->len, value, array->eltSize);
+    if (i >= array->len) {
+        return false;
+    }
+
+    if (index != NULL) {
+        *index = (cuint) i;
+    }
+
+    return true;
+}
+
+cuint c_array_count (CArray* farray, const void* value)
+{
+    CRealArray* array = (CRealArray*) farray;
+
+    c_return_val_if_fail (array != NULL, 0);
+    c_return_val_if_fail (value != NULL, 0);
+
+    return (cuint) array_count_value (array->data, array->len, value, array->eltSize);
+}
+
+cuint c_array_remove_if (CArray* farray, CPredicateFunc func, void* udata)
+{
+    cuint i, j = 0;
+    CRealArray* array = (CRealArray*) farray;
+
+    c_return_val_if_fail (array != NULL, 0);
+    c_return_val_if_fail (func != NULL, 0);
+
+    for (i = 0; i < array->len; ++i) {
+        cuint8* elt = c_array_elt_pos (array, i);
+        if (func (elt, udata)) {
+            if (array->clearFunc != NULL) {
+                array->clearFunc (elt);
             }
+            continue;
         }
+        if (j != i) {
+            memcpy (c_array_elt_pos (array, j), elt, array->eltSize);
+        }
+        j++;
     }
 
-    if (result && outMatchIndex != NULL) {
-        *outMatchIndex = middle;
+    const cuint removed = array->len - j;
+    array->len = j;
+    c_array_zero_terminate (array);
+
+    return removed;
+}
+
+CArray* c_array_new_eytzinger (CArray* sorted)
+{
+    CRealArray* array = (CRealArray*) sorted;
+
+    c_return_val_if_fail (array != NULL, NULL);
+
+    CRealArray* out = (CRealArray*) c_array_sized_new (false, false, array->eltSize, array->len);
+    if (array->len > 0) {
+        c_array_set_size ((CArray*) out, array->len);
+        array_eytzinger_fill (array, out, 0, 0);
     }
 
-    return result;
+    return (CArray*) out;
+}
+
+bool c_array_eytzinger_search (CArray* eytzinger, const void* target, CCompareFunc compareFunc, cuint* outMatchIndex)
+{
+    CRealArray* array = (CRealArray*) eytzinger;
+
+    c_return_val_if_fail (array != NULL, false);
+    c_return_val_if_fail (target != NULL, false);
+    c_return_val_if_fail (compareFunc != NULL || sizeof (cuint32) == array->eltSize || sizeof (cuint64) == array->eltSize, false);
+
+    csize k = 1;
+    const csize n = array->len;
+    const csize w = array->eltSize;
+    const cuint8* base = array->data;
+
+    // 节点 k(从 1 开始)的子节点是 2k 和 2k+1；预取 4 层以后的后代所在的缓存行
+    if (NULL == compareFunc && sizeof (cuint32) == w) {
+        cuint32 x;
+        const cuint32* a = (const cuint32*) base;
+        memcpy (&x, target, sizeof (x));
+        while (k <= n) {
+            __builtin_prefetch ((const void*) ((cuintptr) a + (16 * k - 1) * sizeof (cuint32)));
+            k = 2 * k + (a[k - 1] < x);
+        }
+    }
+    else if (NULL == compareFunc) {
+        cuint64 x;
+        const cuint64* a = (const cuint64*) base;
+        memcpy (&x, target, sizeof (x));
+        while (k <= n) {
+            __builtin_prefetch ((const void*) ((cuintptr) a + (8 * k - 1) * sizeof (cuint64)));
+            k = 2 * k + (a[k - 1] < x);
+        }
+    }
+    else {
+        while (k <= n) {
+            __builtin_prefetch ((const void*) ((cuintptr) base + (16 * k - 1) * w));
+            k = 2 * k + (compareFunc ((void*) (base + (k - 1) * w), (void*) target) < 0);
+        }
+    }
 
+    // 去掉最后向右走的几步和一次向左，得到第一个不小于 target 的节点
+    k >>= __builtin_ffsll ((long long) ~k);
+    if (0 == k) {
+        return false;
+    }
+
+    const cuint8* elt = base + (k - 1) * w;
+    if ((NULL != compareFunc) ? (0 != compareFunc ((void*) elt, (void*) target)) : (0 != memcmp (elt, target, w))) {
+        return false;
+    }
+
+    if (outMatchIndex != NULL) {
+        *outMatchIndex = (cuint) (k - 1);
+    }
+
+    return true;
 }
 
 void c_array_set_clear_func (CArray* array, CDestroyNotify clearFunc)
@@ -612,13 +805,10 @@ bool c_ptr_array_remove (CPtrArray* array, void* data)
     c_return_val_if_fail (array, false);
     c_return_val_if_fail (array->len == 0 || (array->len != 0 && array->pdata != NULL), false);
 
-    CRealPtrArray* ptrArray = (CRealPtrArray*) array;
-
-    for (i = 0; i < array->len; i += 1) {
-        if (ptrArray->pdata[i] == data) {
-            c_ptr_array_remove_index (array, i);
-            return true;
-        }
+    i = (cuint) array_find_value ((const cuint8*) array->pdata, array->len, &data, sizeof (void*));
+    if (i < array->len) {
+        c_ptr_array_remove_index (array, i);
+        return true;
     }
 
     return false;
@@ -632,16 +822,69 @@ bool c_ptr_array_remove_fast (CPtrArray* array, void* data)
     c_return_val_if_fail (rarray, false);
     c_return_val_if_fail (rarray->len == 0 || (rarray->len != 0 && rarray->pdata != NULL), false);
 
-    for (i = 0; i < rarray->len; i += 1) {
-        if (rarray->pdata[i] == data) {
-            c_ptr_array_remove_index_fast (array, i);
-            return true;
-        }
+    i = (cuint) array_find_value ((const cuint8*) rarray->pdata, rarray->len, &data, sizeof (void*));
+    if (i < rarray->len) {
+        c_ptr_array_remove_index_fast (array, i);
+        return true;
     }
 
     return false;
 }
 
+cuint c_ptr_array_remove_all (CPtrArray* array, void* data)
+{
+    cuint i;
+    CRealPtrArray* rarray = (CRealPtrArray*) array;
+
+    c_return_val_if_fail (rarray, 0);
+    c_return_val_if_fail (rarray->len == 0 || (rarray->len != 0 && rarray->pdata != NULL), 0);
+
+    const cuint len = (cuint) array_compact_value ((cuint8*) rarray->pdata, rarray->len, &data, sizeof (void*));
+    const cuint removed = rarray->len - len;
+    if (rarray->elementFreeFunc != NULL) {
+        for (i = 0; i < removed; ++i) {
+            rarray->elementFreeFunc (data);
+        }
+    }
+    rarray->len = len;
+    ptr_array_maybe_null_terminate (rarray);
+
+    return removed;
+}
+
+cuint c_ptr_array_remove_if (CPtrArray* array, CPredicateFunc func, void* udata)
+{
+    cuint i, j = 0;
+    CRealPtrArray* rarray = (CRealPtrArray*) array;
+
+    c_return_val_if_fail (rarray, 0);
+    c_return_val_if_fail (func != NULL, 0);
+
+    for (i = 0; i < rarray->len; ++i) {
+        void* data = rarray->pdata[i];
+        const bool remove = func (data, udata);
+        // 无分支压缩: 总是写入，只有保留时才前进
+        rarray->pdata[j] = data;
+        j += !remove;
+        if (remove && rarray->elementFreeFunc != NULL) {
+            rarray->elementFreeFunc (data);
+        }
+    }
+
+    const cuint removed = rarray->len - j;
+    rarray->len = j;
+    ptr_array_maybe_null_terminate (rarray);
+
+    return removed;
+}
+
+cuint c_ptr_array_count (CPtrArray* array, const void* data)
+{
+    c_return_val_if_fail (array != NULL, 0);
+
+    return (cuint) array_count_value ((const cuint8*) array->pdata, array->len, &data, sizeof (void*));
+}
+
 CPtrArray* c_ptr_array_remove_range (CPtrArray* array, cuint index, cuint length)
 {
     CRealPtrArray* rarray = (CRealPtrArray*) array;
@@ -771,6 +1014,33 @@ void c_ptr_array_sort_with_data (CPtrArray* array, CCompareDataFunc compareFunc,
     }
 }
 
+void c_ptr_array_sort_unstable_with_data (CPtrArray* array, CCompareDataFunc compareFunc, void* udata)
+{
+    c_return_if_fail (array != NULL);
+
+    if (array->len > 0) {
+        c_qsort_unstable_with_data (array->pdata, array->len, sizeof (void*), compareFunc, udata);
+    }
+}
+
+void c_ptr_array_sort_parallel_with_data (CPtrArray* array, CCompareDataFunc compareFunc, void* udata)
+{
+    c_return_if_fail (array != NULL);
+
+    if (array->len > 0) {
+        c_qsort_parallel_with_data (array->pdata, array->len, sizeof (void*), compareFunc, udata);
+    }
+}
+
+void c_ptr_array_sort_by_key (CPtrArray* array, CSortKeyFunc keyFunc, void* udata)
+{
+    c_return_if_fail (array != NULL);
+
+    if (array->len > 0) {
+        c_radix_sort (array->pdata, array->len, sizeof (void*), keyFunc, udata);
+    }
+}
+
 void c_ptr_array_foreach (CPtrArray* array, CFunc func, void* udata)
 {
     c_return_if_fail (array);
@@ -791,8 +1061,15 @@ bool c_ptr_array_find_with_equal_func (CPtrArray* haystack, const void* needle,
     c_return_val_if_fail (haystack != NULL, false);
 
     cuint i;
-    if (equalFunc == NULL) {
-        equalFunc = c_direct_equal;
+    if (equalFunc == NULL || equalFunc == c_direct_equal) {
+        i = (cuint) array_find_value ((const cuint8*) haystack->pdata, haystack->len, &needle, sizeof (void*));
+        if (i >= haystack->len) {
+            return false;
+        }
+        if (index != NULL) {
+            *index = i;
+        }
+        return true;
     }
 
     for (i = 0; i < haystack->len; i++) {
@@ -1114,3 +1391,292 @@ static void* ptr_array_remove_index (CPtrArray* array, cuint index, bool fast, b
 
     return result;
 }
+
+#if defined(ARRAY_SIMD_WIDTH)
+static inline ArrayVec array_simd_splat (const void* value, csize w)
+{
+    switch (w) {
+        case sizeof (cuint8): {
+            cuint8 v;
+            memcpy (&v, value, sizeof (v));
+#if defined(__AVX2__)
+            return _mm256_set1_epi8 ((char) v);
+#else
+            return _mm_set1_epi8 ((char) v);
+#endif
+        }
+        case sizeof (cuint16): {
+            cuint16 v;
+            memcpy (&v, value, sizeof (v));
+#if defined(__AVX2__)
+            return _mm256_set1_epi16 ((short) v);
+#else
+            return _mm_set1_epi16 ((short) v);
+#endif
+        }
+        case sizeof (cuint32): {
+            cuint32 v;
+            memcpy (&v, value, sizeof (v));
+#if defined(__AVX2__)
+            return _mm256_set1_epi32 ((int) v);
+#else
+            return _mm_set1_epi32 ((int) v);
+#endif
+        }
+        default: {
+            cuint64 v;
+            memcpy (&v, value, sizeof (v));
+#if defined(__AVX2__)
+            return _mm256_set1_epi64x ((long long) v);
+#else
+            return _mm_set1_epi64x ((long long) v);
+#endif
+        }
+    }
+}
+
+/**
+ * @brief 比较一个向量宽度的数据块，匹配的元素所在通道为全 1
+ */
+static inline ArrayVec array_simd_eq (const cuint8* p, ArrayVec needle, csize w)
+{
+#if defined(__AVX2__)
+    const __m256i v = _mm256_loadu_si256 ((const __m256i*) p);
+    switch (w) {
+        case sizeof (cuint8):       return _mm256_cmpeq_epi8 (v, needle);
+        case sizeof (cuint16):      return _mm256_cmpeq_epi16 (v, needle);
+        case sizeof (cuint32):      return _mm256_cmpeq_epi32 (v, needle);
+        default:                    return _mm256_cmpeq_epi64 (v, needle);
+    }
+#else
+    const __m128i v = _mm_loadu_si128 ((const __m128i*) p);
+    switch (w) {
+        case sizeof (cuint8):       return _mm_cmpeq_epi8 (v, needle);
+        case sizeof (cuint16):      return _mm_cmpeq_epi16 (v, needle);
+        case sizeof (cuint32):      return _mm_cmpeq_epi32 (v, needle);
+        default: {
+            // SSE2 没有 64 位比较: 两个 32 位半部分都相等
+            const __m128i eq = _mm_cmpeq_epi32 (v, needle);
+            return _mm_and_si128 (eq, _mm_shuffle_epi32 (eq, _MM_SHUFFLE (2, 3, 0, 1)));
+        }
+    }
+#endif
+}
+
+/**
+ * @brief 字节位图，每个匹配的元素占 w 位
+ */
+static inline cuint array_simd_mask (ArrayVec eq)
+{
+#if defined(__AVX2__)
+    return (cuint) _mm256_movemask_epi8 (eq);
+#else
+    return (cuint) _mm_movemask_epi8 (eq);
+#endif
+}
+
+static inline ArrayVec array_simd_or (ArrayVec a, ArrayVec b)
+{
+#if defined(__AVX2__)
+    return _mm256_or_si256 (a, b);
+#else
+    return _mm_or_si128 (a, b);
+#endif
+}
+
+/**
+ * @brief 每个通道减去比较结果(-1)，即匹配计数加 1
+ */
+static inline ArrayVec array_simd_acc (ArrayVec acc, ArrayVec eq, csize w)
+{
+#if defined(__AVX2__)
+    switch (w) {
+        case sizeof (cuint8):       return _mm256_sub_epi8 (acc, eq);
+        case sizeof (cuint16):      return _mm256_sub_epi16 (acc, eq);
+        case sizeof (cuint32):      return _mm256_sub_epi32 (acc, eq);
+        default:                    return _mm256_sub_epi64 (acc, eq);
+    }
+#else
+    switch (w) {
+        case sizeof (cuint8):       return _mm_sub_epi8 (acc, eq);
+        case sizeof (cuint16):      return _mm_sub_epi16 (acc, eq);
+        case sizeof (cuint32):      return _mm_sub_epi32 (acc, eq);
+        default:                    return _mm_sub_epi64 (acc, eq);
+    }
+#endif
+}
+
+static inline csize array_simd_sum (ArrayVec acc, csize w)
+{
+    csize i;
+    csize sum = 0;
+    union { ArrayVec v; cuint8 u8[ARRAY_SIMD_WIDTH]; cuint16 u16[ARRAY_SIMD_WIDTH / 2]; cuint32 u32[ARRAY_SIMD_WIDTH / 4]; cuint64 u64[ARRAY_SIMD_WIDTH / 8]; } lanes;
+
+    lanes.v = acc;
+    for (i = 0; i < ARRAY_SIMD_WIDTH / w; ++i) {
+        switch (w) {
+            case sizeof (cuint8):   sum += lanes.u8[i];     break;
+            case sizeof (cuint16):  sum += lanes.u16[i];    break;
+            case sizeof (cuint32):  sum += lanes.u32[i];    break;
+            default:                sum += lanes.u64[i];    break;
+        }
+    }
+
+    return sum;
+}
+#endif
+
+static inline csize array_find_value_w (const cuint8* data, csize n, const void* value, csize w)
+{
+    csize i = 0;
+
+#if defined(ARRAY_SIMD_WIDTH)
+    if (ARRAY_SIMD_ELEMENT (w)) {
+        const csize step = ARRAY_SIMD_WIDTH / w;
+        const ArrayVec needle = array_simd_splat (value, w);
+        // 一次检查 4 个数据块，只有合并后有匹配时才逐块定位
+        for (; i + 4 * step <= n; i += 4 * step) {
+            const cuint8* p = data + i * w;
+            const ArrayVec eq0 = array_simd_eq (p, needle, w);
+            const ArrayVec eq1 = array_simd_eq (p + ARRAY_SIMD_WIDTH, needle, w);
+            const ArrayVec eq2 = array_simd_eq (p + 2 * ARRAY_SIMD_WIDTH, needle, w);
+            const ArrayVec eq3 = array_simd_eq (p + 3 * ARRAY_SIMD_WIDTH, needle, w);
+            if (C_UNLIKELY (array_simd_mask (array_simd_or (array_simd_or (eq0, eq1), array_simd_or (eq2, eq3))))) {
+                break;
+            }
+        }
+        for (; i + step <= n; i += step) {
+            const cuint mask = array_simd_mask (array_simd_eq (data + i * w, needle, w));
+            if (mask) {
+                return i + (csize) __builtin_ctz (mask) / w;
+            }
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        if (0 == memcmp (data + i * w, value, w)) {
+            return i;
+        }
+    }
+
+    return n;
+}
+
+static inline csize array_count_value_w (const cuint8* data, csize n, const void* value, csize w)
+{
+    csize i = 0;
+    csize count = 0;
+
+#if defined(ARRAY_SIMD_WIDTH)
+    if (ARRAY_SIMD_ELEMENT (w)) {
+        const csize step = ARRAY_SIMD_WIDTH / w;
+        // 8 位、16 位计数通道在溢出之前累加到 count
+        const csize flush = (sizeof (cuint8) == w) ? 255 : 65535;
+        const ArrayVec needle = array_simd_splat (value, w);
+        while (i + step <= n) {
+            csize b;
+            ArrayVec acc;
+            memset (&acc, 0, sizeof (acc));
+            for (b = 0; b < flush && i + step <= n; ++b, i += step) {
+                acc = array_simd_acc (acc, array_simd_eq (data + i * w, needle, w), w);
+            }
+            count += array_simd_sum (acc, w);
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        count += (0 == memcmp (data + i * w, value, w));
+    }
+
+    return count;
+}
+
+/* 删除所有等于 value 的元素，保持顺序，返回剩余元素个数 */
+static inline csize array_compact_value_w (cuint8* data, csize n, const void* value, csize w)
+{
+    csize i = 0;
+    csize j = 0;
+
+#if defined(ARRAY_SIMD_WIDTH)
+    if (ARRAY_SIMD_ELEMENT (w)) {
+        csize k;
+        const csize step = ARRAY_SIMD_WIDTH / w;
+        const ArrayVec needle = array_simd_splat (value, w);
+        for (; i + step <= n; i += step) {
+            const cuint mask = array_simd_mask (array_simd_eq (data + i * w, needle, w));
+            if (0 == mask) {
+                // 整块都保留
+                if (j != i) {
+                    memmove (data + j * w, data + i * w, ARRAY_SIMD_WIDTH);
+                }
+                j += step;
+                continue;
+            }
+            for (k = 0; k < step; ++k) {
+                if (0 == ((mask >> (k * w)) & 1)) {
+                    if (j != i + k) {
+                        memcpy (data + j * w, data + (i + k) * w, w);
+                    }
+                    j++;
+                }
+            }
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        if (0 != memcmp (data + i * w, value, w)) {
+            if (j != i) {
+                memcpy (data + j * w, data + i * w, w);
+            }
+            j++;
+        }
+    }
+
+    return j;
+}
+
+static csize array_find_value (const cuint8* data, csize n, const void* value, csize w)
+{
+    switch (w) {
+        case sizeof (cuint8):       return array_find_value_w (data, n, value, sizeof (cuint8));
+        case sizeof (cuint16):      return array_find_value_w (data, n, value, sizeof (cuint16));
+        case sizeof (cuint32):      return array_find_value_w (data, n, value, sizeof (cuint32));
+        case sizeof (cuint64):      return array_find_value_w (data, n, value, sizeof (cuint64));
+        default:                    return array_find_value_w (data, n, value, w);
+    }
+}
+
+static csize array_count_value (const cuint8* data, csize n, const void* value, csize w)
+{
+    switch (w) {
+        case sizeof (cuint8):       return array_count_value_w (data, n, value, sizeof (cuint8));
+        case sizeof (cuint16):      return array_count_value_w (data, n, value, sizeof (cuint16));
+        case sizeof (cuint32):      return array_count_value_w (data, n, value, sizeof (cuint32));
+        case sizeof (cuint64):      return array_count_value_w (data, n, value, sizeof (cuint64));
+        default:                    return array_count_value_w (data, n, value, w);
+    }
+}
+
+static csize array_compact_value (cuint8* data, csize n, const void* value, csize w)
+{
+    switch (w) {
+        case sizeof (cuint32):      return array_compact_value_w (data, n, value, sizeof (cuint32));
+        case sizeof (cuint64):      return array_compact_value_w (data, n, value, sizeof (cuint64));
+        default:                    return array_compact_value_w (data, n, value, w);
+    }
+}
+
+/* 中序遍历 Eytzinger 树(节点 k 的子节点为 2k+1、2k+2)，依次填入有序数组的元素 */
+static csize array_eytzinger_fill (const CRealArray* sorted, CRealArray* out, csize i, csize k)
+{
+    if (k < sorted->len) {
+        i = array_eytzinger_fill (sorted, out, i, 2 * k + 1);
+        memcpy (c_array_elt_pos (out, k), c_array_elt_pos (sorted, i), sorted->eltSize);
+        i = array_eytzinger_fill (sorted, out, i + 1, 2 * k + 2);
+    }
+
+    return i;
+}
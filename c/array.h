@@ -70,7 +70,15 @@ CArray* c_array_remove_index_fast   (CArray* array, cuint index);
 CArray* c_array_remove_range        (CArray* array, cuint index, cuint length);
 void    c_array_sort                (CArray* array, CCompareFunc compareFunc);
 void    c_array_sort_with_data      (CArray* array, CCompareDataFunc compareFunc, void* udata);
+void    c_array_sort_unstable_with_data (CArray* array, CCompareDataFunc compareFunc, void* udata);
+void    c_array_sort_parallel_with_data (CArray* array, CCompareDataFunc compareFunc, void* udata);
+void    c_array_sort_by_key         (CArray* array, CSortKeyFunc keyFunc, void* udata);
 bool    c_array_binary_search       (CArray* array, const void* target, CCompareFunc compareFunc, cuint* outMatchIndex);
+bool    c_array_find                (CArray* array, const void* value, cuint* index);
+cuint   c_array_count               (CArray* array, const void* value);
+cuint   c_array_remove_if           (CArray* array, CPredicateFunc func, void* udata);
+CArray* c_array_new_eytzinger       (CArray* sorted);
+bool    c_array_eytzinger_search    (CArray* eytzinger, const void* target, CCompareFunc compareFunc, cuint* outMatchIndex);
 void    c_array_set_clear_func      (CArray* array, CDestroyNotify clearFunc);
 
 CPtrArray*  c_ptr_array_new                 (void);
@@ -91,6 +99,8 @@ void*       c_ptr_array_steal_index         (CPtrArray* array, cuint index);
 void*       c_ptr_array_steal_index_fast    (CPtrArray* array, cuint index);
 bool        c_ptr_array_remove              (CPtrArray* array, void* data);
 bool        c_ptr_array_remove_fast         (CPtrArray* array, void* data);
+cuint       c_ptr_array_remove_all          (CPtrArray* array, void* data);
+cuint       c_ptr_array_remove_if           (CPtrArray* array, CPredicateFunc func, void* udata);
 CPtrArray*  c_ptr_array_remove_range        (CPtrArray* array, cuint index, cuint length);
 void        c_ptr_array_add                 (CPtrArray* array, void* data);
 void        c_ptr_array_extend              (CPtrArray* arrayToExtend, CPtrArray* array, CCopyFunc func, void* udata);
@@ -98,9 +108,13 @@ void        c_ptr_array_extend_and_steal    (CPtrArray* arrayToExtend, CPtrArray
 void        c_ptr_array_insert              (CPtrArray* array, cuint index, void* data);
 void        c_ptr_array_sort                (CPtrArray* array, CCompareFunc compareFunc);
 void        c_ptr_array_sort_with_data      (CPtrArray* array, CCompareDataFunc compareFunc, void* udata);
+void        c_ptr_array_sort_unstable_with_data (CPtrArray* array, CCompareDataFunc compareFunc, void* udata);
+void        c_ptr_array_sort_parallel_with_data (CPtrArray* array, CCompareDataFunc compareFunc, void* udata);
+void        c_ptr_array_sort_by_key         (CPtrArray* array, CSortKeyFunc keyFunc, void* udata);
 void        c_ptr_array_foreach             (CPtrArray* array, CFunc func, void* udata);
 bool        c_ptr_array_find                (CPtrArray* haystack, const void* needle, cuint* index);
 bool        c_ptr_array_find_with_equal_func(CPtrArray* haystack, const void* needle, CEqualFunc equalFunc, cuint* index);
+cuint       c_ptr_array_count               (CPtrArray* array, const void* data);
 bool        c_ptr_array_is_null_terminated  (CPtrArray* array);
 
 CByteArray* c_byte_array_new                (void);
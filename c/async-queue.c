@@ -0,0 +1,569 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-12-1.
+//
+
+#include "async-queue.h"
+
+#include "deque.h"
+#include "utils.h"
+#include "atomic.h"
+#include "thread.h"
+#include "futex-priv.h"
+
+#define ASYNC_QUEUE_RING_SIZE       1024
+#define QUEUE_MIN_CAPACITY          2
+
+typedef struct _AsyncEvent          AsyncEvent;
+typedef struct _MpmcCell            MpmcCell;
+
+/**
+ * @brief 休眠/唤醒事件
+ * @note 等待者先增加 waiters 并记下 seq，再重试一次操作，失败后在 seq 上 futex 休眠；
+ *       通知者完成操作后只有在 waiters 不为 0 时才修改 seq 并唤醒，没有等待者时不进入内核
+ */
+struct _AsyncEvent
+{
+    cuint               seq;
+    cuint               waiters;
+};
+
+struct _MpmcCell
+{
+    cuint64             seq;                                            // seq == pos 可写，seq == pos + 1 可读
+    void*               data;
+};
+
+struct _CMpmcQueue
+{
+    MpmcCell*           cells;
+    cuint64             mask;
+    cuint64             pushPos __attribute__((aligned(64)));
+    cuint64             popPos __attribute__((aligned(64)));
+    AsyncEvent          notEmpty __attribute__((aligned(64)));
+    AsyncEvent          notFull __attribute__((aligned(64)));
+};
+
+struct _CSpscRing
+{
+    void**              data;
+    cuint64             mask;
+    cuint64             pushPos __attribute__((aligned(64)));           // 仅生产者修改
+    cuint64             popCache;                                       // 生产者看到的 popPos
+    cuint64             popPos __attribute__((aligned(64)));            // 仅消费者修改
+    cuint64             pushCache;                                      // 消费者看到的 pushPos
+    AsyncEvent          notEmpty __attribute__((aligned(64)));
+    AsyncEvent          notFull __attribute__((aligned(64)));
+};
+
+struct _CAsyncQueue
+{
+    CMpmcQueue*         ring;                                           // 快速路径
+    CMutex              mutex;
+    CCond               cond;
+    CDeque              overflow;                                       // ring 满时的元素，mutex 保护
+    cuint               noverflow;                                      // overflow 中的元素个数
+    cuint               waiters;                                        // 在 cond 上等待的线程个数
+    CDestroyNotify      itemFreeFunc;
+    catomicrefcount     refCount;
+};
+
+
+static cuint async_event_prepare (AsyncEvent* ev)
+{
+    __atomic_add_fetch (&ev->waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+    return __atomic_load_n (&ev->seq, __ATOMIC_SEQ_CST);
+}
+
+static void async_event_cancel (AsyncEvent* ev)
+{
+    __atomic_sub_fetch (&ev->waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+static void async_event_wait (AsyncEvent* ev, cuint key)
+{
+    c_futex_simple (&ev->seq, (csize) FUTEX_WAIT_PRIVATE, (csize) key, NULL);
+    __atomic_sub_fetch (&ev->waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline void async_event_notify (AsyncEvent* ev)
+{
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    if (C_UNLIKELY (0 != __atomic_load_n (&ev->waiters, __ATOMIC_RELAXED))) {
+        __atomic_add_fetch (&ev->seq, 1, __ATOMIC_SEQ_CST);
+        c_futex_simple (&ev->seq, (csize) FUTEX_WAKE_PRIVATE, (csize) 1, NULL);
+    }
+}
+
+static cuint64 queue_capacity (cuint capacity)
+{
+    return c_nearest_pow (C_MAX (capacity, QUEUE_MIN_CAPACITY));
+}
+
+static bool mpmc_try_push (CMpmcQueue* queue, void* data)
+{
+    MpmcCell* cell = NULL;
+    cuint64 pos = __atomic_load_n (&queue->pushPos, __ATOMIC_RELAXED);
+
+    while (true) {
+        cell = &queue->cells[pos & queue->mask];
+        const cint64 diff = (cint64) (__atomic_load_n (&cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if (0 == diff) {
+            if (__atomic_compare_exchange_n (&queue->pushPos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = __atomic_load_n (&queue->pushPos, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->data = data;
+    __atomic_store_n (&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static bool mpmc_try_pop (CMpmcQueue* queue, void** data)
+{
+    MpmcCell* cell = NULL;
+    cuint64 pos = __atomic_load_n (&queue->popPos, __ATOMIC_RELAXED);
+
+    while (true) {
+        cell = &queue->cells[pos & queue->mask];
+        const cint64 diff = (cint64) (__atomic_load_n (&cell->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (0 == diff) {
+            if (__atomic_compare_exchange_n (&queue->popPos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = __atomic_load_n (&queue->popPos, __ATOMIC_RELAXED);
+        }
+    }
+
+    *data = cell->data;
+    __atomic_store_n (&cell->seq, pos + queue->mask + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static cuint queue_length (const cuint64* pushPos, const cuint64* popPos, cuint64 capacity)
+{
+    const cuint64 pop = __atomic_load_n (popPos, __ATOMIC_ACQUIRE);
+    const cuint64 push = __atomic_load_n (pushPos, __ATOMIC_ACQUIRE);
+
+    if (push <= pop) {
+        return 0;
+    }
+
+    return (cuint) C_MIN (push - pop, capacity);
+}
+
+CMpmcQueue* c_mpmc_queue_new (cuint capacity)
+{
+    cuint64 i;
+    const cuint64 size = queue_capacity (capacity);
+
+    CMpmcQueue* queue = c_malloc0 (sizeof (CMpmcQueue));
+    queue->cells = c_malloc0 (size * sizeof (MpmcCell));
+    queue->mask = size - 1;
+    for (i = 0; i < size; ++i) {
+        queue->cells[i].seq = i;
+    }
+
+    return queue;
+}
+
+void c_mpmc_queue_free (CMpmcQueue* queue)
+{
+    c_return_if_fail (NULL != queue);
+
+    c_free (queue->cells);
+    c_free (queue);
+}
+
+cuint c_mpmc_queue_get_capacity (CMpmcQueue* queue)
+{
+    c_return_val_if_fail (NULL != queue, 0);
+
+    return (cuint) (queue->mask + 1);
+}
+
+cuint c_mpmc_queue_get_length (CMpmcQueue* queue)
+{
+    c_return_val_if_fail (NULL != queue, 0);
+
+    return queue_length (&queue->pushPos, &queue->popPos, queue->mask + 1);
+}
+
+bool c_mpmc_queue_try_push (CMpmcQueue* queue, void* data)
+{
+    c_return_val_if_fail (NULL != queue, false);
+
+    if (!mpmc_try_push (queue, data)) {
+        return false;
+    }
+    async_event_notify (&queue->notEmpty);
+
+    return true;
+}
+
+bool c_mpmc_queue_try_pop (CMpmcQueue* queue, void** data)
+{
+    c_return_val_if_fail (NULL != queue && NULL != data, false);
+
+    if (!mpmc_try_pop (queue, data)) {
+        return false;
+    }
+    async_event_notify (&queue->notFull);
+
+    return true;
+}
+
+void c_mpmc_queue_push (CMpmcQueue* queue, void* data)
+{
+    c_return_if_fail (NULL != queue);
+
+    while (!mpmc_try_push (queue, data)) {
+        const cuint key = async_event_prepare (&queue->notFull);
+        if (mpmc_try_push (queue, data)) {
+            async_event_cancel (&queue->notFull);
+            break;
+        }
+        async_event_wait (&queue->notFull, key);
+    }
+    async_event_notify (&queue->notEmpty);
+}
+
+void* c_mpmc_queue_pop (CMpmcQueue* queue)
+{
+    void* data = NULL;
+
+    c_return_val_if_fail (NULL != queue, NULL);
+
+    while (!mpmc_try_pop (queue, &data)) {
+        const cuint key = async_event_prepare (&queue->notEmpty);
+        if (mpmc_try_pop (queue, &data)) {
+            async_event_cancel (&queue->notEmpty);
+            break;
+        }
+        async_event_wait (&queue->notEmpty, key);
+    }
+    async_event_notify (&queue->notFull);
+
+    return data;
+}
+
+static bool spsc_try_push (CSpscRing* ring, void* data)
+{
+    const cuint64 pos = ring->pushPos;
+
+    if (C_UNLIKELY (pos - ring->popCache > ring->mask)) {
+        ring->popCache = __atomic_load_n (&ring->popPos, __ATOMIC_ACQUIRE);
+        if (pos - ring->popCache > ring->mask) {
+            return false;
+        }
+    }
+
+    ring->data[pos & ring->mask] = data;
+    __atomic_store_n (&ring->pushPos, pos + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static bool spsc_try_pop (CSpscRing* ring, void** data)
+{
+    const cuint64 pos = ring->popPos;
+
+    if (C_UNLIKELY (pos == ring->pushCache)) {
+        ring->pushCache = __atomic_load_n (&ring->pushPos, __ATOMIC_ACQUIRE);
+        if (pos == ring->pushCache) {
+            return false;
+        }
+    }
+
+    *data = ring->data[pos & ring->mask];
+    __atomic_store_n (&ring->popPos, pos + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+CSpscRing* c_spsc_ring_new (cuint capacity)
+{
+    const cuint64 size = queue_capacity (capacity);
+
+    CSpscRing* ring = c_malloc0 (sizeof (CSpscRing));
+    ring->data = c_malloc0 (size * sizeof (void*));
+    ring->mask = size - 1;
+
+    return ring;
+}
+
+void c_spsc_ring_free (CSpscRing* ring)
+{
+    c_return_if_fail (NULL != ring);
+
+    c_free (ring->data);
+    c_free (ring);
+}
+
+cuint c_spsc_ring_get_capacity (CSpscRing* ring)
+{
+    c_return_val_if_fail (NULL != ring, 0);
+
+    return (cuint) (ring->mask + 1);
+}
+
+cuint c_spsc_ring_get_length (CSpscRing* ring)
+{
+    c_return_val_if_fail (NULL != ring, 0);
+
+    return queue_length (&ring->pushPos, &ring->popPos, ring->mask + 1);
+}
+
+bool c_spsc_ring_try_push (CSpscRing* ring, void* data)
+{
+    c_return_val_if_fail (NULL != ring, false);
+
+    if (!spsc_try_push (ring, data)) {
+        return false;
+    }
+    async_event_notify (&ring->notEmpty);
+
+    return true;
+}
+
+bool c_spsc_ring_try_pop (CSpscRing* ring, void** data)
+{
+    c_return_val_if_fail (NULL != ring && NULL != data, false);
+
+    if (!spsc_try_pop (ring, data)) {
+        return false;
+    }
+    async_event_notify (&ring->notFull);
+
+    return true;
+}
+
+void c_spsc_ring_push (CSpscRing* ring, void* data)
+{
+    c_return_if_fail (NULL != ring);
+
+    while (!spsc_try_push (ring, data)) {
+        const cuint key = async_event_prepare (&ring->notFull);
+        if (spsc_try_push (ring, data)) {
+            async_event_cancel (&ring->notFull);
+            break;
+        }
+        async_event_wait (&ring->notFull, key);
+    }
+    async_event_notify (&ring->notEmpty);
+}
+
+void* c_spsc_ring_pop (CSpscRing* ring)
+{
+    void* data = NULL;
+
+    c_return_val_if_fail (NULL != ring, NULL);
+
+    while (!spsc_try_pop (ring, &data)) {
+        const cuint key = async_event_prepare (&ring->notEmpty);
+        if (spsc_try_pop (ring, &data)) {
+            async_event_cancel (&ring->notEmpty);
+            break;
+        }
+        async_event_wait (&ring->notEmpty, key);
+    }
+    async_event_notify (&ring->notFull);
+
+    return data;
+}
+
+/* 调用者持有 mutex: 先取 ring，ring 为空时再取溢出队列 */
+static void* async_queue_pop_locked (CAsyncQueue* queue)
+{
+    void* data = NULL;
+
+    if (mpmc_try_pop (queue->ring, &data)) {
+        return data;
+    }
+
+    if (queue->overflow.length > 0) {
+        data = c_deque_pop_head (&queue->overflow);
+        __atomic_sub_fetch (&queue->noverflow, 1, __ATOMIC_RELEASE);
+    }
+
+    return data;
+}
+
+CAsyncQueue* c_async_queue_new (void)
+{
+    return c_async_queue_new_full (NULL);
+}
+
+CAsyncQueue* c_async_queue_new_full (CDestroyNotify itemFreeFunc)
+{
+    CAsyncQueue* queue = c_malloc0 (sizeof (CAsyncQueue));
+
+    queue->ring = c_mpmc_queue_new (ASYNC_QUEUE_RING_SIZE);
+    c_mutex_init (&queue->mutex);
+    c_cond_init (&queue->cond);
+    c_deque_init (&queue->overflow);
+    queue->itemFreeFunc = itemFreeFunc;
+    c_atomic_ref_count_init (&queue->refCount);
+
+    return queue;
+}
+
+CAsyncQueue* c_async_queue_ref (CAsyncQueue* queue)
+{
+    c_return_val_if_fail (NULL != queue, NULL);
+
+    c_atomic_ref_count_inc (&queue->refCount);
+
+    return queue;
+}
+
+void c_async_queue_unref (CAsyncQueue* queue)
+{
+    void* data = NULL;
+
+    c_return_if_fail (NULL != queue);
+
+    if (!c_atomic_ref_count_dec (&queue->refCount)) {
+        return;
+    }
+
+    while (mpmc_try_pop (queue->ring, &data)) {
+        if (queue->itemFreeFunc) {
+            queue->itemFreeFunc (data);
+        }
+    }
+    c_deque_clear_full (&queue->overflow, queue->itemFreeFunc);
+    c_mpmc_queue_free (queue->ring);
+    c_mutex_clear (&queue->mutex);
+    c_cond_clear (&queue->cond);
+    c_free (queue);
+}
+
+void c_async_queue_push (CAsyncQueue* queue, void* data)
+{
+    c_return_if_fail (NULL != queue);
+    c_return_if_fail (NULL != data);
+
+    // 溢出队列不为空时必须排在溢出队列后面，保证同一生产者的元素按顺序取出
+    if (C_LIKELY (0 == __atomic_load_n (&queue->noverflow, __ATOMIC_ACQUIRE)) && mpmc_try_push (queue->ring, data)) {
+        __atomic_thread_fence (__ATOMIC_SEQ_CST);
+        if (C_UNLIKELY (0 != __atomic_load_n (&queue->waiters, __ATOMIC_RELAXED))) {
+            c_mutex_lock (&queue->mutex);
+            c_cond_signal (&queue->cond);
+            c_mutex_unlock (&queue->mutex);
+        }
+        return;
+    }
+
+    c_mutex_lock (&queue->mutex);
+    if (0 != queue->noverflow || !mpmc_try_push (queue->ring, data)) {
+        c_deque_push_tail (&queue->overflow, data);
+        __atomic_add_fetch (&queue->noverflow, 1, __ATOMIC_RELEASE);
+    }
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    if (0 != __atomic_load_n (&queue->waiters, __ATOMIC_RELAXED)) {
+        c_cond_signal (&queue->cond);
+    }
+    c_mutex_unlock (&queue->mutex);
+}
+
+void* c_async_queue_try_pop (CAsyncQueue* queue)
+{
+    void* data = NULL;
+
+    c_return_val_if_fail (NULL != queue, NULL);
+
+    if (mpmc_try_pop (queue->ring, &data)) {
+        return data;
+    }
+
+    if (0 == __atomic_load_n (&queue->noverflow, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    c_mutex_lock (&queue->mutex);
+    data = async_queue_pop_locked (queue);
+    c_mutex_unlock (&queue->mutex);
+
+    return data;
+}
+
+void* c_async_queue_pop (CAsyncQueue* queue)
+{
+    void* data = NULL;
+
+    c_return_val_if_fail (NULL != queue, NULL);
+
+    if (mpmc_try_pop (queue->ring, &data)) {
+        return data;
+    }
+
+    c_mutex_lock (&queue->mutex);
+    __atomic_add_fetch (&queue->waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    while (NULL == (data = async_queue_pop_locked (queue))) {
+        c_cond_wait (&queue->cond, &queue->mutex);
+    }
+    __atomic_sub_fetch (&queue->waiters, 1, __ATOMIC_SEQ_CST);
+    c_mutex_unlock (&queue->mutex);
+
+    return data;
+}
+
+void* c_async_queue_timeout_pop (CAsyncQueue* queue, cuint64 timeout)
+{
+    void* data = NULL;
+
+    c_return_val_if_fail (NULL != queue, NULL);
+
+    if (mpmc_try_pop (queue->ring, &data)) {
+        return data;
+    }
+
+    const cint64 endTime = c_get_monotonic_time () + (cint64) timeout;
+
+    c_mutex_lock (&queue->mutex);
+    __atomic_add_fetch (&queue->waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+    while (NULL == (data = async_queue_pop_locked (queue))) {
+        if (!c_cond_wait_until (&queue->cond, &queue->mutex, endTime)) {
+            data = async_queue_pop_locked (queue);
+            break;
+        }
+    }
+    __atomic_sub_fetch (&queue->waiters, 1, __ATOMIC_SEQ_CST);
+    c_mutex_unlock (&queue->mutex);
+
+    return data;
+}
+
+cuint c_async_queue_length (CAsyncQueue* queue)
+{
+    c_return_val_if_fail (NULL != queue, 0);
+
+    return c_mpmc_queue_get_length (queue->ring) + __atomic_load_n (&queue->noverflow, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,206 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-12-1.
+//
+
+#ifndef CLIBRARY_ASYNC_QUEUE_H
+#define CLIBRARY_ASYNC_QUEUE_H
+
+#if !defined (__CLIB_H_INSIDE__) && !defined (CLIB_COMPILATION)
+#error "Only <clib.h> can be included directly."
+#endif
+
+#include <c/macros.h>
+
+C_BEGIN_EXTERN_C
+
+/**
+ * @brief 有界多生产者多消费者队列(Vyukov 数组队列)
+ * @note 容量向上取整为 2 的幂；try_push/try_pop 无锁，队列满/空时立即返回；
+ *       push/pop 在满/空时通过 futex 休眠，不自旋
+ */
+typedef struct _CMpmcQueue          CMpmcQueue;
+
+/**
+ * @brief 有界单生产者单消费者环形队列
+ * @note 同一时刻只能有一个线程 push、一个线程 pop；try_push/try_pop 无等待
+ */
+typedef struct _CSpscRing           CSpscRing;
+
+/**
+ * @brief 线程间传递数据的无界队列
+ * @note 元素先进入内部的 CMpmcQueue，快速路径不加锁；内部队列满时进入加锁的溢出队列。
+ *       元素不能是 NULL(NULL 表示没有取到元素)
+ */
+typedef struct _CAsyncQueue         CAsyncQueue;
+
+
+/**
+ * @brief 创建容量至少为 capacity 的 MPMC 队列
+ * @param capacity
+ */
+CMpmcQueue*     c_mpmc_queue_new            (cuint capacity);
+
+/**
+ * @brief 释放队列，不处理队列中剩余的元素
+ * @param queue
+ */
+void            c_mpmc_queue_free           (CMpmcQueue* queue);
+
+/**
+ * @brief 队列容量
+ * @param queue
+ */
+cuint           c_mpmc_queue_get_capacity   (CMpmcQueue* queue);
+
+/**
+ * @brief 队列中的元素个数，有并发修改时是近似值
+ * @param queue
+ */
+cuint           c_mpmc_queue_get_length     (CMpmcQueue* queue);
+
+/**
+ * @brief 插入元素，队列满时返回 false
+ * @param queue
+ * @param data
+ */
+bool            c_mpmc_queue_try_push       (CMpmcQueue* queue, void* data);
+
+/**
+ * @brief 取出元素，队列空时返回 false
+ * @param queue
+ * @param data 保存取出的元素
+ */
+bool            c_mpmc_queue_try_pop        (CMpmcQueue* queue, void** data);
+
+/**
+ * @brief 插入元素，队列满时休眠直到有空位
+ * @param queue
+ * @param data
+ */
+void            c_mpmc_queue_push           (CMpmcQueue* queue, void* data);
+
+/**
+ * @brief 取出元素，队列空时休眠直到有元素
+ * @param queue
+ */
+void*           c_mpmc_queue_pop            (CMpmcQueue* queue);
+
+/**
+ * @brief 创建容量至少为 capacity 的 SPSC 队列
+ * @param capacity
+ */
+CSpscRing*      c_spsc_ring_new             (cuint capacity);
+
+/**
+ * @brief 释放队列，不处理队列中剩余的元素
+ * @param ring
+ */
+void            c_spsc_ring_free            (CSpscRing* ring);
+
+/**
+ * @brief 队列容量
+ * @param ring
+ */
+cuint           c_spsc_ring_get_capacity    (CSpscRing* ring);
+
+/**
+ * @brief 队列中的元素个数，有并发修改时是近似值
+ * @param ring
+ */
+cuint           c_spsc_ring_get_length      (CSpscRing* ring);
+
+/**
+ * @brief 插入元素，队列满时返回 false，只能在生产者线程调用
+ * @param ring
+ * @param data
+ */
+bool            c_spsc_ring_try_push        (CSpscRing* ring, void* data);
+
+/**
+ * @brief 取出元素，队列空时返回 false，只能在消费者线程调用
+ * @param ring
+ * @param data 保存取出的元素
+ */
+bool            c_spsc_ring_try_pop         (CSpscRing* ring, void** data);
+
+/**
+ * @brief 插入元素，队列满时休眠直到有空位
+ * @param ring
+ * @param data
+ */
+void            c_spsc_ring_push            (CSpscRing* ring, void* data);
+
+/**
+ * @brief 取出元素，队列空时休眠直到有元素
+ * @param ring
+ */
+void*           c_spsc_ring_pop             (CSpscRing* ring);
+
+/**
+ * @brief 创建 CAsyncQueue
+ */
+CAsyncQueue*    c_async_queue_new           (void);
+
+/**
+ * @brief 创建 CAsyncQueue，释放队列时对剩余元素调用 itemFreeFunc
+ * @param itemFreeFunc
+ */
+CAsyncQueue*    c_async_queue_new_full      (CDestroyNotify itemFreeFunc);
+
+/**
+ * @brief 增加引用计数
+ * @param queue
+ */
+CAsyncQueue*    c_async_queue_ref           (CAsyncQueue* queue);
+
+/**
+ * @brief 减少引用计数，为 0 时释放队列
+ * @param queue
+ */
+void            c_async_queue_unref         (CAsyncQueue* queue);
+
+/**
+ * @brief 插入元素，唤醒一个等待的线程
+ * @param queue
+ * @param data 不能是 NULL
+ */
+void            c_async_queue_push          (CAsyncQueue* queue, void* data);
+
+/**
+ * @brief 取出元素，队列空时阻塞直到有元素
+ * @param queue
+ */
+void*           c_async_queue_pop           (CAsyncQueue* queue);
+
+/**
+ * @brief 取出元素，队列空时返回 NULL
+ * @param queue
+ */
+void*           c_async_queue_try_pop       (CAsyncQueue* queue);
+
+/**
+ * @brief 取出元素，队列空时最多等待 timeout 微秒
+ * @param queue
+ * @param timeout 微秒
+ * @return 超时返回 NULL
+ */
+void*           c_async_queue_timeout_pop   (CAsyncQueue* queue, cuint64 timeout);
+
+/**
+ * @brief 队列中的元素个数，有并发修改时是近似值
+ * @param queue
+ */
+cuint           c_async_queue_length        (CAsyncQueue* queue);
+
+C_END_EXTERN_C
+
+#endif //CLIBRARY_ASYNC_QUEUE_H
@@ -0,0 +1,830 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-28.
+//
+
+#include "btree.h"
+
+#include "atomic.h"
+
+#define BTREE_ORDER                 32                      // 节点最多的元素数/子节点数
+#define BTREE_MIN_FILL              (BTREE_ORDER / 2)       // 非根节点最少的元素数/子节点数
+
+typedef struct _BTreeNode           BTreeNode;
+typedef struct _RealIter            RealIter;
+
+/**
+ * @brief 叶子: keys/values 保存 n 个元素，prev/next 按顺序串联所有叶子；
+ *        内部节点: children 保存 n 个子节点，keys[i] 是 children[i + 1] 子树中最小的 key(指向叶子中的 key)
+ * @note 数组多留一个位置，插入时先放入再分裂
+ */
+struct _BTreeNode
+{
+    cuint               n;
+    bool                leaf;
+    BTreeNode*          prev;
+    BTreeNode*          next;
+    void*               keys[BTREE_ORDER + 1];
+    union {
+        void*           values[BTREE_ORDER + 1];
+        BTreeNode*      children[BTREE_ORDER + 1];
+    } u;
+};
+
+struct _CBTree
+{
+    BTreeNode*          root;
+    BTreeNode*          first;
+    BTreeNode*          last;
+    cuint               nnodes;
+    cuint               height;
+    cint                version;
+    CCompareFunc        keyCompareSimpleFunc;       // c_btree_new() 传入的比较函数
+    CCompareDataFunc    keyCompareFunc;
+    void*               keyCompareData;
+    CDestroyNotify      keyDestroyFunc;
+    CDestroyNotify      valueDestroyFunc;
+    catomicrefcount     refCount;
+};
+
+struct _RealIter
+{
+    CBTree*             tree;
+    BTreeNode*          leaf;
+    cint                index;
+    cint                version;
+};
+
+C_STATIC_ASSERT(sizeof (RealIter) <= sizeof (CBTreeIter));
+
+
+static inline cint btree_compare (const CBTree* tree, const void* a, const void* b)
+{
+    return tree->keyCompareFunc ((void*) a, (void*) b, tree->keyCompareData);
+}
+
+static cint btree_compare_simple (void* a, void* b, void* udata)
+{
+    const CBTree* tree = udata;
+
+    return tree->keyCompareSimpleFunc (a, b);
+}
+
+/* keys[0, n) 中第一个 >= key 的位置 */
+static inline cuint btree_lower_bound (const CBTree* tree, void* const* keys, cuint n, const void* key)
+{
+    cuint lo = 0;
+    cuint hi = n;
+
+    while (lo < hi) {
+        const cuint mid = (lo + hi) >> 1;
+        if (btree_compare (tree, keys[mid], key) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/* keys[0, n) 中第一个 > key 的位置 */
+static inline cuint btree_upper_bound (const CBTree* tree, void* const* keys, cuint n, const void* key)
+{
+    cuint lo = 0;
+    cuint hi = n;
+
+    while (lo < hi) {
+        const cuint mid = (lo + hi) >> 1;
+        if (btree_compare (tree, keys[mid], key) <= 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/* 内部节点中 key 所在的子节点: 小于等于 key 的分隔 key 个数 */
+static inline cuint btree_child_index (const CBTree* tree, const BTreeNode* node, const void* key)
+{
+    return btree_upper_bound (tree, node->keys, node->n - 1, key);
+}
+
+static inline bool btree_leaf_find (const CBTree* tree, const BTreeNode* leaf, const void* key, cuint* index)
+{
+    *index = btree_lower_bound (tree, leaf->keys, leaf->n, key);
+
+    return *index < leaf->n && 0 == btree_compare (tree, leaf->keys[*index], key);
+}
+
+static BTreeNode* btree_find_leaf (const CBTree* tree, const void* key)
+{
+    BTreeNode* node = tree->root;
+
+    while (node && !node->leaf) {
+        node = node->u.children[btree_child_index (tree, node, key)];
+    }
+
+    return node;
+}
+
+static inline void* btree_node_min_key (const BTreeNode* node)
+{
+    while (!node->leaf) {
+        node = node->u.children[0];
+    }
+
+    return node->keys[0];
+}
+
+static BTreeNode* btree_node_new (bool leaf)
+{
+    BTreeNode* node = c_malloc0 (sizeof (BTreeNode));
+    node->leaf = leaf;
+
+    return node;
+}
+
+static void btree_node_free (CBTree* tree, BTreeNode* node, bool notify)
+{
+    cuint i;
+
+    if (node->leaf) {
+        for (i = 0; notify && i < node->n; ++i) {
+            if (tree->keyDestroyFunc) {
+                tree->keyDestroyFunc (node->keys[i]);
+            }
+            if (tree->valueDestroyFunc) {
+                tree->valueDestroyFunc (node->u.values[i]);
+            }
+        }
+    }
+    else {
+        for (i = 0; i < node->n; ++i) {
+            btree_node_free (tree, node->u.children[i], notify);
+        }
+    }
+
+    c_free (node);
+}
+
+/* 重新计算内部节点中 children[lo, hi] 的分隔 key */
+static void btree_node_update_keys (BTreeNode* node, cuint lo, cuint hi)
+{
+    cuint i;
+
+    for (i = C_MAX (lo, 1); i <= hi && i < node->n; ++i) {
+        node->keys[i - 1] = btree_node_min_key (node->u.children[i]);
+    }
+}
+
+/* 节点超出容量时把后一半移到新节点，返回新节点 */
+static BTreeNode* btree_node_split (CBTree* tree, BTreeNode* node)
+{
+    const cuint half = node->n / 2;
+    BTreeNode* right = btree_node_new (node->leaf);
+
+    right->n = node->n - half;
+    if (node->leaf) {
+        memcpy (right->keys, node->keys + half, right->n * sizeof (void*));
+        memcpy (right->u.values, node->u.values + half, right->n * sizeof (void*));
+        right->prev = node;
+        right->next = node->next;
+        if (node->next) {
+            node->next->prev = right;
+        }
+        else {
+            tree->last = right;
+        }
+        node->next = right;
+    }
+    else {
+        // keys[half - 1] 是右边第一个子树的最小 key，由父节点保存
+        memcpy (right->keys, node->keys + half, (right->n - 1) * sizeof (void*));
+        memcpy (right->u.children, node->u.children + half, right->n * sizeof (void*));
+    }
+    node->n = half;
+
+    return right;
+}
+
+/**
+ * @brief 递归插入
+ * @return 节点分裂时返回新的右侧节点
+ */
+static BTreeNode* btree_node_insert (CBTree* tree, BTreeNode* node, void* key, void* value, bool replace, bool* inserted)
+{
+    cuint i;
+
+    if (node->leaf) {
+        if (btree_leaf_find (tree, node, key, &i)) {
+            if (replace) {
+                if (tree->keyDestroyFunc) {
+                    tree->keyDestroyFunc (node->keys[i]);
+                }
+                node->keys[i] = key;
+            }
+            else if (tree->keyDestroyFunc) {
+                tree->keyDestroyFunc (key);
+            }
+            if (tree->valueDestroyFunc) {
+                tree->valueDestroyFunc (node->u.values[i]);
+            }
+            node->u.values[i] = value;
+            *inserted = false;
+            return NULL;
+        }
+        memmove (node->keys + i + 1, node->keys + i, (node->n - i) * sizeof (void*));
+        memmove (node->u.values + i + 1, node->u.values + i, (node->n - i) * sizeof (void*));
+        node->keys[i] = key;
+        node->u.values[i] = value;
+        node->n++;
+        *inserted = true;
+    }
+    else {
+        i = btree_child_index (tree, node, key);
+        BTreeNode* right = btree_node_insert (tree, node->u.children[i], key, value, replace, inserted);
+        if (replace && !*inserted && i > 0) {
+            // 替换了子树中最小的 key 时分隔 key 也要跟着换
+            node->keys[i - 1] = btree_node_min_key (node->u.children[i]);
+        }
+        if (NULL == right) {
+            return NULL;
+        }
+        memmove (node->keys + i + 1, node->keys + i, (node->n - 1 - i) * sizeof (void*));
+        memmove (node->u.children + i + 2, node->u.children + i + 1, (node->n - 1 - i) * sizeof (void*));
+        node->keys[i] = btree_node_min_key (right);
+        node->u.children[i + 1] = right;
+        node->n++;
+    }
+
+    return node->n > BTREE_ORDER ? btree_node_split (tree, node) : NULL;
+}
+
+/* 把 right 合并到 left，right 是 left 右边相邻的节点 */
+static void btree_node_merge (CBTree* tree, BTreeNode* left, BTreeNode* right)
+{
+    if (left->leaf) {
+        memcpy (left->keys + left->n, right->keys, right->n * sizeof (void*));
+        memcpy (left->u.values + left->n, right->u.values, right->n * sizeof (void*));
+        left->next = right->next;
+        if (right->next) {
+            right->next->prev = left;
+        }
+        else {
+            tree->last = left;
+        }
+    }
+    else {
+        left->keys[left->n - 1] = btree_node_min_key (right->u.children[0]);
+        memcpy (left->keys + left->n, right->keys, (right->n - 1) * sizeof (void*));
+        memcpy (left->u.children + left->n, right->u.children, right->n * sizeof (void*));
+    }
+    left->n += right->n;
+
+    c_free (right);
+}
+
+/* 子节点 children[i] 元素不足时，从相邻节点借一个或与相邻节点合并 */
+static void btree_node_rebalance (CBTree* tree, BTreeNode* parent, cuint i)
+{
+    BTreeNode* child = parent->u.children[i];
+    BTreeNode* left = (i > 0) ? parent->u.children[i - 1] : NULL;
+    BTreeNode* right = (i + 1 < parent->n) ? parent->u.children[i + 1] : NULL;
+
+    if (left && left->n > BTREE_MIN_FILL) {
+        if (child->leaf) {
+            memmove (child->keys + 1, child->keys, child->n * sizeof (void*));
+            memmove (child->u.values + 1, child->u.values, child->n * sizeof (void*));
+            child->keys[0] = left->keys[left->n - 1];
+            child->u.values[0] = left->u.values[left->n - 1];
+        }
+        else {
+            memmove (child->keys + 1, child->keys, (child->n - 1) * sizeof (void*));
+            memmove (child->u.children + 1, child->u.children, child->n * sizeof (void*));
+            child->keys[0] = btree_node_min_key (child->u.children[1]);
+            child->u.children[0] = left->u.children[left->n - 1];
+        }
+        left->n--;
+        child->n++;
+    }
+    else if (right && right->n > BTREE_MIN_FILL) {
+        if (child->leaf) {
+            child->keys[child->n] = right->keys[0];
+            child->u.values[child->n] = right->u.values[0];
+            memmove (right->keys, right->keys + 1, (right->n - 1) * sizeof (void*));
+            memmove (right->u.values, right->u.values + 1, (right->n - 1) * sizeof (void*));
+        }
+        else {
+            child->keys[child->n - 1] = btree_node_min_key (right->u.children[0]);
+            child->u.children[child->n] = right->u.children[0];
+            memmove (right->keys, right->keys + 1, (right->n - 2) * sizeof (void*));
+            memmove (right->u.children, right->u.children + 1, (right->n - 1) * sizeof (void*));
+        }
+        right->n--;
+        child->n++;
+    }
+    else {
+        if (left) {
+            child = left;
+            i--;
+        }
+        btree_node_merge (tree, child, parent->u.children[i + 1]);
+        memmove (parent->keys + i, parent->keys + i + 1, (parent->n - 2 - i) * sizeof (void*));
+        memmove (parent->u.children + i + 1, parent->u.children + i + 2, (parent->n - 2 - i) * sizeof (void*));
+        parent->n--;
+    }
+
+    btree_node_update_keys (parent, (i > 0) ? i - 1 : 0, i + 1);
+}
+
+/* 递归删除，找到时返回 true 并通过 origKey/value 返回删除的元素 */
+static bool btree_node_remove (CBTree* tree, BTreeNode* node, const void* key, void** origKey, void** value)
+{
+    cuint i;
+
+    if (node->leaf) {
+        if (!btree_leaf_find (tree, node, key, &i)) {
+            return false;
+        }
+        *origKey = node->keys[i];
+        *value = node->u.values[i];
+        memmove (node->keys + i, node->keys + i + 1, (node->n - 1 - i) * sizeof (void*));
+        memmove (node->u.values + i, node->u.values + i + 1, (node->n - 1 - i) * sizeof (void*));
+        node->n--;
+        return true;
+    }
+
+    i = btree_child_index (tree, node, key);
+    if (!btree_node_remove (tree, node->u.children[i], key, origKey, value)) {
+        return false;
+    }
+
+    if (node->u.children[i]->n < BTREE_MIN_FILL) {
+        btree_node_rebalance (tree, node, i);
+    }
+    else if (i > 0) {
+        // 删除的可能是子树中最小的 key
+        node->keys[i - 1] = btree_node_min_key (node->u.children[i]);
+    }
+
+    return true;
+}
+
+static bool c_btree_insert_internal (CBTree* tree, void* key, void* value, bool replace)
+{
+    bool inserted = false;
+
+    if (C_UNLIKELY (NULL == tree->root)) {
+        tree->root = btree_node_new (true);
+        tree->first = tree->root;
+        tree->last = tree->root;
+        tree->height = 1;
+    }
+
+    BTreeNode* right = btree_node_insert (tree, tree->root, key, value, replace, &inserted);
+    if (right) {
+        BTreeNode* root = btree_node_new (false);
+        root->n = 2;
+        root->keys[0] = btree_node_min_key (right);
+        root->u.children[0] = tree->root;
+        root->u.children[1] = right;
+        tree->root = root;
+        tree->height++;
+    }
+
+    if (inserted) {
+        tree->nnodes++;
+    }
+    tree->version++;
+
+    return inserted;
+}
+
+static bool c_btree_remove_internal (CBTree* tree, const void* key, bool steal, void** origKey, void** value)
+{
+    void* k = NULL;
+    void* v = NULL;
+
+    if (NULL == tree->root || !btree_node_remove (tree, tree->root, key, &k, &v)) {
+        return false;
+    }
+
+    BTreeNode* root = tree->root;
+    if (root->leaf && 0 == root->n) {
+        c_free (tree->root);
+        tree->first = NULL;
+        tree->last = NULL;
+        tree->height = 0;
+    }
+    else if (!root->leaf && 1 == root->n) {
+        tree->root = root->u.children[0];
+        tree->height--;
+        c_free (root);
+    }
+    tree->nnodes--;
+    tree->version++;
+
+    if (!steal) {
+        if (tree->keyDestroyFunc) {
+            tree->keyDestroyFunc (k);
+        }
+        if (tree->valueDestroyFunc) {
+            tree->valueDestroyFunc (v);
+        }
+    }
+
+    if (origKey) {
+        *origKey = k;
+    }
+
+    if (value) {
+        *value = v;
+    }
+
+    return true;
+}
+
+/* 自底向上建树，每层的元素平均分到 ceil(n / BTREE_ORDER) 个节点中，保证每个节点不少于 BTREE_MIN_FILL */
+static void btree_build (CBTree* tree, const CBTreeEntry* entries, cuint n)
+{
+    cuint i, j;
+    cuint pos = 0;
+    BTreeNode* prev = NULL;
+    cuint count = (n + BTREE_ORDER - 1) / BTREE_ORDER;
+    BTreeNode** level = c_malloc0 (count * sizeof (BTreeNode*));
+
+    for (i = 0; i < count; ++i) {
+        BTreeNode* leaf = btree_node_new (true);
+        leaf->n = n / count + (i < n % count ? 1 : 0);
+        for (j = 0; j < leaf->n; ++j) {
+            leaf->keys[j] = entries[pos + j].key;
+            leaf->u.values[j] = entries[pos + j].value;
+        }
+        pos += leaf->n;
+        leaf->prev = prev;
+        if (prev) {
+            prev->next = leaf;
+        }
+        else {
+            tree->first = leaf;
+        }
+        prev = leaf;
+        level[i] = leaf;
+    }
+    tree->last = prev;
+    tree->height = 1;
+
+    while (count > 1) {
+        const cuint parents = (count + BTREE_ORDER - 1) / BTREE_ORDER;
+        for (i = 0, pos = 0; i < parents; ++i) {
+            BTreeNode* node = btree_node_new (false);
+            node->n = count / parents + (i < count % parents ? 1 : 0);
+            for (j = 0; j < node->n; ++j) {
+                node->u.children[j] = level[pos + j];
+                if (j > 0) {
+                    node->keys[j - 1] = btree_node_min_key (level[pos + j]);
+                }
+            }
+            pos += node->n;
+            level[i] = node;
+        }
+        count = parents;
+        tree->height++;
+    }
+
+    tree->root = level[0];
+    tree->nnodes = n;
+
+    c_free (level);
+}
+
+CBTree* c_btree_new (CCompareFunc keyCompareFunc)
+{
+    c_return_val_if_fail (keyCompareFunc != NULL, NULL);
+
+    CBTree* tree = c_btree_new_full (btree_compare_simple, NULL, NULL, NULL);
+    tree->keyCompareSimpleFunc = keyCompareFunc;
+    tree->keyCompareData = tree;
+
+    return tree;
+}
+
+CBTree* c_btree_new_with_data (CCompareDataFunc keyCompareFunc, void* keyCompareData)
+{
+    c_return_val_if_fail (keyCompareFunc != NULL, NULL);
+
+    return c_btree_new_full (keyCompareFunc, keyCompareData, NULL, NULL);
+}
+
+CBTree* c_btree_new_full (CCompareDataFunc keyCompareFunc, void* keyCompareData, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc)
+{
+    c_return_val_if_fail (keyCompareFunc != NULL, NULL);
+
+    CBTree* tree = c_malloc0 (sizeof (CBTree));
+    c_atomic_ref_count_init (&tree->refCount);
+    tree->keyCompareFunc = keyCompareFunc;
+    tree->keyCompareData = keyCompareData;
+    tree->keyDestroyFunc = keyDestroyFunc;
+    tree->valueDestroyFunc = valueDestroyFunc;
+
+    return tree;
+}
+
+CBTree* c_btree_new_from_sorted_array (CArray* entries, CCompareDataFunc keyCompareFunc, void* keyCompareData, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc)
+{
+    cuint i;
+
+    c_return_val_if_fail (entries != NULL, NULL);
+    c_return_val_if_fail (c_array_get_element_size (entries) == sizeof (CBTreeEntry), NULL);
+
+    CBTree* tree = c_btree_new_full (keyCompareFunc, keyCompareData, keyDestroyFunc, valueDestroyFunc);
+    c_return_val_if_fail (tree != NULL, NULL);
+
+    const CBTreeEntry* e = (const CBTreeEntry*) entries->data;
+    for (i = 1; i < entries->len; ++i) {
+        if (btree_compare (tree, e[i - 1].key, e[i].key) >= 0) {
+            break;
+        }
+    }
+
+    if (i < entries->len) {
+        for (i = 0; i < entries->len; ++i) {
+            c_btree_insert (tree, e[i].key, e[i].value);
+        }
+    }
+    else if (entries->len > 0) {
+        btree_build (tree, e, entries->len);
+    }
+
+    return tree;
+}
+
+CBTree* c_btree_ref (CBTree* tree)
+{
+    c_return_val_if_fail (tree != NULL, NULL);
+
+    c_atomic_ref_count_inc (&tree->refCount);
+
+    return tree;
+}
+
+void c_btree_unref (CBTree* tree)
+{
+    c_return_if_fail (tree != NULL);
+
+    if (c_atomic_ref_count_dec (&tree->refCount)) {
+        c_btree_remove_all (tree);
+        c_free (tree);
+    }
+}
+
+void c_btree_destroy (CBTree* tree)
+{
+    c_return_if_fail (tree != NULL);
+
+    c_btree_remove_all (tree);
+    c_btree_unref (tree);
+}
+
+bool c_btree_insert (CBTree* tree, void* key, void* value)
+{
+    c_return_val_if_fail (tree != NULL, false);
+
+    return c_btree_insert_internal (tree, key, value, false);
+}
+
+bool c_btree_replace (CBTree* tree, void* key, void* value)
+{
+    c_return_val_if_fail (tree != NULL, false);
+
+    return c_btree_insert_internal (tree, key, value, true);
+}
+
+bool c_btree_remove (CBTree* tree, const void* key)
+{
+    c_return_val_if_fail (tree != NULL, false);
+
+    return c_btree_remove_internal (tree, key, false, NULL, NULL);
+}
+
+bool c_btree_steal (CBTree* tree, const void* key)
+{
+    c_return_val_if_fail (tree != NULL, false);
+
+    return c_btree_remove_internal (tree, key, true, NULL, NULL);
+}
+
+bool c_btree_steal_extended (CBTree* tree, const void* lookupKey, void** stolenKey, void** stolenValue)
+{
+    c_return_val_if_fail (tree != NULL, false);
+
+    return c_btree_remove_internal (tree, lookupKey, true, stolenKey, stolenValue);
+}
+
+void c_btree_remove_all (CBTree* tree)
+{
+    c_return_if_fail (tree != NULL);
+
+    if (tree->root) {
+        btree_node_free (tree, tree->root, true);
+    }
+
+    tree->root = NULL;
+    tree->first = NULL;
+    tree->last = NULL;
+    tree->nnodes = 0;
+    tree->height = 0;
+    tree->version++;
+}
+
+void* c_btree_lookup (CBTree* tree, const void* key)
+{
+    void* value = NULL;
+
+    c_btree_lookup_extended (tree, key, NULL, &value);
+
+    return value;
+}
+
+bool c_btree_lookup_extended (CBTree* tree, const void* lookupKey, void** origKey, void** value)
+{
+    cuint i;
+
+    c_return_val_if_fail (tree != NULL, false);
+
+    const BTreeNode* leaf = btree_find_leaf (tree, lookupKey);
+    if (NULL == leaf || !btree_leaf_find (tree, leaf, lookupKey, &i)) {
+        return false;
+    }
+
+    if (origKey) {
+        *origKey = leaf->keys[i];
+    }
+
+    if (value) {
+        *value = leaf->u.values[i];
+    }
+
+    return true;
+}
+
+bool c_btree_contains (CBTree* tree, const void* key)
+{
+    return c_btree_lookup_extended (tree, key, NULL, NULL);
+}
+
+void c_btree_foreach (CBTree* tree, CHFunc func, void* udata)
+{
+    cuint i;
+    const BTreeNode* leaf;
+
+    c_return_if_fail (tree != NULL);
+    c_return_if_fail (func != NULL);
+
+    for (leaf = tree->first; leaf; leaf = leaf->next) {
+        for (i = 0; i < leaf->n; ++i) {
+            func (leaf->keys[i], leaf->u.values[i], udata);
+        }
+    }
+}
+
+cuint c_btree_nnodes (CBTree* tree)
+{
+    c_return_val_if_fail (tree != NULL, 0);
+
+    return tree->nnodes;
+}
+
+cuint c_btree_height (CBTree* tree)
+{
+    c_return_val_if_fail (tree != NULL, 0);
+
+    return tree->height;
+}
+
+void c_btree_iter_init (CBTreeIter* iter, CBTree* tree)
+{
+    RealIter* ri = (RealIter*) iter;
+
+    c_return_if_fail (iter != NULL);
+    c_return_if_fail (tree != NULL);
+
+    ri->tree = tree;
+    ri->leaf = tree->first;
+    ri->index = 0;
+    ri->version = tree->version;
+}
+
+void c_btree_iter_init_last (CBTreeIter* iter, CBTree* tree)
+{
+    RealIter* ri = (RealIter*) iter;
+
+    c_return_if_fail (iter != NULL);
+    c_return_if_fail (tree != NULL);
+
+    ri->tree = tree;
+    ri->leaf = tree->last;
+    ri->index = tree->last ? (cint) tree->last->n : 0;
+    ri->version = tree->version;
+}
+
+void c_btree_iter_init_lower_bound (CBTreeIter* iter, CBTree* tree, const void* key)
+{
+    RealIter* ri = (RealIter*) iter;
+
+    c_return_if_fail (iter != NULL);
+    c_return_if_fail (tree != NULL);
+
+    ri->tree = tree;
+    ri->leaf = btree_find_leaf (tree, key);
+    ri->index = ri->leaf ? (cint) btree_lower_bound (tree, ri->leaf->keys, ri->leaf->n, key) : 0;
+    ri->version = tree->version;
+}
+
+void c_btree_iter_init_upper_bound (CBTreeIter* iter, CBTree* tree, const void* key)
+{
+    RealIter* ri = (RealIter*) iter;
+
+    c_return_if_fail (iter != NULL);
+    c_return_if_fail (tree != NULL);
+
+    ri->tree = tree;
+    ri->leaf = btree_find_leaf (tree, key);
+    ri->index = ri->leaf ? (cint) btree_upper_bound (tree, ri->leaf->keys, ri->leaf->n, key) : 0;
+    ri->version = tree->version;
+}
+
+bool c_btree_iter_next (CBTreeIter* iter, void** key, void** value)
+{
+    RealIter* ri = (RealIter*) iter;
+
+    c_return_val_if_fail (iter != NULL, false);
+    c_return_val_if_fail (ri->version == ri->tree->version, false);
+
+    if (NULL == ri->leaf) {
+        return false;
+    }
+
+    while (ri->index >= (cint) ri->leaf->n) {
+        if (NULL == ri->leaf->next) {
+            return false;
+        }
+        ri->leaf = ri->leaf->next;
+        ri->index = 0;
+    }
+
+    if (key) {
+        *key = ri->leaf->keys[ri->index];
+    }
+
+    if (value) {
+        *value = ri->leaf->u.values[ri->index];
+    }
+    ri->index++;
+
+    return true;
+}
+
+bool c_btree_iter_prev (CBTreeIter* iter, void** key, void** value)
+{
+    RealIter* ri = (RealIter*) iter;
+
+    c_return_val_if_fail (iter != NULL, false);
+    c_return_val_if_fail (ri->version == ri->tree->version, false);
+
+    if (NULL == ri->leaf) {
+        return false;
+    }
+
+    while (ri->index <= 0) {
+        if (NULL == ri->leaf->prev) {
+            return false;
+        }
+        ri->leaf = ri->leaf->prev;
+        ri->index = (cint) ri->leaf->n;
+    }
+    ri->index--;
+
+    if (key) {
+        *key = ri->leaf->keys[ri->index];
+    }
+
+    if (value) {
+        *value = ri->leaf->u.values[ri->index];
+    }
+
+    return true;
+}
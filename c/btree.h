@@ -0,0 +1,114 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-28.
+//
+
+#ifndef CLIBRARY_BTREE_H
+#define CLIBRARY_BTREE_H
+
+#if !defined (__CLIB_H_INSIDE__) && !defined (CLIB_COMPILATION)
+#error "Only <clib.h> can be included directly."
+#endif
+
+#include <c/array.h>
+#include <c/macros.h>
+
+C_BEGIN_EXTERN_C
+
+typedef struct _CBTree              CBTree;
+typedef struct _CBTreeIter          CBTreeIter;
+typedef struct _CBTreeEntry         CBTreeEntry;
+
+/**
+ * @brief 有序表(B+ 树)
+ * @note 每个节点连续存放最多 32 个 key，查找时在节点内二分，比每个元素一个节点的平衡二叉树少得多的缓存未命中；
+ *       元素只保存在叶子中，叶子之间双向链接，顺序遍历与范围查询不需要回到父节点。
+ *       需要按 key 顺序遍历或做范围查询时使用，只做等值查找时 CHashTable 更快
+ */
+
+struct _CBTreeEntry
+{
+    void*           key;
+    void*           value;
+};
+
+struct _CBTreeIter
+{
+    /*< private >*/
+    void*           dummy1;
+    void*           dummy2;
+    int             dummy3;
+    int             dummy4;
+};
+
+
+CBTree*         c_btree_new                     (CCompareFunc keyCompareFunc);
+CBTree*         c_btree_new_with_data           (CCompareDataFunc keyCompareFunc, void* keyCompareData);
+CBTree*         c_btree_new_full                (CCompareDataFunc keyCompareFunc, void* keyCompareData, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc);
+
+/**
+ * @brief 由已按 key 升序排列的 CBTreeEntry 数组批量建树，复杂度 O(n)
+ * @note 节点自底向上依次填满，不做任何比较以外的插入操作；数组不是严格升序(有重复或乱序)时退化为逐个插入，
+ *       结果与逐个调用 c_btree_insert 相同。数组本身不会被修改或释放，key 与 value 的所有权转移给树
+ */
+CBTree*         c_btree_new_from_sorted_array   (CArray* entries, CCompareDataFunc keyCompareFunc, void* keyCompareData, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc);
+CBTree*         c_btree_ref                     (CBTree* tree);
+void            c_btree_unref                   (CBTree* tree);
+void            c_btree_destroy                 (CBTree* tree);
+
+/**
+ * @brief 插入，key 已存在时释放新的 key、替换旧的 value
+ * @return key 原来不存在时返回 true
+ */
+bool            c_btree_insert                  (CBTree* tree, void* key, void* value);
+
+/**
+ * @brief 插入，key 已存在时释放旧的 key 与 value，替换为新的
+ * @return key 原来不存在时返回 true
+ */
+bool            c_btree_replace                 (CBTree* tree, void* key, void* value);
+bool            c_btree_remove                  (CBTree* tree, const void* key);
+bool            c_btree_steal                   (CBTree* tree, const void* key);
+bool            c_btree_steal_extended          (CBTree* tree, const void* lookupKey, void** stolenKey, void** stolenValue);
+void            c_btree_remove_all              (CBTree* tree);
+void*           c_btree_lookup                  (CBTree* tree, const void* key);
+bool            c_btree_lookup_extended         (CBTree* tree, const void* lookupKey, void** origKey, void** value);
+bool            c_btree_contains                (CBTree* tree, const void* key);
+
+/**
+ * @brief 按 key 升序遍历，遍历期间不能修改树
+ */
+void            c_btree_foreach                 (CBTree* tree, CHFunc func, void* udata);
+cuint           c_btree_nnodes                  (CBTree* tree);
+
+/**
+ * @brief 树的层数，空树为 0，只有一个叶子时为 1
+ */
+cuint           c_btree_height                  (CBTree* tree);
+
+/**
+ * @brief 迭代器位于两个元素之间: next 返回后一个元素并后移，prev 返回前一个元素并前移
+ * @note 迭代期间修改树会使迭代器失效
+ *       c_btree_iter_init: 位于第一个元素之前
+ *       c_btree_iter_init_last: 位于最后一个元素之后
+ *       c_btree_iter_init_lower_bound: 位于第一个 >= key 的元素之前
+ *       c_btree_iter_init_upper_bound: 位于第一个 > key 的元素之前
+ */
+void            c_btree_iter_init               (CBTreeIter* iter, CBTree* tree);
+void            c_btree_iter_init_last          (CBTreeIter* iter, CBTree* tree);
+void            c_btree_iter_init_lower_bound   (CBTreeIter* iter, CBTree* tree, const void* key);
+void            c_btree_iter_init_upper_bound   (CBTreeIter* iter, CBTree* tree, const void* key);
+bool            c_btree_iter_next               (CBTreeIter* iter, void** key, void** value);
+bool            c_btree_iter_prev               (CBTreeIter* iter, void** key, void** value);
+
+C_END_EXTERN_C
+
+#endif //CLIBRARY_BTREE_H
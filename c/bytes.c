@@ -13,6 +13,7 @@
 
 #include "bytes.h"
 #include "atomic.h"
+#include "hash-table.h"
 
 struct _CBytes
 {
@@ -150,17 +151,9 @@ CByteArray* c_bytes_unref_to_array (CBytes* bytes)
 
 cuint c_bytes_hash (const CBytes* bytes)
 {
-    const CBytes *a = bytes;
-    const signed char *p, *e;
-    cuint32 h = 5381;
-
     c_return_val_if_fail (bytes, 0);
 
-    for (p = (signed char *)a->data, e = (signed char *)a->data + a->size; p != e; p++) {
-        h = (h << 5) + h + *p;
-    }
-
-    return h;
+    return c_data_hash (bytes->data, bytes->size);
 }
 
 bool c_bytes_equal (const CBytes* bytes1, const CBytes* bytes2)
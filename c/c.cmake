@@ -50,6 +50,12 @@ file(GLOB C_SRC
         ${CMAKE_SOURCE_DIR}/c/queue.h
         ${CMAKE_SOURCE_DIR}/c/queue.c
 
+        ${CMAKE_SOURCE_DIR}/c/deque.h
+        ${CMAKE_SOURCE_DIR}/c/deque.c
+
+        ${CMAKE_SOURCE_DIR}/c/async-queue.h
+        ${CMAKE_SOURCE_DIR}/c/async-queue.c
+
         ${CMAKE_SOURCE_DIR}/c/error.h
         ${CMAKE_SOURCE_DIR}/c/error.c
 
@@ -98,9 +104,19 @@ file(GLOB C_SRC
         ${CMAKE_SOURCE_DIR}/c/time-zone.h
         ${CMAKE_SOURCE_DIR}/c/time-zone.c
 
+        ${CMAKE_SOURCE_DIR}/c/hash-map.h
         ${CMAKE_SOURCE_DIR}/c/hash-table.h
         ${CMAKE_SOURCE_DIR}/c/hash-table.c
 
+        ${CMAKE_SOURCE_DIR}/c/concurrent-hash-table.h
+        ${CMAKE_SOURCE_DIR}/c/concurrent-hash-table.c
+
+        ${CMAKE_SOURCE_DIR}/c/btree.h
+        ${CMAKE_SOURCE_DIR}/c/btree.c
+
+        ${CMAKE_SOURCE_DIR}/c/slice.h
+        ${CMAKE_SOURCE_DIR}/c/slice.c
+
         ${CMAKE_SOURCE_DIR}/c/file-utils.h
         ${CMAKE_SOURCE_DIR}/c/file-utils.c
 
@@ -129,6 +145,9 @@ file(GLOB C_HEADERS
         ${CMAKE_SOURCE_DIR}/c/array.h
         ${CMAKE_SOURCE_DIR}/c/bytes.h
         ${CMAKE_SOURCE_DIR}/c/slist.h
+        ${CMAKE_SOURCE_DIR}/c/queue.h
+        ${CMAKE_SOURCE_DIR}/c/deque.h
+        ${CMAKE_SOURCE_DIR}/c/async-queue.h
         ${CMAKE_SOURCE_DIR}/c/rcbox.h
         ${CMAKE_SOURCE_DIR}/c/quark.h
         ${CMAKE_SOURCE_DIR}/c/option.h
@@ -143,7 +162,11 @@ file(GLOB C_HEADERS
         ${CMAKE_SOURCE_DIR}/c/charset.h
         ${CMAKE_SOURCE_DIR}/c/time-zone.h
         ${CMAKE_SOURCE_DIR}/c/host-utils.h
+        ${CMAKE_SOURCE_DIR}/c/hash-map.h
         ${CMAKE_SOURCE_DIR}/c/hash-table.h
+        ${CMAKE_SOURCE_DIR}/c/concurrent-hash-table.h
+        ${CMAKE_SOURCE_DIR}/c/btree.h
+        ${CMAKE_SOURCE_DIR}/c/slice.h
         ${CMAKE_SOURCE_DIR}/c/file-utils.h
         ${CMAKE_SOURCE_DIR}/c/mapped-file.h
 )
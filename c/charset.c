@@ -554,6 +554,8 @@ const char* _c_locale_get_charset_aliases(void)
 
     cp = gsCharsetAliases;
     if (cp == NULL) {
+        /* 没有别名表，返回空列表 */
+        cp = "";
         gsCharsetAliases = cp;
     }
 
@@ -31,6 +31,9 @@
 #include <c/bytes.h>
 #include <c/quark.h>
 #include <c/slist.h>
+#include <c/queue.h>
+#include <c/deque.h>
+#include <c/async-queue.h>
 #include <c/utils.h>
 #include <c/rcbox.h>
 // #include <c/source.h>
@@ -46,7 +49,11 @@
 #include <c/charset.h>
 #include <c/time-zone.h>
 #include <c/host-utils.h>
+#include <c/hash-map.h>
 #include <c/hash-table.h>
+#include <c/concurrent-hash-table.h>
+#include <c/btree.h>
+#include <c/slice.h>
 #include <c/file-utils.h>
 #include <c/mapped-file.h>
 
@@ -0,0 +1,327 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-20.
+//
+
+#include "concurrent-hash-table.h"
+
+#include "thread.h"
+
+#define CONCURRENT_DEFAULT_SHARDS       64
+#define CONCURRENT_MAX_SHARDS           (1U << 16)
+#define CONCURRENT_CACHE_LINE           64
+
+
+/**
+ * @brief 每个分片独占一个 cache line，避免相邻分片的锁互相伪共享
+ */
+typedef union
+{
+    struct {
+        CRWLock         lock;
+        CHashTable*     table;
+    };
+    cuint8              padding[CONCURRENT_CACHE_LINE];
+} CConcurrentShard;
+
+struct _CConcurrentHashTable
+{
+    CHashFunc           hashFunc;
+    CEqualFunc          keyEqualFunc;
+    CDestroyNotify      keyDestroyFunc;
+    CDestroyNotify      valueDestroyFunc;
+    cuint               shift;              // 64 - log2(分片数)
+    cuint               nShards;
+    CConcurrentShard*   shards;
+};
+
+C_STATIC_ASSERT(sizeof(CConcurrentShard) == CONCURRENT_CACHE_LINE);
+
+
+static inline CConcurrentShard* c_concurrent_hash_table_get_shard (CConcurrentHashTable* hashTable, const void* key);
+
+
+CConcurrentHashTable* c_concurrent_hash_table_new (CHashFunc hashFunc, CEqualFunc keyEqualFunc, cuint shards)
+{
+    return c_concurrent_hash_table_new_full (hashFunc, keyEqualFunc, NULL, NULL, shards);
+}
+
+CConcurrentHashTable* c_concurrent_hash_table_new_full (CHashFunc hashFunc, CEqualFunc keyEqualFunc, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc, cuint shards)
+{
+    cuint bits = 0;
+
+    if (0 == shards) {
+        shards = CONCURRENT_DEFAULT_SHARDS;
+    }
+    shards = C_MIN (shards, CONCURRENT_MAX_SHARDS);
+    while ((1U << bits) < shards) {
+        ++bits;
+    }
+
+    CConcurrentHashTable* hashTable = c_malloc0 (sizeof (CConcurrentHashTable));
+    hashTable->hashFunc = hashFunc ? hashFunc : c_direct_hash;
+    hashTable->keyEqualFunc = keyEqualFunc;
+    hashTable->keyDestroyFunc = keyDestroyFunc;
+    hashTable->valueDestroyFunc = valueDestroyFunc;
+    hashTable->nShards = 1U << bits;
+    hashTable->shift = 64 - bits;
+    hashTable->shards = c_malloc0 (sizeof (CConcurrentShard) * hashTable->nShards);
+
+    for (cuint i = 0; i < hashTable->nShards; ++i) {
+        c_rw_lock_init (&hashTable->shards[i].lock);
+        hashTable->shards[i].table = c_hash_table_new_flat_full (hashTable->hashFunc, keyEqualFunc, keyDestroyFunc, valueDestroyFunc);
+    }
+
+    return hashTable;
+}
+
+void c_concurrent_hash_table_destroy (CConcurrentHashTable* hashTable)
+{
+    c_return_if_fail (hashTable != NULL);
+
+    for (cuint i = 0; i < hashTable->nShards; ++i) {
+        c_hash_table_unref (hashTable->shards[i].table);
+        c_rw_lock_clear (&hashTable->shards[i].lock);
+    }
+    c_free (hashTable->shards);
+    c_free (hashTable);
+}
+
+bool c_concurrent_hash_table_insert (CConcurrentHashTable* hashTable, void* key, void* value)
+{
+    c_return_val_if_fail (hashTable != NULL, false);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, key);
+
+    c_rw_lock_writer_lock (&shard->lock);
+    bool ret = c_hash_table_insert (shard->table, key, value);
+    c_rw_lock_writer_unlock (&shard->lock);
+
+    return ret;
+}
+
+bool c_concurrent_hash_table_replace (CConcurrentHashTable* hashTable, void* key, void* value)
+{
+    c_return_val_if_fail (hashTable != NULL, false);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, key);
+
+    c_rw_lock_writer_lock (&shard->lock);
+    bool ret = c_hash_table_replace (shard->table, key, value);
+    c_rw_lock_writer_unlock (&shard->lock);
+
+    return ret;
+}
+
+bool c_concurrent_hash_table_remove (CConcurrentHashTable* hashTable, const void* key)
+{
+    c_return_val_if_fail (hashTable != NULL, false);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, key);
+
+    c_rw_lock_writer_lock (&shard->lock);
+    bool ret = c_hash_table_remove (shard->table, key);
+    c_rw_lock_writer_unlock (&shard->lock);
+
+    return ret;
+}
+
+bool c_concurrent_hash_table_steal_extended (CConcurrentHashTable* hashTable, const void* lookupKey, void** stolenKey, void** stolenValue)
+{
+    c_return_val_if_fail (hashTable != NULL, false);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, lookupKey);
+
+    c_rw_lock_writer_lock (&shard->lock);
+    bool ret = c_hash_table_steal_extended (shard->table, lookupKey, stolenKey, stolenValue);
+    c_rw_lock_writer_unlock (&shard->lock);
+
+    return ret;
+}
+
+void c_concurrent_hash_table_remove_all (CConcurrentHashTable* hashTable)
+{
+    c_return_if_fail (hashTable != NULL);
+
+    for (cuint i = 0; i < hashTable->nShards; ++i) {
+        CConcurrentShard* shard = &hashTable->shards[i];
+        c_rw_lock_writer_lock (&shard->lock);
+        c_hash_table_remove_all (shard->table);
+        c_rw_lock_writer_unlock (&shard->lock);
+    }
+}
+
+bool c_concurrent_hash_table_insert_if_absent (CConcurrentHashTable* hashTable, void* key, void* value, void** existing)
+{
+    bool ret = false;
+    void* oldValue = NULL;
+
+    c_return_val_if_fail (hashTable != NULL, false);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, key);
+
+    c_rw_lock_writer_lock (&shard->lock);
+    if (!c_hash_table_lookup_extended (shard->table, key, NULL, &oldValue)) {
+        c_hash_table_insert (shard->table, key, value);
+        ret = true;
+    }
+    c_rw_lock_writer_unlock (&shard->lock);
+
+    if (existing) {
+        *existing = ret ? NULL : oldValue;
+    }
+
+    return ret;
+}
+
+bool c_concurrent_hash_table_compute (CConcurrentHashTable* hashTable, void* key, CConcurrentComputeFunc func, void* udata)
+{
+    bool ret = false;
+    void* origKey = NULL;
+    void* oldValue = NULL;
+    void* valueToFree = NULL;
+
+    c_return_val_if_fail (hashTable != NULL, false);
+    c_return_val_if_fail (func != NULL, false);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, key);
+
+    c_rw_lock_writer_lock (&shard->lock);
+    bool exists = c_hash_table_lookup_extended (shard->table, key, &origKey, &oldValue);
+    void* value = oldValue;
+    if (func (key, &value, exists, udata)) {
+        if (!exists) {
+            c_hash_table_insert (shard->table, key, value);
+            ret = true;
+        }
+        else if (value != oldValue) {
+            // 不能直接 insert(origKey, ...)，那样会对表中仍在使用的 key 调用 keyDestroyFunc
+            c_hash_table_steal (shard->table, origKey);
+            c_hash_table_insert (shard->table, origKey, value);
+            valueToFree = oldValue;
+        }
+    }
+    else if (exists) {
+        c_hash_table_remove (shard->table, origKey);
+    }
+
+    if (valueToFree && hashTable->valueDestroyFunc) {
+        hashTable->valueDestroyFunc (valueToFree);
+    }
+    c_rw_lock_writer_unlock (&shard->lock);
+
+    return ret;
+}
+
+void* c_concurrent_hash_table_lookup (CConcurrentHashTable* hashTable, const void* key)
+{
+    c_return_val_if_fail (hashTable != NULL, NULL);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, key);
+
+    c_rw_lock_reader_lock (&shard->lock);
+    void* value = c_hash_table_lookup (shard->table, key);
+    c_rw_lock_reader_unlock (&shard->lock);
+
+    return value;
+}
+
+void* c_concurrent_hash_table_lookup_copy (CConcurrentHashTable* hashTable, const void* key, CCopyFunc copyFunc, void* udata)
+{
+    void* value = NULL;
+
+    c_return_val_if_fail (hashTable != NULL, NULL);
+    c_return_val_if_fail (copyFunc != NULL, NULL);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, key);
+
+    c_rw_lock_reader_lock (&shard->lock);
+    if (c_hash_table_lookup_extended (shard->table, key, NULL, &value)) {
+        value = copyFunc (value, udata);
+    }
+    c_rw_lock_reader_unlock (&shard->lock);
+
+    return value;
+}
+
+bool c_concurrent_hash_table_lookup_extended (CConcurrentHashTable* hashTable, const void* lookupKey, void** origKey, void** value)
+{
+    c_return_val_if_fail (hashTable != NULL, false);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, lookupKey);
+
+    c_rw_lock_reader_lock (&shard->lock);
+    bool ret = c_hash_table_lookup_extended (shard->table, lookupKey, origKey, value);
+    c_rw_lock_reader_unlock (&shard->lock);
+
+    return ret;
+}
+
+bool c_concurrent_hash_table_contains (CConcurrentHashTable* hashTable, const void* key)
+{
+    c_return_val_if_fail (hashTable != NULL, false);
+
+    CConcurrentShard* shard = c_concurrent_hash_table_get_shard (hashTable, key);
+
+    c_rw_lock_reader_lock (&shard->lock);
+    bool ret = c_hash_table_contains (shard->table, key);
+    c_rw_lock_reader_unlock (&shard->lock);
+
+    return ret;
+}
+
+void c_concurrent_hash_table_foreach (CConcurrentHashTable* hashTable, CHFunc func, void* udata)
+{
+    c_return_if_fail (hashTable != NULL);
+    c_return_if_fail (func != NULL);
+
+    for (cuint i = 0; i < hashTable->nShards; ++i) {
+        CConcurrentShard* shard = &hashTable->shards[i];
+        c_rw_lock_reader_lock (&shard->lock);
+        c_hash_table_foreach (shard->table, func, udata);
+        c_rw_lock_reader_unlock (&shard->lock);
+    }
+}
+
+cuint c_concurrent_hash_table_size (CConcurrentHashTable* hashTable)
+{
+    cuint size = 0;
+
+    c_return_val_if_fail (hashTable != NULL, 0);
+
+    for (cuint i = 0; i < hashTable->nShards; ++i) {
+        CConcurrentShard* shard = &hashTable->shards[i];
+        c_rw_lock_reader_lock (&shard->lock);
+        size += c_hash_table_size (shard->table);
+        c_rw_lock_reader_unlock (&shard->lock);
+    }
+
+    return size;
+}
+
+cuint c_concurrent_hash_table_get_shards (CConcurrentHashTable* hashTable)
+{
+    c_return_val_if_fail (hashTable != NULL, 0);
+
+    return hashTable->nShards;
+}
+
+static inline CConcurrentShard* c_concurrent_hash_table_get_shard (CConcurrentHashTable* hashTable, const void* key)
+{
+    // 分片内的 flat 表用 hash 的另一组混合位定位槽位，这里取 c_hash_mix64 的高位，两者互不相关
+    if (64 == hashTable->shift) {
+        return hashTable->shards;
+    }
+
+    cuint64 h = c_hash_mix64 (hashTable->hashFunc (key));
+
+    return &hashTable->shards[h >> hashTable->shift];
+}
@@ -0,0 +1,103 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-20.
+//
+
+#ifndef CLIBRARY_CONCURRENT_HASH_TABLE_H
+#define CLIBRARY_CONCURRENT_HASH_TABLE_H
+
+#if !defined (__CLIB_H_INSIDE__) && !defined (CLIB_COMPILATION)
+#error "Only <clib.h> can be included directly."
+#endif
+
+#include <c/macros.h>
+#include <c/hash-table.h>
+
+C_BEGIN_EXTERN_C
+
+/**
+ * @brief 分片(lock striping)的线程安全 hash 表
+ *
+ * 表由 2^n 个分片组成，每个分片是一个独立的 CHashTable(flat)并由自己的 CRWLock 保护，
+ * key 通过 hash 值的高位选择分片：
+ *  - 查找只获取所在分片的读锁，不同分片、同一分片的多个读者互不阻塞；
+ *  - 写操作只获取所在分片的写锁，某个分片扩容时其它分片照常读写。
+ *
+ * keyDestroyFunc/valueDestroyFunc 以及 compute 回调均在分片锁内调用，回调中不能再访问同一个表。
+ */
+typedef struct _CConcurrentHashTable    CConcurrentHashTable;
+
+/**
+ * @brief compute 回调
+ * @param key 调用者传入的 key
+ * @param value 进入时为当前 value(不存在时为 NULL)，可以修改为新的 value
+ * @param exists key 是否已存在
+ * @return true 保存 *value(不存在则插入，存在则替换)；false 删除 key(不存在则什么都不做)
+ */
+typedef bool (*CConcurrentComputeFunc) (const void* key, void** value, bool exists, void* udata);
+
+
+/**
+ * @brief 创建分片 hash 表
+ * @param shards 分片数，向上取 2 的幂，为 0 时使用默认值(64)
+ */
+CConcurrentHashTable*   c_concurrent_hash_table_new                 (CHashFunc hashFunc, CEqualFunc keyEqualFunc, cuint shards);
+CConcurrentHashTable*   c_concurrent_hash_table_new_full            (CHashFunc hashFunc, CEqualFunc keyEqualFunc, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc, cuint shards);
+void                    c_concurrent_hash_table_destroy             (CConcurrentHashTable* hashTable);
+
+/**
+ * @brief 与 c_hash_table_insert/c_hash_table_replace/c_hash_table_remove 语义相同
+ */
+bool                    c_concurrent_hash_table_insert              (CConcurrentHashTable* hashTable, void* key, void* value);
+bool                    c_concurrent_hash_table_replace             (CConcurrentHashTable* hashTable, void* key, void* value);
+bool                    c_concurrent_hash_table_remove              (CConcurrentHashTable* hashTable, const void* key);
+bool                    c_concurrent_hash_table_steal_extended      (CConcurrentHashTable* hashTable, const void* lookupKey, void** stolenKey, void** stolenValue);
+void                    c_concurrent_hash_table_remove_all          (CConcurrentHashTable* hashTable);
+
+/**
+ * @brief key 不存在时插入并返回 true；已存在时不修改表，返回 false，并通过 existing 返回已有的 value
+ * @note 返回 false 时 key 与 value 的所有权仍属于调用者
+ */
+bool                    c_concurrent_hash_table_insert_if_absent    (CConcurrentHashTable* hashTable, void* key, void* value, void** existing);
+
+/**
+ * @brief 在分片写锁内对 key 执行 读-改-写，见 CConcurrentComputeFunc
+ * @return key 被保存到表中(新插入)时返回 true，否则 key 的所有权仍属于调用者
+ */
+bool                    c_concurrent_hash_table_compute             (CConcurrentHashTable* hashTable, void* key, CConcurrentComputeFunc func, void* udata);
+
+/**
+ * @brief 查找 value
+ * @note 返回后其它线程可能删除并释放该 value，value 生命周期不受表控制时使用 c_concurrent_hash_table_lookup_copy
+ */
+void*                   c_concurrent_hash_table_lookup              (CConcurrentHashTable* hashTable, const void* key);
+
+/**
+ * @brief 在读锁内对 value 调用 copyFunc(如增加引用计数、复制字符串)，返回其结果；key 不存在时返回 NULL
+ */
+void*                   c_concurrent_hash_table_lookup_copy         (CConcurrentHashTable* hashTable, const void* key, CCopyFunc copyFunc, void* udata);
+bool                    c_concurrent_hash_table_lookup_extended     (CConcurrentHashTable* hashTable, const void* lookupKey, void** origKey, void** value);
+bool                    c_concurrent_hash_table_contains            (CConcurrentHashTable* hashTable, const void* key);
+
+/**
+ * @brief 依次对每个分片加读锁并遍历，遍历期间其它分片可以被修改，结果不是整个表的快照
+ */
+void                    c_concurrent_hash_table_foreach             (CConcurrentHashTable* hashTable, CHFunc func, void* udata);
+
+/**
+ * @brief 各分片元素数之和，并发修改时只是近似值
+ */
+cuint                   c_concurrent_hash_table_size                (CConcurrentHashTable* hashTable);
+cuint                   c_concurrent_hash_table_get_shards          (CConcurrentHashTable* hashTable);
+
+C_END_EXTERN_C
+
+#endif //CLIBRARY_CONCURRENT_HASH_TABLE_H
@@ -0,0 +1,418 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-30.
+//
+
+#include "deque.h"
+
+#include "slice.h"
+
+#define DEQUE_MIN_CAPACITY          8
+
+// 第 i 个元素
+#define DEQUE_SLOT(deque, i)        ((deque)->data[((deque)->head + (i)) & ((deque)->capacity - 1)])
+
+typedef struct
+{
+    CCompareDataFunc    func;
+    void*               udata;
+} DequeSortData;
+
+
+/* 扩容到至少能存放 n 个元素，元素的逻辑顺序不变 */
+static void c_deque_grow (CDeque* deque, cuint n)
+{
+    const cuint oldCapacity = deque->capacity;
+
+    if (n <= oldCapacity) {
+        return;
+    }
+
+    const cuint capacity = (cuint) c_nearest_pow (C_MAX (n, DEQUE_MIN_CAPACITY));
+    deque->data = c_realloc (deque->data, capacity * sizeof (void*));
+    c_assert (deque->data);
+
+    // 回绕到数组开头的部分与尾部的部分中，移动较短的一段，使元素在新数组中连续
+    if (deque->head + deque->length > oldCapacity) {
+        const cuint wrapped = deque->head + deque->length - oldCapacity;
+        const cuint tail = oldCapacity - deque->head;
+        if (wrapped <= tail) {
+            memcpy (deque->data + oldCapacity, deque->data, wrapped * sizeof (void*));
+        }
+        else {
+            memcpy (deque->data + capacity - tail, deque->data + deque->head, tail * sizeof (void*));
+            deque->head = capacity - tail;
+        }
+    }
+
+    deque->capacity = capacity;
+}
+
+static cint c_deque_sort_compare (void* a, void* b, void* udata)
+{
+    const DequeSortData* sd = udata;
+
+    return sd->func (*(void**) a, *(void**) b, sd->udata);
+}
+
+CDeque* c_deque_new (void)
+{
+    return c_slice_new0 (CDeque);
+}
+
+CDeque* c_deque_sized_new (cuint reserved)
+{
+    CDeque* deque = c_deque_new ();
+
+    c_deque_grow (deque, reserved);
+
+    return deque;
+}
+
+void c_deque_free (CDeque* deque)
+{
+    c_return_if_fail (NULL != deque);
+
+    c_deque_clear (deque);
+    c_slice_free (CDeque, deque);
+}
+
+void c_deque_free_full (CDeque* deque, CDestroyNotify freeFunc)
+{
+    c_return_if_fail (NULL != deque);
+
+    c_deque_clear_full (deque, freeFunc);
+    c_slice_free (CDeque, deque);
+}
+
+void c_deque_init (CDeque* deque)
+{
+    c_return_if_fail (NULL != deque);
+
+    deque->data = NULL;
+    deque->head = 0;
+    deque->length = 0;
+    deque->capacity = 0;
+}
+
+void c_deque_clear (CDeque* deque)
+{
+    c_return_if_fail (NULL != deque);
+
+    c_free (deque->data);
+    c_deque_init (deque);
+}
+
+void c_deque_clear_full (CDeque* deque, CDestroyNotify freeFunc)
+{
+    c_return_if_fail (NULL != deque);
+
+    if (freeFunc) {
+        c_deque_foreach (deque, (CFunc) freeFunc, NULL);
+    }
+
+    c_deque_clear (deque);
+}
+
+void c_deque_reserve (CDeque* deque, cuint n)
+{
+    c_return_if_fail (NULL != deque);
+
+    c_deque_grow (deque, n);
+}
+
+bool c_deque_is_empty (CDeque* deque)
+{
+    c_return_val_if_fail (NULL != deque, true);
+
+    return 0 == deque->length;
+}
+
+cuint c_deque_get_length (CDeque* deque)
+{
+    c_return_val_if_fail (NULL != deque, 0);
+
+    return deque->length;
+}
+
+void c_deque_reverse (CDeque* deque)
+{
+    cuint i;
+
+    c_return_if_fail (NULL != deque);
+
+    for (i = 0; i < deque->length / 2; ++i) {
+        void* tmp = DEQUE_SLOT (deque, i);
+        DEQUE_SLOT (deque, i) = DEQUE_SLOT (deque, deque->length - 1 - i);
+        DEQUE_SLOT (deque, deque->length - 1 - i) = tmp;
+    }
+}
+
+CDeque* c_deque_copy (CDeque* deque)
+{
+    cuint i;
+
+    c_return_val_if_fail (NULL != deque, NULL);
+
+    CDeque* result = c_deque_sized_new (deque->length);
+    for (i = 0; i < deque->length; ++i) {
+        result->data[i] = DEQUE_SLOT (deque, i);
+    }
+    result->length = deque->length;
+
+    return result;
+}
+
+void c_deque_foreach (CDeque* deque, CFunc func, void* udata)
+{
+    cuint i;
+
+    c_return_if_fail (NULL != deque);
+    c_return_if_fail (NULL != func);
+
+    for (i = 0; i < deque->length; ++i) {
+        func (DEQUE_SLOT (deque, i), udata);
+    }
+}
+
+cint c_deque_find_custom (CDeque* deque, const void* data, CCompareFunc func)
+{
+    cuint i;
+
+    c_return_val_if_fail (NULL != deque, -1);
+    c_return_val_if_fail (NULL != func, -1);
+
+    for (i = 0; i < deque->length; ++i) {
+        if (0 == func (DEQUE_SLOT (deque, i), (void*) data)) {
+            return (cint) i;
+        }
+    }
+
+    return -1;
+}
+
+void c_deque_sort (CDeque* deque, CCompareDataFunc compareFunc, void* udata)
+{
+    cuint i;
+    DequeSortData sd = { compareFunc, udata };
+
+    c_return_if_fail (NULL != deque);
+    c_return_if_fail (NULL != compareFunc);
+
+    if (deque->length < 2) {
+        return;
+    }
+
+    // 先把元素放到从 0 开始的连续位置
+    if (0 != deque->head) {
+        void** data = c_malloc0 (deque->capacity * sizeof (void*));
+        for (i = 0; i < deque->length; ++i) {
+            data[i] = DEQUE_SLOT (deque, i);
+        }
+        c_free (deque->data);
+        deque->data = data;
+        deque->head = 0;
+    }
+
+    c_qsort_with_data (deque->data, (cint) deque->length, sizeof (void*), c_deque_sort_compare, &sd);
+}
+
+void c_deque_push_head (CDeque* deque, void* data)
+{
+    c_return_if_fail (NULL != deque);
+
+    if (C_UNLIKELY (deque->length == deque->capacity)) {
+        c_deque_grow (deque, deque->length + 1);
+    }
+
+    deque->head = (deque->head - 1) & (deque->capacity - 1);
+    deque->data[deque->head] = data;
+    deque->length++;
+}
+
+void c_deque_push_tail (CDeque* deque, void* data)
+{
+    c_return_if_fail (NULL != deque);
+
+    if (C_UNLIKELY (deque->length == deque->capacity)) {
+        c_deque_grow (deque, deque->length + 1);
+    }
+
+    DEQUE_SLOT (deque, deque->length) = data;
+    deque->length++;
+}
+
+void c_deque_push_nth (CDeque* deque, void* data, cint n)
+{
+    cuint i;
+
+    c_return_if_fail (NULL != deque);
+
+    if (n < 0 || (cuint) n >= deque->length) {
+        c_deque_push_tail (deque, data);
+        return;
+    }
+
+    if (C_UNLIKELY (deque->length == deque->capacity)) {
+        c_deque_grow (deque, deque->length + 1);
+    }
+
+    // 移动较短的一侧
+    if ((cuint) n < deque->length / 2) {
+        deque->head = (deque->head - 1) & (deque->capacity - 1);
+        for (i = 0; i < (cuint) n; ++i) {
+            DEQUE_SLOT (deque, i) = DEQUE_SLOT (deque, i + 1);
+        }
+    }
+    else {
+        for (i = deque->length; i > (cuint) n; --i) {
+            DEQUE_SLOT (deque, i) = DEQUE_SLOT (deque, i - 1);
+        }
+    }
+    DEQUE_SLOT (deque, n) = data;
+    deque->length++;
+}
+
+void* c_deque_pop_head (CDeque* deque)
+{
+    c_return_val_if_fail (NULL != deque, NULL);
+
+    if (0 == deque->length) {
+        return NULL;
+    }
+
+    void* data = deque->data[deque->head];
+    deque->head = (deque->head + 1) & (deque->capacity - 1);
+    deque->length--;
+
+    return data;
+}
+
+void* c_deque_pop_tail (CDeque* deque)
+{
+    c_return_val_if_fail (NULL != deque, NULL);
+
+    if (0 == deque->length) {
+        return NULL;
+    }
+
+    deque->length--;
+
+    return DEQUE_SLOT (deque, deque->length);
+}
+
+void* c_deque_pop_nth (CDeque* deque, cuint n)
+{
+    cuint i;
+
+    c_return_val_if_fail (NULL != deque, NULL);
+
+    if (n >= deque->length) {
+        return NULL;
+    }
+
+    void* data = DEQUE_SLOT (deque, n);
+    if (n < deque->length / 2) {
+        for (i = n; i > 0; --i) {
+            DEQUE_SLOT (deque, i) = DEQUE_SLOT (deque, i - 1);
+        }
+        deque->head = (deque->head + 1) & (deque->capacity - 1);
+    }
+    else {
+        for (i = n; i + 1 < deque->length; ++i) {
+            DEQUE_SLOT (deque, i) = DEQUE_SLOT (deque, i + 1);
+        }
+    }
+    deque->length--;
+
+    return data;
+}
+
+void* c_deque_peek_head (CDeque* deque)
+{
+    c_return_val_if_fail (NULL != deque, NULL);
+
+    return deque->length ? deque->data[deque->head] : NULL;
+}
+
+void* c_deque_peek_tail (CDeque* deque)
+{
+    c_return_val_if_fail (NULL != deque, NULL);
+
+    return deque->length ? DEQUE_SLOT (deque, deque->length - 1) : NULL;
+}
+
+void* c_deque_peek_nth (CDeque* deque, cuint n)
+{
+    c_return_val_if_fail (NULL != deque, NULL);
+
+    return (n < deque->length) ? DEQUE_SLOT (deque, n) : NULL;
+}
+
+void* c_deque_set_nth (CDeque* deque, cuint n, void* data)
+{
+    c_return_val_if_fail (NULL != deque, NULL);
+    c_return_val_if_fail (n < deque->length, NULL);
+
+    void* old = DEQUE_SLOT (deque, n);
+    DEQUE_SLOT (deque, n) = data;
+
+    return old;
+}
+
+cint c_deque_index (CDeque* deque, const void* data)
+{
+    cuint i;
+
+    c_return_val_if_fail (NULL != deque, -1);
+
+    for (i = 0; i < deque->length; ++i) {
+        if (DEQUE_SLOT (deque, i) == data) {
+            return (cint) i;
+        }
+    }
+
+    return -1;
+}
+
+bool c_deque_remove (CDeque* deque, const void* data)
+{
+    c_return_val_if_fail (NULL != deque, false);
+
+    const cint i = c_deque_index (deque, data);
+    if (i < 0) {
+        return false;
+    }
+
+    c_deque_pop_nth (deque, (cuint) i);
+
+    return true;
+}
+
+cuint c_deque_remove_all (CDeque* deque, const void* data)
+{
+    cuint i;
+    cuint n = 0;
+
+    c_return_val_if_fail (NULL != deque, 0);
+
+    for (i = 0; i < deque->length; ++i) {
+        if (DEQUE_SLOT (deque, i) != data) {
+            DEQUE_SLOT (deque, n) = DEQUE_SLOT (deque, i);
+            n++;
+        }
+    }
+
+    const cuint removed = deque->length - n;
+    deque->length = n;
+
+    return removed;
+}
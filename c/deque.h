@@ -0,0 +1,244 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-30.
+//
+
+#ifndef CLIBRARY_DEQUE_H
+#define CLIBRARY_DEQUE_H
+
+#if !defined (__CLIB_H_INSIDE__) && !defined (CLIB_COMPILATION)
+#error "Only <clib.h> can be included directly."
+#endif
+
+#include <c/macros.h>
+
+C_BEGIN_EXTERN_C
+
+/**
+ * @brief 双端队列，接口与 CQueue 对应(c_queue_xxx -> c_deque_xxx)
+ * @note 元素保存在容量为 2 的幂的环形数组中，头尾插入/删除均摊 O(1) 且不分配节点，按下标访问 O(1)；
+ *       中间插入/删除移动较短的一侧。容量只在 c_deque_clear 时释放。
+ *       与 CQueue 不同，不提供基于 CList 节点的接口(find 返回下标而不是节点)
+ */
+typedef struct _CDeque CDeque;
+
+struct _CDeque
+{
+    void**  data;
+    cuint   head;           // 第一个元素在 data 中的位置
+    cuint   length;
+    cuint   capacity;       // 0 或 2 的幂
+};
+
+#define C_DEQUE_INIT { NULL, 0, 0, 0 }
+
+/**
+ * @brief 创建一个 Deque
+ */
+CDeque*  c_deque_new                (void);
+
+/**
+ * @brief 创建一个 Deque，预留能存放 reserved 个元素的空间
+ * @param reserved
+ */
+CDeque*  c_deque_sized_new          (cuint reserved);
+
+/**
+ * @brief 释放整个 Deque
+ * @param deque
+ */
+void     c_deque_free               (CDeque* deque);
+
+/**
+ * @brief 对每个元素调用 freeFunc 后释放整个 Deque
+ * @param deque
+ * @param freeFunc
+ */
+void     c_deque_free_full          (CDeque* deque, CDestroyNotify freeFunc);
+
+/**
+ * @brief 初始化栈上或嵌入在结构体中的 Deque
+ * @param deque
+ */
+void     c_deque_init               (CDeque* deque);
+
+/**
+ * @brief 释放 Deque 的存储后重新初始化
+ * @param deque
+ */
+void     c_deque_clear              (CDeque* deque);
+
+/**
+ * @brief 对每个元素调用 freeFunc 后释放存储并重新初始化
+ * @param deque
+ * @param freeFunc
+ */
+void     c_deque_clear_full         (CDeque* deque, CDestroyNotify freeFunc);
+
+/**
+ * @brief 预留能存放 n 个元素的空间
+ * @param deque
+ * @param n
+ */
+void     c_deque_reserve            (CDeque* deque, cuint n);
+
+/**
+ * @brief 检测 Deque 是否为空
+ * @param deque
+ * @return
+ */
+bool     c_deque_is_empty           (CDeque* deque);
+
+/**
+ * @brief 元素个数
+ * @param deque
+ * @return
+ */
+cuint    c_deque_get_length         (CDeque* deque);
+
+/**
+ * @brief 元素反转
+ * @param deque
+ */
+void     c_deque_reverse            (CDeque* deque);
+
+/**
+ * @brief 复制一个 Deque
+ * @note 元素数据没有复制
+ * @param deque
+ * @return
+ */
+CDeque*  c_deque_copy               (CDeque* deque);
+
+/**
+ * @brief 按顺序对每个元素调用 func 函数
+ * @param deque
+ * @param func
+ * @param udata
+ */
+void     c_deque_foreach            (CDeque* deque, CFunc func, void* udata);
+
+/**
+ * @brief 使用自定义比较函数查找元素，func 返回 0 表示匹配
+ * @return 第一个匹配元素的位置，没有找到返回 -1
+ */
+cint     c_deque_find_custom        (CDeque* deque, const void* data, CCompareFunc func);
+
+/**
+ * @brief 稳定排序，compareFunc 的参数是元素本身
+ * @param deque
+ * @param compareFunc
+ * @param udata
+ */
+void     c_deque_sort               (CDeque* deque, CCompareDataFunc compareFunc, void* udata);
+
+/**
+ * @brief 头部插入
+ * @param deque
+ * @param data
+ */
+void     c_deque_push_head          (CDeque* deque, void* data);
+
+/**
+ * @brief 尾部插入
+ * @param deque
+ * @param data
+ */
+void     c_deque_push_tail          (CDeque* deque, void* data);
+
+/**
+ * @brief 插入到位置 n，n 为负数或不小于长度时插入到尾部
+ * @param deque
+ * @param data
+ * @param n
+ */
+void     c_deque_push_nth           (CDeque* deque, void* data, cint n);
+
+/**
+ * @brief 弹出第一个元素，为空时返回 NULL
+ * @param deque
+ * @return
+ */
+void*    c_deque_pop_head           (CDeque* deque);
+
+/**
+ * @brief 弹出最后一个元素，为空时返回 NULL
+ * @param deque
+ * @return
+ */
+void*    c_deque_pop_tail           (CDeque* deque);
+
+/**
+ * @brief 弹出位置 n 的元素，越界时返回 NULL
+ * @param deque
+ * @param n
+ * @return
+ */
+void*    c_deque_pop_nth            (CDeque* deque, cuint n);
+
+/**
+ * @brief 返回第一个元素
+ * @param deque
+ * @return
+ */
+void*    c_deque_peek_head          (CDeque* deque);
+
+/**
+ * @brief 返回最后一个元素
+ * @param deque
+ * @return
+ */
+void*    c_deque_peek_tail          (CDeque* deque);
+
+/**
+ * @brief 返回位置 n 的元素，越界时返回 NULL
+ * @param deque
+ * @param n
+ * @return
+ */
+void*    c_deque_peek_nth           (CDeque* deque, cuint n);
+
+/**
+ * @brief 替换位置 n 的元素，返回原来的元素
+ * @param deque
+ * @param n
+ * @param data
+ * @return
+ */
+void*    c_deque_set_nth            (CDeque* deque, cuint n, void* data);
+
+/**
+ * @brief 返回第一个 data 元素所在位置，没有找到返回 -1
+ * @param deque
+ * @param data
+ * @return
+ */
+cint     c_deque_index              (CDeque* deque, const void* data);
+
+/**
+ * @brief 删除第一个 data 元素，找到时返回 true
+ * @param deque
+ * @param data
+ * @return
+ */
+bool     c_deque_remove             (CDeque* deque, const void* data);
+
+/**
+ * @brief 删除所有 data 元素，返回删除的个数
+ * @param deque
+ * @param data
+ * @return
+ */
+cuint    c_deque_remove_all         (CDeque* deque, const void* data);
+
+C_END_EXTERN_C
+
+#endif //CLIBRARY_DEQUE_H
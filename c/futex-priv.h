@@ -0,0 +1,49 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-12-1.
+//
+
+#ifndef CLIBRARY_FUTEX_PRIV_H
+#define CLIBRARY_FUTEX_PRIV_H
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifndef FUTEX_WAIT_PRIVATE
+#define FUTEX_WAIT_PRIVATE FUTEX_WAIT
+#define FUTEX_WAKE_PRIVATE FUTEX_WAKE
+#endif
+
+#if defined(__NR_futex) && defined(__NR_futex_time64)
+#define c_futex_simple(uaddr, futex_op, ...) \
+    C_STMT_START { \
+        int res = syscall (__NR_futex_time64, uaddr, (csize) futex_op, __VA_ARGS__); \
+        if (res < 0 && errno == ENOSYS) { \
+            syscall (__NR_futex, uaddr, (csize) futex_op, __VA_ARGS__);              \
+        } \
+    } C_STMT_END
+#elif defined(__NR_futex_time64)
+#define c_futex_simple(uaddr, futex_op, ...) \
+    C_STMT_START { \
+        syscall (__NR_futex_time64, uaddr, (csize) futex_op, __VA_ARGS__); \
+    } C_STMT_END
+#elif defined(__NR_futex)
+#define c_futex_simple(uaddr, futex_op, ...) \
+    C_STMT_START { \
+        syscall (__NR_futex, uaddr, (csize) futex_op, __VA_ARGS__); \
+    } C_STMT_END
+#else /* !defined(__NR_futex) && !defined(__NR_futex_time64) */
+#error "Neither __NR_futex nor __NR_futex_time64 are defined but were found by meson"
+#endif /* defined(__NR_futex) && defined(__NR_futex_time64) */
+
+#endif //CLIBRARY_FUTEX_PRIV_H
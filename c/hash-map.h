@@ -0,0 +1,408 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-26.
+//
+
+#ifndef CLIBRARY_HASH_MAP_H
+#define CLIBRARY_HASH_MAP_H
+
+#if !defined (__CLIB_H_INSIDE__) && !defined (CLIB_COMPILATION)
+#error "Only <clib.h> can be included directly."
+#endif
+
+#include <c/macros.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+C_BEGIN_EXTERN_C
+
+/**
+ * 开放寻址(Swiss table)的公共部分，c_hash_table_new_flat() 创建的表与 C_DEFINE_HASH_MAP 生成的表共用:
+ * 每个槽位 1 字节控制位，空槽位 C_HASH_MAP_CTRL_EMPTY、墓碑 C_HASH_MAP_CTRL_DELETED、有元素时为 7 位标签；
+ * 控制位数组长度为 size + C_HASH_MAP_GROUP_WIDTH，末尾复制开头的一组，任意位置都能读取一整组；
+ * 按组做三角探测，负载因子不超过 7/8，元素数不足容量的 1/4 时收缩。
+ */
+#define C_HASH_MAP_MIN_SHIFT            4
+#define C_HASH_MAP_GROUP_WIDTH          16
+#define C_HASH_MAP_CTRL_EMPTY           ((cuint8) 0x80)
+#define C_HASH_MAP_CTRL_DELETED         ((cuint8) 0xFE)
+#define C_HASH_MAP_HASH_MUL             (0x9E3779B97F4A7C15ULL)
+#define C_HASH_MAP_H1(h_)               ((cuint) (((cuint64) (h_) * C_HASH_MAP_HASH_MUL) >> 25))     /* 起始探测位置 */
+#define C_HASH_MAP_H2(h_)               ((cuint8) (((cuint64) (h_) * C_HASH_MAP_HASH_MUL) >> 57))    /* 7 位标签 */
+#define C_HASH_MAP_CTRL_IS_FULL(c_)     (0 == ((c_) & 0x80))
+
+
+/**
+ * @brief murmur3 fmix64，c_hash_mix64() 的内联版本
+ */
+static inline cuint64 c_hash_map_mix64 (cuint64 x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return x;
+}
+
+/**
+ * @brief C_DEFINE_HASH_MAP 常用的整数 hash 与比较函数
+ */
+static inline cuint c_hash_map_int_hash (cint v)
+{
+    return (cuint) c_hash_map_mix64 ((cuint64) (cuint) v);
+}
+
+static inline bool c_hash_map_int_equal (cint v1, cint v2)
+{
+    return v1 == v2;
+}
+
+static inline cuint c_hash_map_int64_hash (cint64 v)
+{
+    return (cuint) c_hash_map_mix64 ((cuint64) v);
+}
+
+static inline bool c_hash_map_int64_equal (cint64 v1, cint64 v2)
+{
+    return v1 == v2;
+}
+
+/**
+ * @brief 返回组内控制位等于 tag 的槽位位图，第 k 位对应 group[k]
+ */
+static inline cuint c_hash_map_group_match (const cuint8* group, cuint8 tag)
+{
+#if defined(__SSE2__)
+    const __m128i ctrl = _mm_loadu_si128 ((const __m128i*) group);
+    return (cuint) _mm_movemask_epi8 (_mm_cmpeq_epi8 (ctrl, _mm_set1_epi8 ((char) tag)));
+#else
+    cuint i, bits = 0;
+    for (i = 0; i < C_HASH_MAP_GROUP_WIDTH; ++i) {
+        bits |= (cuint) (group[i] == tag) << i;
+    }
+    return bits;
+#endif
+}
+
+static inline cuint c_hash_map_group_match_empty (const cuint8* group)
+{
+    return c_hash_map_group_match (group, C_HASH_MAP_CTRL_EMPTY);
+}
+
+/**
+ * @brief 空槽位与墓碑的最高位都是 1
+ */
+static inline cuint c_hash_map_group_match_empty_or_deleted (const cuint8* group)
+{
+#if defined(__SSE2__)
+    return (cuint) _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i*) group));
+#else
+    cuint i, bits = 0;
+    for (i = 0; i < C_HASH_MAP_GROUP_WIDTH; ++i) {
+        bits |= (cuint) (group[i] >> 7) << i;
+    }
+    return bits;
+#endif
+}
+
+/**
+ * @brief 三角探测的下一组，组数是 2 的幂，能遍历所有组
+ */
+static inline cuint c_hash_map_probe_next (cuint pos, cuint* step, cuint mask)
+{
+    *step += C_HASH_MAP_GROUP_WIDTH;
+
+    return (pos + *step) & mask;
+}
+
+static inline void c_hash_map_set_ctrl (cuint8* ctrl, cuint mask, cuint index, cuint8 c)
+{
+    ctrl[index] = c;
+    /* 开头 C_HASH_MAP_GROUP_WIDTH 个槽位同时写入末尾的副本，其它槽位写入的是自身 */
+    ctrl[((index - C_HASH_MAP_GROUP_WIDTH) & mask) + C_HASH_MAP_GROUP_WIDTH] = c;
+}
+
+/**
+ * @brief hash 探测序列上第一个空槽位(onlyEmpty)或空槽位/墓碑，负载因子保证一定存在
+ */
+static inline cuint c_hash_map_find_free (const cuint8* ctrl, cuint mask, cuint hash, bool onlyEmpty)
+{
+    cuint bits;
+    cuint step = 0;
+    cuint pos = C_HASH_MAP_H1 (hash) & mask;
+
+    while (0 == (bits = (onlyEmpty ? c_hash_map_group_match_empty (ctrl + pos) : c_hash_map_group_match_empty_or_deleted (ctrl + pos)))) {
+        pos = c_hash_map_probe_next (pos, &step, mask);
+    }
+
+    return (pos + (cuint) __builtin_ctz (bits)) & mask;
+}
+
+/**
+ * @brief 已占用(元素 + 墓碑) noccupied 个槽位时是否需要扩容
+ */
+static inline bool c_hash_map_is_full (csize size, csize noccupied)
+{
+    return noccupied >= size - size / 8;
+}
+
+static inline bool c_hash_map_should_shrink (csize size, csize nodes)
+{
+    return size > nodes * 4 && size > (1 << C_HASH_MAP_MIN_SHIFT);
+}
+
+/**
+ * @brief 容纳 nodes 个元素时的容量: 大于 nodes * 4 / 3 的最小 2 的幂
+ */
+static inline cuint c_hash_map_size_for (cuint nodes)
+{
+    cuint shift = C_HASH_MAP_MIN_SHIFT;
+    const cuint64 n = (cuint64) nodes * 4 / 3;
+
+    while (((cuint64) 1 << shift) <= n) {
+        ++shift;
+    }
+
+    return 1U << shift;
+}
+
+/**
+ * @brief 生成键值类型固定的开放寻址哈希表，键值直接保存在数组中，hash 与比较函数内联调用
+ *
+ * @param TypeName 生成的结构体类型名
+ * @param type_name 生成的函数前缀
+ * @param KeyType 键类型，按值传递与保存
+ * @param ValueType 值类型，按值保存
+ * @param hashFunc cuint (*) (KeyType key)，可以是函数或宏
+ * @param equalFunc bool (*) (KeyType a, KeyType b)，可以是函数或宏
+ *
+ * 生成的函数(均为 static inline):
+ *  - void        type_name_init       (TypeName* map)                      初始化，TypeName map = {0} 等价
+ *  - void        type_name_clear      (TypeName* map)                      释放存储，之后可继续使用
+ *  - cuint       type_name_size       (const TypeName* map)
+ *  - void        type_name_reserve    (TypeName* map, cuint n)             预留 n 个元素的容量，收缩不会低于 n
+ *  - bool        type_name_insert     (TypeName* map, KeyType, ValueType)  key 已存在时替换值并返回 false
+ *  - ValueType*  type_name_lookup     (const TypeName* map, KeyType)       返回值所在位置，下次修改前有效；不存在返回 NULL
+ *  - bool        type_name_contains   (const TypeName* map, KeyType)
+ *  - bool        type_name_remove     (TypeName* map, KeyType, ValueType* value) value 可为 NULL
+ *  - void        type_name_remove_all (TypeName* map)
+ *  - bool        type_name_next       (const TypeName* map, cuint* index, KeyType* key, ValueType* value)
+ *                                      遍历，*index 从 0 开始，遍历期间不能修改
+ *
+ * 不保存 hash 值，扩容时重新调用 hashFunc；键值不需要释放，表中不保存指针所有权。
+ */
+#define C_DEFINE_HASH_MAP(TypeName, type_name, KeyType, ValueType, hashFunc, equalFunc) \
+typedef struct \
+{ \
+    cuint               size; \
+    cuint               mask; \
+    cuint               nnodes; \
+    cuint               noccupied; \
+    cuint               reserved; \
+    cuint8*             ctrl; \
+    KeyType*            keys; \
+    ValueType*          values; \
+} TypeName; \
+\
+static inline void type_name ## _init (TypeName* map) \
+{ \
+    memset (map, 0, sizeof (TypeName)); \
+} \
+\
+static inline void type_name ## _clear (TypeName* map) \
+{ \
+    c_free (map->ctrl); \
+    c_free (map->keys); \
+    c_free (map->values); \
+    type_name ## _init (map); \
+} \
+\
+static inline cuint type_name ## _size (const TypeName* map) \
+{ \
+    return map->nnodes; \
+} \
+\
+static inline void type_name ## _resize (TypeName* map, cuint nodes) \
+{ \
+    cuint i; \
+    const cuint oldSize = map->size; \
+    cuint8* oldCtrl = map->ctrl; \
+    KeyType* oldKeys = map->keys; \
+    ValueType* oldValues = map->values; \
+\
+    map->size = c_hash_map_size_for (nodes); \
+    map->mask = map->size - 1; \
+    map->ctrl = (cuint8*) c_malloc0 (map->size + C_HASH_MAP_GROUP_WIDTH); \
+    map->keys = (KeyType*) c_malloc0 (sizeof (KeyType) * map->size); \
+    map->values = (ValueType*) c_malloc0 (sizeof (ValueType) * map->size); \
+    memset (map->ctrl, C_HASH_MAP_CTRL_EMPTY, map->size + C_HASH_MAP_GROUP_WIDTH); \
+\
+    for (i = 0; i < oldSize; ++i) { \
+        if (C_HASH_MAP_CTRL_IS_FULL (oldCtrl[i])) { \
+            const cuint hash = hashFunc (oldKeys[i]); \
+            const cuint index = c_hash_map_find_free (map->ctrl, map->mask, hash, true); \
+            c_hash_map_set_ctrl (map->ctrl, map->mask, index, C_HASH_MAP_H2 (hash)); \
+            map->keys[index] = oldKeys[i]; \
+            map->values[index] = oldValues[i]; \
+        } \
+    } \
+    map->noccupied = map->nnodes; \
+\
+    c_free (oldCtrl); \
+    c_free (oldKeys); \
+    c_free (oldValues); \
+} \
+\
+static inline void type_name ## _maybe_resize (TypeName* map) \
+{ \
+    const cuint nodes = C_MAX (map->nnodes, map->reserved); \
+    if (c_hash_map_should_shrink (map->size, nodes) || c_hash_map_is_full (map->size, map->noccupied)) { \
+        type_name ## _resize (map, nodes); \
+    } \
+} \
+\
+static inline void type_name ## _reserve (TypeName* map, cuint n) \
+{ \
+    map->reserved = n; \
+    if (NULL == map->ctrl || c_hash_map_is_full (map->size, (csize) n + (map->noccupied - map->nnodes))) { \
+        type_name ## _resize (map, C_MAX (map->nnodes, n)); \
+    } \
+} \
+\
+/* 找到 key 返回 true；否则 *index 为探测序列上第一个空槽位或墓碑 */ \
+static inline bool type_name ## _find (const TypeName* map, KeyType key, cuint hash, cuint* index) \
+{ \
+    cuint bits; \
+    cuint step = 0; \
+    bool haveInsertIndex = false; \
+    const cuint8 tag = C_HASH_MAP_H2 (hash); \
+    cuint pos = C_HASH_MAP_H1 (hash) & map->mask; \
+\
+    for (;;) { \
+        const cuint8* group = map->ctrl + pos; \
+        for (bits = c_hash_map_group_match (group, tag); bits; bits &= bits - 1) { \
+            const cuint nodeIndex = (pos + (cuint) __builtin_ctz (bits)) & map->mask; \
+            if (C_LIKELY (equalFunc (map->keys[nodeIndex], key))) { \
+                *index = nodeIndex; \
+                return true; \
+            } \
+        } \
+        if (!haveInsertIndex) { \
+            bits = c_hash_map_group_match_empty_or_deleted (group); \
+            if (bits) { \
+                *index = (pos + (cuint) __builtin_ctz (bits)) & map->mask; \
+                haveInsertIndex = true; \
+            } \
+        } \
+        if (c_hash_map_group_match_empty (group)) { \
+            return false; \
+        } \
+        pos = c_hash_map_probe_next (pos, &step, map->mask); \
+    } \
+} \
+\
+static inline bool type_name ## _insert (TypeName* map, KeyType key, ValueType value) \
+{ \
+    cuint index = 0; \
+    const cuint hash = hashFunc (key); \
+\
+    if (C_UNLIKELY (NULL == map->ctrl)) { \
+        type_name ## _resize (map, map->reserved); \
+    } \
+\
+    if (type_name ## _find (map, key, hash, &index)) { \
+        map->values[index] = value; \
+        return false; \
+    } \
+\
+    if (map->ctrl[index] == C_HASH_MAP_CTRL_EMPTY) { \
+        map->noccupied++; \
+    } \
+    c_hash_map_set_ctrl (map->ctrl, map->mask, index, C_HASH_MAP_H2 (hash)); \
+    map->keys[index] = key; \
+    map->values[index] = value; \
+    map->nnodes++; \
+    type_name ## _maybe_resize (map); \
+\
+    return true; \
+} \
+\
+static inline ValueType* type_name ## _lookup (const TypeName* map, KeyType key) \
+{ \
+    cuint index = 0; \
+\
+    if (C_UNLIKELY (0 == map->nnodes)) { \
+        return NULL; \
+    } \
+\
+    return type_name ## _find (map, key, hashFunc (key), &index) ? &map->values[index] : NULL; \
+} \
+\
+static inline bool type_name ## _contains (const TypeName* map, KeyType key) \
+{ \
+    return NULL != type_name ## _lookup (map, key); \
+} \
+\
+static inline bool type_name ## _remove (TypeName* map, KeyType key, ValueType* value) \
+{ \
+    cuint index = 0; \
+\
+    if (0 == map->nnodes || !type_name ## _find (map, key, hashFunc (key), &index)) { \
+        return false; \
+    } \
+\
+    if (value) { \
+        *value = map->values[index]; \
+    } \
+    c_hash_map_set_ctrl (map->ctrl, map->mask, index, C_HASH_MAP_CTRL_DELETED); \
+    map->nnodes--; \
+    type_name ## _maybe_resize (map); \
+\
+    return true; \
+} \
+\
+static inline void type_name ## _remove_all (TypeName* map) \
+{ \
+    if (NULL == map->ctrl) { \
+        return; \
+    } \
+    memset (map->ctrl, C_HASH_MAP_CTRL_EMPTY, map->size + C_HASH_MAP_GROUP_WIDTH); \
+    map->nnodes = 0; \
+    map->noccupied = 0; \
+    type_name ## _maybe_resize (map); \
+} \
+\
+static inline bool type_name ## _next (const TypeName* map, cuint* index, KeyType* key, ValueType* value) \
+{ \
+    for (; *index < map->size; ++(*index)) { \
+        if (C_HASH_MAP_CTRL_IS_FULL (map->ctrl[*index])) { \
+            if (key) { \
+                *key = map->keys[*index]; \
+            } \
+            if (value) { \
+                *value = map->values[*index]; \
+            } \
+            ++(*index); \
+            return true; \
+        } \
+    } \
+\
+    return false; \
+}
+
+
+C_END_EXTERN_C
+
+#endif //CLIBRARY_HASH_MAP_H
@@ -13,7 +13,12 @@
 
 #include "hash-table.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "utils.h"
 #include "atomic.h"
+#include "hash-map.h"
 
 // 1 << 3 == 8 buckets
 #define HASH_TABLE_MIN_SHIFT        3
@@ -24,12 +29,46 @@
 #define HASH_IS_UNUSED(h_)          ((h_) == UNUSED_HASH_VALUE)
 #define HASH_IS_TOMBSTONE(h_)       ((h_) == TOMBSTONE_HASH_VALUE)
 
+/**
+ * flat 表(c_hash_table_new_flat): 在 hashes/keys/values 之外为每个槽位保存 1 字节控制位，
+ * 控制位格式、分组探测与负载因子与 C_DEFINE_HASH_MAP 共用(hash-map.h)，只有 7 位标签相同的槽位才比较 key。
+ * hashes[] 仍然保存完整 hash 值与 UNUSED/TOMBSTONE 状态，遍历、迭代器与扩容共用原有逻辑。
+ */
+
+/**
+ * 渐进式扩容(c_hash_table_set_incremental_resize): 扩容时保留旧存储，新存储从空表开始，
+ * 之后每次插入/删除至少迁移 INCREMENTAL_STEP 个旧槽位，迁移完成前查找依次检查新、旧存储。
+ * 每个元素只存在于其中一个存储中；旧存储只删除(迁移后留下墓碑)不插入，原有的探测序列始终有效。
+ * 每次写操作最多占用新存储的一个槽位，每步迁移的槽位数按新存储的剩余空间计算，保证新存储装满之前迁移完成；
+ * 收缩(新存储可能远小于旧存储)总是立即完成。
+ */
+#define INCREMENTAL_MIN_SIZE        (1 << 12)
+#define INCREMENTAL_STEP            64
+#define INCREMENTAL_NOT_FOUND       ((cuint) -1)
+
+/* 批量接口每批先计算 hash 并预取槽位，再依次探测 */
+#define BATCH_SIZE                  16
+
+/* 编译时定义 C_HASH_TABLE_PROBE_STATS 后统计每次查找的探测次数(普通表按槽位，flat 表按组)，结果见 c_hash_table_get_stats */
+#ifdef C_HASH_TABLE_PROBE_STATS
+// 并发表的读者在分片读锁下并行查找，计数必须原子递增
+#define PROBE_STATS_LOOKUP(h_)      ((void) __atomic_fetch_add (&(h_)->nlookups, 1, __ATOMIC_RELAXED))
+#define PROBE_STATS_PROBE(h_)       ((void) __atomic_fetch_add (&(h_)->nprobes, 1, __ATOMIC_RELAXED))
+#else
+#define PROBE_STATS_LOOKUP(h_)      ((void) 0)
+#define PROBE_STATS_PROBE(h_)       ((void) 0)
+#endif
+
 #define BIG_ENTRY_SIZE              (SIZEOF_VOID_P)
 #define SMALL_ENTRY_SIZE            (SIZEOF_INT)
 
-//#if SMALL_ENTRY_SIZE < BIG_ENTRY_SIZE
-//#endif
-#undef USE_SMALL_ARRAYS
+/**
+ * 新建的表用 4 字节槽位保存 key/value(适合 C_UINT_TO_POINTER 存入的整数)，
+ * 第一次存入高 32 位非 0 的指针时才把对应数组扩展为 8 字节槽位，之后不再缩回
+ */
+#if SMALL_ENTRY_SIZE < BIG_ENTRY_SIZE
+#define USE_SMALL_ARRAYS
+#endif
 
 #define DEFINE_RESIZE_FUNC(fname) \
 static void fname (CHashTable* hashTable, cuint oldSize, cuint32* reallocatedBucketsBitmap) \
@@ -50,13 +89,7 @@ static void fname (CHashTable* hashTable, cuint oldSize, cuint32* reallocatedBuc
         for (;;) { \
             cuint hashVal; \
             cuint replacedHash; \
-            cuint step = 0; \
-            hashVal = c_hash_table_hash_to_index (hashTable, nodeHash); \
-            while (get_status_bit (reallocatedBucketsBitmap, hashVal)) { \
-                step++; \
-                hashVal += step; \
-                hashVal &= hashTable->mask; \
-            } \
+            hashVal = c_hash_table_first_unallocated_node (hashTable, nodeHash, reallocatedBucketsBitmap); \
             set_status_bit (reallocatedBucketsBitmap, hashVal); \
             replacedHash = hashTable->hashes[hashVal]; \
             hashTable->hashes[hashVal] = nodeHash; \
@@ -71,20 +104,43 @@ static void fname (CHashTable* hashTable, cuint oldSize, cuint32* reallocatedBuc
 }
 
 
+typedef struct
+{
+    csize               size;
+    cint                mod;
+    cuint               mask;
+    cuint               nnodes;     /* 尚未迁移的元素数 */
+    csize               migrated;   /* 下一个待迁移的槽位 */
+    csize               step;       /* 每次写操作迁移的槽位数，不小于 INCREMENTAL_STEP */
+    bool                haveBigKeys;
+    bool                haveBigValues;
+
+    void*               keys;
+    cuint*              hashes;
+    void*               values;
+    cuint8*             ctrl;
+} OldStorage;
+
 struct _CHashTable
 {
     csize               size;
     cint                mod;
     cuint               mask;
-    cuint               nnodes;
-    cuint               noccupied;  /* nnodes + tombstones */
+    cuint               nnodes;     /* 包括旧存储中尚未迁移的元素 */
+    cuint               noccupied;  /* nnodes + tombstones，只统计当前存储 */
+    cuint               reserved;   /* c_hash_table_reserve 预留的元素数，收缩时不低于该值 */
+    cuint               resizeCount;
 
     cuint               haveBigKeys : 1;
     cuint               haveBigValues : 1;
+    cuint               flat : 1;
+    cuint               incremental : 1;
 
     void*               keys;
     cuint*              hashes;
     void*               values;
+    cuint8*             ctrl;       /* 仅 flat 表使用 */
+    OldStorage*         old;        /* 仅渐进式扩容过程中使用 */
 
     CHashFunc           hashFunc;
     CEqualFunc          keyEqualFunc;
@@ -92,6 +148,10 @@ struct _CHashTable
     int                 version;
     CDestroyNotify      keyDestroyFunc;
     CDestroyNotify      valueDestroyFunc;
+#ifdef C_HASH_TABLE_PROBE_STATS
+    cuint64             nlookups;
+    cuint64             nprobes;
+#endif
 };
 
 typedef struct
@@ -106,7 +166,29 @@ typedef struct
 
 
 static int c_hash_table_find_closest_shift (int n);
-static void c_hash_table_resize (CHashTable* hashTable);
+static void c_hash_table_resize (CHashTable* hashTable, cuint nodes);
+static void c_hash_table_resize_flat (CHashTable* hashTable, cuint nodes);
+static void c_hash_table_resize_incremental (CHashTable* hashTable, cuint nodes);
+static inline bool c_hash_table_is_full (CHashTable* hashTable, csize noccupied);
+static void c_hash_table_resize_now (CHashTable* hashTable, cuint nodes);
+static inline cuint c_hash_table_hash_key (CHashTable* hashTable, const void* key);
+static inline void c_hash_table_prefetch_node (CHashTable* hashTable, cuint hashValue);
+static inline cuint c_hash_table_lookup_node_with_hash (CHashTable* hashTable, const void* key, cuint hashValue);
+static void c_hash_table_alloc_storage (CHashTable* hashTable, bool isASet);
+static void c_hash_table_migrate_all (CHashTable* hashTable);
+static void c_hash_table_migrate_step (CHashTable* hashTable, csize buckets);
+static void c_hash_table_migrate_node (CHashTable* hashTable, cuint oldIndex, cuint nodeIndex);
+static void c_hash_table_free_old (CHashTable* hashTable, bool notify);
+static cuint c_hash_table_lookup_old (CHashTable* hashTable, const void* key, cuint hashValue);
+static inline cuint c_hash_table_find_free_node (CHashTable* hashTable, cuint hashValue);
+static inline cuint c_hash_table_first_unallocated_node (CHashTable* hashTable, cuint hashValue, const cuint32* bitmap);
+static void c_hash_table_rehash_in_place (CHashTable* hashTable);
+static void c_hash_table_collect_probe_stats (CHashTableStats* stats, const cuint* hashes, csize size, bool flat, cint mod, cuint mask, cuint64* total);
+static inline cuint c_hash_table_lookup_node_for_write (CHashTable* hashTable, const void* key, cuint* hashReturn);
+static inline void flat_set_ctrl (CHashTable* hashTable, cuint index, cuint8 ctrl);
+static inline bool c_hash_table_node_is_real (CHashTable* hashTable, cuint index);
+static CHashTable* c_hash_table_new_internal (CHashFunc hashFunc, CEqualFunc keyEqualFunc, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc, bool flat);
+static inline cuint c_hash_table_lookup_node_flat (CHashTable* hashTable, const void* key, cuint hashValue);
 static void iter_remove_or_steal (RealIter* ri, bool notify);
 static void c_hash_table_setup_storage (CHashTable* hashTable);
 static void realloc_arrays (CHashTable* hashTable, bool isASet);
@@ -121,7 +203,7 @@ static inline cuint c_hash_table_hash_to_index (CHashTable* hashTable, cuint has
 static void* c_hash_table_evict_key_or_value (void* a, cuint index, bool isBig, void* v);
 static void c_hash_table_assign_key_or_value (void* a, cuint index, bool isBig, void* v);
 static bool c_hash_table_remove_internal (CHashTable* hashTable, const void* key, bool notify);
-static void* c_hash_table_realloc_key_or_value_array (void* a, cuint size, C_UNUSED bool isBig);
+static void* c_hash_table_realloc_key_or_value_array (void* a, cuint size, bool isBig);
 static void c_hash_table_remove_all_nodes (CHashTable* hashTable, bool notify, bool destruction);
 static inline void c_hash_table_ensure_keyval_fits (CHashTable* hashTable, void* key, void* value);
 static inline cuint c_hash_table_lookup_node (CHashTable* hashTable, const void* key, cuint* hashReturn);
@@ -130,6 +212,14 @@ static cuint c_hash_table_foreach_remove_or_steal (CHashTable* hashTable, CHRFun
 static bool c_hash_table_insert_node (CHashTable* hashTable, cuint nodeIndex, cuint keyHash, void* newKey, void* newValue, bool keepNewKey, bool reusingKey);
 
 
+/* wyhash(final4 算法) 使用的常量 */
+static const cuint64 gsHashSecret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+static cuint64 gsHashSeed = 0;
+static bool gsHashSeedUsed = false;         // 种子已被 hash 函数或 quark 表使用，之后不允许再修改
+
 static const cint gsPrimeMod [] =
     {
         1,          /* For 1 << 0 */
@@ -204,26 +294,185 @@ CHashTable* c_hash_table_new (CHashFunc hashFunc, CEqualFunc keyEqualFunc)
 
 CHashTable* c_hash_table_new_full (CHashFunc hashFunc, CEqualFunc keyEqualFunc, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc)
 {
-    CHashTable* hashTable = c_malloc0(sizeof(CHashTable));
-    c_atomic_ref_count_init (&hashTable->refCount);
-    hashTable->nnodes             = 0;
-    hashTable->noccupied          = 0;
-    hashTable->hashFunc           = hashFunc ? hashFunc : c_direct_hash;
-    hashTable->keyEqualFunc       = keyEqualFunc;
-    hashTable->version            = 0;
-    hashTable->keyDestroyFunc     = keyDestroyFunc;
-    hashTable->valueDestroyFunc   = valueDestroyFunc;
+    return c_hash_table_new_internal (hashFunc, keyEqualFunc, keyDestroyFunc, valueDestroyFunc, false);
+}
 
-    c_hash_table_setup_storage (hashTable);
+CHashTable* c_hash_table_new_flat (CHashFunc hashFunc, CEqualFunc keyEqualFunc)
+{
+    return c_hash_table_new_internal (hashFunc, keyEqualFunc, NULL, NULL, true);
+}
 
-    return hashTable;
+CHashTable* c_hash_table_new_flat_full (CHashFunc hashFunc, CEqualFunc keyEqualFunc, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc)
+{
+    return c_hash_table_new_internal (hashFunc, keyEqualFunc, keyDestroyFunc, valueDestroyFunc, true);
 }
 
 CHashTable* c_hash_table_new_similar (CHashTable* otherHashTable)
 {
     c_return_val_if_fail (otherHashTable, NULL);
 
-    return c_hash_table_new_full (otherHashTable->hashFunc, otherHashTable->keyEqualFunc, otherHashTable->keyDestroyFunc, otherHashTable->valueDestroyFunc);
+    CHashTable* hashTable = c_hash_table_new_internal (otherHashTable->hashFunc, otherHashTable->keyEqualFunc, otherHashTable->keyDestroyFunc, otherHashTable->valueDestroyFunc, otherHashTable->flat);
+    hashTable->incremental = otherHashTable->incremental;
+    if (otherHashTable->reserved > 0) {
+        c_hash_table_reserve (hashTable, otherHashTable->reserved);
+    }
+
+    return hashTable;
+}
+
+void c_hash_table_set_incremental_resize (CHashTable* hashTable, bool incremental)
+{
+    c_return_if_fail (hashTable != NULL);
+
+    hashTable->incremental = incremental;
+    if (!incremental && hashTable->old) {
+        c_hash_table_migrate_all (hashTable);
+    }
+}
+
+void c_hash_table_reserve (CHashTable* hashTable, cuint n)
+{
+    c_return_if_fail (hashTable != NULL);
+
+    hashTable->reserved = n;
+    if (hashTable->old) {
+        c_hash_table_migrate_all (hashTable);
+    }
+
+    // 墓碑同样占用槽位，扩容时会一并清理
+    if (c_hash_table_is_full (hashTable, (csize) n + (hashTable->noccupied - hashTable->nnodes))) {
+        c_hash_table_resize_now (hashTable, C_MAX (hashTable->nnodes, n));
+    }
+}
+
+cuint c_hash_table_insert_many (CHashTable* hashTable, void** keys, void** values, cuint n)
+{
+    cuint i, j;
+    cuint inserted = 0;
+    cuint hashValues[BATCH_SIZE];
+
+    c_return_val_if_fail (hashTable != NULL, 0);
+    c_return_val_if_fail (keys != NULL || 0 == n, 0);
+
+    if (hashTable->incremental) {
+        // 渐进式扩容的表不一次扩容到位，逐个插入
+        for (i = 0; i < n; ++i) {
+            inserted += c_hash_table_insert_internal (hashTable, keys[i], values ? values[i] : keys[i], false);
+        }
+        return inserted;
+    }
+
+    // 一次扩容到位；插入期间临时预留，避免表在装入前几个元素时被收缩
+    const cuint reserved = hashTable->reserved;
+    hashTable->reserved = C_MAX (reserved, hashTable->nnodes + n);
+    if (c_hash_table_is_full (hashTable, (csize) hashTable->noccupied + n)) {
+        cuint nodes = hashTable->reserved;
+        if (c_hash_table_is_full (hashTable, (csize) hashTable->nnodes + n)) {
+            // 真正需要扩容时至少按常规扩容的倍数增长，反复小批量插入不会每次都重新分配
+            nodes = C_MAX (nodes, (cuint) (hashTable->size - hashTable->size / 8));
+        }
+        c_hash_table_resize_now (hashTable, nodes);
+    }
+
+    for (i = 0; i < n; i += BATCH_SIZE) {
+        const cuint m = C_MIN (BATCH_SIZE, n - i);
+        for (j = 0; j < m; ++j) {
+            hashValues[j] = c_hash_table_hash_key (hashTable, keys[i + j]);
+            c_hash_table_prefetch_node (hashTable, hashValues[j]);
+        }
+        for (j = 0; j < m; ++j) {
+            void* key = keys[i + j];
+            const cuint nodeIndex = c_hash_table_lookup_node_with_hash (hashTable, key, hashValues[j]);
+            inserted += c_hash_table_insert_node (hashTable, nodeIndex, hashValues[j], key, values ? values[i + j] : key, false, false);
+        }
+    }
+
+    hashTable->reserved = reserved;
+
+    return inserted;
+}
+
+cuint c_hash_table_lookup_many (CHashTable* hashTable, void** keys, cuint n, void** values)
+{
+    cuint i, j;
+    cuint found = 0;
+    cuint hashValues[BATCH_SIZE];
+
+    c_return_val_if_fail (hashTable != NULL, 0);
+    c_return_val_if_fail ((keys != NULL && values != NULL) || 0 == n, 0);
+
+    for (i = 0; i < n; i += BATCH_SIZE) {
+        const cuint m = C_MIN (BATCH_SIZE, n - i);
+        for (j = 0; j < m; ++j) {
+            hashValues[j] = c_hash_table_hash_key (hashTable, keys[i + j]);
+            c_hash_table_prefetch_node (hashTable, hashValues[j]);
+        }
+        for (j = 0; j < m; ++j) {
+            cuint nodeIndex = c_hash_table_lookup_node_with_hash (hashTable, keys[i + j], hashValues[j]);
+            if (C_LIKELY (c_hash_table_node_is_real (hashTable, nodeIndex))) {
+                values[i + j] = c_hash_table_fetch_key_or_value (hashTable->values, nodeIndex, hashTable->haveBigValues);
+                ++found;
+                continue;
+            }
+            values[i + j] = NULL;
+            if (C_UNLIKELY (hashTable->old != NULL)) {
+                nodeIndex = c_hash_table_lookup_old (hashTable, keys[i + j], hashValues[j]);
+                if (nodeIndex != INCREMENTAL_NOT_FOUND) {
+                    values[i + j] = c_hash_table_fetch_key_or_value (hashTable->old->values, nodeIndex, hashTable->old->haveBigValues);
+                    ++found;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+void c_hash_table_get_stats (CHashTable* hashTable, CHashTableStats* stats)
+{
+    cuint64 total = 0;
+
+    c_return_if_fail (hashTable != NULL);
+    c_return_if_fail (stats != NULL);
+
+    memset (stats, 0, sizeof (CHashTableStats));
+
+    const cuint oldNodes = hashTable->old ? hashTable->old->nnodes : 0;
+    stats->size = (cuint) hashTable->size;
+    stats->nnodes = hashTable->nnodes;
+    stats->ntombstones = hashTable->noccupied - (hashTable->nnodes - oldNodes);
+    stats->loadFactor = (double) hashTable->nnodes / (double) hashTable->size;
+    stats->tombstoneRatio = (double) stats->ntombstones / (double) hashTable->size;
+    stats->resizeCount = hashTable->resizeCount;
+
+    c_hash_table_collect_probe_stats (stats, hashTable->hashes, hashTable->size, hashTable->flat, hashTable->mod, hashTable->mask, &total);
+    if (hashTable->old) {
+        const OldStorage* old = hashTable->old;
+        c_hash_table_collect_probe_stats (stats, old->hashes, old->size, hashTable->flat, old->mod, old->mask, &total);
+    }
+    stats->avgProbeLength = hashTable->nnodes ? (double) total / (double) hashTable->nnodes : 0.0;
+
+#ifdef C_HASH_TABLE_PROBE_STATS
+    stats->lookups = __atomic_load_n (&hashTable->nlookups, __ATOMIC_RELAXED);
+    stats->probes = __atomic_load_n (&hashTable->nprobes, __ATOMIC_RELAXED);
+#endif
+}
+
+void c_hash_table_purge_tombstones (CHashTable* hashTable)
+{
+    c_return_if_fail (hashTable != NULL);
+
+    if (hashTable->old) {
+        c_hash_table_migrate_all (hashTable);
+    }
+
+    if (hashTable->noccupied == hashTable->nnodes) {
+        return;
+    }
+
+    hashTable->resizeCount++;
+    hashTable->version++;
+    c_hash_table_rehash_in_place (hashTable);
 }
 
 void c_hash_table_destroy (CHashTable* hashTable)
@@ -277,9 +526,9 @@ bool c_hash_table_steal_extended (CHashTable* hashTable, const void* lookupKey,
 
     c_return_val_if_fail (hashTable != NULL, false);
 
-    nodeIndex = c_hash_table_lookup_node (hashTable, lookupKey, &nodeHash);
+    nodeIndex = c_hash_table_lookup_node_for_write (hashTable, lookupKey, &nodeHash);
 
-    if (!HASH_IS_REAL (hashTable->hashes[nodeIndex])) {
+    if (!c_hash_table_node_is_real (hashTable, nodeIndex)) {
         if (stolenKey != NULL) {
             *stolenKey = NULL;
         }
@@ -364,7 +613,18 @@ void* c_hash_table_lookup (CHashTable* hashTable, const void* key)
 
     nodeIndex = c_hash_table_lookup_node (hashTable, key, &nodeHash);
 
-    return HASH_IS_REAL (hashTable->hashes[nodeIndex]) ? c_hash_table_fetch_key_or_value (hashTable->values, nodeIndex, hashTable->haveBigValues) : NULL;
+    if (C_LIKELY (c_hash_table_node_is_real (hashTable, nodeIndex))) {
+        return c_hash_table_fetch_key_or_value (hashTable->values, nodeIndex, hashTable->haveBigValues);
+    }
+
+    if (C_UNLIKELY (hashTable->old != NULL)) {
+        nodeIndex = c_hash_table_lookup_old (hashTable, key, nodeHash);
+        if (nodeIndex != INCREMENTAL_NOT_FOUND) {
+            return c_hash_table_fetch_key_or_value (hashTable->old->values, nodeIndex, hashTable->old->haveBigValues);
+        }
+    }
+
+    return NULL;
 }
 
 bool c_hash_table_contains (CHashTable* hashTable, const void* key)
@@ -376,7 +636,11 @@ bool c_hash_table_contains (CHashTable* hashTable, const void* key)
 
     nodeIndex = c_hash_table_lookup_node (hashTable, key, &nodeHash);
 
-    return HASH_IS_REAL (hashTable->hashes[nodeIndex]);
+    if (C_UNLIKELY (hashTable->old != NULL) && !c_hash_table_node_is_real (hashTable, nodeIndex)) {
+        return INCREMENTAL_NOT_FOUND != c_hash_table_lookup_old (hashTable, key, nodeHash);
+    }
+
+    return c_hash_table_node_is_real (hashTable, nodeIndex);
 }
 
 bool c_hash_table_lookup_extended (CHashTable* hashTable, const void* lookupKey, void** origKey, void** value)
@@ -386,8 +650,23 @@ bool c_hash_table_lookup_extended (CHashTable* hashTable, const void* lookupKey,
     c_return_val_if_fail (hashTable != NULL, false);
 
     cuint nodeIndex = c_hash_table_lookup_node (hashTable, lookupKey, &nodeHash);
+    void* keys = hashTable->keys;
+    void* values = hashTable->values;
+    bool haveBigKeys = hashTable->haveBigKeys;
+    bool haveBigValues = hashTable->haveBigValues;
+
+    if (C_UNLIKELY (hashTable->old != NULL) && !c_hash_table_node_is_real (hashTable, nodeIndex)) {
+        keys = hashTable->old->keys;
+        values = hashTable->old->values;
+        haveBigKeys = hashTable->old->haveBigKeys;
+        haveBigValues = hashTable->old->haveBigValues;
+        nodeIndex = c_hash_table_lookup_old (hashTable, lookupKey, nodeHash);
+    }
+    else if (!c_hash_table_node_is_real (hashTable, nodeIndex)) {
+        nodeIndex = INCREMENTAL_NOT_FOUND;
+    }
 
-    if (!HASH_IS_REAL (hashTable->hashes[nodeIndex])) {
+    if (INCREMENTAL_NOT_FOUND == nodeIndex) {
         if (origKey != NULL) {
             *origKey = NULL;
         }
@@ -400,11 +679,11 @@ bool c_hash_table_lookup_extended (CHashTable* hashTable, const void* lookupKey,
     }
 
     if (origKey) {
-        *origKey = c_hash_table_fetch_key_or_value (hashTable->keys, nodeIndex, hashTable->haveBigKeys);
+        *origKey = c_hash_table_fetch_key_or_value (keys, nodeIndex, haveBigKeys);
     }
 
     if (value) {
-        *value = c_hash_table_fetch_key_or_value (hashTable->values, nodeIndex, hashTable->haveBigValues);
+        *value = c_hash_table_fetch_key_or_value (values, nodeIndex, haveBigValues);
     }
 
     return true;
@@ -428,6 +707,14 @@ void c_hash_table_foreach (CHashTable* hashTable, CHFunc func, void* udata)
         }
         c_return_if_fail (version == hashTable->version);
     }
+
+    for (i = 0; hashTable->old && i < hashTable->old->size; i++) {
+        if (HASH_IS_REAL (hashTable->old->hashes[i])) {
+            (*func) (c_hash_table_fetch_key_or_value (hashTable->old->keys, i, (int) hashTable->old->haveBigKeys),
+                     c_hash_table_fetch_key_or_value (hashTable->old->values, i, (int) hashTable->old->haveBigValues), udata);
+        }
+        c_return_if_fail (version == hashTable->version);
+    }
 }
 
 void* c_hash_table_find (CHashTable* hashTable, CHRFunc predicate, void* udata)
@@ -458,6 +745,17 @@ void* c_hash_table_find (CHashTable* hashTable, CHRFunc predicate, void* udata)
         }
     }
 
+    for (i = 0; hashTable->old && i < hashTable->old->size; i++) {
+        if (HASH_IS_REAL (hashTable->old->hashes[i])) {
+            void* nodeValue = c_hash_table_fetch_key_or_value (hashTable->old->values, i, (int) hashTable->old->haveBigValues);
+            match = predicate (c_hash_table_fetch_key_or_value (hashTable->old->keys, i, (int) hashTable->old->haveBigKeys), nodeValue, udata);
+            c_return_val_if_fail (version == hashTable->version, NULL);
+            if (match) {
+                return nodeValue;
+            }
+        }
+    }
+
     return NULL;
 }
 
@@ -497,6 +795,12 @@ CList* c_hash_table_get_keys (CHashTable* hashTable)
         }
     }
 
+    for (i = 0; hashTable->old && i < hashTable->old->size; i++) {
+        if (HASH_IS_REAL (hashTable->old->hashes[i])) {
+            retval = c_list_prepend (retval, c_hash_table_fetch_key_or_value (hashTable->old->keys, i, (int) hashTable->old->haveBigKeys));
+        }
+    }
+
     return retval;
 }
 
@@ -514,6 +818,12 @@ CList* c_hash_table_get_values (CHashTable* hashTable)
         }
     }
 
+    for (i = 0; hashTable->old && i < hashTable->old->size; i++) {
+        if (HASH_IS_REAL (hashTable->old->hashes[i])) {
+            retval = c_list_prepend (retval, c_hash_table_fetch_key_or_value (hashTable->old->values, i, hashTable->old->haveBigValues));
+        }
+    }
+
     return retval;
 }
 
@@ -521,12 +831,17 @@ void** c_hash_table_get_keys_as_array (CHashTable* hashTable, cuint* length)
 {
     csize i, j = 0;
 
-    void** result = c_malloc0(sizeof(void*) * hashTable->nnodes + 1);
+    void** result = c_malloc0(sizeof(void*) * (hashTable->nnodes + 1));
     for (i = 0; i < hashTable->size; i++) {
         if (HASH_IS_REAL (hashTable->hashes[i])) {
             result[j++] = c_hash_table_fetch_key_or_value (hashTable->keys, i, (int) hashTable->haveBigKeys);
         }
     }
+    for (i = 0; hashTable->old && i < hashTable->old->size; i++) {
+        if (HASH_IS_REAL (hashTable->old->hashes[i])) {
+            result[j++] = c_hash_table_fetch_key_or_value (hashTable->old->keys, i, (int) hashTable->old->haveBigKeys);
+        }
+    }
     c_assert (j == hashTable->nnodes);
     result[j] = NULL;
 
@@ -548,6 +863,11 @@ CPtrArray* c_hash_table_get_keys_as_ptr_array (CHashTable* hashTable)
             c_ptr_array_add (array, c_hash_table_fetch_key_or_value (hashTable->keys, i, (int) hashTable->haveBigKeys));
         }
     }
+    for (i = 0; hashTable->old && i < hashTable->old->size; ++i) {
+        if (HASH_IS_REAL (hashTable->old->hashes[i])) {
+            c_ptr_array_add (array, c_hash_table_fetch_key_or_value (hashTable->old->keys, i, (int) hashTable->old->haveBigKeys));
+        }
+    }
     c_assert (array->len == hashTable->nnodes);
 
     return array;
@@ -566,6 +886,11 @@ CPtrArray* c_hash_table_get_values_as_ptr_array (CHashTable* hashTable)
             c_ptr_array_add (array, c_hash_table_fetch_key_or_value (hashTable->values, i, hashTable->haveBigValues));
         }
     }
+    for (i = 0; hashTable->old && i < hashTable->old->size; ++i) {
+        if (HASH_IS_REAL (hashTable->old->hashes[i])) {
+            c_ptr_array_add (array, c_hash_table_fetch_key_or_value (hashTable->old->values, i, hashTable->old->haveBigValues));
+        }
+    }
     c_assert (array->len == hashTable->nnodes);
 
     return array;
@@ -578,6 +903,11 @@ void c_hash_table_iter_init (CHashTableIter* iter, CHashTable* hashTable)
     c_return_if_fail (iter != NULL);
     c_return_if_fail (hashTable != NULL);
 
+    // 迭代器只遍历当前存储，c_hash_table_iter_remove/replace 也只作用于当前存储
+    if (hashTable->old) {
+        c_hash_table_migrate_all (hashTable);
+    }
+
     ri->hashTable = hashTable;
     ri->position = -1;
     ri->version = hashTable->version;
@@ -590,13 +920,13 @@ bool c_hash_table_iter_next (CHashTableIter* iter, void** key, void** value)
 
     c_return_val_if_fail (iter != NULL, false);
     c_return_val_if_fail (ri->version == ri->hashTable->version, false);
-    c_return_val_if_fail (ri->position < (csize) ri->hashTable->size, false);
+    c_return_val_if_fail (ri->position < (cssize) ri->hashTable->size, false);
 
     position = ri->position;
 
     do {
         position++;
-        if (position >= (csize) ri->hashTable->size) {
+        if (position >= (cssize) ri->hashTable->size) {
             ri->position = position;
             return false;
         }
@@ -675,44 +1005,175 @@ void c_hash_table_unref (CHashTable* hashTable)
         }
         c_free (hashTable->keys);
         c_free (hashTable->hashes);
+        c_free (hashTable->ctrl);
         c_free (hashTable);
     }
 }
 
+static inline cuint64 c_hash_seed_use (void)
+{
+    if (C_UNLIKELY (!__atomic_load_n (&gsHashSeedUsed, __ATOMIC_RELAXED))) {
+        __atomic_store_n (&gsHashSeedUsed, true, __ATOMIC_RELAXED);
+    }
+
+    return __atomic_load_n (&gsHashSeed, __ATOMIC_RELAXED);
+}
+
 cuint c_int_hash (const void* v)
 {
-    return *(const cint*) v;
+    return (cuint) c_hash_map_mix64 ((cuint64) *(const cuint*) v ^ c_hash_seed_use ());
 }
 
 cuint c_str_hash (const void* v)
 {
-    const signed char *p;
-    cuint32 h = 5381;
+    return c_str_hash_len (v, strlen (v));
+}
 
-    for (p = v; *p != '\0'; p++) {
-        h = (h << 5) + h + *p;
-    }
+cuint c_str_hash_len (const char* str, csize len)
+{
+    return (cuint) c_hash_wy (str, len, c_hash_seed_use ());
+}
 
-    return h;
+cuint c_data_hash (const void* data, csize len)
+{
+    return (cuint) c_hash_wy (data, len, c_hash_seed_use ());
 }
 
 cuint c_int64_hash (const void* v)
 {
-    const cuint64 *bits = v;
-
-    return (cuint) ((*bits >> 32) ^ (*bits & 0xffffffffU));
+    return (cuint) c_hash_map_mix64 (*(const cuint64*) v ^ c_hash_seed_use ());
 }
 
 cuint c_double_hash (const void* v)
 {
-    const cuint64 *bits = v;
+    cuint64 bits;
+    cdouble d = *(const cdouble*) v;
 
-    return (cuint) ((*bits >> 32) ^ (*bits & 0xffffffffU));
+    /* c_double_equal 认为 0.0 与 -0.0 相等，hash 也必须相同 */
+    if (d == 0.0) {
+        d = 0.0;
+    }
+    memcpy (&bits, &d, sizeof (bits));
+
+    return (cuint) c_hash_map_mix64 (bits ^ c_hash_seed_use ());
 }
 
 cuint c_direct_hash (const void* v)
 {
-    return C_POINTER_TO_UINT (v);
+    return (cuint) c_hash_map_mix64 ((cuint64) (cuintptr) v);
+}
+
+void c_hash_set_seed (cuint64 seed)
+{
+    c_return_if_fail (!__atomic_load_n (&gsHashSeedUsed, __ATOMIC_RELAXED));
+
+    __atomic_store_n (&gsHashSeed, seed, __ATOMIC_RELAXED);
+}
+
+cuint64 c_hash_get_seed (void)
+{
+    return c_hash_seed_use ();
+}
+
+void c_hash_set_random_seed (void)
+{
+    cuint64 seed = 0;
+
+    c_return_if_fail (!__atomic_load_n (&gsHashSeedUsed, __ATOMIC_RELAXED));
+
+    const int fd = open ("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        if (sizeof (seed) != read (fd, &seed, sizeof (seed))) {
+            seed = 0;
+        }
+        close (fd);
+    }
+
+    if (0 == seed) {
+        seed = c_hash_map_mix64 ((cuint64) c_get_monotonic_time () ^ ((cuint64) getpid () << 32) ^ (cuint64) (cuintptr) &seed);
+    }
+
+    __atomic_store_n (&gsHashSeed, seed, __ATOMIC_RELAXED);
+}
+
+cuint64 c_hash_mix64 (cuint64 x)
+{
+    return c_hash_map_mix64 (x);
+}
+
+static inline cuint64 c_hash_mum (cuint64 a, cuint64 b)
+{
+    const __uint128_t r = (__uint128_t) a * b;
+
+    return (cuint64) r ^ (cuint64) (r >> 64);
+}
+
+static inline cuint64 c_hash_read64 (const cuint8* p)
+{
+    cuint64 v;
+    memcpy (&v, p, sizeof (v));
+
+    return v;
+}
+
+static inline cuint64 c_hash_read32 (const cuint8* p)
+{
+    cuint32 v;
+    memcpy (&v, p, sizeof (v));
+
+    return v;
+}
+
+cuint64 c_hash_wy (const void* data, csize len, cuint64 seed)
+{
+    cuint64 a, b;
+    csize i = len;
+    const cuint8* p = (const cuint8*) data;
+
+    seed ^= c_hash_mum (seed ^ gsHashSecret[0], gsHashSecret[1]);
+
+    /* 每次读取 8 字节，短串用重叠读取避免逐字节循环 */
+    if (C_LIKELY (len <= 16)) {
+        if (C_LIKELY (len >= 4)) {
+            a = (c_hash_read32 (p) << 32) | c_hash_read32 (p + ((len >> 3) << 2));
+            b = (c_hash_read32 (p + len - 4) << 32) | c_hash_read32 (p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (C_LIKELY (len > 0)) {
+            a = (((cuint64) p[0]) << 16) | (((cuint64) p[len >> 1]) << 8) | p[len - 1];
+            b = 0;
+        }
+        else {
+            a = b = 0;
+        }
+    }
+    else {
+        if (C_UNLIKELY (i > 48)) {
+            cuint64 see1 = seed, see2 = seed;
+            do {
+                seed = c_hash_mum (c_hash_read64 (p) ^ gsHashSecret[1], c_hash_read64 (p + 8) ^ seed);
+                see1 = c_hash_mum (c_hash_read64 (p + 16) ^ gsHashSecret[2], c_hash_read64 (p + 24) ^ see1);
+                see2 = c_hash_mum (c_hash_read64 (p + 32) ^ gsHashSecret[3], c_hash_read64 (p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (C_LIKELY (i > 48));
+            seed ^= see1 ^ see2;
+        }
+        while (C_UNLIKELY (i > 16)) {
+            seed = c_hash_mum (c_hash_read64 (p) ^ gsHashSecret[1], c_hash_read64 (p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = c_hash_read64 (p + i - 16);
+        b = c_hash_read64 (p + i - 8);
+    }
+
+    a ^= gsHashSecret[1];
+    b ^= seed;
+    const __uint128_t r = (__uint128_t) a * b;
+    a = (cuint64) r;
+    b = (cuint64) (r >> 64);
+
+    return c_hash_mum (a ^ gsHashSecret[0] ^ len, b ^ gsHashSecret[1]);
 }
 
 
@@ -743,26 +1204,52 @@ static void c_hash_table_set_shift_from_size (CHashTable* hashTable, cint size)
     cint shift;
 
     shift = c_hash_table_find_closest_shift (size);
-    shift = C_MAX (shift, HASH_TABLE_MIN_SHIFT);
+    shift = C_MAX (shift, hashTable->flat ? C_HASH_MAP_MIN_SHIFT : HASH_TABLE_MIN_SHIFT);
 
     c_hash_table_set_shift (hashTable, shift);
 }
 
-static void* c_hash_table_realloc_key_or_value_array (void* a, cuint size, C_UNUSED bool isBig)
+static void* c_hash_table_realloc_key_or_value_array (void* a, cuint size, bool isBig)
 {
     return c_realloc (a, size * (isBig ? BIG_ENTRY_SIZE : SMALL_ENTRY_SIZE));
 }
 
-static void* c_hash_table_fetch_key_or_value (void* a, cuint index, bool isBig)
+#ifdef USE_SMALL_ARRAYS
+static inline bool c_hash_table_entry_is_big (void* v)
 {
-    isBig = true;
+    return (((cuintptr) v) >> ((BIG_ENTRY_SIZE - SMALL_ENTRY_SIZE) * 8)) != 0;
+}
+
+/* 原地把 4 字节槽位数组扩展为 8 字节，从后往前复制不会覆盖尚未读取的元素 */
+static void* c_hash_table_expand_key_or_value_array (void* a, cuint size)
+{
+    cint i;
+    void** p = c_realloc (a, size * BIG_ENTRY_SIZE);
+    const cuint* u = (const cuint*) p;
 
+    for (i = (cint) size - 1; i >= 0; i--) {
+        p[i] = C_UINT_TO_POINTER (u[i]);
+    }
+
+    return p;
+}
+#endif
+
+static inline void* c_hash_table_fetch_key_or_value (void* a, cuint index, bool isBig)
+{
+#ifdef USE_SMALL_ARRAYS
     return isBig ? *(((void**) a) + index) : C_UINT_TO_POINTER (*(((cuint*) a) + index));
+#else
+    (void) isBig;
+    return *(((void**) a) + index);
+#endif
 }
 
-static void c_hash_table_assign_key_or_value (void* a, cuint index, bool isBig, void* v)
+static inline void c_hash_table_assign_key_or_value (void* a, cuint index, bool isBig, void* v)
 {
+#ifndef USE_SMALL_ARRAYS
     isBig = true;
+#endif
 
     if (isBig) {
         *(((void**) a) + index) = v;
@@ -774,7 +1261,9 @@ static void c_hash_table_assign_key_or_value (void* a, cuint index, bool isBig,
 
 static void* c_hash_table_evict_key_or_value (void* a, cuint index, bool isBig, void* v)
 {
+#ifndef USE_SMALL_ARRAYS
     isBig = true;
+#endif
 
     if (isBig) {
         void* r = *(((void**) a) + index);
@@ -793,26 +1282,38 @@ static inline cuint c_hash_table_hash_to_index (CHashTable* hashTable, cuint has
     return (hash * 11) % hashTable->mod;
 }
 
+static inline cuint c_hash_table_hash_key (CHashTable* hashTable, const void* key)
+{
+    const cuint hashValue = hashTable->hashFunc (key);
+
+    return C_LIKELY (HASH_IS_REAL (hashValue)) ? hashValue : 2;
+}
+
 static inline cuint c_hash_table_lookup_node (CHashTable* hashTable, const void* key, cuint* hashReturn)
+{
+    *hashReturn = c_hash_table_hash_key (hashTable, key);
+
+    return c_hash_table_lookup_node_with_hash (hashTable, key, *hashReturn);
+}
+
+static inline cuint c_hash_table_lookup_node_with_hash (CHashTable* hashTable, const void* key, cuint hashValue)
 {
     cuint nodeIndex;
     cuint nodeHash;
-    cuint hashValue;
     cuint step = 0;
     cuint firstTombstone = 0;
     bool haveTombstone = false;
 
-    hashValue = hashTable->hashFunc (key);
-    if (C_UNLIKELY (!HASH_IS_REAL (hashValue))) {
-        hashValue = 2;
+    if (hashTable->flat) {
+        return c_hash_table_lookup_node_flat (hashTable, key, hashValue);
     }
 
-    *hashReturn = hashValue;
-
+    PROBE_STATS_LOOKUP (hashTable);
     nodeIndex = c_hash_table_hash_to_index (hashTable, hashValue);
     nodeHash = hashTable->hashes[nodeIndex];
 
     while (!HASH_IS_UNUSED (nodeHash)) {
+        PROBE_STATS_PROBE (hashTable);
         if (nodeHash == hashValue) {
             void* nodeKey = c_hash_table_fetch_key_or_value (hashTable->keys, nodeIndex, hashTable->haveBigKeys);
             if (hashTable->keyEqualFunc) {
@@ -851,6 +1352,9 @@ static void c_hash_table_remove_node (CHashTable* hashTable, int i, bool notify)
 
     /* Erect tombstone */
     hashTable->hashes[i] = TOMBSTONE_HASH_VALUE;
+    if (hashTable->flat) {
+        flat_set_ctrl (hashTable, (cuint) i, C_HASH_MAP_CTRL_DELETED);
+    }
 
     /* Be GC friendly */
     c_hash_table_assign_key_or_value (hashTable->keys, i, (bool) hashTable->haveBigKeys, NULL);
@@ -872,13 +1376,21 @@ static void c_hash_table_setup_storage (CHashTable* hashTable)
 {
     bool small = false;
 
-    c_hash_table_set_shift (hashTable, HASH_TABLE_MIN_SHIFT);
+#ifdef USE_SMALL_ARRAYS
+    small = true;
+#endif
+
+    c_hash_table_set_shift (hashTable, hashTable->flat ? C_HASH_MAP_MIN_SHIFT : HASH_TABLE_MIN_SHIFT);
 
     hashTable->haveBigKeys = !small;
     hashTable->haveBigValues = !small;
     hashTable->keys = c_hash_table_realloc_key_or_value_array (NULL, hashTable->size, hashTable->haveBigKeys);
     hashTable->values = hashTable->keys;
     hashTable->hashes = c_malloc0(sizeof(cuint) * hashTable->size);
+    if (hashTable->flat) {
+        hashTable->ctrl = c_malloc0(hashTable->size + C_HASH_MAP_GROUP_WIDTH);
+        memset (hashTable->ctrl, C_HASH_MAP_CTRL_EMPTY, hashTable->size + C_HASH_MAP_GROUP_WIDTH);
+    }
 }
 
 static void c_hash_table_remove_all_nodes (CHashTable* hashTable, bool notify, bool destruction)
@@ -890,9 +1402,14 @@ static void c_hash_table_remove_all_nodes (CHashTable* hashTable, bool notify, b
     void** oldKeys;
     void** oldValues;
     cuint* oldHashes;
+    cuint8* oldCtrl;
     bool oldHaveBigKeys;
     bool oldHaveBigValues;
 
+    if (hashTable->old) {
+        c_hash_table_free_old (hashTable, notify);
+    }
+
     if (hashTable->nnodes == 0) {
         return;
     }
@@ -903,8 +1420,11 @@ static void c_hash_table_remove_all_nodes (CHashTable* hashTable, bool notify, b
     if (!notify || (hashTable->keyDestroyFunc == NULL && hashTable->valueDestroyFunc == NULL)) {
         if (!destruction) {
             memset (hashTable->hashes, 0, hashTable->size * sizeof (cuint));
-            memset (hashTable->keys, 0, hashTable->size * sizeof (void*));
-            memset (hashTable->values, 0, hashTable->size * sizeof (void*));
+            memset (hashTable->keys, 0, hashTable->size * (hashTable->haveBigKeys ? BIG_ENTRY_SIZE : SMALL_ENTRY_SIZE));
+            memset (hashTable->values, 0, hashTable->size * (hashTable->haveBigValues ? BIG_ENTRY_SIZE : SMALL_ENTRY_SIZE));
+            if (hashTable->flat) {
+                memset (hashTable->ctrl, C_HASH_MAP_CTRL_EMPTY, hashTable->size + C_HASH_MAP_GROUP_WIDTH);
+            }
         }
         return;
     }
@@ -915,6 +1435,7 @@ static void c_hash_table_remove_all_nodes (CHashTable* hashTable, bool notify, b
     oldKeys   = c_steal_pointer (&hashTable->keys);
     oldValues = c_steal_pointer (&hashTable->values);
     oldHashes = c_steal_pointer (&hashTable->hashes);
+    oldCtrl   = c_steal_pointer (&hashTable->ctrl);
 
     if (!destruction) {
         c_hash_table_setup_storage (hashTable);
@@ -950,11 +1471,12 @@ static void c_hash_table_remove_all_nodes (CHashTable* hashTable, bool notify, b
 
     c_free (oldKeys);
     c_free (oldHashes);
+    c_free (oldCtrl);
 }
 
 static void realloc_arrays (CHashTable* hashTable, bool isASet)
 {
-    hashTable->hashes = c_realloc(hashTable->hashes, hashTable->size);
+    hashTable->hashes = c_realloc(hashTable->hashes, sizeof(cuint) * hashTable->size);
     hashTable->keys = c_hash_table_realloc_key_or_value_array (hashTable->keys, hashTable->size, (bool) hashTable->haveBigKeys);
 
     if (isASet) {
@@ -968,7 +1490,7 @@ static void realloc_arrays (CHashTable* hashTable, bool isASet)
 
 static inline bool get_status_bit (const cuint32 *bitmap, cuint index)
 {
-    return (bool) (bitmap[index / 32] >> (index % 32)) & 1;
+    return (bool) ((bitmap[index / 32] >> (index % 32)) & 1);
 }
 
 static inline void set_status_bit (cuint32 *bitmap, cuint index)
@@ -976,7 +1498,7 @@ static inline void set_status_bit (cuint32 *bitmap, cuint index)
     bitmap[index / 32] |= 1U << (index % 32);
 }
 
-static void c_hash_table_resize (CHashTable* hashTable)
+static void c_hash_table_resize (CHashTable* hashTable, cuint nodes)
 {
     cuint32* reallocatedBucketsBitmap;
     csize oldSize;
@@ -985,7 +1507,8 @@ static void c_hash_table_resize (CHashTable* hashTable)
     oldSize = hashTable->size;
     isASet = hashTable->keys == hashTable->values;
 
-    c_hash_table_set_shift_from_size (hashTable, hashTable->nnodes * 1.333);
+    hashTable->resizeCount++;
+    c_hash_table_set_shift_from_size (hashTable, nodes * 1.333);
 
     if (hashTable->size > oldSize) {
         realloc_arrays (hashTable, isASet);
@@ -1012,13 +1535,152 @@ static void c_hash_table_resize (CHashTable* hashTable)
     hashTable->noccupied = hashTable->nnodes;
 }
 
+static CHashTable* c_hash_table_new_internal (CHashFunc hashFunc, CEqualFunc keyEqualFunc, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc, bool flat)
+{
+    CHashTable* hashTable = c_malloc0(sizeof(CHashTable));
+    c_atomic_ref_count_init (&hashTable->refCount);
+    hashTable->nnodes             = 0;
+    hashTable->noccupied          = 0;
+    hashTable->flat               = flat;
+    hashTable->hashFunc           = hashFunc ? hashFunc : c_direct_hash;
+    hashTable->keyEqualFunc       = keyEqualFunc;
+    hashTable->version            = 0;
+    hashTable->keyDestroyFunc     = keyDestroyFunc;
+    hashTable->valueDestroyFunc   = valueDestroyFunc;
+
+    c_hash_table_setup_storage (hashTable);
+
+    return hashTable;
+}
+
+/* flat 表查找后只读刚访问过的控制位，不再访问 hashes[] */
+static inline bool c_hash_table_node_is_real (CHashTable* hashTable, cuint index)
+{
+    return hashTable->flat ? (0 == (hashTable->ctrl[index] & 0x80)) : HASH_IS_REAL (hashTable->hashes[index]);
+}
+
+static inline void flat_set_ctrl (CHashTable* hashTable, cuint index, cuint8 ctrl)
+{
+    c_hash_map_set_ctrl (hashTable->ctrl, hashTable->mask, index, ctrl);
+}
+
+
+static inline cuint c_hash_table_lookup_node_flat (CHashTable* hashTable, const void* key, cuint hashValue)
+{
+    cuint bits;
+    cuint step = 0;
+    cuint insertIndex = 0;
+    bool haveInsertIndex = false;
+    const cuint8 tag = C_HASH_MAP_H2 (hashValue);
+    cuint pos = C_HASH_MAP_H1 (hashValue) & hashTable->mask;
+
+    PROBE_STATS_LOOKUP (hashTable);
+
+    /* 按组做三角探测，组数是 2 的幂，能遍历所有组；负载因子保证总能遇到空槽位 */
+    for (;;) {
+        const cuint8* group = hashTable->ctrl + pos;
+        PROBE_STATS_PROBE (hashTable);
+
+        for (bits = c_hash_map_group_match (group, tag); bits; bits &= bits - 1) {
+            cuint nodeIndex = (pos + (cuint) __builtin_ctz (bits)) & hashTable->mask;
+            void* nodeKey = c_hash_table_fetch_key_or_value (hashTable->keys, nodeIndex, hashTable->haveBigKeys);
+            if (hashTable->keyEqualFunc ? hashTable->keyEqualFunc (nodeKey, key) : (nodeKey == key)) {
+                return nodeIndex;
+            }
+        }
+
+        if (!haveInsertIndex) {
+            bits = c_hash_map_group_match_empty_or_deleted (group);
+            if (bits) {
+                insertIndex = (pos + (cuint) __builtin_ctz (bits)) & hashTable->mask;
+                haveInsertIndex = true;
+            }
+        }
+
+        if (c_hash_map_group_match_empty (group)) {
+            return insertIndex;
+        }
+
+        pos = c_hash_map_probe_next (pos, &step, hashTable->mask);
+    }
+}
+
+static void c_hash_table_resize_flat (CHashTable* hashTable, cuint nodes)
+{
+    csize i;
+    const csize oldSize = hashTable->size;
+    cuint* oldHashes = hashTable->hashes;
+    cuint8* oldCtrl = hashTable->ctrl;
+    void* oldKeys = hashTable->keys;
+    void* oldValues = hashTable->values;
+    const bool isASet = hashTable->keys == hashTable->values;
+
+    hashTable->resizeCount++;
+    c_hash_table_set_shift_from_size (hashTable, nodes * 1.333);
+
+    /* 容量不变(墓碑过多)时原地重排，不重新分配 */
+    if (hashTable->size == oldSize) {
+        c_hash_table_rehash_in_place (hashTable);
+        return;
+    }
+
+    /* 重新分配存储并逐个插入，同时清理所有墓碑 */
+    c_hash_table_alloc_storage (hashTable, isASet);
+
+    for (i = 0; i < oldSize; ++i) {
+        const cuint nodeHash = oldHashes[i];
+        if (!HASH_IS_REAL (nodeHash)) {
+            continue;
+        }
+
+        const cuint nodeIndex = c_hash_map_find_free (hashTable->ctrl, hashTable->mask, nodeHash, true);
+        hashTable->hashes[nodeIndex] = nodeHash;
+        flat_set_ctrl (hashTable, nodeIndex, C_HASH_MAP_H2 (nodeHash));
+        c_hash_table_assign_key_or_value (hashTable->keys, nodeIndex, hashTable->haveBigKeys, c_hash_table_fetch_key_or_value (oldKeys, i, hashTable->haveBigKeys));
+        if (!isASet) {
+            c_hash_table_assign_key_or_value (hashTable->values, nodeIndex, hashTable->haveBigValues, c_hash_table_fetch_key_or_value (oldValues, i, hashTable->haveBigValues));
+        }
+    }
+
+    if (!isASet) {
+        c_free (oldValues);
+    }
+    c_free (oldKeys);
+    c_free (oldHashes);
+    c_free (oldCtrl);
+
+    hashTable->noccupied = hashTable->nnodes;
+}
+
+/* 当前存储中已占用(元素 + 墓碑) noccupied 个槽位时是否需要扩容 */
+static inline bool c_hash_table_is_full (CHashTable* hashTable, csize noccupied)
+{
+    const csize size = hashTable->size;
+
+    return hashTable->flat ? c_hash_map_is_full (size, noccupied) : (size <= noccupied + (noccupied / 16));
+}
+
 static inline void c_hash_table_maybe_resize (CHashTable* hashTable)
 {
-    csize noccupied = hashTable->noccupied;
-    csize size = hashTable->size;
+    if (C_UNLIKELY (hashTable->old != NULL)) {
+        // 迁移期间不收缩；按 step 迁移时新存储装满之前旧存储已经迁移完，这里的 migrate_all 不会再搬动元素
+        if (!c_hash_table_is_full (hashTable, hashTable->noccupied)) {
+            return;
+        }
+        c_hash_table_migrate_all (hashTable);
+    }
+
+    const csize size = hashTable->size;
+    const cuint nodes = C_MAX (hashTable->nnodes, hashTable->reserved);
+    const bool shrink = size > (csize) nodes * 4 && size > 1 << (hashTable->flat ? C_HASH_MAP_MIN_SHIFT : HASH_TABLE_MIN_SHIFT);
 
-    if ((size > hashTable->nnodes * 4 && size > 1 << HASH_TABLE_MIN_SHIFT) || (size <= noccupied + (noccupied / 16))) {
-        c_hash_table_resize (hashTable);
+    if (shrink || c_hash_table_is_full (hashTable, hashTable->noccupied)) {
+        if (!shrink && hashTable->incremental && size >= INCREMENTAL_MIN_SIZE) {
+            c_hash_table_resize_incremental (hashTable, nodes);
+        }
+        else {
+            c_hash_table_resize_now (hashTable, nodes);
+        }
     }
 }
 
@@ -1026,10 +1688,42 @@ static inline void c_hash_table_ensure_keyval_fits (CHashTable* hashTable, void*
 {
     bool isASet = (hashTable->keys == hashTable->values);
 
+#ifdef USE_SMALL_ARRAYS
+    /* set 转为 map */
+    if (isASet) {
+        if (hashTable->haveBigKeys) {
+            if (key != value) {
+                hashTable->values = c_memdup (hashTable->keys, BIG_ENTRY_SIZE * hashTable->size);
+            }
+            /* key 与 value 都已经是 8 字节槽位，不需要再检查 */
+            return;
+        }
+        if (key != value) {
+            hashTable->values = c_memdup (hashTable->keys, SMALL_ENTRY_SIZE * hashTable->size);
+            isASet = false;
+        }
+    }
+
+    if (!hashTable->haveBigKeys) {
+        hashTable->haveBigKeys = c_hash_table_entry_is_big (key);
+        if (hashTable->haveBigKeys) {
+            hashTable->keys = c_hash_table_expand_key_or_value_array (hashTable->keys, hashTable->size);
+        }
+    }
+
+    if (!hashTable->haveBigValues) {
+        hashTable->haveBigValues = c_hash_table_entry_is_big (value);
+        if (hashTable->haveBigValues) {
+            /* set 中 key 与 value 相同，keys 刚刚已经扩展过 */
+            hashTable->values = isASet ? hashTable->keys : c_hash_table_expand_key_or_value_array (hashTable->values, hashTable->size);
+        }
+    }
+#else
     /* Just split if necessary */
     if (isASet && key != value) {
         hashTable->values = c_memdup (hashTable->keys, sizeof (void*) * hashTable->size);
     }
+#endif
 }
 
 static void iter_remove_or_steal (RealIter* ri, bool notify)
@@ -1069,6 +1763,9 @@ static bool c_hash_table_insert_node (CHashTable* hashTable, cuint nodeIndex, cu
     }
     else {
         hashTable->hashes[nodeIndex] = keyHash;
+        if (hashTable->flat) {
+            flat_set_ctrl (hashTable, nodeIndex, C_HASH_MAP_H2 (keyHash));
+        }
         keyToKeep = newKey;
     }
 
@@ -1105,7 +1802,7 @@ static bool c_hash_table_insert_internal (CHashTable* hashTable, void* key, void
 
     c_return_val_if_fail (hashTable != NULL, false);
 
-    nodeIndex = c_hash_table_lookup_node (hashTable, key, &keyHash);
+    nodeIndex = c_hash_table_lookup_node_for_write (hashTable, key, &keyHash);
 
     return c_hash_table_insert_node (hashTable, nodeIndex, keyHash, key, value, keepNewKey, false);
 }
@@ -1117,9 +1814,9 @@ static bool c_hash_table_remove_internal (CHashTable* hashTable, const void* key
 
     c_return_val_if_fail (hashTable != NULL, false);
 
-    nodeIndex = c_hash_table_lookup_node (hashTable, key, &nodeHash);
+    nodeIndex = c_hash_table_lookup_node_for_write (hashTable, key, &nodeHash);
 
-    if (!HASH_IS_REAL (hashTable->hashes[nodeIndex])) {
+    if (!c_hash_table_node_is_real (hashTable, nodeIndex)) {
         return false;
     }
 
@@ -1135,6 +1832,11 @@ static cuint c_hash_table_foreach_remove_or_steal (CHashTable* hashTable, CHRFun
 {
     cuint deleted = 0;
     csize i;
+
+    if (hashTable->old) {
+        c_hash_table_migrate_all (hashTable);
+    }
+
     cint version = hashTable->version;
 
     for (i = 0; i < hashTable->size; i++) {
@@ -1157,3 +1859,333 @@ static cuint c_hash_table_foreach_remove_or_steal (CHashTable* hashTable, CHRFun
 
     return deleted;
 }
+
+static void c_hash_table_alloc_storage (CHashTable* hashTable, bool isASet)
+{
+    hashTable->hashes = c_malloc0(sizeof(cuint) * hashTable->size);
+    hashTable->keys = c_hash_table_realloc_key_or_value_array (NULL, hashTable->size, hashTable->haveBigKeys);
+    hashTable->values = isASet ? hashTable->keys : c_hash_table_realloc_key_or_value_array (NULL, hashTable->size, hashTable->haveBigValues);
+    if (hashTable->flat) {
+        hashTable->ctrl = c_malloc0(hashTable->size + C_HASH_MAP_GROUP_WIDTH);
+        memset (hashTable->ctrl, C_HASH_MAP_CTRL_EMPTY, hashTable->size + C_HASH_MAP_GROUP_WIDTH);
+    }
+}
+
+static void c_hash_table_resize_incremental (CHashTable* hashTable, cuint nodes)
+{
+    OldStorage* old = c_malloc0 (sizeof (OldStorage));
+
+    hashTable->resizeCount++;
+    old->size = hashTable->size;
+    old->mod = hashTable->mod;
+    old->mask = hashTable->mask;
+    old->nnodes = hashTable->nnodes;
+    old->haveBigKeys = hashTable->haveBigKeys;
+    old->haveBigValues = hashTable->haveBigValues;
+    old->keys = c_steal_pointer (&hashTable->keys);
+    old->values = c_steal_pointer (&hashTable->values);
+    old->hashes = c_steal_pointer (&hashTable->hashes);
+    old->ctrl = c_steal_pointer (&hashTable->ctrl);
+
+    c_hash_table_set_shift_from_size (hashTable, nodes * 1.333);
+    c_hash_table_alloc_storage (hashTable, old->keys == old->values);
+
+    hashTable->noccupied = 0;
+    hashTable->old = old;
+
+    // 新存储装满(c_hash_table_is_full)之前最多还能写入 room 次，迁移必须在这之前完成
+    const csize limit = hashTable->size - hashTable->size / 8 - 1;
+    const csize room = (limit > old->nnodes) ? limit - old->nnodes : 1;
+    old->step = C_MAX ((csize) INCREMENTAL_STEP, (old->size + room - 1) / room);
+
+    if (0 == old->nnodes) {
+        c_hash_table_free_old (hashTable, false);
+    }
+}
+
+static void c_hash_table_free_old (CHashTable* hashTable, bool notify)
+{
+    csize i;
+    OldStorage* old = c_steal_pointer (&hashTable->old);
+
+    for (i = 0; notify && old->nnodes > 0 && i < old->size; ++i) {
+        if (HASH_IS_REAL (old->hashes[i])) {
+            void* key = c_hash_table_fetch_key_or_value (old->keys, i, old->haveBigKeys);
+            void* value = c_hash_table_fetch_key_or_value (old->values, i, old->haveBigValues);
+            old->nnodes--;
+            hashTable->nnodes--;
+            if (hashTable->keyDestroyFunc) {
+                hashTable->keyDestroyFunc (key);
+            }
+            if (hashTable->valueDestroyFunc) {
+                hashTable->valueDestroyFunc (value);
+            }
+        }
+    }
+    hashTable->nnodes -= old->nnodes;
+
+    if (old->keys != old->values) {
+        c_free (old->values);
+    }
+    c_free (old->keys);
+    c_free (old->hashes);
+    c_free (old->ctrl);
+    c_free (old);
+}
+
+static void c_hash_table_migrate_node (CHashTable* hashTable, cuint oldIndex, cuint nodeIndex)
+{
+    OldStorage* old = hashTable->old;
+    const cuint nodeHash = old->hashes[oldIndex];
+    void* key = c_hash_table_fetch_key_or_value (old->keys, oldIndex, old->haveBigKeys);
+    void* value = c_hash_table_fetch_key_or_value (old->values, oldIndex, old->haveBigValues);
+
+    old->hashes[oldIndex] = TOMBSTONE_HASH_VALUE;
+    if (hashTable->flat) {
+        c_hash_map_set_ctrl (old->ctrl, old->mask, oldIndex, C_HASH_MAP_CTRL_DELETED);
+    }
+    old->nnodes--;
+
+    if (HASH_IS_UNUSED (hashTable->hashes[nodeIndex])) {
+        hashTable->noccupied++;
+    }
+    hashTable->hashes[nodeIndex] = nodeHash;
+    if (hashTable->flat) {
+        flat_set_ctrl (hashTable, nodeIndex, C_HASH_MAP_H2 (nodeHash));
+    }
+    c_hash_table_ensure_keyval_fits (hashTable, key, value);
+    c_hash_table_assign_key_or_value (hashTable->keys, nodeIndex, hashTable->haveBigKeys, key);
+    c_hash_table_assign_key_or_value (hashTable->values, nodeIndex, hashTable->haveBigValues, value);
+}
+
+static void c_hash_table_migrate_step (CHashTable* hashTable, csize buckets)
+{
+    csize i;
+    OldStorage* old = hashTable->old;
+    const csize end = C_MIN (old->size, old->migrated + buckets);
+
+    for (i = old->migrated; i < end && old->nnodes > 0; ++i) {
+        if (HASH_IS_REAL (old->hashes[i])) {
+            c_hash_table_migrate_node (hashTable, (cuint) i, c_hash_table_find_free_node (hashTable, old->hashes[i]));
+        }
+    }
+    old->migrated = i;
+
+    if (0 == old->nnodes) {
+        c_hash_table_free_old (hashTable, false);
+    }
+}
+
+static void c_hash_table_migrate_all (CHashTable* hashTable)
+{
+    if (hashTable->old) {
+        c_hash_table_migrate_step (hashTable, hashTable->old->size);
+    }
+}
+
+static cuint c_hash_table_lookup_old (CHashTable* hashTable, const void* key, cuint hashValue)
+{
+    cuint step = 0;
+    const OldStorage* old = hashTable->old;
+
+    if (hashTable->flat) {
+        cuint bits;
+        const cuint8 tag = C_HASH_MAP_H2 (hashValue);
+        cuint pos = C_HASH_MAP_H1 (hashValue) & old->mask;
+        for (;;) {
+            const cuint8* group = old->ctrl + pos;
+            for (bits = c_hash_map_group_match (group, tag); bits; bits &= bits - 1) {
+                cuint nodeIndex = (pos + (cuint) __builtin_ctz (bits)) & old->mask;
+                void* nodeKey = c_hash_table_fetch_key_or_value (old->keys, nodeIndex, old->haveBigKeys);
+                if (hashTable->keyEqualFunc ? hashTable->keyEqualFunc (nodeKey, key) : (nodeKey == key)) {
+                    return nodeIndex;
+                }
+            }
+            if (c_hash_map_group_match_empty (group)) {
+                return INCREMENTAL_NOT_FOUND;
+            }
+            pos = c_hash_map_probe_next (pos, &step, old->mask);
+        }
+    }
+
+    cuint nodeIndex = (hashValue * 11) % old->mod;
+    cuint nodeHash = old->hashes[nodeIndex];
+    while (!HASH_IS_UNUSED (nodeHash)) {
+        if (nodeHash == hashValue) {
+            void* nodeKey = c_hash_table_fetch_key_or_value (old->keys, nodeIndex, old->haveBigKeys);
+            if (hashTable->keyEqualFunc ? hashTable->keyEqualFunc (nodeKey, key) : (nodeKey == key)) {
+                return nodeIndex;
+            }
+        }
+        step++;
+        nodeIndex = (nodeIndex + step) & old->mask;
+        nodeHash = old->hashes[nodeIndex];
+    }
+
+    return INCREMENTAL_NOT_FOUND;
+}
+
+/* 当前存储中 hashValue 探测序列上第一个空槽位或墓碑，调用者保证 key 不在当前存储中 */
+static inline cuint c_hash_table_find_free_node (CHashTable* hashTable, cuint hashValue)
+{
+    cuint step = 0;
+
+    if (hashTable->flat) {
+        return c_hash_map_find_free (hashTable->ctrl, hashTable->mask, hashValue, false);
+    }
+
+    cuint nodeIndex = c_hash_table_hash_to_index (hashTable, hashValue);
+    while (HASH_IS_REAL (hashTable->hashes[nodeIndex])) {
+        step++;
+        nodeIndex = (nodeIndex + step) & hashTable->mask;
+    }
+
+    return nodeIndex;
+}
+
+/* 原地重排时 hashValue 探测序列上第一个尚未放置元素的槽位；flat 表按组内顺序查找，与插入时的位置规则一致 */
+static inline cuint c_hash_table_first_unallocated_node (CHashTable* hashTable, cuint hashValue, const cuint32* bitmap)
+{
+    cuint i;
+    cuint step = 0;
+
+    if (hashTable->flat) {
+        cuint pos = C_HASH_MAP_H1 (hashValue) & hashTable->mask;
+        for (;;) {
+            for (i = 0; i < C_HASH_MAP_GROUP_WIDTH; ++i) {
+                const cuint nodeIndex = (pos + i) & hashTable->mask;
+                if (!get_status_bit (bitmap, nodeIndex)) {
+                    return nodeIndex;
+                }
+            }
+            pos = c_hash_map_probe_next (pos, &step, hashTable->mask);
+        }
+    }
+
+    cuint nodeIndex = c_hash_table_hash_to_index (hashTable, hashValue);
+    while (get_status_bit (bitmap, nodeIndex)) {
+        step++;
+        nodeIndex = (nodeIndex + step) & hashTable->mask;
+    }
+
+    return nodeIndex;
+}
+
+/**
+ * @brief 不改变容量重排当前存储，清除所有墓碑
+ * @note 按 hashes[] 移动元素，每个元素放到探测序列上第一个尚未放置元素的槽位，被占用时换出原有元素继续放置；
+ *       flat 表最后根据 hashes[] 重建控制位
+ */
+static void c_hash_table_rehash_in_place (CHashTable* hashTable)
+{
+    cuint i;
+    const bool isASet = hashTable->keys == hashTable->values;
+    cuint32* reallocatedBucketsBitmap = c_malloc0 (sizeof (cuint32) * ((hashTable->size + 31) / 32));
+
+    if (isASet) {
+        resize_set (hashTable, hashTable->size, reallocatedBucketsBitmap);
+    }
+    else {
+        resize_map (hashTable, hashTable->size, reallocatedBucketsBitmap);
+    }
+    c_free (reallocatedBucketsBitmap);
+
+    if (hashTable->flat) {
+        for (i = 0; i < hashTable->size; ++i) {
+            const cuint nodeHash = hashTable->hashes[i];
+            flat_set_ctrl (hashTable, i, HASH_IS_REAL (nodeHash) ? C_HASH_MAP_H2 (nodeHash) : C_HASH_MAP_CTRL_EMPTY);
+        }
+    }
+
+    hashTable->noccupied = hashTable->nnodes;
+}
+
+/* 元素在探测序列上的位置(0 表示起始位置)；普通表按槽位计数，flat 表按组计数 */
+static cuint c_hash_table_probe_length (bool flat, cint mod, cuint mask, cuint hashValue, cuint index)
+{
+    cuint length = 0;
+    cuint step = 0;
+
+    if (flat) {
+        cuint pos = C_HASH_MAP_H1 (hashValue) & mask;
+        while (((index - pos) & mask) >= C_HASH_MAP_GROUP_WIDTH) {
+            pos = c_hash_map_probe_next (pos, &step, mask);
+            length++;
+        }
+        return length;
+    }
+
+    cuint nodeIndex = (hashValue * 11) % mod;
+    while (nodeIndex != index) {
+        step++;
+        nodeIndex = (nodeIndex + step) & mask;
+        length++;
+    }
+
+    return length;
+}
+
+static void c_hash_table_collect_probe_stats (CHashTableStats* stats, const cuint* hashes, csize size, bool flat, cint mod, cuint mask, cuint64* total)
+{
+    csize i;
+
+    for (i = 0; i < size; ++i) {
+        if (!HASH_IS_REAL (hashes[i])) {
+            continue;
+        }
+        const cuint length = c_hash_table_probe_length (flat, mod, mask, hashes[i], (cuint) i);
+        stats->maxProbeLength = C_MAX (stats->maxProbeLength, length);
+        stats->probeHistogram[C_MIN (length, C_HASH_TABLE_PROBE_HISTOGRAM_SIZE - 1)]++;
+        *total += length;
+    }
+}
+
+/**
+ * @brief 修改表之前的查找：迁移期间先推进一步迁移，key 仍在旧存储时把它移到查找得到的槽位，
+ *        返回值与 c_hash_table_lookup_node 一样总是当前存储中的下标
+ */
+static inline cuint c_hash_table_lookup_node_for_write (CHashTable* hashTable, const void* key, cuint* hashReturn)
+{
+    if (C_UNLIKELY (hashTable->old != NULL)) {
+        c_hash_table_migrate_step (hashTable, hashTable->old->step);
+    }
+
+    const cuint nodeIndex = c_hash_table_lookup_node (hashTable, key, hashReturn);
+
+    if (C_UNLIKELY (hashTable->old != NULL) && !c_hash_table_node_is_real (hashTable, nodeIndex)) {
+        const cuint oldIndex = c_hash_table_lookup_old (hashTable, key, *hashReturn);
+        if (oldIndex != INCREMENTAL_NOT_FOUND) {
+            c_hash_table_migrate_node (hashTable, oldIndex, nodeIndex);
+            if (0 == hashTable->old->nnodes) {
+                c_hash_table_free_old (hashTable, false);
+            }
+        }
+    }
+
+    return nodeIndex;
+}
+
+/* 同步扩容(或收缩)到能容纳 nodes 个元素，不使用渐进式扩容 */
+static void c_hash_table_resize_now (CHashTable* hashTable, cuint nodes)
+{
+    if (hashTable->flat) {
+        c_hash_table_resize_flat (hashTable, nodes);
+    }
+    else {
+        c_hash_table_resize (hashTable, nodes);
+    }
+}
+
+/* 预取 hashValue 探测起点的控制位(flat)或 hash 值以及 key 槽位 */
+static inline void c_hash_table_prefetch_node (CHashTable* hashTable, cuint hashValue)
+{
+    const cuint nodeIndex = hashTable->flat ? (C_HASH_MAP_H1 (hashValue) & hashTable->mask) : c_hash_table_hash_to_index (hashTable, hashValue);
+
+    if (hashTable->flat) {
+        __builtin_prefetch (hashTable->ctrl + nodeIndex);
+    }
+    else {
+        __builtin_prefetch (hashTable->hashes + nodeIndex);
+    }
+    __builtin_prefetch ((const cuint8*) hashTable->keys + (csize) nodeIndex * (hashTable->haveBigKeys ? BIG_ENTRY_SIZE : SMALL_ENTRY_SIZE));
+}
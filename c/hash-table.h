@@ -25,8 +25,11 @@
 C_BEGIN_EXTERN_C
 
 
+#define C_HASH_TABLE_PROBE_HISTOGRAM_SIZE      16
+
 typedef struct _CHashTable          CHashTable;
 typedef struct _CHashTableIter      CHashTableIter;
+typedef struct _CHashTableStats     CHashTableStats;
 
 typedef bool  (*CHRFunc)  (void* key, void* value, void* udata);
 
@@ -42,10 +45,82 @@ struct _CHashTableIter
     void*           dummy6;
 };
 
+/**
+ * @brief c_hash_table_get_stats() 的结果
+ * @note 探测长度是元素所在位置相对起始位置多探测的次数，0 表示在起始位置就能找到；
+ *       普通表按槽位计数，flat 表按 16 个槽位的组计数
+ */
+struct _CHashTableStats
+{
+    cuint           size;                   /* 当前存储的槽位数 */
+    cuint           nnodes;                 /* 元素数，包括渐进式扩容中尚未迁移的元素 */
+    cuint           ntombstones;            /* 当前存储中的墓碑数(noccupied - nnodes) */
+    double          loadFactor;             /* nnodes / size */
+    double          tombstoneRatio;         /* ntombstones / size */
+    double          avgProbeLength;
+    cuint           maxProbeLength;
+    cuint           resizeCount;            /* 扩容、收缩与原地重排的次数 */
+    cuint           probeHistogram[C_HASH_TABLE_PROBE_HISTOGRAM_SIZE];    /* 最后一项包括更长的探测 */
+    cuint64         lookups;                /* 以下两项只在定义 C_HASH_TABLE_PROBE_STATS 编译时统计 */
+    cuint64         probes;
+};
+
 
 CHashTable*     c_hash_table_new                        (CHashFunc hashFunc, CEqualFunc keyEqualFunc);
 CHashTable*     c_hash_table_new_full                   (CHashFunc hashFunc, CEqualFunc keyEqualFunc, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc);
+
+/**
+ * @brief 创建开放寻址(Swiss table 风格)的 hash 表，接口与普通 hash 表完全相同
+ * @note 每个槽位额外保存 1 字节控制位，查找时一次比较 16 个控制位(SSE2)，
+ *       只有 7 位标签相同的槽位才调用 keyEqualFunc，适合元素多、查找频繁的表
+ */
+CHashTable*     c_hash_table_new_flat                   (CHashFunc hashFunc, CEqualFunc keyEqualFunc);
+CHashTable*     c_hash_table_new_flat_full              (CHashFunc hashFunc, CEqualFunc keyEqualFunc, CDestroyNotify keyDestroyFunc, CDestroyNotify valueDestroyFunc);
+
+/**
+ * @brief 创建与 otherHashTable 使用相同 hash/比较/释放函数的空表，同时继承 flat、渐进式扩容与 c_hash_table_reserve 的预留设置
+ */
 CHashTable*     c_hash_table_new_similar                (CHashTable* otherHashTable);
+
+/**
+ * @brief 渐进式扩容，默认关闭
+ * @note 开启后扩容时保留旧存储，每次插入/删除只迁移有限个槽位，避免大表在一次插入中整体重新 hash 造成的延迟尖峰；
+ *       迁移期间查找依次检查新、旧存储，查找与遍历(foreach/find/get_keys 等)不会修改表；
+ *       c_hash_table_iter_init、c_hash_table_foreach_remove/steal 会先完成剩余的迁移。关闭时立即完成迁移；
+ *       收缩总是立即完成
+ */
+void            c_hash_table_set_incremental_resize     (CHashTable* hashTable, bool incremental);
+
+/**
+ * @brief 预留能容纳 n 个元素的空间，装入已知数量的元素时只扩容一次
+ * @note 之后删除元素时表不会收缩到 n 以下，c_hash_table_reserve (hashTable, 0) 取消预留；总是立即(非渐进)扩容
+ */
+void            c_hash_table_reserve                    (CHashTable* hashTable, cuint n);
+
+/**
+ * @brief 批量插入，语义与逐个调用 c_hash_table_insert 相同，values 为 NULL 时 value 与 key 相同
+ * @note 先一次扩容到位，再按批计算 hash 并预取槽位后插入，隐藏大表的内存访问延迟
+ * @return 新插入的 key 个数
+ */
+cuint           c_hash_table_insert_many                (CHashTable* hashTable, void** keys, void** values, cuint n);
+
+/**
+ * @brief 批量查找，values[i] 为 keys[i] 对应的 value，不存在时为 NULL
+ * @return 找到的 key 个数
+ */
+cuint           c_hash_table_lookup_many                (CHashTable* hashTable, void** keys, cuint n, void** values);
+
+/**
+ * @brief 统计负载、墓碑与探测长度，用来区分 hash 函数分布不好与墓碑堆积
+ * @note 需要遍历所有元素并重新走一遍探测序列，不要在热路径上调用
+ */
+void            c_hash_table_get_stats                  (CHashTable* hashTable, CHashTableStats* stats);
+
+/**
+ * @brief 不改变容量，原地重排所有元素以清除墓碑
+ * @note 渐进式扩容中会先完成迁移；会使正在进行的迭代失效
+ */
+void            c_hash_table_purge_tombstones           (CHashTable* hashTable);
 void            c_hash_table_destroy                    (CHashTable* hashTable);
 bool            c_hash_table_insert                     (CHashTable* hashTable, void* key, void* value);
 bool            c_hash_table_replace                    (CHashTable* hashTable, void* key, void* value);
@@ -88,12 +163,34 @@ void            c_hash_table_iter_steal                 (CHashTableIter* iter);
 CHashTable*     c_hash_table_ref                        (CHashTable* hashTable);
 void            c_hash_table_unref                      (CHashTable* hashTable);
 
+/**
+ * @brief 字符串/二进制数据使用 wyhash(每次处理 8 字节)，整数、浮点数与指针使用 64 位混合函数，
+ *        结果的低位同样分布均匀
+ */
 cuint    c_int_hash     (const void* v);
 cuint    c_str_hash     (const void* v);
+cuint    c_str_hash_len (const char* str, csize len);
+cuint    c_data_hash    (const void* data, csize len);
 cuint    c_int64_hash   (const void* v);
 cuint    c_double_hash  (const void* v);
 cuint    c_direct_hash  (const void* v) C_CONST;
 
+/**
+ * @brief 64 位 hash，供自定义 CHashFunc 组合使用
+ */
+cuint64  c_hash_mix64   (cuint64 x) C_CONST;
+cuint64  c_hash_wy      (const void* data, csize len, cuint64 seed);
+
+/**
+ * @brief 设置 c_str_hash/c_str_hash_len/c_data_hash/c_int_hash/c_int64_hash/c_double_hash 使用的种子，默认为 0
+ * @note 必须在第一次计算 hash 之前调用(包括 quark 等库内部的表)，已有 hash 值依赖旧种子，
+ *       之后的修改会被拒绝并输出警告；c_hash_get_seed() 同样视为使用了种子。
+ *       c_hash_set_random_seed() 使用随机种子，用于抵御针对 hash 冲突的攻击，hash 值在进程之间不再相同
+ */
+void     c_hash_set_seed        (cuint64 seed);
+cuint64  c_hash_get_seed        (void);
+void     c_hash_set_random_seed (void);
+
 C_END_EXTERN_C
 
 #endif //CLIBRARY_HASH_TABLE_H
@@ -13,6 +13,8 @@
 
 #include "list.h"
 
+#include "slice.h"
+
 
 static inline CList* _c_list_remove_link (CList* list, CList* link);
 static CList* c_list_sort_real (CList* list, CFunc compareFunc, void* udata);
@@ -22,27 +24,17 @@ static CList* c_list_insert_sorted_real (CList* list, void* data, CFunc func, vo
 
 CList* c_list_alloc (void)
 {
-    CList* list = c_malloc0 (sizeof(CList));
-
-    list->next = NULL;
-    list->prev = NULL;
-
-    return list;
+    return c_slice_new0 (CList);
 }
 
 void c_list_free (CList* list)
 {
-    CList* i = NULL;
-    CList* k = NULL;
-    for (i = list; i; i = k) {
-        k = i->next;
-        c_free(i);
-    }
+    c_slice_free_chain (CList, list, next);
 }
 
 void c_list_free_1 (CList* list)
 {
-    c_free(list);
+    c_slice_free (CList, list);
 }
 
 void c_list_free_full (CList* list, CDestroyNotify freeFunc)
@@ -16,24 +16,58 @@
 #include <time.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <ctype.h>
 #include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
 #include <pthread.h>
+#include <dirent.h>
+#include <spawn.h>
 #include <sys/uio.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <sys/types.h>
 
+#include "quark.h"
+#include "utils.h"
+#include "thread.h"
+#include "mapped-file.h"
+
 #define LOG_IOVEC_MAX               16
 #define LOG_FILENAME_LEN            (1024)
 #define LOG_DIRNAME_LEN             (1024)
 #define LOG_PATH_MAX                (2048)
 #define LOG_BUF_SIZE                (20480)
+#define LOG_PREFIX_LEN              (512)
 #define PATH_SPLIT                  '/'
 
+#define LOG_BIN_MAGIC               "CLOGBIN\001"
+#define LOG_BIN_MAGIC_LEN           (8)
+#define LOG_BIN_MAX_ARGS            (32)
+#define LOG_SITE_BUSY               (0xFFFFFFFFU)
+
+#define LOG_TAG_LEVEL_MAX           (256)                               // 必须是 2 的幂
+
+#define LOG_ROTATE_MAX_FILES        (5)
+#define LOG_ROTATE_NAME_LEN         (LOG_PATH_MAX + 64)
+
+#define LOG_ASYNC_RING_SIZE         (8192)
+#define LOG_ASYNC_SLOT_SIZE         (512)
+#define LOG_ASYNC_BATCH             (64)
+#define LOG_ASYNC_IDLE_US           (100 * 1000)
+#define LOG_ASYNC_FULL_US           (1000)
+
+#define LOG_BUFFERED_SIZE           (64 * 1024)
+#define LOG_BUFFERED_FLUSH_MS       (200)
+
+#define LOG_MMAP_MAGIC              "CLOGMMAP"
+#define LOG_MMAP_MAGIC_LEN          (8)
+#define LOG_MMAP_VERSION            (1)
+#define LOG_MMAP_HEADER_SIZE        (64)
+
 
 #define FG_BLACK                    30
 #define FG_RED                      31
@@ -67,26 +101,248 @@
 #define WHITE(str)                  "\033[37m" str "\033[0m"
 
 
+typedef struct _LogAsync            LogAsync;
+typedef struct _LogAsyncSlot        LogAsyncSlot;
+
+struct _LogAsyncSlot
+{
+    cuint64             seq;                                            // 槽位序号，seq == pos 可写，seq == pos + 1 可读
+    csize               len;
+    CLogFormat          format;                                         // 日志的编码格式
+    char*               heap;                                           // 超出 data 容量的日志
+    char                data[LOG_ASYNC_SLOT_SIZE];
+};
+
+struct _LogAsync
+{
+    LogAsyncSlot*       slots;
+    cuint64             mask;
+    CLogAsyncPolicy     policy;
+    CThread*            thread;                                         // 写线程
+    CMutex              lock;                                           // 仅用于写线程/生产者休眠与唤醒
+    CCond               notEmpty;
+    CCond               notFull;
+    cint                sleeping;                                       // 写线程是否在等待新日志
+    cint                waiters;                                        // 等待队列空间的生产者个数
+    cint                stop;                                           // 写线程写完队列中的日志后退出
+    cint                closing;                                        // 正在关闭，队列满时生产者直接丢弃
+    cuint64             dropped;
+    cuint64             tail;                                           // 写线程读取位置，仅写线程修改
+    cuint64             head __attribute__((aligned(64)));              // 生产者写入位置
+};
+
+typedef struct _LogBuffered         LogBuffered;
+typedef struct _LogThreadBuf        LogThreadBuf;
+typedef struct _LogTimeCache        LogTimeCache;
+typedef struct _LogTagLevel         LogTagLevel;
+typedef struct _LogSiteInfo         LogSiteInfo;
+typedef struct _LogFmtSpec          LogFmtSpec;
+typedef struct _LogBinEvent         LogBinEvent;
+typedef struct _LogBinSite          LogBinSite;
+typedef struct _LogMmapHeader       LogMmapHeader;
+
+/**
+ * mmap 日志段: 文件头 LogMmapHeader(占 LOG_MMAP_HEADER_SIZE 字节)，之后是容量为 capacity 的数据区，
+ * 数据区内容与普通日志文件相同(文本或二进制格式)。每条日志拷贝进映射区后再更新 committed，
+ * 进程崩溃时页缓存中的内容仍会写回文件，重新打开时 committed 之后的内容视为无效。
+ * 段写满切分或关闭日志时把文件截断到 LOG_MMAP_HEADER_SIZE + committed。
+ */
+struct _LogMmapHeader
+{
+    char                magic[LOG_MMAP_MAGIC_LEN];
+    cuint32             version;
+    cuint32             headerSize;
+    cuint64             capacity;                                       // 数据区容量
+    cuint64             committed;                                      // 数据区已提交字节数
+};
+
+/**
+ * 二进制日志文件: 文件头 LOG_BIN_MAGIC，之后是若干记录，记录均以本机字节序写入
+ *  - LOG_BIN_SITE:  LogBinSite + tag + file + func + fmt
+ *  - LOG_BIN_EVENT: LogBinEvent + 按格式化字符串顺序排列的参数
+ *  - LOG_BIN_TEXT:  LogBinEvent + line + 4 个 uint16 长度 + tag + file + func + 已格式化的消息
+ *                   (无调用点或格式化字符串不支持二进制编码时使用)
+ *  - LOG_BIN_RAW:   LogBinEvent + c_log_raw() 输出的原始内容
+ *
+ * 参数编码: 整数 4/8 字节，浮点 8 字节(long double 为 sizeof(long double))，指针 8 字节，
+ * 字符串为 4 字节长度加内容
+ */
+typedef enum
+{
+    LOG_BIN_SITE = 1,
+    LOG_BIN_EVENT,
+    LOG_BIN_TEXT,
+    LOG_BIN_RAW,
+} LogBinType;
+
+typedef enum
+{
+    LOG_ARG_NONE = 0,                                                   // "%%"
+    LOG_ARG_INT,
+    LOG_ARG_LONG,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LDOUBLE,
+    LOG_ARG_STR,
+    LOG_ARG_PTR,
+    LOG_ARG_INVALID,                                                    // 不支持二进制编码: %n %m $ %ls 等
+} LogArgType;
+
+struct _LogBinSite
+{
+    cuint8              type;
+    cuint8              level;
+    cuint16             reserved;
+    cuint32             id;
+    cint32              line;
+    cuint16             tagLen;
+    cuint16             fileLen;
+    cuint16             funcLen;
+    cuint16             fmtLen;
+};
+
+struct _LogBinEvent
+{
+    cuint8              type;
+    cuint8              level;
+    cuint16             reserved;
+    cuint32             id;
+    cuint64             time;                                           // 微秒
+    cuint32             pid;
+    cuint32             len;
+};
+
+struct _LogFmtSpec
+{
+    cint                nstar;                                          // '*' 宽度/精度参数个数
+    cint                prec;                                           // %s 的精度，-1 表示未指定
+    LogArgType          type;
+};
+
+struct _LogSiteInfo
+{
+    cuint32             id;
+    CLogLevel           level;
+    cint                line;
+    bool                binary;                                         // 格式化字符串是否支持二进制编码
+    const cchar*        fmtPtr;                                         // 注册时的格式化字符串地址
+    char*               tag;
+    char*               file;
+    char*               func;
+    char*               fmt;
+    cint                nargs;
+    cuint8              args[LOG_BIN_MAX_ARGS];
+    cint                precs[LOG_BIN_MAX_ARGS];                        // 字符串参数的精度，-2 表示由前一个 '*' 参数给出
+};
+
+struct _LogBuffered
+{
+    CThread*            thread;                                         // 定时刷新线程
+    CMutex              lock;
+    CCond               cond;
+    cint                stop;
+    cint64              intervalUs;                                     // 刷新间隔
+};
+
+struct _LogThreadBuf
+{
+    CMutex              lock;                                           // 只与刷新线程竞争
+    csize               len;
+    CLogFormat          format;                                         // 缓冲区中日志的编码格式
+    LogThreadBuf*       prev;
+    LogThreadBuf*       next;
+    char                data[LOG_BUFFERED_SIZE];
+};
+
+struct _LogTagLevel
+{
+    cuint32             quark;                                          // 0 表示空槽位，写入后不再变化
+    cint                level;                                          // -1 表示未设置，使用全局级别
+};
+
+struct _LogTimeCache
+{
+    time_t              sec;                                            // 缓存对应的秒
+    csize               len;                                            // "[YYYY-mm-dd HH:MM:SS." 的长度
+    char                buf[32];
+};
+
 static bool open_file();
 static void log_init_once(void);
 static cint check_dir (const cchar* path);
 static const cchar* get_dir(const cchar* path);
-static cuint64 get_file_size(const char *path);
-static cint log_open_rewrite(const char *path);
+static void log_rotate(bool force);
+static void log_rotate_wait_compress(void);
 static cint mkdir_r(const char* path, mode_t mode);
 static void log_get_time(cchar* str, cint len, cint flag);
 static const cchar* file_name(const char* path, cint64 len);
-static cint64 log_write(CLogType logType, struct iovec *vec, cint n);
-static void log_print(CLogType logType, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg);
+static cint64 log_write(CLogType logType, CLogFormat format, struct iovec *vec, cint n);
+static void log_output(CLogType logType, CLogLevel level, CLogFormat format, struct iovec* vec, cint n);
+static void log_print(CLogType logType, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg, csize msgLen);
+static void log_pid_init(void);
+static void log_vprint(CLogType logType, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* fmt, va_list ap);
+static void log_binary_print(CLogSite* site, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* fmt, va_list ap);
+static void log_binary_raw(CLogLevel level, const cchar* msg, csize len);
+static void log_binary_text(CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg, csize msgLen);
+static void log_binary_file_begin(void);
+static bool log_file_check_format(void);
+static void log_file_switch_format(CLogFormat format);
+static cint64 log_file_append(const struct iovec* vec, cint n);
+
+static void log_mmap_open (void);
+static void log_mmap_close (void);
+static cint64 log_mmap_append (const struct iovec* vec, cint n);
+
+static void log_level_update (void);
+static bool log_level_enabled (CLogLevel level, const cchar* tag, CLogSite* site);
+
+static void log_async_stop (void);
+static void log_async_free (LogAsync* async);
+static LogAsync* log_async_acquire (void);
+static void log_async_release (void);
+static void* log_async_writer (void* udata);
+static LogAsync* log_async_new (cuint ringSize, CLogAsyncPolicy policy);
+static void log_async_drain (LogAsync* async);
+static void log_async_push (LogAsync* async, CLogFormat format, const struct iovec* vec, cint n);
+
+static void log_buffered_stop (void);
+static LogBuffered* log_buffered_acquire (void);
+static void log_buffered_release (void);
+static void log_thread_buf_free (void* data);
+static void log_thread_buf_flush_all (void);
+static void log_thread_buf_flush (LogThreadBuf* buf, const struct iovec* vec, cint n);
+static LogBuffered* log_buffered_new (cuint flushMs);
+static void* log_buffered_flusher (void* udata);
+static void log_thread_buf_push (CLogLevel level, CLogFormat format, const struct iovec* vec, cint n);
 
 
 static const char* gsLogLevelStr[] = {
-    "ERROR",
-    "CRIT",
-    "WARN",
-    "INFO",
-    "DEBUG",
-    "VERBOSE",
+    "[ERROR] ",
+    "[CRIT] ",
+    "[WARN] ",
+    "[INFO] ",
+    "[DEBUG] ",
+    "[VERBOSE] ",
+    NULL
+};
+
+static const char* gsLogLevelConsoleStr[] = {
+    B_RED("[ERROR] "),
+    B_YELLOW("[CRIT] "),
+    B_BLUE("[WARN] "),
+    B_GREEN("[INFO] "),
+    B_CYAN("[DEBUG] "),
+    B_WHITE("[VERBOSE] "),
+    NULL
+};
+
+// 控制台消息颜色，与 RED(" %s") 等格式一致
+static const char* gsLogMsgConsoleStr[] = {
+    "\033[31m ",
+    "\033[33m ",
+    "\033[34m ",
+    "\033[32m ",
+    "\033[36m ",
+    "\033[37m ",
     NULL
 };
 
@@ -94,16 +350,48 @@ static const char* gsLogLevelStr[] = {
 //static CLogType gsLogType = C_LOG_TYPE_CONSOLE;                       // 日志默认输出到控制台
 static unsigned long long gsLogSize = 0;                                // 日志文件大小
 static CLogLevel gsLogLevel = C_LOG_LEVEL_WARNING;                      // 输出日至级别
+cint gsLogLevelMax = C_LOG_LEVEL_VERB;                                  // 全局与各 tag 级别的最大值，初始化前放行；C_LOG_LEVEL_ENABLED 直接读取
+static LogTagLevel gsLogTagLevels[LOG_TAG_LEVEL_MAX];                   // 以 tag 的 CQuark 为键的开放寻址表，读取无锁
+static cuint gsLogTagLevelNum = 0;                                      // 已设置级别的 tag 个数
+static pthread_mutex_t gsLogLevelMutex = PTHREAD_MUTEX_INITIALIZER;     // 修改日志级别时使用
 static char gsLogDir[LOG_DIRNAME_LEN] = "./";                           // 日志输出文件夹
 static char gsLogPrefix[LOG_FILENAME_LEN] = "log";                      // 日志名称
 static char gsLogSuffix[LOG_FILENAME_LEN] = "log";                      // 日志扩展名
 static char gsPathName[LOG_PATH_MAX] = {0};                             // 完整日志路径
 static int gsLogFd = 0;                                                 // 当前打开的日志文件描述符
+static cuint64 gsLogWritten = 0;                                        // 当前日志文件已写入字节数
+static CLogRotateMode gsLogRotateMode = C_LOG_ROTATE_NUMBERED;          // 切分后备份文件命名方式
+static cuint gsLogRotateMax = LOG_ROTATE_MAX_FILES;                     // 最多保留备份文件个数
+static bool gsLogRotateCompress = false;                                // 是否压缩备份文件
+static CThread* gsLogCompressThread = NULL;                             // 正在执行的压缩任务
 static bool gsHasTime = false;                                          // 文件名中是否带时间
-
-static pthread_mutex_t gsLogMutex;                                      // 日志锁
+static CLogFormat gsLogFormat = C_LOG_FORMAT_TEXT;                      // 新日志的编码格式
+static CLogFormat gsLogFileFormat = C_LOG_FORMAT_TEXT;                  // 当前日志文件的格式，持有 gsLogMutex 时修改
+static cint gsLogFileSwitching = 0;                                     // 正在切换文件格式，不持锁的写入改走加锁路径
+static cuint gsLogFileWriters = 0;                                      // 正在不持锁写入当前文件的线程个数
+static LogSiteInfo** gsLogSites = NULL;                                 // 已注册的调用点，下标为 id - 1
+static cuint gsLogSiteNum = 0;
+static cuint gsLogSiteCap = 0;
+
+static pthread_mutex_t gsLogMutex = PTHREAD_MUTEX_INITIALIZER;          // 日志锁，c_log_destroy() 时其它线程可能仍在使用，不销毁
 static pthread_once_t gsThreadOnce = PTHREAD_ONCE_INIT;                 // 确保初始化一次
 static bool gsIsLogInit = false;                                        // 是否完成初始化
+static LogAsync* gsLogAsync = NULL;                                     // 异步模式下的日志队列
+static cuint gsLogAsyncUsers = 0;                                       // 正在使用 gsLogAsync 的线程个数
+static cuint64 gsLogAsyncDropped = 0;                                   // 已关闭队列的丢弃条数
+static LogBuffered* gsLogBuffered = NULL;                               // 线程缓冲模式下的刷新线程
+static cuint gsLogBufferedUsers = 0;                                    // 正在使用线程缓冲区写文件的线程个数
+static LogThreadBuf* gsLogThreadBufs = NULL;                            // 所有线程的日志缓冲区
+static bool gsLogMmapMode = false;                                      // 是否使用 mmap 日志段
+static CMappedFile* gsLogMmap = NULL;                                   // 当前映射的日志段，NULL 表示使用 writev
+static LogMmapHeader* gsLogMmapHeader = NULL;
+static pthread_mutex_t gsLogThreadBufMutex = PTHREAD_MUTEX_INITIALIZER; // 保护 gsLogThreadBufs 链表
+static CPrivate gsLogThreadBufPrivate = C_PRIVATE_INIT(log_thread_buf_free);
+static char gsLogPid[32] = {0};                                         // 缓存 "pid:xxx"，fork 后刷新
+static csize gsLogPidLen = 0;
+static cuint32 gsLogPidNum = 0;
+static pthread_once_t gsLogPidOnce = PTHREAD_ONCE_INIT;
+static __thread LogTimeCache gsLogTimeCache = { -1, 0, {0} };          // 每个线程缓存到秒的时间前缀
 
 
 bool c_log_init(CLogLevel level, cuint64 logSize, const cchar *dir, const cchar *prefix, const cchar *suffix, bool hasTime)
@@ -118,7 +406,7 @@ bool c_log_init(CLogLevel level, cuint64 logSize, const cchar *dir, const cchar
         return false;
     }
 
-    gsLogLevel = level;
+    c_log_set_level(level);
     gsHasTime = hasTime;
     if (logSize > 0) {
         gsLogSize = logSize;
@@ -165,25 +453,256 @@ RET_ERR:
     return false;
 }
 
+bool c_log_init_async(CLogLevel level, cuint64 logSize, const cchar* dir, const cchar* prefix, const cchar* suffix, bool hasTime, cuint ringSize, CLogAsyncPolicy policy)
+{
+    if (!c_log_init(level, logSize, dir, prefix, suffix, hasTime)) {
+        return false;
+    }
+
+    if (NULL != __atomic_load_n(&gsLogAsync, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+
+    LogAsync* async = log_async_new(ringSize, policy);
+    if (NULL == async) {
+        return false;
+    }
+
+    __atomic_store_n(&gsLogAsyncDropped, 0, __ATOMIC_RELAXED);
+
+    LogAsync* expected = NULL;
+    if (!__atomic_compare_exchange_n(&gsLogAsync, &expected, async, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // 其它线程已经完成异步初始化
+        log_async_free(async);
+    }
+
+    return true;
+}
+
+bool c_log_init_buffered(CLogLevel level, cuint64 logSize, const cchar* dir, const cchar* prefix, const cchar* suffix, bool hasTime, cuint flushMs)
+{
+    if (!c_log_init(level, logSize, dir, prefix, suffix, hasTime)) {
+        return false;
+    }
+
+    if (NULL != __atomic_load_n(&gsLogBuffered, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+
+    LogBuffered* buffered = log_buffered_new(flushMs);
+    if (NULL == buffered) {
+        return false;
+    }
+
+    LogBuffered* expected = NULL;
+    if (!__atomic_compare_exchange_n(&gsLogBuffered, &expected, buffered, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // 其它线程已经完成初始化
+        __atomic_store_n(&buffered->stop, 1, __ATOMIC_SEQ_CST);
+        c_mutex_lock(&buffered->lock);
+        c_cond_signal(&buffered->cond);
+        c_mutex_unlock(&buffered->lock);
+        c_thread_join(buffered->thread);
+        free(buffered);
+    }
+
+    return true;
+}
+
+bool c_log_init_mmap(CLogLevel level, cuint64 logSize, const cchar* dir, const cchar* prefix, const cchar* suffix, bool hasTime)
+{
+    if (c_log_is_inited()) {
+        // 映射在打开文件时建立，已经初始化后不能再切换
+        return gsLogMmapMode;
+    }
+
+    gsLogMmapMode = true;
+
+    return c_log_init(level, logSize, dir, prefix, suffix, hasTime);
+}
+
+void c_log_flush(void)
+{
+    LogThreadBuf* buf = c_private_get(&gsLogThreadBufPrivate);
+    if (NULL == buf || !c_log_is_inited()) {
+        return;
+    }
+
+    c_mutex_lock(&buf->lock);
+    log_thread_buf_flush(buf, NULL, 0);
+    c_mutex_unlock(&buf->lock);
+}
+
+cuint64 c_log_async_dropped(void)
+{
+    cuint64 dropped = 0;
+    LogAsync* async = log_async_acquire();
+
+    if (NULL != async) {
+        dropped = __atomic_load_n(&async->dropped, __ATOMIC_RELAXED);
+    }
+    else {
+        dropped = __atomic_load_n(&gsLogAsyncDropped, __ATOMIC_RELAXED);
+    }
+    log_async_release();
+
+    return dropped;
+}
+
+void c_log_set_rotate(CLogRotateMode mode, cuint maxFiles, bool compress)
+{
+    pthread_mutex_lock(&gsLogMutex);
+    gsLogRotateMode = mode;
+    gsLogRotateMax = maxFiles;
+    gsLogRotateCompress = compress;
+    pthread_mutex_unlock(&gsLogMutex);
+}
+
+void c_log_set_level(CLogLevel level)
+{
+    pthread_mutex_lock(&gsLogLevelMutex);
+    __atomic_store_n(&gsLogLevel, level, __ATOMIC_RELAXED);
+    log_level_update();
+    pthread_mutex_unlock(&gsLogLevelMutex);
+}
+
+CLogLevel c_log_get_level(void)
+{
+    return __atomic_load_n(&gsLogLevel, __ATOMIC_RELAXED);
+}
+
+cint c_log_get_level_max(void)
+{
+    return __atomic_load_n(&gsLogLevelMax, __ATOMIC_RELAXED);
+}
+
+bool c_log_set_tag_level(const cchar* tag, CLogLevel level)
+{
+    c_return_val_if_fail(NULL != tag, false);
+
+    cuint i = 0;
+    bool ret = false;
+    CQuark quark = c_quark_from_string(tag);
+
+    pthread_mutex_lock(&gsLogLevelMutex);
+    for (i = 0; i < LOG_TAG_LEVEL_MAX; ++i) {
+        LogTagLevel* slot = &gsLogTagLevels[(quark * 2654435761U + i) & (LOG_TAG_LEVEL_MAX - 1)];
+        if (0 == slot->quark || quark == slot->quark) {
+            if (0 == slot->quark || slot->level < 0) {
+                __atomic_add_fetch(&gsLogTagLevelNum, 1, __ATOMIC_RELAXED);
+            }
+            // 先写级别再发布 quark，读者看到 quark 时级别一定有效
+            __atomic_store_n(&slot->level, (cint) level, __ATOMIC_RELAXED);
+            __atomic_store_n(&slot->quark, quark, __ATOMIC_RELEASE);
+            ret = true;
+            break;
+        }
+    }
+    log_level_update();
+    pthread_mutex_unlock(&gsLogLevelMutex);
+
+    return ret;
+}
+
+void c_log_unset_tag_level(const cchar* tag)
+{
+    c_return_if_fail(NULL != tag);
+
+    cuint i = 0;
+    CQuark quark = c_quark_try_string(tag);
+    if (0 == quark) {
+        return;
+    }
+
+    pthread_mutex_lock(&gsLogLevelMutex);
+    for (i = 0; i < LOG_TAG_LEVEL_MAX; ++i) {
+        LogTagLevel* slot = &gsLogTagLevels[(quark * 2654435761U + i) & (LOG_TAG_LEVEL_MAX - 1)];
+        if (0 == slot->quark) {
+            break;
+        }
+        if (quark == slot->quark) {
+            if (slot->level >= 0) {
+                __atomic_store_n(&slot->level, -1, __ATOMIC_RELAXED);
+                __atomic_sub_fetch(&gsLogTagLevelNum, 1, __ATOMIC_RELAXED);
+            }
+            break;
+        }
+    }
+    log_level_update();
+    pthread_mutex_unlock(&gsLogLevelMutex);
+}
+
+void c_log_set_format(CLogFormat format)
+{
+    __atomic_store_n(&gsLogFormat, format, __ATOMIC_RELEASE);
+
+    // 先写出已经按原格式编码、还在异步队列和线程缓冲区中的日志，再切分文件。
+    // 与本调用并发、仍按原格式编码的日志由写入方按每条日志的格式切换文件
+    LogAsync* async = log_async_acquire();
+    if (NULL != async) {
+        log_async_drain(async);
+    }
+    log_async_release();
+
+    if (NULL != log_buffered_acquire()) {
+        log_thread_buf_flush_all();
+    }
+    log_buffered_release();
+
+    // 未初始化或已销毁时 gsLogFd 已关闭，下次 open_file 按新格式打开
+    pthread_mutex_lock(&gsLogMutex);
+    if (c_log_is_inited() && format != gsLogFileFormat) {
+        log_file_switch_format(format);
+    }
+    pthread_mutex_unlock(&gsLogMutex);
+}
+
 void c_log_destroy(void)
 {
     if (C_UNLIKELY(!c_log_is_inited())) {
         return;
     }
-    gsIsLogInit = false;
+    log_async_stop();
+    log_buffered_stop();
+    __atomic_store_n(&gsIsLogInit, false, __ATOMIC_RELEASE);
     pthread_mutex_lock(&gsLogMutex);
+    // 缓冲模式已停止，不会再有新的不持锁写入；等待仍在 writev 的线程之后才能关闭 gsLogFd
+    while (0 != __atomic_load_n(&gsLogFileWriters, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+    log_rotate_wait_compress();
+    log_mmap_close();
     close(gsLogFd);
+    gsLogMmapMode = false;
     gsThreadOnce = PTHREAD_ONCE_INIT;
     pthread_mutex_unlock(&gsLogMutex);
-    pthread_mutex_destroy(&gsLogMutex);
 }
 
 void c_log_print(CLogLevel level, const cchar *tag, const cchar *file, cint line, const cchar *func, const cchar *fmt,...)
 {
+    if (!log_level_enabled(level, tag, NULL)) {
+        return;
+    }
+
+    if (C_UNLIKELY(!c_log_is_inited())) {
+        fprintf(stderr, "log has not been initialized!\n");
+        return;
+    }
+
     va_list ap;
-    char buf[LOG_BUF_SIZE] = {0};
-    int n;
-    if (level > gsLogLevel) {
+
+    va_start(ap, fmt);
+    if (C_LOG_FORMAT_BINARY == __atomic_load_n(&gsLogFormat, __ATOMIC_ACQUIRE)) {
+        log_binary_print(NULL, level, tag, file, line, func, fmt, ap);
+    }
+    else {
+        log_vprint(C_LOG_TYPE_FILE, level, tag, file, line, func, fmt, ap);
+    }
+    va_end(ap);
+}
+
+void c_log_print_site(CLogSite* site, CLogLevel level, const cchar* tag, const cchar* file, int line, const cchar* func, const cchar* fmt, ...)
+{
+    if (!log_level_enabled(level, tag, site)) {
         return;
     }
 
@@ -191,49 +710,65 @@ void c_log_print(CLogLevel level, const cchar *tag, const cchar *file, cint line
         fprintf(stderr, "log has not been initialized!\n");
         return;
     }
+
+    va_list ap;
+
     va_start(ap, fmt);
-    n = vsnprintf(buf, LOG_BUF_SIZE, fmt, ap);
+    if (C_LOG_FORMAT_BINARY == __atomic_load_n(&gsLogFormat, __ATOMIC_ACQUIRE)) {
+        log_binary_print(site, level, tag, file, line, func, fmt, ap);
+    }
+    else {
+        log_vprint(C_LOG_TYPE_FILE, level, tag, file, line, func, fmt, ap);
+    }
     va_end(ap);
-    if(n < 0) {
+}
+
+void c_log_write_fields(CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg, cssize msgLen)
+{
+    if (!log_level_enabled(level, tag, NULL)) {
+        return;
+    }
+
+    if (C_UNLIKELY(!c_log_is_inited())) {
+        fprintf(stderr, "log has not been initialized!\n");
         return;
     }
 
-    log_print(C_LOG_TYPE_FILE, level, tag, file, line, func, buf);
+    csize len = (NULL == msg) ? 0 : ((msgLen < 0) ? strlen(msg) : (csize) msgLen);
+    if (C_LOG_FORMAT_BINARY == __atomic_load_n(&gsLogFormat, __ATOMIC_ACQUIRE)) {
+        log_binary_text(level, tag, file, line, func, (NULL != msg) ? msg : "<null>", (NULL != msg) ? len : 6);
+    }
+    else {
+        log_print(C_LOG_TYPE_FILE, level, tag, file, line, func, msg, len);
+    }
 }
 
 void c_log_print_console (CLogLevel level, const cchar* tag, const cchar* file, int line, const cchar* func, const cchar* fmt, ...)
 {
-    if (level > gsLogLevel) {
+    if (!log_level_enabled(level, tag, NULL)) {
         return;
     }
 
     va_list ap;
-    char buf[LOG_BUF_SIZE] = {0};
-    int n;
 
     va_start(ap, fmt);
-    n = vsnprintf(buf, LOG_BUF_SIZE, fmt, ap);
+    log_vprint(C_LOG_TYPE_CONSOLE, level, tag, file, line, func, fmt, ap);
     va_end(ap);
-    if(n < 0) {
-        return;
-    }
-
-    log_print(C_LOG_TYPE_CONSOLE, level, tag, file, line, func, buf);
 }
 
 bool c_log_is_inited()
 {
-    return gsIsLogInit;
+    return __atomic_load_n(&gsIsLogInit, __ATOMIC_ACQUIRE);
 }
 
 void c_log_raw(CLogLevel level, const cchar *fmt, ...)
 {
-    if (level > gsLogLevel) {
+    if (level > __atomic_load_n(&gsLogLevel, __ATOMIC_RELAXED)) {
         return;
     }
 
     va_list ap;
-    char buf[LOG_BUF_SIZE] = {0};
+    char buf[LOG_BUF_SIZE];
     int n;
 
     va_start(ap, fmt);
@@ -243,147 +778,266 @@ void c_log_raw(CLogLevel level, const cchar *fmt, ...)
         return;
     }
 
+    if (C_LOG_FORMAT_BINARY == __atomic_load_n(&gsLogFormat, __ATOMIC_ACQUIRE)) {
+        log_binary_raw(level, buf, C_MIN((csize) n, (csize) LOG_BUF_SIZE - 2));
+        return;
+    }
+
     struct iovec vec[2];
     vec[0].iov_base = buf;
-    vec[0].iov_len = strlen(buf);
+    vec[0].iov_len = C_MIN((csize) n, (csize) LOG_BUF_SIZE - 2);
 
     vec[1].iov_base = "\n";
     vec[1].iov_len = 1;
 
-    log_write(C_LOG_TYPE_FILE, vec, 2);
+    log_output(C_LOG_TYPE_FILE, level, C_LOG_FORMAT_TEXT, vec, 2);
 }
 
-static void log_print(CLogType logType, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg)
+static void log_level_update(void)
 {
-    struct iovec vec[LOG_IOVEC_MAX];
-    char s_time[LOG_FILENAME_LEN] = {0};
-    char s_level[LOG_FILENAME_LEN] = {0};
-    char s_tag[LOG_FILENAME_LEN] = {0};
-    char s_pid[LOG_FILENAME_LEN] = {0};
-    char s_file[LOG_DIRNAME_LEN] = {0};
-    char s_msg[LOG_BUF_SIZE] = {0};
+    cuint i = 0;
+    cint max = (cint) gsLogLevel;
 
-    pthread_mutex_lock(&gsLogMutex);
-    log_get_time(s_time, sizeof(s_time), 0);
-    if(C_LOG_TYPE_CONSOLE == logType) {
-        switch(level) {
-            case C_LOG_LEVEL_ERROR: {
-                snprintf (s_level, sizeof (s_level), B_RED("[%s] "), gsLogLevelStr[level]);
-                snprintf (s_msg, sizeof (s_msg), RED(" %s"), msg);
-                break;
-            }
-            case C_LOG_LEVEL_CRIT: {
-                snprintf (s_level, sizeof (s_level), B_YELLOW("[%s] "), gsLogLevelStr[level]);
-                snprintf (s_msg, sizeof (s_msg), YELLOW(" %s"), msg);
-                break;
-            }
-            case C_LOG_LEVEL_WARNING: {
-                snprintf (s_level, sizeof (s_level), B_BLUE("[%s] "), gsLogLevelStr[level]);
-                snprintf (s_msg, sizeof (s_msg), BLUE(" %s"), msg);
-                break;
-            }
-            case C_LOG_LEVEL_INFO: {
-                snprintf (s_level, sizeof (s_level), B_GREEN("[%s] "), gsLogLevelStr[level]);
-                snprintf (s_msg, sizeof (s_msg), GREEN(" %s"), msg);
-                break;
-            }
-            case C_LOG_LEVEL_DEBUG: {
-                snprintf (s_level, sizeof (s_level), B_CYAN("[%s] "), gsLogLevelStr[level]);
-                snprintf (s_msg, sizeof (s_msg), CYAN(" %s"), msg);
-                break;
-            }
-            case C_LOG_LEVEL_VERB:
-            default: {
-                snprintf (s_level, sizeof (s_level), B_WHITE("[%s] "), gsLogLevelStr[level]);
-                snprintf (s_msg, sizeof (s_msg), WHITE(" %s"), msg);
-                break;
-            }
+    // 调用时持有 gsLogLevelMutex
+    for (i = 0; i < LOG_TAG_LEVEL_MAX; ++i) {
+        if (0 != gsLogTagLevels[i].quark && gsLogTagLevels[i].level > max) {
+            max = gsLogTagLevels[i].level;
+        }
+    }
+    __atomic_store_n(&gsLogLevelMax, max, __ATOMIC_RELAXED);
+}
+
+static bool log_level_enabled(CLogLevel level, const cchar* tag, CLogSite* site)
+{
+    cuint i = 0;
+    CQuark quark = 0;
+    cint global = (cint) __atomic_load_n(&gsLogLevel, __ATOMIC_RELAXED);
+
+    if (C_LIKELY(0 == __atomic_load_n(&gsLogTagLevelNum, __ATOMIC_RELAXED) || NULL == tag)) {
+        return (cint) level <= global;
+    }
+
+    // 调用点缓存 tag 的 quark，只在第一次查询时加锁
+    if (NULL != site) {
+        quark = __atomic_load_n(&site->tag, __ATOMIC_RELAXED);
+        if (C_UNLIKELY(0 == quark)) {
+            quark = c_quark_from_string(tag);
+            __atomic_store_n(&site->tag, quark, __ATOMIC_RELAXED);
         }
     }
     else {
-        snprintf(s_level, sizeof(s_level) - 1, "[%s] ", gsLogLevelStr[level]);
-        snprintf(s_msg, sizeof(s_msg) - 1, " %s", (NULL == msg) ? "<null>" : msg);
+        quark = c_quark_try_string(tag);
     }
 
-    if (strlen (tag) > 0) {
-        snprintf(s_tag, sizeof(s_tag), "[%s] ", tag);
+    for (i = 0; 0 != quark && i < LOG_TAG_LEVEL_MAX; ++i) {
+        LogTagLevel* slot = &gsLogTagLevels[(quark * 2654435761U + i) & (LOG_TAG_LEVEL_MAX - 1)];
+        CQuark q = __atomic_load_n(&slot->quark, __ATOMIC_ACQUIRE);
+        if (0 == q) {
+            break;
+        }
+        if (q == quark) {
+            cint tagLevel = __atomic_load_n(&slot->level, __ATOMIC_RELAXED);
+            return (cint) level <= ((tagLevel >= 0) ? tagLevel : global);
+        }
     }
 
-    snprintf(s_pid, sizeof(s_pid), "pid:%d", getpid());
+    return (cint) level <= global;
+}
 
-    if (strlen (file) > 0) {
-        snprintf(s_file, sizeof(s_file) - 1, " %s:%d: %s", file_name(file, (cint64) strlen(file)), line, func);
-    }
+static void log_pid_refresh(void)
+{
+    gsLogPidNum = (cuint32) getpid();
+    int n = snprintf(gsLogPid, sizeof(gsLogPid), "pid:%u", gsLogPidNum);
 
-    int i = -1;
-    vec[++i].iov_base = (void*)s_time;
-    vec[i].iov_len = strlen(s_time);
-    vec[++i].iov_base = " ";
-    vec[i].iov_len = 1;
-    vec[++i].iov_base = (void*)s_tag;
-    vec[i].iov_len = strlen(s_tag);
-    vec[++i].iov_base = (void*)s_level;
-    vec[i].iov_len = strlen(s_level);
-    vec[++i].iov_base = "[";
-    vec[i].iov_len = 1;
-    vec[++i].iov_base = (void*)s_pid;
-    vec[i].iov_len = strlen(s_pid);
-    vec[++i].iov_base = (void*)s_file;
-    vec[i].iov_len = strlen(s_file);
-    vec[++i].iov_base = "]";
-    vec[i].iov_len = 1;
-    vec[++i].iov_base = (void*)s_msg;
-    vec[i].iov_len = strlen(s_msg);
-    vec[++i].iov_base = "\n";
-    vec[i].iov_len = 1;
+    gsLogPidLen = (n > 0) ? C_MIN((csize) n, sizeof(gsLogPid) - 1) : 0;
+}
+
+static void log_pid_init(void)
+{
+    log_pid_refresh();
+    pthread_atfork(NULL, NULL, log_pid_refresh);
+}
 
-    log_write(logType, vec, ++i);
+static inline void log_append(char* buf, csize* len, const cchar* str, csize n)
+{
+    csize cp = C_MIN(n, LOG_PREFIX_LEN - *len);
 
-    pthread_mutex_unlock(&gsLogMutex);
+    memcpy(buf + *len, str, cp);
+    *len += cp;
 }
 
-static const char* file_name(const char* path, cint64 len)
+static inline csize log_time_prefix(char* buf, const struct timeval* tv)
 {
-    if (NULL == path) {
-        return path;
+    LogTimeCache* cache = &gsLogTimeCache;
+
+    if (C_UNLIKELY(cache->sec != tv->tv_sec)) {
+        struct tm nowTm;
+        time_t nowSec = tv->tv_sec;
+        localtime_r(&nowSec, &nowTm);
+        cache->len = strftime(cache->buf, sizeof(cache->buf), "[%Y-%m-%d %H:%M:%S.", &nowTm);
+        cache->sec = tv->tv_sec;
     }
-    char* pend = NULL;
-    pend = (char*)path + len;
-    int i = 0;
-    for(i = 1; i < len; ++i) {
-        if((pend - i == path)
-            || (*(pend - i) == '/')
-            || (*(pend - i) == '\\')) {
-            break;
-        }
+
+    // 只补上毫秒部分
+    csize len = cache->len;
+    cuint ms = (cuint) tv->tv_usec / 1000;
+    memcpy(buf, cache->buf, len);
+    buf[len++] = (char) ('0' + ms / 100);
+    buf[len++] = (char) ('0' + ms / 10 % 10);
+    buf[len++] = (char) ('0' + ms % 10);
+    buf[len++] = ']';
+
+    return len;
+}
+
+static inline csize log_int_to_str(char* buf, cint val)
+{
+    char tmp[16];
+    csize n = 0;
+    csize len = 0;
+    cuint v = (val < 0) ? (cuint) -(cint64) val : (cuint) val;
+
+    do {
+        tmp[n++] = (char) ('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+
+    if (val < 0) {
+        buf[len++] = '-';
+    }
+    while (n > 0) {
+        buf[len++] = tmp[--n];
     }
-    if(i >= 2) i--;
 
-    return pend - i;
+    return len;
 }
 
-static cuint64 get_file_size(const char *path)
+static csize log_build_prefix(char* prefix, const struct timeval* tv, const cchar* tag, const cchar* levelStr, const cchar* pid, csize pidLen, const cchar* file, cint line, const cchar* func)
 {
-    struct stat buf;
-    if (stat(path, &buf) < 0) {
-        return 0;
+    char num[16];
+    csize len = 0;
+
+    // [time] [tag] [LEVEL] [pid:xxx file:line: func]
+    len = log_time_prefix(prefix, tv);
+    log_append(prefix, &len, " ", 1);
+    if (NULL != tag && '\0' != tag[0]) {
+        log_append(prefix, &len, "[", 1);
+        log_append(prefix, &len, tag, strlen(tag));
+        log_append(prefix, &len, "] ", 2);
+    }
+    log_append(prefix, &len, levelStr, strlen(levelStr));
+    log_append(prefix, &len, "[", 1);
+    log_append(prefix, &len, pid, pidLen);
+    if (NULL != file && '\0' != file[0]) {
+        const cchar* name = file_name(file, (cint64) strlen(file));
+        log_append(prefix, &len, " ", 1);
+        log_append(prefix, &len, name, strlen(name));
+        log_append(prefix, &len, ":", 1);
+        log_append(prefix, &len, num, log_int_to_str(num, line));
+        log_append(prefix, &len, ": ", 2);
+        if (NULL != func) {
+            log_append(prefix, &len, func, strlen(func));
+        }
     }
-    return (cuint64) buf.st_size;
+    log_append(prefix, &len, "]", 1);
+
+    return len;
 }
 
-static int log_open_rewrite(const char *path)
+static void log_vprint(CLogType logType, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* fmt, va_list ap)
 {
-    check_dir(path);
-    gsLogFd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
-    if (gsLogFd == -1) {
-        fprintf(stderr, "open %s failed: %s\n", path, strerror(errno));
-        fprintf(stderr, "use STDERR_FILEIO as output\n");
-        gsLogFd = STDERR_FILENO;
+    char buf[LOG_BUF_SIZE];
+
+    int n = vsnprintf(buf, LOG_BUF_SIZE, fmt, ap);
+    if (n < 0) {
+        return;
     }
-    return 0;
+
+    log_print(logType, level, tag, file, line, func, buf, C_MIN((csize) n, (csize) LOG_BUF_SIZE - 1));
 }
 
-static cint64 log_write(CLogType logType, struct iovec *vec, cint n)
+static void log_print(CLogType logType, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg, csize msgLen)
+{
+    cint i = -1;
+    csize len = 0;
+    struct timeval tv;
+    char prefix[LOG_PREFIX_LEN];
+    struct iovec vec[LOG_IOVEC_MAX];
+    const bool console = (C_LOG_TYPE_CONSOLE == logType);
+    const cuint idx = ((cuint) level <= C_LOG_LEVEL_VERB) ? (cuint) level : C_LOG_LEVEL_VERB;
+
+    pthread_once(&gsLogPidOnce, log_pid_init);
+    gettimeofday(&tv, NULL);
+
+    len = log_build_prefix(prefix, &tv, tag, console ? gsLogLevelConsoleStr[idx] : gsLogLevelStr[idx], gsLogPid, gsLogPidLen, file, line, func);
+
+    if (NULL == msg) {
+        msg = "<null>";
+        msgLen = 6;
+    }
+
+    vec[++i].iov_base = (void*) prefix;
+    vec[i].iov_len = len;
+    vec[++i].iov_base = (void*) (console ? gsLogMsgConsoleStr[idx] : " ");
+    vec[i].iov_len = strlen(vec[i].iov_base);
+    vec[++i].iov_base = (void*) msg;
+    vec[i].iov_len = msgLen;
+    if (console) {
+        vec[++i].iov_base = "\033[0m";
+        vec[i].iov_len = 4;
+    }
+    vec[++i].iov_base = "\n";
+    vec[i].iov_len = 1;
+
+    log_output(logType, level, C_LOG_FORMAT_TEXT, vec, ++i);
+}
+
+static void log_output(CLogType logType, CLogLevel level, CLogFormat format, struct iovec* vec, cint n)
+{
+    if (C_LOG_TYPE_FILE == logType && NULL != __atomic_load_n(&gsLogAsync, __ATOMIC_RELAXED)) {
+        LogAsync* async = log_async_acquire();
+        if (NULL != async) {
+            log_async_push(async, format, vec, n);
+            log_async_release();
+            return;
+        }
+        log_async_release();
+    }
+
+    if (C_LOG_TYPE_FILE == logType && NULL != __atomic_load_n(&gsLogBuffered, __ATOMIC_RELAXED)) {
+        if (NULL != log_buffered_acquire()) {
+            log_thread_buf_push(level, format, vec, n);
+            log_buffered_release();
+            return;
+        }
+        log_buffered_release();
+    }
+
+    pthread_mutex_lock(&gsLogMutex);
+    // 调用方检查初始化之后日志可能已被销毁，gsLogFd 已关闭甚至被复用
+    if (C_LOG_TYPE_FILE != logType || c_log_is_inited()) {
+        log_write(logType, format, vec, n);
+    }
+    pthread_mutex_unlock(&gsLogMutex);
+}
+
+static const char* file_name(const char* path, cint64 len)
+{
+    if (NULL == path) {
+        return path;
+    }
+
+    const char* p = path + len;
+    for (; p > path; --p) {
+        if (('/' == *(p - 1)) || ('\\' == *(p - 1))) {
+            break;
+        }
+    }
+
+    return p;
+}
+
+static cint64 log_write(CLogType logType, CLogFormat format, struct iovec *vec, cint n)
 {
     switch (logType) {
         default: {}
@@ -391,16 +1045,293 @@ static cint64 log_write(CLogType logType, struct iovec *vec, cint n)
             return writev(STDOUT_FILENO, vec, n);
         }
         case C_LOG_TYPE_FILE: {
-            unsigned long long tmpSize = get_file_size(gsPathName);
-            if (tmpSize >= gsLogSize) {
-                if (-1 == close(gsLogFd)) {
-                    fprintf(stderr, "close file errno:%d", errno);
-                }
-                log_open_rewrite(gsPathName);
+            // 调用时持有 gsLogMutex，一个文件中只写入一种格式
+            if (C_UNLIKELY(format != gsLogFileFormat)) {
+                log_file_switch_format(format);
+            }
+            if (__atomic_load_n(&gsLogWritten, __ATOMIC_RELAXED) >= gsLogSize) {
+                log_rotate(false);
+            }
+            cint64 ret = log_file_append(vec, n);
+            if (ret < 0 && NULL != gsLogMmap) {
+                // 当前段剩余空间放不下这次写入
+                log_rotate(true);
+                ret = log_file_append(vec, n);
+            }
+            return ret;
+        }
+    }
+}
+
+static cint64 log_file_append(const struct iovec* vec, cint n)
+{
+    // 调用时持有 gsLogMutex
+    if (NULL != gsLogMmap) {
+        return log_mmap_append(vec, n);
+    }
+
+    // 线程缓冲模式下其它线程可能同时在不持锁写入
+    cint64 ret = writev(gsLogFd, vec, n);
+    if (ret > 0) {
+        __atomic_add_fetch(&gsLogWritten, (cuint64) ret, __ATOMIC_RELAXED);
+    }
+
+    return ret;
+}
+
+static void log_rotate_wait_compress(void)
+{
+    if (NULL != gsLogCompressThread) {
+        c_thread_join(gsLogCompressThread);
+        gsLogCompressThread = NULL;
+    }
+}
+
+static void* log_compress_thread(void* udata)
+{
+    pid_t pid;
+    char* path = udata;
+    char* argv[] = {"gzip", "-f", "-q", path, NULL};
+    extern char** environ;
+
+    if (0 == posix_spawnp(&pid, "gzip", NULL, NULL, argv, environ)) {
+        waitpid(pid, NULL, 0);
+    }
+    free(path);
+
+    return NULL;
+}
+
+static void log_rotate_compress(const cchar* path)
+{
+    char* pathT = NULL;
+
+    if (!gsLogRotateCompress || NULL == (pathT = strdup(path))) {
+        return;
+    }
+
+    // 失败时不能经由 c_thread_new 输出日志，此时仍持有 gsLogMutex
+    gsLogCompressThread = c_thread_try_new("clog-compress", log_compress_thread, pathT, NULL);
+    if (NULL == gsLogCompressThread) {
+        free(pathT);
+    }
+}
+
+static void log_rotate_remove(const cchar* path)
+{
+    char gz[LOG_ROTATE_NAME_LEN] = {0};
+
+    snprintf(gz, sizeof(gz), "%s.gz", path);
+    unlink(path);
+    unlink(gz);
+}
+
+static void log_rotate_rename(const cchar* from, const cchar* to)
+{
+    char fromGz[LOG_ROTATE_NAME_LEN] = {0};
+    char toGz[LOG_ROTATE_NAME_LEN] = {0};
+
+    snprintf(fromGz, sizeof(fromGz), "%s.gz", from);
+    snprintf(toGz, sizeof(toGz), "%s.gz", to);
+    rename(from, to);
+    rename(fromGz, toGz);
+}
+
+static void log_rotate_numbered(void)
+{
+    cuint i = 0;
+    char from[LOG_ROTATE_NAME_LEN] = {0};
+    char to[LOG_ROTATE_NAME_LEN] = {0};
+
+    snprintf(to, sizeof(to), "%s.%u", gsPathName, gsLogRotateMax);
+    log_rotate_remove(to);
+
+    for (i = gsLogRotateMax - 1; i >= 1; --i) {
+        snprintf(from, sizeof(from), "%s.%u", gsPathName, i);
+        snprintf(to, sizeof(to), "%s.%u", gsPathName, i + 1);
+        log_rotate_rename(from, to);
+    }
+
+    snprintf(to, sizeof(to), "%s.1", gsPathName);
+    if (0 == rename(gsPathName, to)) {
+        log_rotate_compress(to);
+    }
+}
+
+static csize log_rotate_name_len(const cchar* name)
+{
+    csize len = strlen(name);
+
+    return (len > 3 && 0 == strcmp(name + len - 3, ".gz")) ? len - 3 : len;
+}
+
+static int log_rotate_name_cmp(const void* a, const void* b)
+{
+    const cchar* na = *(char* const*) a;
+    const cchar* nb = *(char* const*) b;
+    const csize la = log_rotate_name_len(na);
+    const csize lb = log_rotate_name_len(nb);
+
+    // 忽略 .gz 后缀，同一秒内的 name.TIME 早于 name.TIME-1
+    int ret = memcmp(na, nb, C_MIN(la, lb));
+
+    return (0 != ret) ? ret : (la > lb) - (la < lb);
+}
+
+static const cchar* log_rotate_skip_digits(const cchar* p, csize n)
+{
+    csize i = 0;
+
+    for (i = 0; (0 == n || i < n) && isdigit((unsigned char) p[i]); ++i) {}
+
+    return (i > 0 && (0 == n || i == n)) ? p + i : NULL;
+}
+
+/**
+ * @brief 判断文件名后缀是否为时间戳切分生成的备份：YYYYmmdd-HHMMSS[-N][.gz]
+ */
+static bool log_rotate_is_timestamp_suffix(const cchar* suffix)
+{
+    const cchar* p = log_rotate_skip_digits(suffix, 8);
+
+    if (NULL == p || '-' != *p || NULL == (p = log_rotate_skip_digits(p + 1, 6))) {
+        return false;
+    }
+    if ('-' == *p && NULL == (p = log_rotate_skip_digits(p + 1, 0))) {
+        return false;
+    }
+
+    return '\0' == *p || 0 == strcmp(p, ".gz");
+}
+
+static void log_rotate_prune(void)
+{
+    DIR* dir = NULL;
+    cuint i = 0;
+    cuint num = 0;
+    cuint cap = 0;
+    char** names = NULL;
+    struct dirent* ent = NULL;
+    char dirName[LOG_PATH_MAX] = {0};
+    char path[LOG_ROTATE_NAME_LEN] = {0};
+    const cchar* base = strrchr(gsPathName, PATH_SPLIT);
+
+    base = (NULL != base) ? base + 1 : gsPathName;
+    snprintf(dirName, sizeof(dirName), "%.*s", (int) (base - gsPathName), gsPathName);
+    const csize baseLen = strlen(base);
+
+    if (NULL == (dir = opendir(('\0' != dirName[0]) ? dirName : "."))) {
+        return;
+    }
+
+    while (NULL != (ent = readdir(dir))) {
+        // 只处理本模式生成的备份，其它 base.* 文件（如 base.conf）不能删除
+        if (0 != strncmp(ent->d_name, base, baseLen) || '.' != ent->d_name[baseLen]
+            || !log_rotate_is_timestamp_suffix(ent->d_name + baseLen + 1)) {
+            continue;
+        }
+        if (num >= cap) {
+            cap = (0 == cap) ? 16 : cap * 2;
+            char** tmp = realloc(names, sizeof(char*) * cap);
+            if (NULL == tmp) {
+                break;
             }
-            return writev(gsLogFd, vec, n);
+            names = tmp;
+        }
+        if (NULL != (names[num] = strdup(ent->d_name))) {
+            ++num;
+        }
+    }
+    closedir(dir);
+
+    // 时间戳备份名按字典序即为时间顺序，删除最旧的文件
+    if (num > 0) {
+        qsort(names, num, sizeof(char*), log_rotate_name_cmp);
+    }
+    for (i = 0; i < num; ++i) {
+        if (i + gsLogRotateMax < num) {
+            snprintf(path, sizeof(path), "%s%s", dirName, names[i]);
+            unlink(path);
+        }
+        free(names[i]);
+    }
+    free(names);
+}
+
+static void log_rotate_timestamp(void)
+{
+    cint i = 0;
+    struct stat buf;
+    struct tm nowTm;
+    char timeStr[32] = {0};
+    char to[LOG_ROTATE_NAME_LEN] = {0};
+    char toGz[LOG_ROTATE_NAME_LEN] = {0};
+    time_t now = time(NULL);
+
+    localtime_r(&now, &nowTm);
+    strftime(timeStr, sizeof(timeStr), "%Y%m%d-%H%M%S", &nowTm);
+
+    snprintf(to, sizeof(to), "%s.%s", gsPathName, timeStr);
+    snprintf(toGz, sizeof(toGz), "%s.gz", to);
+    for (i = 1; 0 == stat(to, &buf) || 0 == stat(toGz, &buf); ++i) {
+        snprintf(to, sizeof(to), "%s.%s-%d", gsPathName, timeStr, i);
+        snprintf(toGz, sizeof(toGz), "%s.gz", to);
+    }
+
+    if (0 == rename(gsPathName, to)) {
+        log_rotate_compress(to);
+    }
+
+    log_rotate_prune();
+}
+
+static void log_rotate(bool force)
+{
+    struct stat buf;
+
+    if (STDERR_FILENO == gsLogFd) {
+        return;
+    }
+
+    // 内存中计数可能因为外部截断而偏大，切分前以文件实际大小为准；mmap 段的计数以段头为准
+    if (!force && NULL == gsLogMmap && 0 == fstat(gsLogFd, &buf) && (cuint64) buf.st_size < gsLogSize) {
+        gsLogWritten = (cuint64) buf.st_size;
+        return;
+    }
+
+    // 上一次的压缩任务还在处理备份文件时不能移动它
+    log_rotate_wait_compress();
+    log_mmap_close();
+
+    if (0 == gsLogRotateMax) {
+        unlink(gsPathName);
+    }
+    else if (C_LOG_ROTATE_TIMESTAMP == gsLogRotateMode) {
+        log_rotate_timestamp();
+    }
+    else {
+        log_rotate_numbered();
+    }
+
+    const int mask = umask(0);
+    const int fd = open(gsPathName, O_CREAT | O_RDWR | O_APPEND, 0666);
+    umask(mask);
+    if (-1 == fd) {
+        fprintf(stderr, "open %s failed: %s\n", gsPathName, strerror(errno));
+        fprintf(stderr, "use STDERR_FILEIO as output\n");
+        close(gsLogFd);
+        __atomic_store_n(&gsLogFd, STDERR_FILENO, __ATOMIC_RELAXED);
+    }
+    else {
+        // 保持描述符编号不变，线程缓冲模式下不持锁写入的线程不会用到已关闭的描述符
+        if (-1 == dup2(fd, gsLogFd)) {
+            fprintf(stderr, "dup2 errno:%d", errno);
         }
+        close(fd);
     }
+    __atomic_store_n(&gsLogWritten, 0, __ATOMIC_RELAXED);
+    log_mmap_open();
+    log_binary_file_begin();
 }
 
 
@@ -490,7 +1421,7 @@ static void log_get_time(cchar* str, cint len, cint flag)
     char dateMs[8] = {0};
     struct timeval tv;
     struct tm nowTm;
-    cuint8 nowMs;
+    cuint nowMs;
     time_t nowSec;
     gettimeofday(&tv, NULL);
     nowSec = tv.tv_sec;
@@ -510,6 +1441,9 @@ static void log_get_time(cchar* str, cint len, cint flag)
 
 static bool open_file()
 {
+    // 重复初始化时先结束当前段，重新打开后在已提交位置之后继续写
+    log_mmap_close();
+
     if(0 != check_dir(gsLogDir)) {
         fprintf(stderr, "check_dir error, log_init failed\n");
         return false;
@@ -540,6 +1474,21 @@ static bool open_file()
         return false;
     }
 
+    struct stat buf;
+    gsLogWritten = (0 == fstat(gsLogFd, &buf)) ? (cuint64) buf.st_size : 0;
+    __atomic_store_n(&gsLogFileFormat, __atomic_load_n(&gsLogFormat, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+
+    // 不能把两种格式的日志追加到同一个文件
+    if (!log_file_check_format()) {
+        log_rotate(true);
+        return true;
+    }
+
+    log_mmap_open();
+    if (0 == gsLogWritten) {
+        log_binary_file_begin();
+    }
+
     return true;
 }
 
@@ -549,6 +1498,1396 @@ static void log_init_once(void)
         return;
     }
 
-    gsIsLogInit = true;
-    pthread_mutex_init(&gsLogMutex, NULL);
+    __atomic_store_n(&gsIsLogInit, true, __ATOMIC_RELEASE);
+}
+
+static LogAsync* log_async_new (cuint ringSize, CLogAsyncPolicy policy)
+{
+    LogAsync* async = NULL;
+    cuint64 i = 0;
+    csize size = c_nearest_pow((0 == ringSize) ? LOG_ASYNC_RING_SIZE : ringSize);
+
+    if (0 != posix_memalign((void**) &async, 64, sizeof(LogAsync))) {
+        fprintf(stderr, "malloc async log queue failed\n");
+        return NULL;
+    }
+    memset(async, 0, sizeof(LogAsync));
+
+    async->slots = calloc(size, sizeof(LogAsyncSlot));
+    if (NULL == async->slots) {
+        fprintf(stderr, "malloc async log queue failed\n");
+        free(async);
+        return NULL;
+    }
+    for (i = 0; i < size; ++i) {
+        async->slots[i].seq = i;
+    }
+
+    async->mask = size - 1;
+    async->policy = policy;
+    c_mutex_init(&async->lock);
+    c_cond_init(&async->notEmpty);
+    c_cond_init(&async->notFull);
+
+    async->thread = c_thread_new("clog-writer", log_async_writer, async);
+    if (NULL == async->thread) {
+        free(async->slots);
+        free(async);
+        return NULL;
+    }
+
+    return async;
+}
+
+static void log_async_free (LogAsync* async)
+{
+    cuint64 i = 0;
+
+    __atomic_store_n(&async->stop, 1, __ATOMIC_SEQ_CST);
+    c_mutex_lock(&async->lock);
+    c_cond_signal(&async->notEmpty);
+    c_mutex_unlock(&async->lock);
+
+    // 写线程退出前会写完队列中所有日志
+    c_thread_join(async->thread);
+
+    for (i = 0; i <= async->mask; ++i) {
+        free(async->slots[i].heap);
+    }
+    free(async->slots);
+    free(async);
+}
+
+static LogAsync* log_async_acquire (void)
+{
+    // 与 log_async_stop 配对: 先登记再读取队列指针，关闭方摘除指针后等待登记数归零
+    __atomic_add_fetch(&gsLogAsyncUsers, 1, __ATOMIC_SEQ_CST);
+
+    return __atomic_load_n(&gsLogAsync, __ATOMIC_SEQ_CST);
+}
+
+static void log_async_release (void)
+{
+    __atomic_sub_fetch(&gsLogAsyncUsers, 1, __ATOMIC_RELEASE);
+}
+
+static void log_async_stop (void)
+{
+    LogAsync* async = __atomic_exchange_n(&gsLogAsync, NULL, __ATOMIC_SEQ_CST);
+    if (NULL == async) {
+        return;
+    }
+
+    // 唤醒等待空间的生产者，队列仍满时放弃本条日志；写线程继续运行，已入队的日志不会丢失
+    __atomic_store_n(&async->closing, 1, __ATOMIC_SEQ_CST);
+    c_mutex_lock(&async->lock);
+    c_cond_broadcast(&async->notFull);
+    c_mutex_unlock(&async->lock);
+
+    // 之后的生产者读到 NULL，只需等待已经取得队列指针的生产者
+    while (0 != __atomic_load_n(&gsLogAsyncUsers, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    __atomic_store_n(&gsLogAsyncDropped, __atomic_load_n(&async->dropped, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    log_async_free(async);
+}
+
+static void log_async_wait_space (LogAsync* async)
+{
+    c_mutex_lock(&async->lock);
+    __atomic_add_fetch(&async->waiters, 1, __ATOMIC_SEQ_CST);
+    c_cond_wait_until(&async->notFull, &async->lock, c_get_monotonic_time() + LOG_ASYNC_FULL_US);
+    __atomic_sub_fetch(&async->waiters, 1, __ATOMIC_SEQ_CST);
+    c_mutex_unlock(&async->lock);
+}
+
+static void log_async_drain (LogAsync* async)
+{
+    // 等待写线程写完调用前已经入队的日志，调用时不能持有 gsLogMutex
+    const cuint64 head = __atomic_load_n(&async->head, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&async->tail, __ATOMIC_ACQUIRE) < head) {
+        sched_yield();
+    }
+}
+
+static void log_async_push (LogAsync* async, CLogFormat format, const struct iovec* vec, cint n)
+{
+    cint i = 0;
+    csize len = 0;
+    char* dst = NULL;
+    LogAsyncSlot* slot = NULL;
+
+    for (i = 0; i < n; ++i) {
+        len += vec[i].iov_len;
+    }
+
+    // 多生产者: 先抢占 head，再填充槽位，最后发布 seq
+    cuint64 pos = __atomic_load_n(&async->head, __ATOMIC_RELAXED);
+    while (true) {
+        slot = &async->slots[pos & async->mask];
+        cuint64 seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        cint64 diff = (cint64) (seq - pos);
+        if (0 == diff) {
+            if (__atomic_compare_exchange_n(&async->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            if (C_LOG_ASYNC_DROP == async->policy || __atomic_load_n(&async->closing, __ATOMIC_ACQUIRE)) {
+                __atomic_add_fetch(&async->dropped, 1, __ATOMIC_RELAXED);
+                return;
+            }
+            log_async_wait_space(async);
+            pos = __atomic_load_n(&async->head, __ATOMIC_RELAXED);
+        }
+        else {
+            pos = __atomic_load_n(&async->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    dst = slot->data;
+    if (len > sizeof(slot->data)) {
+        slot->heap = malloc(len);
+        if (NULL != slot->heap) {
+            dst = slot->heap;
+        }
+        else {
+            len = sizeof(slot->data);
+        }
+    }
+
+    slot->len = 0;
+    slot->format = format;
+    for (i = 0; i < n && slot->len < len; ++i) {
+        csize cp = C_MIN(vec[i].iov_len, len - slot->len);
+        memcpy(dst + slot->len, vec[i].iov_base, cp);
+        slot->len += cp;
+    }
+
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&async->sleeping, __ATOMIC_SEQ_CST)) {
+        c_mutex_lock(&async->lock);
+        c_cond_signal(&async->notEmpty);
+        c_mutex_unlock(&async->lock);
+    }
+}
+
+static bool log_async_ready (LogAsync* async)
+{
+    LogAsyncSlot* slot = &async->slots[async->tail & async->mask];
+
+    return __atomic_load_n(&slot->seq, __ATOMIC_SEQ_CST) == async->tail + 1;
+}
+
+static void* log_async_writer (void* udata)
+{
+    LogAsync* async = udata;
+    struct iovec vec[LOG_ASYNC_BATCH];
+
+    while (true) {
+        cint i = 0;
+        cint n = 0;
+        cuint64 pos = async->tail;
+        CLogFormat format = C_LOG_FORMAT_TEXT;
+
+        for (n = 0; n < LOG_ASYNC_BATCH; ++n, ++pos) {
+            LogAsyncSlot* slot = &async->slots[pos & async->mask];
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+                break;
+            }
+            // 一批只写同一种格式的日志
+            if (n > 0 && slot->format != format) {
+                break;
+            }
+            format = slot->format;
+            vec[n].iov_base = (NULL != slot->heap) ? slot->heap : slot->data;
+            vec[n].iov_len = slot->len;
+        }
+
+        if (n > 0) {
+            pthread_mutex_lock(&gsLogMutex);
+            log_write(C_LOG_TYPE_FILE, format, vec, n);
+            pthread_mutex_unlock(&gsLogMutex);
+
+            for (i = 0; i < n; ++i) {
+                LogAsyncSlot* slot = &async->slots[(async->tail + i) & async->mask];
+                if (NULL != slot->heap) {
+                    free(slot->heap);
+                    slot->heap = NULL;
+                }
+                __atomic_store_n(&slot->seq, async->tail + i + async->mask + 1, __ATOMIC_RELEASE);
+            }
+            __atomic_store_n(&async->tail, async->tail + n, __ATOMIC_RELEASE);
+
+            if (__atomic_load_n(&async->waiters, __ATOMIC_SEQ_CST) > 0) {
+                c_mutex_lock(&async->lock);
+                c_cond_broadcast(&async->notFull);
+                c_mutex_unlock(&async->lock);
+            }
+            continue;
+        }
+
+        if (__atomic_load_n(&async->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        c_mutex_lock(&async->lock);
+        __atomic_store_n(&async->sleeping, 1, __ATOMIC_SEQ_CST);
+        if (!log_async_ready(async) && !__atomic_load_n(&async->stop, __ATOMIC_SEQ_CST)) {
+            c_cond_wait_until(&async->notEmpty, &async->lock, c_get_monotonic_time() + LOG_ASYNC_IDLE_US);
+        }
+        __atomic_store_n(&async->sleeping, 0, __ATOMIC_RELAXED);
+        c_mutex_unlock(&async->lock);
+    }
+
+    return NULL;
+}
+
+static LogBuffered* log_buffered_new (cuint flushMs)
+{
+    LogBuffered* buffered = calloc(1, sizeof(LogBuffered));
+    if (NULL == buffered) {
+        fprintf(stderr, "malloc buffered log failed\n");
+        return NULL;
+    }
+
+    buffered->intervalUs = (cint64) ((0 == flushMs) ? LOG_BUFFERED_FLUSH_MS : flushMs) * 1000;
+    c_mutex_init(&buffered->lock);
+    c_cond_init(&buffered->cond);
+
+    buffered->thread = c_thread_new("clog-flusher", log_buffered_flusher, buffered);
+    if (NULL == buffered->thread) {
+        free(buffered);
+        return NULL;
+    }
+
+    return buffered;
+}
+
+static LogBuffered* log_buffered_acquire (void)
+{
+    // 与 log_buffered_stop 配对: 先登记再读取指针，登记期间 gsLogFd 不会被关闭
+    __atomic_add_fetch(&gsLogBufferedUsers, 1, __ATOMIC_SEQ_CST);
+
+    return __atomic_load_n(&gsLogBuffered, __ATOMIC_SEQ_CST);
+}
+
+static void log_buffered_release (void)
+{
+    __atomic_sub_fetch(&gsLogBufferedUsers, 1, __ATOMIC_RELEASE);
+}
+
+static void log_buffered_stop (void)
+{
+    LogBuffered* buffered = __atomic_exchange_n(&gsLogBuffered, NULL, __ATOMIC_SEQ_CST);
+    if (NULL == buffered) {
+        return;
+    }
+
+    // 之后的写入方读到 NULL 走加锁路径，只需等待已经进入缓冲路径、可能正在不持锁 writev 的线程
+    while (0 != __atomic_load_n(&gsLogBufferedUsers, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    c_mutex_lock(&buffered->lock);
+    buffered->stop = 1;
+    c_cond_signal(&buffered->cond);
+    c_mutex_unlock(&buffered->lock);
+    c_thread_join(buffered->thread);
+    free(buffered);
+
+    // 刷新线程已退出，写出各线程缓冲区中剩余的日志
+    log_thread_buf_flush_all();
+}
+
+static void* log_buffered_flusher (void* udata)
+{
+    LogBuffered* buffered = udata;
+
+    c_mutex_lock(&buffered->lock);
+    while (!buffered->stop) {
+        c_cond_wait_until(&buffered->cond, &buffered->lock, c_get_monotonic_time() + buffered->intervalUs);
+        c_mutex_unlock(&buffered->lock);
+        log_thread_buf_flush_all();
+        c_mutex_lock(&buffered->lock);
+    }
+    c_mutex_unlock(&buffered->lock);
+
+    return NULL;
+}
+
+static void log_buffered_write (CLogFormat format, struct iovec* vec, cint n)
+{
+    if (NULL != __atomic_load_n(&gsLogMmap, __ATOMIC_RELAXED)) {
+        // 拷贝进映射区需要串行，一次刷新仍然只拷贝一次
+        pthread_mutex_lock(&gsLogMutex);
+        log_write(C_LOG_TYPE_FILE, format, vec, n);
+        pthread_mutex_unlock(&gsLogMutex);
+        return;
+    }
+
+    // 与 log_file_switch_format 配对: 先登记再检查文件格式，切换格式时等待登记数归零
+    __atomic_add_fetch(&gsLogFileWriters, 1, __ATOMIC_SEQ_CST);
+    if (C_UNLIKELY(__atomic_load_n(&gsLogFileSwitching, __ATOMIC_SEQ_CST) || format != __atomic_load_n(&gsLogFileFormat, __ATOMIC_RELAXED))) {
+        __atomic_sub_fetch(&gsLogFileWriters, 1, __ATOMIC_RELEASE);
+        pthread_mutex_lock(&gsLogMutex);
+        log_write(C_LOG_TYPE_FILE, format, vec, n);
+        pthread_mutex_unlock(&gsLogMutex);
+        return;
+    }
+
+    // O_APPEND 保证一次 writev 的内容整体追加到文件末尾，不会与其它线程交错
+    cint64 ret = writev(__atomic_load_n(&gsLogFd, __ATOMIC_RELAXED), vec, n);
+    const cuint64 written = (ret > 0) ? __atomic_add_fetch(&gsLogWritten, (cuint64) ret, __ATOMIC_RELAXED) : 0;
+    __atomic_sub_fetch(&gsLogFileWriters, 1, __ATOMIC_RELEASE);
+    if (written >= gsLogSize) {
+        pthread_mutex_lock(&gsLogMutex);
+        if (gsLogWritten >= gsLogSize) {
+            log_rotate(false);
+        }
+        pthread_mutex_unlock(&gsLogMutex);
+    }
+}
+
+static void log_thread_buf_flush (LogThreadBuf* buf, const struct iovec* vec, cint n)
+{
+    cint i = 0;
+    cint cnt = 0;
+    struct iovec all[LOG_IOVEC_MAX + 1];
+
+    // 调用时持有 buf->lock，缓冲区内容与 vec 合并为一次 writev
+    if (buf->len > 0) {
+        all[cnt].iov_base = buf->data;
+        all[cnt++].iov_len = buf->len;
+    }
+    for (i = 0; i < n && cnt < (cint) C_N_ELEMENTS(all); ++i) {
+        all[cnt++] = vec[i];
+    }
+
+    if (cnt > 0) {
+        log_buffered_write(buf->format, all, cnt);
+    }
+    buf->len = 0;
+}
+
+static void log_thread_buf_flush_all (void)
+{
+    LogThreadBuf* buf = NULL;
+
+    pthread_mutex_lock(&gsLogThreadBufMutex);
+    for (buf = gsLogThreadBufs; NULL != buf; buf = buf->next) {
+        c_mutex_lock(&buf->lock);
+        log_thread_buf_flush(buf, NULL, 0);
+        c_mutex_unlock(&buf->lock);
+    }
+    pthread_mutex_unlock(&gsLogThreadBufMutex);
+}
+
+static LogThreadBuf* log_thread_buf_get (void)
+{
+    LogThreadBuf* buf = c_private_get(&gsLogThreadBufPrivate);
+    if (C_LIKELY(NULL != buf)) {
+        return buf;
+    }
+
+    buf = c_private_set_alloc0(&gsLogThreadBufPrivate, sizeof(LogThreadBuf));
+    c_mutex_init(&buf->lock);
+
+    pthread_mutex_lock(&gsLogThreadBufMutex);
+    buf->next = gsLogThreadBufs;
+    if (NULL != gsLogThreadBufs) {
+        gsLogThreadBufs->prev = buf;
+    }
+    gsLogThreadBufs = buf;
+    pthread_mutex_unlock(&gsLogThreadBufMutex);
+
+    return buf;
+}
+
+static void log_thread_buf_free (void* data)
+{
+    LogThreadBuf* buf = data;
+
+    // 线程退出: 写出剩余日志后从链表中摘除
+    pthread_mutex_lock(&gsLogThreadBufMutex);
+    if (NULL != buf->prev) {
+        buf->prev->next = buf->next;
+    }
+    else {
+        gsLogThreadBufs = buf->next;
+    }
+    if (NULL != buf->next) {
+        buf->next->prev = buf->prev;
+    }
+    c_mutex_lock(&buf->lock);
+    if (NULL != log_buffered_acquire()) {
+        log_thread_buf_flush(buf, NULL, 0);
+    }
+    log_buffered_release();
+    c_mutex_unlock(&buf->lock);
+    pthread_mutex_unlock(&gsLogThreadBufMutex);
+
+    c_mutex_clear(&buf->lock);
+    c_free(buf);
+}
+
+static void log_thread_buf_push (CLogLevel level, CLogFormat format, const struct iovec* vec, cint n)
+{
+    cint i = 0;
+    csize len = 0;
+    LogThreadBuf* buf = log_thread_buf_get();
+
+    for (i = 0; i < n; ++i) {
+        len += vec[i].iov_len;
+    }
+
+    c_mutex_lock(&buf->lock);
+    // 缓冲区中只保存同一种格式的日志
+    if (C_UNLIKELY(buf->format != format)) {
+        if (buf->len > 0) {
+            log_thread_buf_flush(buf, NULL, 0);
+        }
+        buf->format = format;
+    }
+    if (buf->len + len <= sizeof(buf->data)) {
+        for (i = 0; i < n; ++i) {
+            memcpy(buf->data + buf->len, vec[i].iov_base, vec[i].iov_len);
+            buf->len += vec[i].iov_len;
+        }
+        // 错误日志立即写出
+        if (level <= C_LOG_LEVEL_CRIT) {
+            log_thread_buf_flush(buf, NULL, 0);
+        }
+    }
+    else {
+        log_thread_buf_flush(buf, vec, n);
+    }
+    c_mutex_unlock(&buf->lock);
+}
+
+static const cchar* log_fmt_spec(const cchar* p, LogFmtSpec* spec)
+{
+    bool isLong = false;
+    bool isLongDouble = false;
+
+    spec->nstar = 0;
+    spec->prec = -1;
+    spec->type = LOG_ARG_INVALID;
+
+    // p 指向 '%'
+    ++p;
+    if ('%' == *p) {
+        spec->type = LOG_ARG_NONE;
+        return p + 1;
+    }
+
+    while ('\0' != *p && NULL != strchr("-+ #0'I", *p)) {
+        ++p;
+    }
+
+    const cchar* digits = p;
+    if ('*' == *p) {
+        ++spec->nstar;
+        ++p;
+    }
+    else {
+        while (*p >= '0' && *p <= '9') {
+            ++p;
+        }
+    }
+
+    // 不支持位置参数 "%1$d"
+    if ('$' == *p || ('*' == *digits && *p >= '0' && *p <= '9')) {
+        return ('\0' != *p) ? p + 1 : p;
+    }
+
+    if ('.' == *p) {
+        ++p;
+        if ('*' == *p) {
+            ++spec->nstar;
+            spec->prec = -2;
+            ++p;
+        }
+        else {
+            spec->prec = 0;
+            while (*p >= '0' && *p <= '9') {
+                spec->prec = spec->prec * 10 + (*p - '0');
+                ++p;
+            }
+        }
+    }
+
+    switch (*p) {
+        case 'h': {
+            ++p;
+            if ('h' == *p) {
+                ++p;
+            }
+            break;
+        }
+        case 'l': {
+            ++p;
+            isLong = true;
+            if ('l' == *p) {
+                ++p;
+            }
+            break;
+        }
+        case 'L':
+        case 'q': {
+            ++p;
+            isLong = true;
+            isLongDouble = true;
+            break;
+        }
+        case 'j':
+        case 'z':
+        case 'Z':
+        case 't': {
+            ++p;
+            isLong = true;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    switch (*p) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            spec->type = isLong ? LOG_ARG_LONG : LOG_ARG_INT;
+            break;
+        }
+        case 'c': {
+            spec->type = LOG_ARG_INT;
+            break;
+        }
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            spec->type = isLongDouble ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+            break;
+        }
+        case 's': {
+            spec->type = isLong ? LOG_ARG_INVALID : LOG_ARG_STR;
+            break;
+        }
+        case 'p': {
+            spec->type = LOG_ARG_PTR;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    return ('\0' != *p) ? p + 1 : p;
+}
+
+static void log_site_info_free(LogSiteInfo* info)
+{
+    if (NULL != info) {
+        free(info->tag);
+        free(info->file);
+        free(info->func);
+        free(info->fmt);
+        free(info);
+    }
+}
+
+static LogSiteInfo* log_site_info_new(CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* fmt)
+{
+    cint i = 0;
+    const cchar* p = NULL;
+    LogSiteInfo* info = calloc(1, sizeof(LogSiteInfo));
+
+    if (NULL == info) {
+        return NULL;
+    }
+
+    info->level = level;
+    info->line = line;
+    info->fmtPtr = fmt;
+    info->tag = strdup((NULL != tag) ? tag : "");
+    info->file = strdup((NULL != file) ? file : "");
+    info->func = strdup((NULL != func) ? func : "");
+    info->fmt = strdup((NULL != fmt) ? fmt : "");
+    if (NULL == info->tag || NULL == info->file || NULL == info->func || NULL == info->fmt) {
+        log_site_info_free(info);
+        return NULL;
+    }
+
+    // 格式化字符串只解析一次，记录每个参数的类型
+    info->binary = true;
+    for (p = info->fmt; '\0' != *p;) {
+        if ('%' != *p) {
+            ++p;
+            continue;
+        }
+        LogFmtSpec spec;
+        p = log_fmt_spec(p, &spec);
+        if (LOG_ARG_NONE == spec.type) {
+            continue;
+        }
+        if (LOG_ARG_INVALID == spec.type || info->nargs + spec.nstar + 1 > LOG_BIN_MAX_ARGS) {
+            info->binary = false;
+            break;
+        }
+        for (i = 0; i < spec.nstar; ++i) {
+            info->args[info->nargs] = LOG_ARG_INT;
+            info->precs[info->nargs++] = -1;
+        }
+        info->args[info->nargs] = (cuint8) spec.type;
+        info->precs[info->nargs++] = spec.prec;
+    }
+
+    return info;
+}
+
+static char* log_site_encode(const LogSiteInfo* info, csize* len)
+{
+    LogBinSite head;
+    const csize tagLen = C_MIN(strlen(info->tag), C_MAX_UINT16);
+    const csize fileLen = C_MIN(strlen(info->file), C_MAX_UINT16);
+    const csize funcLen = C_MIN(strlen(info->func), C_MAX_UINT16);
+    const csize fmtLen = C_MIN(strlen(info->fmt), C_MAX_UINT16);
+    char* buf = malloc(sizeof(head) + tagLen + fileLen + funcLen + fmtLen);
+
+    if (NULL == buf) {
+        return NULL;
+    }
+
+    memset(&head, 0, sizeof(head));
+    head.type = LOG_BIN_SITE;
+    head.level = (cuint8) info->level;
+    head.id = info->id;
+    head.line = info->line;
+    head.tagLen = (cuint16) tagLen;
+    head.fileLen = (cuint16) fileLen;
+    head.funcLen = (cuint16) funcLen;
+    head.fmtLen = (cuint16) fmtLen;
+
+    *len = 0;
+    memcpy(buf, &head, sizeof(head));                       *len += sizeof(head);
+    memcpy(buf + *len, info->tag, tagLen);                  *len += tagLen;
+    memcpy(buf + *len, info->file, fileLen);                *len += fileLen;
+    memcpy(buf + *len, info->func, funcLen);                *len += funcLen;
+    memcpy(buf + *len, info->fmt, fmtLen);                  *len += fmtLen;
+
+    return buf;
+}
+
+static LogSiteInfo* log_site_get(CLogSite* site, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* fmt)
+{
+    cuint32 id = __atomic_load_n(&site->id, __ATOMIC_ACQUIRE);
+    if (C_LIKELY(0 != id && LOG_SITE_BUSY != id)) {
+        return site->info;
+    }
+
+    cuint32 expected = 0;
+    if (!__atomic_compare_exchange_n(&site->id, &expected, LOG_SITE_BUSY, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // 其它线程正在注册此调用点
+        while (LOG_SITE_BUSY == (id = __atomic_load_n(&site->id, __ATOMIC_ACQUIRE))) {
+            sched_yield();
+        }
+        return (0 != id) ? site->info : NULL;
+    }
+
+    LogSiteInfo* info = log_site_info_new(level, tag, file, line, func, fmt);
+    if (NULL == info) {
+        __atomic_store_n(&site->id, 0, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&gsLogMutex);
+    if (gsLogSiteNum >= gsLogSiteCap) {
+        cuint cap = (0 == gsLogSiteCap) ? 64 : gsLogSiteCap * 2;
+        LogSiteInfo** sites = realloc(gsLogSites, sizeof(LogSiteInfo*) * cap);
+        if (NULL == sites) {
+            pthread_mutex_unlock(&gsLogMutex);
+            log_site_info_free(info);
+            __atomic_store_n(&site->id, 0, __ATOMIC_RELEASE);
+            return NULL;
+        }
+        gsLogSites = sites;
+        gsLogSiteCap = cap;
+    }
+    gsLogSites[gsLogSiteNum++] = info;
+    info->id = gsLogSiteNum;
+
+    // 调用点定义必须先于引用它的日志写入，并且不能被丢弃：不经过异步队列和线程缓冲区，
+    // 持锁直接写入文件；之后切分出的新文件由 log_binary_file_begin 重新写入全部定义
+    csize len = 0;
+    char* def = log_site_encode(info, &len);
+    if (NULL != def && c_log_is_inited()) {
+        struct iovec vec = { def, len };
+        log_write(C_LOG_TYPE_FILE, C_LOG_FORMAT_BINARY, &vec, 1);
+    }
+    free(def);
+    pthread_mutex_unlock(&gsLogMutex);
+
+    site->info = info;
+    __atomic_store_n(&site->id, info->id, __ATOMIC_RELEASE);
+
+    return info;
+}
+
+static void log_binary_file_begin(void)
+{
+    cuint i = 0;
+    csize len = 0;
+
+    // 调用时持有 gsLogMutex
+    if (C_LOG_FORMAT_BINARY != gsLogFileFormat || gsLogFd <= STDERR_FILENO) {
+        return;
+    }
+
+    struct iovec vec = { LOG_BIN_MAGIC, LOG_BIN_MAGIC_LEN };
+    log_file_append(&vec, 1);
+
+    // 新文件需要重新写入所有调用点定义
+    for (i = 0; i < gsLogSiteNum; ++i) {
+        char* def = log_site_encode(gsLogSites[i], &len);
+        if (NULL != def) {
+            vec.iov_base = def;
+            vec.iov_len = len;
+            log_file_append(&vec, 1);
+            free(def);
+        }
+    }
+}
+
+static bool log_file_check_format(void)
+{
+    off_t offset = 0;
+    LogMmapHeader header;
+    char magic[LOG_BIN_MAGIC_LEN] = {0};
+
+    // 调用时 gsLogWritten 为文件实际大小
+    if (0 == gsLogWritten) {
+        return true;
+    }
+
+    // 普通日志文件和 mmap 日志段也不能混用
+    bool isMmap = (sizeof(header) == pread(gsLogFd, &header, sizeof(header), 0))
+                    && (0 == memcmp(header.magic, LOG_MMAP_MAGIC, LOG_MMAP_MAGIC_LEN))
+                    && (LOG_MMAP_HEADER_SIZE == header.headerSize)
+                    && (header.committed <= header.capacity);
+    if (isMmap != gsLogMmapMode) {
+        return false;
+    }
+    if (isMmap) {
+        if (0 == header.committed) {
+            return true;
+        }
+        offset = LOG_MMAP_HEADER_SIZE;
+    }
+
+    bool isBinary = (LOG_BIN_MAGIC_LEN == pread(gsLogFd, magic, LOG_BIN_MAGIC_LEN, offset))
+                    && (0 == memcmp(magic, LOG_BIN_MAGIC, LOG_BIN_MAGIC_LEN));
+
+    return (C_LOG_FORMAT_BINARY == gsLogFileFormat) == isBinary;
+}
+
+static void log_file_switch_format(CLogFormat format)
+{
+    // 调用时持有 gsLogMutex。先让不持锁的写入改走加锁路径，等已经开始的写入结束后再切分文件
+    __atomic_store_n(&gsLogFileSwitching, 1, __ATOMIC_SEQ_CST);
+    while (0 != __atomic_load_n(&gsLogFileWriters, __ATOMIC_SEQ_CST)) {
+        sched_yield();
+    }
+
+    __atomic_store_n(&gsLogFileFormat, format, __ATOMIC_RELAXED);
+    if (gsLogFd > STDERR_FILENO) {
+        if (__atomic_load_n(&gsLogWritten, __ATOMIC_RELAXED) > 0) {
+            log_rotate(true);
+        }
+        else {
+            log_binary_file_begin();
+        }
+    }
+
+    __atomic_store_n(&gsLogFileSwitching, 0, __ATOMIC_SEQ_CST);
+}
+
+static void log_mmap_open (void)
+{
+    struct stat buf;
+    CError* error = NULL;
+    LogMmapHeader header;
+
+    // 调用时持有 gsLogMutex，gsLogFd 已经打开且格式检查通过
+    if (!gsLogMmapMode || NULL != gsLogMmap || gsLogFd <= STDERR_FILENO || 0 != fstat(gsLogFd, &buf)) {
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));
+    if ((cuint64) buf.st_size >= LOG_MMAP_HEADER_SIZE) {
+        // 已有的日志段(包括崩溃时没来得及截断的)，在 committed 之后继续写
+        if (sizeof(header) != pread(gsLogFd, &header, sizeof(header), 0)) {
+            return;
+        }
+    }
+    else {
+        memcpy(header.magic, LOG_MMAP_MAGIC, LOG_MMAP_MAGIC_LEN);
+        header.version = LOG_MMAP_VERSION;
+        header.headerSize = LOG_MMAP_HEADER_SIZE;
+    }
+    header.capacity = C_MAX(gsLogSize, header.committed);
+
+    gsLogMmap = c_mapped_file_new_shared_from_fd(gsLogFd, LOG_MMAP_HEADER_SIZE + header.capacity, &error);
+    if (NULL == gsLogMmap) {
+        fprintf(stderr, "mmap %s failed: %s, use writev as output\n", gsPathName, error ? error->message : "");
+        c_error_free(error);
+        // 恢复文件原有大小，之后的日志直接追加
+        if (0 != ftruncate(gsLogFd, buf.st_size)) {
+            fprintf(stderr, "ftruncate %s failed: %s\n", gsPathName, strerror(errno));
+        }
+        gsLogWritten = (cuint64) buf.st_size;
+        return;
+    }
+
+    gsLogMmapHeader = (LogMmapHeader*) c_mapped_file_get_contents(gsLogMmap);
+    memcpy(gsLogMmapHeader, &header, sizeof(header));
+    __atomic_store_n(&gsLogWritten, header.committed, __ATOMIC_RELAXED);
+}
+
+static void log_mmap_close (void)
+{
+    // 调用时持有 gsLogMutex
+    if (NULL == gsLogMmap) {
+        return;
+    }
+
+    const cuint64 committed = __atomic_load_n(&gsLogMmapHeader->committed, __ATOMIC_ACQUIRE);
+    c_mapped_file_sync(gsLogMmap, 0, LOG_MMAP_HEADER_SIZE + committed, false);
+    c_mapped_file_unref(gsLogMmap);
+    __atomic_store_n(&gsLogMmap, NULL, __ATOMIC_RELAXED);
+    gsLogMmapHeader = NULL;
+
+    // 去掉预分配但未使用的空间
+    if (0 != ftruncate(gsLogFd, (off_t) (LOG_MMAP_HEADER_SIZE + committed))) {
+        fprintf(stderr, "ftruncate %s failed: %s\n", gsPathName, strerror(errno));
+    }
+}
+
+static cint64 log_mmap_append (const struct iovec* vec, cint n)
+{
+    cint i = 0;
+    csize total = 0;
+
+    // 调用时持有 gsLogMutex
+    for (i = 0; i < n; ++i) {
+        total += vec[i].iov_len;
+    }
+
+    const cuint64 committed = gsLogMmapHeader->committed;
+    const cuint64 room = gsLogMmapHeader->capacity - committed;
+    if (total > room) {
+        if (committed > 0) {
+            return -1;
+        }
+        // 单次写入比整个段还大，截断到段容量
+        total = room;
+    }
+
+    char* dst = c_mapped_file_get_contents(gsLogMmap) + LOG_MMAP_HEADER_SIZE + committed;
+    csize left = total;
+    for (i = 0; i < n && left > 0; ++i) {
+        const csize len = C_MIN(vec[i].iov_len, left);
+        memcpy(dst, vec[i].iov_base, len);
+        dst += len;
+        left -= len;
+    }
+
+    // 内容先于 committed 可见，崩溃后不会读到半条日志
+    __atomic_store_n(&gsLogMmapHeader->committed, committed + total, __ATOMIC_RELEASE);
+    __atomic_store_n(&gsLogWritten, committed + total, __ATOMIC_RELAXED);
+
+    return (cint64) total;
+}
+
+static csize log_binary_put(char* rec, csize len, const void* data, csize n)
+{
+    memcpy(rec + len, data, n);
+
+    return len + n;
+}
+
+static csize log_binary_encode_args(const LogSiteInfo* info, char* rec, csize len, va_list ap)
+{
+    cint i = 0;
+    cint lastInt = -1;
+
+    for (i = 0; i < info->nargs; ++i) {
+        switch (info->args[i]) {
+            case LOG_ARG_INT: {
+                cint v = va_arg(ap, cint);
+                lastInt = v;
+                len = log_binary_put(rec, len, &v, sizeof(v));
+                break;
+            }
+            case LOG_ARG_LONG: {
+                cint64 v = va_arg(ap, cint64);
+                len = log_binary_put(rec, len, &v, sizeof(v));
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                cdouble v = va_arg(ap, cdouble);
+                len = log_binary_put(rec, len, &v, sizeof(v));
+                break;
+            }
+            case LOG_ARG_LDOUBLE: {
+                long double v = va_arg(ap, long double);
+                len = log_binary_put(rec, len, &v, sizeof(v));
+                break;
+            }
+            case LOG_ARG_PTR: {
+                cuint64 v = (cuint64) (cuintptr) va_arg(ap, void*);
+                len = log_binary_put(rec, len, &v, sizeof(v));
+                break;
+            }
+            case LOG_ARG_STR: {
+                const cchar* str = va_arg(ap, const cchar*);
+                cint prec = (-2 == info->precs[i]) ? lastInt : info->precs[i];
+                if (NULL == str) {
+                    str = "(null)";
+                }
+                // 为后续定长参数预留空间
+                csize room = LOG_BUF_SIZE - len - sizeof(cuint32) - (csize) (info->nargs - i) * 16;
+                cuint32 n = (cuint32) C_MIN((prec >= 0) ? strnlen(str, (csize) prec) : strlen(str), room);
+                len = log_binary_put(rec, len, &n, sizeof(n));
+                len = log_binary_put(rec, len, str, n);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    return len;
+}
+
+static csize log_binary_text_head(char* rec, csize len, const cchar* tag, const cchar* file, cint line, const cchar* func)
+{
+    cuint16 lens[4] = {0};
+
+    tag = (NULL != tag) ? tag : "";
+    file = (NULL != file) ? file : "";
+    func = (NULL != func) ? func : "";
+    lens[0] = (cuint16) C_MIN(strlen(tag), 1024);
+    lens[1] = (cuint16) C_MIN(strlen(file), 1024);
+    lens[2] = (cuint16) C_MIN(strlen(func), 1024);
+
+    // line + tagLen + fileLen + funcLen + reserved + 字符串
+    len = log_binary_put(rec, len, &line, sizeof(line));
+    len = log_binary_put(rec, len, lens, sizeof(lens));
+    len = log_binary_put(rec, len, tag, lens[0]);
+    len = log_binary_put(rec, len, file, lens[1]);
+    len = log_binary_put(rec, len, func, lens[2]);
+
+    return len;
+}
+
+static void log_binary_output(LogBinEvent* ev, char* rec, csize len)
+{
+    struct timeval tv;
+    struct iovec vec;
+
+    pthread_once(&gsLogPidOnce, log_pid_init);
+    gettimeofday(&tv, NULL);
+
+    ev->time = (cuint64) tv.tv_sec * 1000000 + (cuint64) tv.tv_usec;
+    ev->pid = gsLogPidNum;
+    ev->len = (cuint32) (len - sizeof(LogBinEvent));
+    memcpy(rec, ev, sizeof(LogBinEvent));
+
+    vec.iov_base = rec;
+    vec.iov_len = len;
+    log_output(C_LOG_TYPE_FILE, (CLogLevel) ev->level, C_LOG_FORMAT_BINARY, &vec, 1);
+}
+
+static void log_binary_print(CLogSite* site, CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* fmt, va_list ap)
+{
+    LogBinEvent ev;
+    char rec[LOG_BUF_SIZE];
+    csize len = sizeof(LogBinEvent);
+    LogSiteInfo* info = (NULL != site) ? log_site_get(site, level, tag, file, line, func, fmt) : NULL;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.level = (cuint8) level;
+
+    if (C_LIKELY(NULL != info && info->binary && info->fmtPtr == fmt)) {
+        ev.type = LOG_BIN_EVENT;
+        ev.id = info->id;
+        len = log_binary_encode_args(info, rec, len, ap);
+    }
+    else {
+        // 无调用点或格式化字符串不支持二进制编码，退化为写入格式化后的文本
+        ev.type = LOG_BIN_TEXT;
+        len = log_binary_text_head(rec, len, tag, file, line, func);
+        int n = vsnprintf(rec + len, LOG_BUF_SIZE - len, fmt, ap);
+        if (n < 0) {
+            return;
+        }
+        len += C_MIN((csize) n, LOG_BUF_SIZE - len - 1);
+    }
+
+    log_binary_output(&ev, rec, len);
+}
+
+static void log_binary_text(CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg, csize msgLen)
+{
+    LogBinEvent ev;
+    char rec[LOG_BUF_SIZE];
+    csize len = sizeof(LogBinEvent);
+
+    memset(&ev, 0, sizeof(ev));
+    ev.type = LOG_BIN_TEXT;
+    ev.level = (cuint8) level;
+
+    len = log_binary_text_head(rec, len, tag, file, line, func);
+    msgLen = C_MIN(msgLen, LOG_BUF_SIZE - len);
+    memcpy(rec + len, msg, msgLen);
+
+    log_binary_output(&ev, rec, len + msgLen);
+}
+
+static void log_binary_raw(CLogLevel level, const cchar* msg, csize len)
+{
+    LogBinEvent ev;
+    char rec[LOG_BUF_SIZE];
+
+    memset(&ev, 0, sizeof(ev));
+    ev.type = LOG_BIN_RAW;
+    ev.level = (cuint8) level;
+
+    len = C_MIN(len, LOG_BUF_SIZE - sizeof(LogBinEvent));
+    memcpy(rec + sizeof(LogBinEvent), msg, len);
+    log_binary_output(&ev, rec, sizeof(LogBinEvent) + len);
+}
+
+static bool log_binary_take(const char* data, csize dataLen, csize* off, void* dst, csize n)
+{
+    if (*off + n > dataLen) {
+        return false;
+    }
+    memcpy(dst, data + *off, n);
+    *off += n;
+
+    return true;
+}
+
+static csize log_binary_decode_msg(const LogSiteInfo* info, const char* data, csize dataLen, char* out, csize outCap)
+{
+    cint i = 0;
+    csize off = 0;
+    csize len = 0;
+    const cchar* p = info->fmt;
+
+    while ('\0' != *p && len + 1 < outCap) {
+        if ('%' != *p) {
+            out[len++] = *p++;
+            continue;
+        }
+
+        LogFmtSpec spec;
+        const cchar* start = p;
+        p = log_fmt_spec(p, &spec);
+        if (LOG_ARG_NONE == spec.type) {
+            out[len++] = '%';
+            continue;
+        }
+
+        // 把 '*' 替换为记录中的宽度/精度
+        cint stars[2] = {0};
+        char one[64] = {0};
+        csize ol = 0;
+        const cchar* q = NULL;
+        for (i = 0; i < spec.nstar && i < 2; ++i) {
+            if (!log_binary_take(data, dataLen, &off, &stars[i], sizeof(cint))) {
+                goto OUT;
+            }
+        }
+        for (i = 0, q = start; q < p && ol + 12 < sizeof(one); ++q) {
+            if ('*' == *q) {
+                ol += (csize) snprintf(one + ol, sizeof(one) - ol, "%d", stars[i++]);
+            }
+            else {
+                one[ol++] = *q;
+            }
+        }
+        one[ol] = '\0';
+
+        int n = 0;
+        csize room = outCap - len;
+        switch (spec.type) {
+            case LOG_ARG_INT: {
+                cint v = 0;
+                if (!log_binary_take(data, dataLen, &off, &v, sizeof(v))) {
+                    goto OUT;
+                }
+                n = snprintf(out + len, room, one, v);
+                break;
+            }
+            case LOG_ARG_LONG: {
+                cint64 v = 0;
+                if (!log_binary_take(data, dataLen, &off, &v, sizeof(v))) {
+                    goto OUT;
+                }
+                n = snprintf(out + len, room, one, v);
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                cdouble v = 0;
+                if (!log_binary_take(data, dataLen, &off, &v, sizeof(v))) {
+                    goto OUT;
+                }
+                n = snprintf(out + len, room, one, v);
+                break;
+            }
+            case LOG_ARG_LDOUBLE: {
+                long double v = 0;
+                if (!log_binary_take(data, dataLen, &off, &v, sizeof(v))) {
+                    goto OUT;
+                }
+                n = snprintf(out + len, room, one, v);
+                break;
+            }
+            case LOG_ARG_PTR: {
+                cuint64 v = 0;
+                if (!log_binary_take(data, dataLen, &off, &v, sizeof(v))) {
+                    goto OUT;
+                }
+                n = snprintf(out + len, room, one, (void*) (cuintptr) v);
+                break;
+            }
+            case LOG_ARG_STR: {
+                cuint32 sl = 0;
+                char str[LOG_BUF_SIZE];
+                if (!log_binary_take(data, dataLen, &off, &sl, sizeof(sl)) || sl >= sizeof(str)
+                    || !log_binary_take(data, dataLen, &off, str, sl)) {
+                    goto OUT;
+                }
+                str[sl] = '\0';
+                n = snprintf(out + len, room, one, str);
+                break;
+            }
+            default: {
+                goto OUT;
+            }
+        }
+        if (n > 0) {
+            len += C_MIN((csize) n, room - 1);
+        }
+    }
+
+OUT:
+    out[len] = '\0';
+
+    return len;
+}
+
+static bool log_decode_write(cint fd, const LogBinEvent* ev, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg, csize msgLen)
+{
+    cint i = -1;
+    struct timeval tv;
+    char pid[32] = {0};
+    char prefix[LOG_PREFIX_LEN];
+    struct iovec vec[4];
+    const cuint idx = (ev->level <= C_LOG_LEVEL_VERB) ? ev->level : C_LOG_LEVEL_VERB;
+
+    if (LOG_BIN_RAW != ev->type) {
+        tv.tv_sec = (time_t) (ev->time / 1000000);
+        tv.tv_usec = (suseconds_t) (ev->time % 1000000);
+        int pidLen = snprintf(pid, sizeof(pid), "pid:%u", ev->pid);
+        csize len = log_build_prefix(prefix, &tv, tag, gsLogLevelStr[idx], pid, (csize) pidLen, file, line, func);
+        vec[++i].iov_base = prefix;
+        vec[i].iov_len = len;
+        vec[++i].iov_base = " ";
+        vec[i].iov_len = 1;
+    }
+    vec[++i].iov_base = (void*) msg;
+    vec[i].iov_len = msgLen;
+    vec[++i].iov_base = "\n";
+    vec[i].iov_len = 1;
+
+    return writev(fd, vec, ++i) >= 0;
+}
+
+bool c_log_decode(const cchar* path, cint fd)
+{
+    bool ret = false;
+    FILE* fp = NULL;
+    cuint i = 0;
+    cuint siteCap = 0;
+    LogSiteInfo** sites = NULL;
+    char* data = NULL;
+    csize dataCap = 0;
+    char magic[LOG_BIN_MAGIC_LEN] = {0};
+    char msg[LOG_BUF_SIZE];
+    CMappedFile* mf = NULL;
+
+    if (NULL == path || NULL == (mf = c_mapped_file_new(path, false, NULL))) {
+        return false;
+    }
+
+    char* content = c_mapped_file_get_contents(mf);
+    csize contentLen = c_mapped_file_get_length(mf);
+
+    // mmap 日志段只解码段头记录的已提交部分
+    const LogMmapHeader* header = (const LogMmapHeader*) content;
+    if (contentLen >= LOG_MMAP_HEADER_SIZE && 0 == memcmp(header->magic, LOG_MMAP_MAGIC, LOG_MMAP_MAGIC_LEN)) {
+        contentLen = C_MIN(contentLen - LOG_MMAP_HEADER_SIZE, (csize) header->committed);
+        content += LOG_MMAP_HEADER_SIZE;
+        if (contentLen < LOG_BIN_MAGIC_LEN || 0 != memcmp(content, LOG_BIN_MAGIC, LOG_BIN_MAGIC_LEN)) {
+            // 文本格式的日志段原样输出
+            ret = (0 == contentLen) || (write(fd, content, contentLen) == (cssize) contentLen);
+            c_mapped_file_unref(mf);
+            return ret;
+        }
+    }
+
+    if (0 == contentLen || NULL == (fp = fmemopen(content, contentLen, "rb"))) {
+        c_mapped_file_unref(mf);
+        return false;
+    }
+
+    if (1 != fread(magic, LOG_BIN_MAGIC_LEN, 1, fp) || 0 != memcmp(magic, LOG_BIN_MAGIC, LOG_BIN_MAGIC_LEN)) {
+        fclose(fp);
+        c_mapped_file_unref(mf);
+        return false;
+    }
+
+    while (true) {
+        cuint8 type = 0;
+        if (1 != fread(&type, 1, 1, fp)) {
+            ret = feof(fp);
+            break;
+        }
+
+        if (LOG_BIN_SITE == type) {
+            LogBinSite head;
+            head.type = type;
+            if (1 != fread((char*) &head + 1, sizeof(head) - 1, 1, fp)) {
+                break;
+            }
+            csize need = (csize) head.tagLen + head.fileLen + head.funcLen + head.fmtLen + 4;
+            if (need > dataCap) {
+                char* tmp = realloc(data, need);
+                if (NULL == tmp) {
+                    break;
+                }
+                data = tmp;
+                dataCap = need;
+            }
+            char* tag = data;
+            char* file = tag + head.tagLen + 1;
+            char* func = file + head.fileLen + 1;
+            char* fmt = func + head.funcLen + 1;
+            if ((head.tagLen > 0 && 1 != fread(tag, head.tagLen, 1, fp))
+                || (head.fileLen > 0 && 1 != fread(file, head.fileLen, 1, fp))
+                || (head.funcLen > 0 && 1 != fread(func, head.funcLen, 1, fp))
+                || (head.fmtLen > 0 && 1 != fread(fmt, head.fmtLen, 1, fp))) {
+                break;
+            }
+            tag[head.tagLen] = file[head.fileLen] = func[head.funcLen] = fmt[head.fmtLen] = '\0';
+
+            if (0 == head.id) {
+                continue;
+            }
+            if (head.id > siteCap) {
+                cuint cap = C_MAX(head.id, siteCap * 2);
+                LogSiteInfo** tmp = realloc(sites, sizeof(LogSiteInfo*) * cap);
+                if (NULL == tmp) {
+                    break;
+                }
+                memset(tmp + siteCap, 0, sizeof(LogSiteInfo*) * (cap - siteCap));
+                sites = tmp;
+                siteCap = cap;
+            }
+            // 追加写入的新进程会复用 id，以最后一次定义为准
+            log_site_info_free(sites[head.id - 1]);
+            sites[head.id - 1] = log_site_info_new((CLogLevel) head.level, tag, file, head.line, func, fmt);
+            if (NULL != sites[head.id - 1]) {
+                sites[head.id - 1]->id = head.id;
+            }
+            continue;
+        }
+
+        if (LOG_BIN_EVENT != type && LOG_BIN_TEXT != type && LOG_BIN_RAW != type) {
+            break;
+        }
+
+        LogBinEvent ev;
+        ev.type = type;
+        if (1 != fread((char*) &ev + 1, sizeof(ev) - 1, 1, fp)) {
+            break;
+        }
+        if ((csize) ev.len + 1 > dataCap) {
+            char* tmp = realloc(data, (csize) ev.len + 1);
+            if (NULL == tmp) {
+                break;
+            }
+            data = tmp;
+            dataCap = (csize) ev.len + 1;
+        }
+        if (ev.len > 0 && 1 != fread(data, ev.len, 1, fp)) {
+            break;
+        }
+
+        if (LOG_BIN_RAW == ev.type) {
+            log_decode_write(fd, &ev, NULL, NULL, 0, NULL, data, ev.len);
+        }
+        else if (LOG_BIN_TEXT == ev.type) {
+            cint line = 0;
+            cuint16 lens[4] = {0};
+            csize off = 0;
+            char tag[1025] = {0};
+            char file[1025] = {0};
+            char func[1025] = {0};
+            if (!log_binary_take(data, ev.len, &off, &line, sizeof(line))
+                || !log_binary_take(data, ev.len, &off, lens, sizeof(lens))
+                || lens[0] > 1024 || lens[1] > 1024 || lens[2] > 1024
+                || !log_binary_take(data, ev.len, &off, tag, lens[0])
+                || !log_binary_take(data, ev.len, &off, file, lens[1])
+                || !log_binary_take(data, ev.len, &off, func, lens[2])) {
+                break;
+            }
+            log_decode_write(fd, &ev, tag, file, line, func, data + off, ev.len - off);
+        }
+        else {
+            LogSiteInfo* info = (ev.id > 0 && ev.id <= siteCap) ? sites[ev.id - 1] : NULL;
+            if (NULL == info) {
+                csize n = (csize) snprintf(msg, sizeof(msg), "<unknown log site %u>", ev.id);
+                log_decode_write(fd, &ev, NULL, NULL, 0, NULL, msg, n);
+                continue;
+            }
+            csize n = log_binary_decode_msg(info, data, ev.len, msg, sizeof(msg));
+            log_decode_write(fd, &ev, info->tag, info->file, info->line, info->func, msg, n);
+        }
+    }
+
+    for (i = 0; i < siteCap; ++i) {
+        log_site_info_free(sites[i]);
+    }
+    free(sites);
+    free(data);
+    fclose(fp);
+    c_mapped_file_unref(mf);
+
+    return ret;
 }
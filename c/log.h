@@ -39,6 +39,30 @@ C_BEGIN_EXTERN_C
 #define C_LOG_LEVEL    C_LOG_LEVEL_INFO
 #endif
 
+/**
+ * 编译期日志级别(0: ERROR ... 5: VERB，必须是数字)，高于此级别的 C_LOG_* 调用点在预处理时整体去掉
+ */
+#ifndef C_LOG_COMPILE_LEVEL
+#ifdef DEBUG
+#define C_LOG_COMPILE_LEVEL     5
+#else
+#define C_LOG_COMPILE_LEVEL     3
+#endif
+#endif
+
+
+#define C_LOG_SITE_INIT         { 0, 0, NULL }
+
+/**
+ * 全局级别与各 tag 级别中的最大值，只能通过 c_log_set_level 等接口修改
+ */
+extern cint gsLogLevelMax;
+
+/**
+ * 运行期级别检查，在计算日志参数之前完成；直接读取 gsLogLevelMax，不产生函数调用
+ */
+#define C_LOG_LEVEL_ENABLED(level) \
+    C_LIKELY((cint) (level) <= __atomic_load_n(&gsLogLevelMax, __ATOMIC_RELAXED))
 
 #define C_LOG_INIT_IF_NOT_INIT \
 C_STMT_START { \
@@ -48,77 +72,154 @@ C_STMT_START { \
 } C_STMT_END
 
 
+#if C_LOG_COMPILE_LEVEL >= 0
 #define C_LOG_ERROR(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print(C_LOG_LEVEL_ERROR, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_ERROR)) { \
+        static CLogSite cLogSite_ = C_LOG_SITE_INIT; \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_site(&cLogSite_, C_LOG_LEVEL_ERROR, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_ERROR(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 1
 #define C_LOG_CRIT(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print(C_LOG_LEVEL_CRIT, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_CRIT)) { \
+        static CLogSite cLogSite_ = C_LOG_SITE_INIT; \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_site(&cLogSite_, C_LOG_LEVEL_CRIT, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_CRIT(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 2
 #define C_LOG_WARNING(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print(C_LOG_LEVEL_WARNING, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_WARNING)) { \
+        static CLogSite cLogSite_ = C_LOG_SITE_INIT; \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_site(&cLogSite_, C_LOG_LEVEL_WARNING, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_WARNING(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 3
 #define C_LOG_INFO(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print(C_LOG_LEVEL_INFO, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_INFO)) { \
+        static CLogSite cLogSite_ = C_LOG_SITE_INIT; \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_site(&cLogSite_, C_LOG_LEVEL_INFO, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_INFO(...)
+#endif
 
 
+#if C_LOG_COMPILE_LEVEL >= 0
 #define C_LOG_ERROR_CONSOLE(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print_console(C_LOG_LEVEL_ERROR, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_ERROR)) { \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_console(C_LOG_LEVEL_ERROR, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_ERROR_CONSOLE(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 1
 #define C_LOG_CRIT_CONSOLE(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print_console(C_LOG_LEVEL_CRIT, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_CRIT)) { \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_console(C_LOG_LEVEL_CRIT, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_CRIT_CONSOLE(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 2
 #define C_LOG_WARNING_CONSOLE(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print_console(C_LOG_LEVEL_WARNING, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_WARNING)) { \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_console(C_LOG_LEVEL_WARNING, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_WARNING_CONSOLE(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 3
 #define C_LOG_INFO_CONSOLE(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print_console(C_LOG_LEVEL_INFO, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_INFO)) { \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_console(C_LOG_LEVEL_INFO, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_INFO_CONSOLE(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 4
 #define C_LOG_DEBUG_CONSOLE(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print_console(C_LOG_LEVEL_DEBUG, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_DEBUG)) { \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_console(C_LOG_LEVEL_DEBUG, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_DEBUG_CONSOLE(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 5
+#define C_LOG_VERB_CONSOLE(...) \
+C_STMT_START { \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_VERB)) { \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_console(C_LOG_LEVEL_VERB, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
+} C_STMT_END
+#else
 #define C_LOG_VERB_CONSOLE(...)
+#endif
 
-#ifdef DEBUG
+#if C_LOG_COMPILE_LEVEL >= 4
 #define C_LOG_DEBUG(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print(C_LOG_LEVEL_DEBUG, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_DEBUG)) { \
+        static CLogSite cLogSite_ = C_LOG_SITE_INIT; \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_site(&cLogSite_, C_LOG_LEVEL_DEBUG, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
+#else
+#define C_LOG_DEBUG(...)
+#endif
 
+#if C_LOG_COMPILE_LEVEL >= 5
 #define C_LOG_VERB(...) \
 C_STMT_START { \
-    C_LOG_INIT_IF_NOT_INIT; \
-    c_log_print(C_LOG_LEVEL_VERB, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    if (C_LOG_LEVEL_ENABLED(C_LOG_LEVEL_VERB)) { \
+        static CLogSite cLogSite_ = C_LOG_SITE_INIT; \
+        C_LOG_INIT_IF_NOT_INIT; \
+        c_log_print_site(&cLogSite_, C_LOG_LEVEL_VERB, C_LOG_TAG, __FILE__, __LINE__, __func__, __VA_ARGS__); \
+    } \
 } C_STMT_END
 #else
-#define C_LOG_DEBUG(...)
 #define C_LOG_VERB(...)
 #endif
 
@@ -142,6 +243,20 @@ C_STMT_START { \
 } C_STMT_END
 
 
+/**
+ * @brief 日志调用点，由 C_LOG_* 宏为每个调用位置静态分配
+ *
+ * 二进制日志模式下格式化字符串、文件名、行号只在首次调用时写入一次，之后只记录调用点 id 与参数
+ */
+typedef struct _CLogSite CLogSite;
+struct _CLogSite
+{
+    /*< private >*/
+    cuint32         id;
+    cuint32         tag;                    // tag 对应的 CQuark，设置了 tag 级别后才会填充
+    void*           info;
+};
+
 /**
  * @brief 日志输出模式
  */
@@ -164,6 +279,33 @@ typedef enum
     C_LOG_LEVEL_VERB        = 5,
 } CLogLevel;
 
+/**
+ * @brief 日志文件格式
+ */
+typedef enum
+{
+    C_LOG_FORMAT_TEXT = 0,                  // 文本格式(默认)
+    C_LOG_FORMAT_BINARY,                    // 二进制格式，写入时不做格式化，使用 c_log_decode() 还原为文本
+} CLogFormat;
+
+/**
+ * @brief 日志文件达到 logSize 后的切分方式
+ */
+typedef enum
+{
+    C_LOG_ROTATE_NUMBERED = 0,              // 备份为 name.1 name.2 ... (默认，数字越大越旧)
+    C_LOG_ROTATE_TIMESTAMP,                 // 备份为 name.YYYYmmdd-HHMMSS
+} CLogRotateMode;
+
+/**
+ * @brief 异步日志队列满时的处理策略
+ */
+typedef enum
+{
+    C_LOG_ASYNC_BLOCK = 0,                  // 阻塞等待写线程腾出空间
+    C_LOG_ASYNC_DROP,                       // 丢弃当前日志并计数
+} CLogAsyncPolicy;
+
 /**
  * @brief 初始化 log 参数
  *
@@ -179,6 +321,131 @@ typedef enum
  */
 bool c_log_init (CLogLevel level, cuint64 logSize, const cchar* dir, const cchar* prefix, const cchar* suffix, bool hasTime);
 
+/**
+ * @brief 以异步模式初始化 log 参数，文件日志先写入环形队列，由独立写线程批量写入文件
+ *
+ * @param level: 设置 log 输出级别
+ * @param logSize: 每个日志文件的大小
+ * @param dir: 日志文件存储文件夹路径
+ * @param prefix: 日志文件名
+ * @param suffix: 日志文件后缀名
+ * @param hasTime: 文件名中是否带时间
+ * @param ringSize: 队列槽位个数(向上取整为2的幂)，为 0 则使用默认值
+ * @param policy: 队列满时的处理策略
+ *
+ * @note 控制台日志仍然同步输出；c_log_destroy() 会把队列中剩余日志全部写入文件
+ *
+ * @return 成功: true; 失败: false
+ */
+bool c_log_init_async (CLogLevel level, cuint64 logSize, const cchar* dir, const cchar* prefix, const cchar* suffix, bool hasTime, cuint ringSize, CLogAsyncPolicy policy);
+
+/**
+ * @brief 以线程缓冲模式初始化 log 参数，文件日志先追加到当前线程的缓冲区，写文件时不需要加锁
+ *
+ * @param level: 设置 log 输出级别
+ * @param logSize: 每个日志文件的大小
+ * @param dir: 日志文件存储文件夹路径
+ * @param prefix: 日志文件名
+ * @param suffix: 日志文件后缀名
+ * @param hasTime: 文件名中是否带时间
+ * @param flushMs: 缓冲区定时刷新间隔(毫秒)，为 0 则使用默认值
+ *
+ * @note 缓冲区满、到达刷新间隔、输出 ERROR/CRIT 日志时写入文件，每次刷新只调用一次 writev；
+ *       线程退出时会写出剩余日志，不同线程的日志在文件中按刷新先后排列
+ *
+ * @return 成功: true; 失败: false
+ */
+bool c_log_init_buffered (CLogLevel level, cuint64 logSize, const cchar* dir, const cchar* prefix, const cchar* suffix, bool hasTime, cuint flushMs);
+
+/**
+ * @brief 初始化日志，日志写入预先分配好大小的共享内存映射区(MAP_SHARED)，每条日志只做一次内存拷贝
+ *
+ * @param level: 设置 log 输出级别
+ * @param logSize: 每个日志段数据区的大小，写满后切分到新的段
+ * @param dir: 日志文件存储文件夹路径
+ * @param prefix: 日志文件名
+ * @param suffix: 日志文件后缀名
+ * @param hasTime: 文件名中是否带时间
+ *
+ * @note 进程崩溃(非系统掉电)时已经写入的日志不会丢失；日志段带有文件头，需要用 c_log_decode() 查看。
+ *       映射失败时退回 writev 方式写文件。可以与 c_log_init_async/c_log_init_buffered 同时使用，
+ *       但必须先调用本函数。
+ *
+ * @return 成功: true; 失败: false
+ */
+bool c_log_init_mmap (CLogLevel level, cuint64 logSize, const cchar* dir, const cchar* prefix, const cchar* suffix, bool hasTime);
+
+/**
+ * @brief 线程缓冲模式下，把当前线程缓冲区中的日志写入文件
+ */
+void c_log_flush (void);
+
+/**
+ * @brief 异步模式下因队列满而被丢弃的日志条数
+ * @note c_log_destroy() 之后返回最后一个队列的计数
+ */
+cuint64 c_log_async_dropped (void);
+
+/**
+ * @brief 设置日志切分策略
+ *
+ * @param mode: 备份文件命名方式
+ * @param maxFiles: 最多保留的备份文件个数，为 0 则切分时直接丢弃旧日志
+ * @param compress: 是否在后台使用 gzip 压缩切分出的备份文件
+ */
+void c_log_set_rotate (CLogRotateMode mode, cuint maxFiles, bool compress);
+
+/**
+ * @brief 运行期修改全局日志级别
+ */
+void c_log_set_level (CLogLevel level);
+
+/**
+ * @brief 获取全局日志级别
+ */
+CLogLevel c_log_get_level (void);
+
+/**
+ * @brief 全局级别与各 tag 级别中的最大值，即 gsLogLevelMax
+ * @note 初始化之前返回 C_LOG_LEVEL_VERB，保证 C_LOG_* 能触发初始化
+ */
+cint c_log_get_level_max (void);
+
+/**
+ * @brief 为指定 tag 单独设置日志级别，优先于全局级别，可以用来只打开某个子系统的调试日志
+ *
+ * @param tag: 日志 tag，即 C_LOG_TAG
+ * @param level: 此 tag 的日志级别，可以高于或低于全局级别
+ *
+ * @note 读取路径无锁；最多支持 256 个 tag
+ *
+ * @return 成功: true; tag 个数超出上限: false
+ */
+bool c_log_set_tag_level (const cchar* tag, CLogLevel level);
+
+/**
+ * @brief 取消 tag 单独设置的日志级别，恢复使用全局级别
+ */
+void c_log_unset_tag_level (const cchar* tag);
+
+/**
+ * @brief 设置日志文件格式，建议在 c_log_init 之前调用
+ *
+ * @note 已打开的日志文件非空时会先切分，保证一个文件中只有一种格式。异步队列和线程缓冲区中
+ *       已按原格式编码的日志先写入原文件；与本调用并发、仍按原格式编码的日志会另起一个文件
+ */
+void c_log_set_format (CLogFormat format);
+
+/**
+ * @brief 将二进制日志文件还原为文本格式，输出与文本模式相同；mmap 日志段输出已提交的部分
+ *
+ * @param path: 二进制日志文件或 mmap 日志段路径
+ * @param fd: 输出文本写入的文件描述符
+ *
+ * @return 成功: true; 文件格式错误或读取失败: false
+ */
+bool c_log_decode (const cchar* path, cint fd);
+
 /**
  * 销毁 log 参数
  */
@@ -189,6 +456,19 @@ void c_log_destroy (void);
  */
 void c_log_print (CLogLevel level, const cchar* tag, const cchar* file, int line, const cchar* func, const cchar* fmt, ...);
 
+/**
+ * @brief 输出日志到文件，C_LOG_* 宏使用此接口，二进制模式下只记录调用点 id 与原始参数
+ */
+void c_log_print_site (CLogSite* site, CLogLevel level, const cchar* tag, const cchar* file, int line, const cchar* func, const cchar* fmt, ...);
+
+/**
+ * @brief 输出已经拆分好字段的日志到文件，不再经过 printf 格式化，供 glib/Qt 等日志桥接使用
+ *
+ * @param msg: 日志内容，可以不以 '\0' 结尾
+ * @param msgLen: msg 的长度，小于 0 时按 '\0' 结尾的字符串处理
+ */
+void c_log_write_fields (CLogLevel level, const cchar* tag, const cchar* file, cint line, const cchar* func, const cchar* msg, cssize msgLen);
+
 /**
  * 输出日志到控制台
  */
@@ -41,7 +41,19 @@
 #endif
 
 
+#define MSORT_INSERTION_THRESHOLD       8
+#define SORT_INSERTION_THRESHOLD        24
+#define SORT_NINTHER_THRESHOLD          128
+#define SORT_PARTIAL_INSERTION_LIMIT    8
+#define SORT_PARALLEL_THRESHOLD         (1 << 16)
+#define SORT_RADIX_BITS                 8
+#define SORT_RADIX_SIZE                 (1 << SORT_RADIX_BITS)
+#define SORT_RADIX_MASK                 (SORT_RADIX_SIZE - 1)
+
+
+typedef struct _SortTask            SortTask;
 typedef struct _MSortParam          MSortParam;
+typedef struct _PdqSortParam        PdqSortParam;
 
 struct _MSortParam
 {
@@ -52,6 +64,30 @@ struct _MSortParam
     char*                   t;
 };
 
+struct _PdqSortParam
+{
+    csize                   s;
+    CCompareDataFunc        cmp;
+    void*                   arg;
+    char*                   tmp;                // 一个元素大小的临时空间
+};
+
+/**
+ * @brief 并行排序的任务: merge 为 false 时对 a 排序，否则把 a、b 归并到 out
+ */
+struct _SortTask
+{
+    bool                    merge;
+    char*                   a;
+    csize                   na;
+    char*                   b;
+    csize                   nb;
+    char*                   out;
+    csize                   s;
+    CCompareDataFunc        cmp;
+    void*                   arg;
+};
+
 
 /* rand start */
 C_LOCK_DEFINE_STATIC (gsGlobalRandom);
@@ -83,6 +119,12 @@ static cuint get_random_version (void);
 static CRand* get_global_random (void);
 static void msort_with_tmp (const MSortParam* p, void* b, size_t n);
 static void msort_r (void *b, cuint64 n, cuint64 s, CCompareDataFunc cmp, void *arg);
+static void pdq_loop (const PdqSortParam* p, char* begin, char* end, cint badAllowed, bool leftmost);
+static void* sort_task_run (void* data);
+static void sort_task_run_all (SortTask* tasks, cuint n);
+static csize sort_co_rank (csize d, const char* a, csize na, const char* b, csize nb, csize s, CCompareDataFunc cmp, void* arg);
+static inline cuint64 radix_key (const char* e, csize s, CSortKeyFunc keyFunc, void* udata);
+static void radix_scatter (const char* src, char* dst, csize n, csize s, cuint shift, csize* offsets, CSortKeyFunc keyFunc, void* udata);
 
 static void ensure_gettext_initialized (void);
 static bool _c_dgettext_should_translate (void);
@@ -106,6 +148,152 @@ void c_qsort_with_data (const void* pBase, cint totalElems, csize size, CCompare
     msort_r ((void*) pBase, totalElems, size, compareFunc, udata);
 }
 
+void c_qsort_unstable_with_data (const void* pBase, cint totalElems, csize size, CCompareDataFunc compareFunc, void* udata)
+{
+    char buf[256];
+
+    c_return_if_fail (NULL != compareFunc);
+
+    if (totalElems < 2 || 0 == size) {
+        return;
+    }
+
+    const PdqSortParam p = { size, compareFunc, udata, (size <= sizeof (buf)) ? buf : c_malloc0 (size) };
+    const cint badAllowed = 64 - __builtin_clzll ((cuint64) totalElems);
+
+    pdq_loop (&p, (char*) pBase, (char*) pBase + (csize) totalElems * size, badAllowed, true);
+
+    if (p.tmp != buf) {
+        c_free0 (p.tmp);
+    }
+}
+
+void c_qsort_parallel_with_data (const void* pBase, cint totalElems, csize size, CCompareDataFunc compareFunc, void* udata)
+{
+    cuint i, j;
+
+    c_return_if_fail (NULL != compareFunc);
+
+    if (totalElems < SORT_PARALLEL_THRESHOLD || 0 == size) {
+        msort_r ((void*) pBase, totalElems, size, compareFunc, udata);
+        return;
+    }
+
+    // 单核时也至少分两段，分段排序再归并的工作量与 msort_r 相同
+    const csize n = (csize) totalElems;
+    const cuint nThreads = c_get_num_processors ();
+    cuint nRuns = C_MIN (C_MAX (nThreads, 2), (cuint) (n / (SORT_PARALLEL_THRESHOLD / 2)));
+    csize* bounds = c_malloc0 ((nRuns + 1) * sizeof (csize));
+    SortTask* tasks = c_malloc0 ((C_MAX (nThreads, nRuns) + nRuns) * sizeof (SortTask));
+    char* src = (char*) pBase;
+    char* dst = c_malloc0 (n * size);
+    char* tmp = dst;
+
+    // 每个线程排序一段
+    for (i = 0; i <= nRuns; ++i) {
+        bounds[i] = n * i / nRuns;
+    }
+    for (i = 0; i < nRuns; ++i) {
+        tasks[i] = (SortTask) { false, src + bounds[i] * size, bounds[i + 1] - bounds[i], NULL, 0, NULL, size, compareFunc, udata };
+    }
+    sort_task_run_all (tasks, nRuns);
+
+    // 两两归并，每对的输出再按 merge path 切分给多个线程
+    while (nRuns > 1) {
+        cuint nTasks = 0;
+        const cuint nPairs = nRuns / 2;
+        const cuint parts = C_MAX (1, nThreads / nPairs);
+        for (i = 0; i < nRuns; i += 2) {
+            char* a = src + bounds[i] * size;
+            const csize na = bounds[i + 1] - bounds[i];
+            char* b = src + bounds[i + 1] * size;
+            const csize nb = (i + 1 < nRuns) ? bounds[i + 2] - bounds[i + 1] : 0;
+            char* out = dst + bounds[i] * size;
+            for (j = 0; j < ((nb > 0) ? parts : 1); ++j) {
+                const csize d0 = (na + nb) * j / parts;
+                const csize d1 = (nb > 0) ? (na + nb) * (j + 1) / parts : na;
+                const csize i0 = sort_co_rank (d0, a, na, b, nb, size, compareFunc, udata);
+                const csize i1 = sort_co_rank (d1, a, na, b, nb, size, compareFunc, udata);
+                tasks[nTasks++] = (SortTask) { true, a + i0 * size, i1 - i0, b + (d0 - i0) * size, (d1 - i1) - (d0 - i0), out + d0 * size, size, compareFunc, udata };
+            }
+        }
+        sort_task_run_all (tasks, nTasks);
+
+        for (i = 0; i < nRuns; i += 2) {
+            bounds[i / 2] = bounds[i];
+        }
+        nRuns = (nRuns + 1) / 2;
+        bounds[nRuns] = n;
+
+        char* t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != (char*) pBase) {
+        memcpy ((void*) pBase, src, n * size);
+    }
+
+    c_free (tmp);
+    c_free (tasks);
+    c_free (bounds);
+}
+
+void c_radix_sort (void* pBase, cint totalElems, csize size, CSortKeyFunc keyFunc, void* udata)
+{
+    cuint d;
+    csize i;
+
+    c_return_if_fail (NULL != keyFunc || 1 == size || 2 == size || 4 == size || 8 == size);
+
+    if (totalElems < 2) {
+        return;
+    }
+
+    const csize n = (csize) totalElems;
+    const cuint nDigits = (NULL == keyFunc) ? (cuint) size : (cuint) sizeof (cuint64);
+    csize (*counts)[SORT_RADIX_SIZE] = c_malloc0 (nDigits * sizeof (*counts));
+    char* src = pBase;
+    char* dst = c_malloc0 (n * size);
+    char* tmp = dst;
+
+    // 一次遍历统计所有位的分布
+    for (i = 0; i < n; ++i) {
+        const cuint64 key = radix_key (src + i * size, size, keyFunc, udata);
+        for (d = 0; d < nDigits; ++d) {
+            counts[d][(key >> (d * SORT_RADIX_BITS)) & SORT_RADIX_MASK]++;
+        }
+    }
+
+    const cuint64 firstKey = radix_key (src, size, keyFunc, udata);
+    for (d = 0; d < nDigits; ++d) {
+        const cuint shift = d * SORT_RADIX_BITS;
+        // 这一位上所有键都相同，不需要移动
+        if (counts[d][(firstKey >> shift) & SORT_RADIX_MASK] == n) {
+            continue;
+        }
+
+        csize offset = 0;
+        for (i = 0; i < SORT_RADIX_SIZE; ++i) {
+            const csize c = counts[d][i];
+            counts[d][i] = offset;
+            offset += c;
+        }
+        radix_scatter (src, dst, n, size, shift, counts[d], keyFunc, udata);
+
+        char* t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != (char*) pBase) {
+        memcpy (pBase, src, n * size);
+    }
+
+    c_free (tmp);
+    c_free (counts);
+}
+
 bool c_direct_equal (const void* p1, const void* p2)
 {
     return p1 == p2;
@@ -819,6 +1007,10 @@ static void msort_r (void *b, cuint64 n, cuint64 s, CCompareDataFunc cmp, void *
     MSortParam p;
     cuint64 size = n * s;
 
+    if (n < 2) {
+        return;
+    }
+
     /* For large object sizes use indirect sorting.  */
     if (s > 32) {
         size = 2 * n * sizeof (void *) + s;
@@ -885,6 +1077,82 @@ static void msort_r (void *b, cuint64 n, cuint64 s, CCompareDataFunc cmp, void *
     c_free (tmp);
 }
 
+static inline void sort_copy (char* dst, const char* src, csize s)
+{
+    switch (s) {
+        case sizeof (cuint32): {
+            memcpy (dst, src, sizeof (cuint32));
+            break;
+        }
+        case sizeof (cuint64): {
+            memcpy (dst, src, sizeof (cuint64));
+            break;
+        }
+        default: {
+            memcpy (dst, src, s);
+            break;
+        }
+    }
+}
+
+static inline void sort_swap (char* a, char* b, csize s)
+{
+    char t[64];
+
+    switch (s) {
+        case sizeof (cuint32): {
+            cuint32 x;
+            memcpy (&x, a, sizeof (x));
+            memcpy (a, b, sizeof (x));
+            memcpy (b, &x, sizeof (x));
+            break;
+        }
+        case sizeof (cuint64): {
+            cuint64 x;
+            memcpy (&x, a, sizeof (x));
+            memcpy (a, b, sizeof (x));
+            memcpy (b, &x, sizeof (x));
+            break;
+        }
+        default: {
+            while (s > 0) {
+                const csize k = C_MIN (s, sizeof (t));
+                memcpy (t, a, k);
+                memcpy (a, b, k);
+                memcpy (b, t, k);
+                a += k;
+                b += k;
+                s -= k;
+            }
+            break;
+        }
+    }
+}
+
+static inline cint msort_compare (const MSortParam* p, const char* a, const char* b)
+{
+    if (3 == p->var) {
+        return p->cmp (*(void**) a, *(void**) b, p->arg);
+    }
+
+    return p->cmp ((void*) a, (void*) b, p->arg);
+}
+
+/* 相邻交换的插入排序，只在严格大于时交换，保持稳定 */
+static void msort_insertion (const MSortParam* p, char* b, csize n)
+{
+    csize i;
+    const csize s = p->s;
+
+    for (i = 1; i < n; ++i) {
+        char* cur = b + i * s;
+        while (cur > b && msort_compare (p, cur - s, cur) > 0) {
+            sort_swap (cur - s, cur, s);
+            cur -= s;
+        }
+    }
+}
+
 static void msort_with_tmp (const MSortParam* p, void *b, size_t n)
 {
     char *b1, *b2;
@@ -898,6 +1166,11 @@ static void msort_with_tmp (const MSortParam* p, void *b, size_t n)
         return;
     }
 
+    if (n <= MSORT_INSERTION_THRESHOLD) {
+        msort_insertion (p, b, n);
+        return;
+    }
+
     n1 = n / 2;
     n2 = n - n1;
     b1 = b;
@@ -906,6 +1179,11 @@ static void msort_with_tmp (const MSortParam* p, void *b, size_t n)
     msort_with_tmp (p, b1, n1);
     msort_with_tmp (p, b2, n2);
 
+    // 两段已经首尾有序时不需要归并
+    if (msort_compare (p, b2 - s, b2) <= 0) {
+        return;
+    }
+
     switch (p->var) {
         case 0: {
             while (n1 > 0 && n2 > 0) {
@@ -1002,6 +1280,385 @@ static void msort_with_tmp (const MSortParam* p, void *b, size_t n)
     memcpy (b, p->t, (n - n2) * s);
 }
 
+#define PDQ_LESS(p, a, b)       ((p)->cmp ((void*) (a), (void*) (b), (p)->arg) < 0)
+
+static void pdq_insertion_sort (const PdqSortParam* p, char* begin, char* end, bool guarded)
+{
+    char* cur;
+    const csize s = p->s;
+
+    if (begin == end) {
+        return;
+    }
+
+    for (cur = begin + s; cur < end; cur += s) {
+        char* sift = cur;
+        char* sift1 = cur - s;
+        if (PDQ_LESS (p, sift, sift1)) {
+            sort_copy (p->tmp, sift, s);
+            do {
+                sort_copy (sift, sift1, s);
+                sift -= s;
+            } while ((!guarded || sift != begin) && PDQ_LESS (p, p->tmp, (sift1 -= s)));
+            sort_copy (sift, p->tmp, s);
+        }
+    }
+}
+
+/* 移动元素的次数超过限制时放弃，返回 false */
+static bool pdq_partial_insertion_sort (const PdqSortParam* p, char* begin, char* end)
+{
+    char* cur;
+    csize limit = 0;
+    const csize s = p->s;
+
+    if (begin == end) {
+        return true;
+    }
+
+    for (cur = begin + s; cur < end; cur += s) {
+        char* sift = cur;
+        char* sift1 = cur - s;
+        if (PDQ_LESS (p, sift, sift1)) {
+            sort_copy (p->tmp, sift, s);
+            do {
+                sort_copy (sift, sift1, s);
+                sift -= s;
+            } while (sift != begin && PDQ_LESS (p, p->tmp, (sift1 -= s)));
+            sort_copy (sift, p->tmp, s);
+            limit += (csize) (cur - sift) / s;
+        }
+        if (limit > SORT_PARTIAL_INSERTION_LIMIT) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static inline void pdq_sort2 (const PdqSortParam* p, char* a, char* b)
+{
+    if (PDQ_LESS (p, b, a)) {
+        sort_swap (a, b, p->s);
+    }
+}
+
+static inline void pdq_sort3 (const PdqSortParam* p, char* a, char* b, char* c)
+{
+    pdq_sort2 (p, a, b);
+    pdq_sort2 (p, b, c);
+    pdq_sort2 (p, a, b);
+}
+
+/* 以 *begin 为轴，小于轴的放左边，大于等于的放右边，返回轴的最终位置 */
+static char* pdq_partition_right (const PdqSortParam* p, char* begin, char* end, bool* alreadyPartitioned)
+{
+    const csize s = p->s;
+    char* first = begin;
+    char* last = end;
+
+    // 三数取中保证能找到不小于轴的元素
+    while (PDQ_LESS (p, (first += s), begin));
+
+    if (first - s == begin) {
+        while (first < last && !PDQ_LESS (p, (last -= s), begin));
+    }
+    else {
+        while (!PDQ_LESS (p, (last -= s), begin));
+    }
+
+    *alreadyPartitioned = (first >= last);
+
+    while (first < last) {
+        sort_swap (first, last, s);
+        while (PDQ_LESS (p, (first += s), begin));
+        while (!PDQ_LESS (p, (last -= s), begin));
+    }
+
+    char* pivotPos = first - s;
+    if (pivotPos != begin) {
+        sort_swap (begin, pivotPos, s);
+    }
+
+    return pivotPos;
+}
+
+/* 与轴相等的元素放左边，用于大量重复元素 */
+static char* pdq_partition_left (const PdqSortParam* p, char* begin, char* end)
+{
+    const csize s = p->s;
+    char* first = begin;
+    char* last = end;
+
+    while (PDQ_LESS (p, begin, (last -= s)));
+
+    if (last + s == end) {
+        while (first < last && !PDQ_LESS (p, begin, (first += s)));
+    }
+    else {
+        while (!PDQ_LESS (p, begin, (first += s)));
+    }
+
+    while (first < last) {
+        sort_swap (first, last, s);
+        while (PDQ_LESS (p, begin, (last -= s)));
+        while (!PDQ_LESS (p, begin, (first += s)));
+    }
+
+    if (last != begin) {
+        sort_swap (begin, last, s);
+    }
+
+    return last;
+}
+
+static void pdq_sift_down (const PdqSortParam* p, char* base, csize root, csize n)
+{
+    const csize s = p->s;
+
+    while (true) {
+        csize child = 2 * root + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && PDQ_LESS (p, base + child * s, base + (child + 1) * s)) {
+            child++;
+        }
+        if (!PDQ_LESS (p, base + root * s, base + child * s)) {
+            break;
+        }
+        sort_swap (base + root * s, base + child * s, s);
+        root = child;
+    }
+}
+
+static void pdq_heap_sort (const PdqSortParam* p, char* begin, char* end)
+{
+    csize i;
+    const csize s = p->s;
+    const csize n = (csize) (end - begin) / s;
+
+    for (i = n / 2; i-- > 0;) {
+        pdq_sift_down (p, begin, i, n);
+    }
+    for (i = n - 1; i > 0; --i) {
+        sort_swap (begin, begin + i * s, s);
+        pdq_sift_down (p, begin, 0, i);
+    }
+}
+
+static void pdq_loop (const PdqSortParam* p, char* begin, char* end, cint badAllowed, bool leftmost)
+{
+    const csize s = p->s;
+
+    while (true) {
+        const csize size = (csize) (end - begin) / s;
+        if (size < SORT_INSERTION_THRESHOLD) {
+            pdq_insertion_sort (p, begin, end, leftmost);
+            return;
+        }
+
+        const csize s2 = size / 2;
+        if (size > SORT_NINTHER_THRESHOLD) {
+            pdq_sort3 (p, begin, begin + s2 * s, end - s);
+            pdq_sort3 (p, begin + s, begin + (s2 - 1) * s, end - 2 * s);
+            pdq_sort3 (p, begin + 2 * s, begin + (s2 + 1) * s, end - 3 * s);
+            pdq_sort3 (p, begin + (s2 - 1) * s, begin + s2 * s, begin + (s2 + 1) * s);
+            sort_swap (begin, begin + s2 * s, s);
+        }
+        else {
+            pdq_sort3 (p, begin + s2 * s, begin, end - s);
+        }
+
+        // 左边的元素不大于轴时，与轴相等的元素都放在左边，左边不需要再排序
+        if (!leftmost && !PDQ_LESS (p, begin - s, begin)) {
+            begin = pdq_partition_left (p, begin, end) + s;
+            continue;
+        }
+
+        bool alreadyPartitioned = false;
+        char* pivotPos = pdq_partition_right (p, begin, end, &alreadyPartitioned);
+        const csize lSize = (csize) (pivotPos - begin) / s;
+        const csize rSize = (csize) (end - (pivotPos + s)) / s;
+
+        if (lSize < size / 8 || rSize < size / 8) {
+            // 不平衡的划分太多，改用堆排序保证 O(n log n)
+            if (--badAllowed == 0) {
+                pdq_heap_sort (p, begin, end);
+                return;
+            }
+
+            // 打乱一些元素，破坏导致不平衡划分的模式
+            if (lSize >= SORT_INSERTION_THRESHOLD) {
+                sort_swap (begin, begin + (lSize / 4) * s, s);
+                sort_swap (pivotPos - s, pivotPos - (lSize / 4) * s, s);
+                if (lSize > SORT_NINTHER_THRESHOLD) {
+                    sort_swap (begin + s, begin + (lSize / 4 + 1) * s, s);
+                    sort_swap (begin + 2 * s, begin + (lSize / 4 + 2) * s, s);
+                    sort_swap (pivotPos - 2 * s, pivotPos - (lSize / 4 + 1) * s, s);
+                    sort_swap (pivotPos - 3 * s, pivotPos - (lSize / 4 + 2) * s, s);
+                }
+            }
+            if (rSize >= SORT_INSERTION_THRESHOLD) {
+                sort_swap (pivotPos + s, pivotPos + (1 + rSize / 4) * s, s);
+                sort_swap (end - s, end - (rSize / 4) * s, s);
+                if (rSize > SORT_NINTHER_THRESHOLD) {
+                    sort_swap (pivotPos + 2 * s, pivotPos + (2 + rSize / 4) * s, s);
+                    sort_swap (pivotPos + 3 * s, pivotPos + (3 + rSize / 4) * s, s);
+                    sort_swap (end - 2 * s, end - (1 + rSize / 4) * s, s);
+                    sort_swap (end - 3 * s, end - (2 + rSize / 4) * s, s);
+                }
+            }
+        }
+        else if (alreadyPartitioned
+            && pdq_partial_insertion_sort (p, begin, pivotPos)
+            && pdq_partial_insertion_sort (p, pivotPos + s, end)) {
+            // 已经划分好的序列基本有序，插入排序完成
+            return;
+        }
+
+        pdq_loop (p, begin, pivotPos, badAllowed, leftmost);
+        begin = pivotPos + s;
+        leftmost = false;
+    }
+}
+
+/* 稳定归并，相等时先取 a */
+static void sort_merge (const SortTask* t)
+{
+    const char* a = t->a;
+    const char* b = t->b;
+    const char* aEnd = t->a + t->na * t->s;
+    const char* bEnd = t->b + t->nb * t->s;
+    char* out = t->out;
+
+    while (a < aEnd && b < bEnd) {
+        if (t->cmp ((void*) a, (void*) b, t->arg) <= 0) {
+            sort_copy (out, a, t->s);
+            a += t->s;
+        }
+        else {
+            sort_copy (out, b, t->s);
+            b += t->s;
+        }
+        out += t->s;
+    }
+
+    if (a < aEnd) {
+        memcpy (out, a, (csize) (aEnd - a));
+    }
+    if (b < bEnd) {
+        memcpy (out, b, (csize) (bEnd - b));
+    }
+}
+
+static void* sort_task_run (void* data)
+{
+    SortTask* t = data;
+
+    if (t->merge) {
+        sort_merge (t);
+    }
+    else {
+        msort_r (t->a, t->na, t->s, t->cmp, t->arg);
+    }
+
+    return NULL;
+}
+
+/* 第一个任务在当前线程执行 */
+static void sort_task_run_all (SortTask* tasks, cuint n)
+{
+    cuint i;
+    CThread** threads = c_malloc0 (n * sizeof (CThread*));
+
+    for (i = 1; i < n; ++i) {
+        threads[i] = c_thread_new ("c-sort", sort_task_run, &tasks[i]);
+    }
+    sort_task_run (&tasks[0]);
+    for (i = 1; i < n; ++i) {
+        c_thread_join (threads[i]);
+    }
+
+    c_free (threads);
+}
+
+/* 归并结果的前 d 个元素中有多少个来自 a */
+static csize sort_co_rank (csize d, const char* a, csize na, const char* b, csize nb, csize s, CCompareDataFunc cmp, void* arg)
+{
+    csize lo = (d > nb) ? d - nb : 0;
+    csize hi = C_MIN (d, na);
+
+    while (lo < hi) {
+        const csize i = lo + (hi - lo) / 2;
+        if (cmp ((void*) (a + i * s), (void*) (b + (d - i - 1) * s), arg) <= 0) {
+            lo = i + 1;
+        }
+        else {
+            hi = i;
+        }
+    }
+
+    return lo;
+}
+
+static inline cuint64 radix_key (const char* e, csize s, CSortKeyFunc keyFunc, void* udata)
+{
+    if (NULL != keyFunc) {
+        return keyFunc (e, udata);
+    }
+
+    switch (s) {
+        case sizeof (cuint8): {
+            return *(const cuint8*) e;
+        }
+        case sizeof (cuint16): {
+            cuint16 v;
+            memcpy (&v, e, sizeof (v));
+            return v;
+        }
+        case sizeof (cuint32): {
+            cuint32 v;
+            memcpy (&v, e, sizeof (v));
+            return v;
+        }
+        default: {
+            cuint64 v;
+            memcpy (&v, e, sizeof (v));
+            return v;
+        }
+    }
+}
+
+static void radix_scatter (const char* src, char* dst, csize n, csize s, cuint shift, csize* offsets, CSortKeyFunc keyFunc, void* udata)
+{
+    csize i;
+
+    // 元素本身是对齐的整数时直接按整数搬移
+    if (NULL == keyFunc && sizeof (cuint32) == s && 0 == (cuintptr) src % ALIGNOF_CUINT32 && 0 == (cuintptr) dst % ALIGNOF_CUINT32) {
+        const cuint32* in = (const cuint32*) src;
+        cuint32* out = (cuint32*) dst;
+        for (i = 0; i < n; ++i) {
+            out[offsets[(in[i] >> shift) & SORT_RADIX_MASK]++] = in[i];
+        }
+        return;
+    }
+
+    if (NULL == keyFunc && sizeof (cuint64) == s && 0 == (cuintptr) src % ALIGNOF_CUINT64 && 0 == (cuintptr) dst % ALIGNOF_CUINT64) {
+        const cuint64* in = (const cuint64*) src;
+        cuint64* out = (cuint64*) dst;
+        for (i = 0; i < n; ++i) {
+            out[offsets[(in[i] >> shift) & SORT_RADIX_MASK]++] = in[i];
+        }
+        return;
+    }
+
+    for (i = 0; i < n; ++i, src += s) {
+        const cuint64 key = radix_key (src, s, keyFunc, udata);
+        sort_copy (dst + offsets[(key >> shift) & SORT_RADIX_MASK]++ * s, src, s);
+    }
+}
+
 static cuint get_random_version (void)
 {
     static csize initialized = false;
@@ -375,6 +375,8 @@ typedef cint            (*CCompareFunc)         (void* data1, void* data2);
 typedef cint            (*CCompareDataFunc)     (void* data1, void* data2, void* udata);
 typedef bool            (*CEqualFunc)           (const void* data1, const void* data2);
 typedef bool            (*CEqualFuncFull)       (const void* data1, const void* data2, void* udata);
+typedef cuint64         (*CSortKeyFunc)         (const void* data, void* udata);
+typedef bool            (*CPredicateFunc)       (void* data, void* udata);
 
 typedef void            (*CDestroyNotify)       (void* data);
 typedef void            (*CFunc)                (void* data, void* udata);
@@ -1196,6 +1198,26 @@ static inline csize c_nearest_pow (csize num)
 void c_abort (void);
 void c_qsort_with_data (const void* pBase, cint totalElems, csize size, CCompareDataFunc compareFunc, void* udata);
 
+/**
+ * @brief 不稳定排序(pdqsort)，不分配内存，最坏 O(n log n)
+ * @note compareFunc 的参数是指向元素的指针，与 c_qsort_with_data 相同
+ */
+void c_qsort_unstable_with_data (const void* pBase, cint totalElems, csize size, CCompareDataFunc compareFunc, void* udata);
+
+/**
+ * @brief 多线程稳定排序，元素个数超过阈值时按 c_get_num_processors() 分段排序后并行归并
+ * @note compareFunc 会在多个线程中同时调用，必须是线程安全的；结果与 c_qsort_with_data 相同
+ */
+void c_qsort_parallel_with_data (const void* pBase, cint totalElems, csize size, CCompareDataFunc compareFunc, void* udata);
+
+/**
+ * @brief 按 64 位无符号整数键稳定排序(LSD 基数排序)，不调用比较函数
+ * @note keyFunc 的参数是指向元素的指针；只有键值不全相同的字节才会搬移元素。
+ *       keyFunc 为 NULL 时元素本身就是键，size 只能是 1、2、4、8(无符号整数或指针)；
+ *       有符号整数的键需要翻转符号位: (cuint64) x ^ (1ULL << 63)
+ */
+void c_radix_sort (void* pBase, cint totalElems, csize size, CSortKeyFunc keyFunc, void* udata);
+
 bool c_direct_equal (const void* p1, const void* p2);
 bool c_str_equal (const void* p1, const void* p2);
 bool c_int_equal (const void* p1, const void* p2);
@@ -33,17 +33,27 @@
 #define MAP_FAILED ((void *) -1)
 #endif
 
+enum
+{
+    C_MAPPED_FILE_RDONLY = 0,           // PROT_READ, MAP_PRIVATE
+    C_MAPPED_FILE_PRIVATE_RW,           // PROT_READ|PROT_WRITE, MAP_PRIVATE(写时复制, 不回写文件)
+    C_MAPPED_FILE_SHARED,               // PROT_READ|PROT_WRITE, MAP_SHARED(写入直接进入页缓存)
+};
+
 struct _CMappedFile
 {
     char*   contents;
     csize   length;
     void*   freeFunc;
     int     refCount;
+    bool    shared;
 };
 
 
 static void c_mapped_file_destroy (CMappedFile* file);
 static CMappedFile* mapped_file_new_from_fd (int fd, bool writable, const char* filename, CError** error);
+static CMappedFile* mapped_file_new_shared_from_fd (int fd, csize size, const char* filename, CError** error);
+static CMappedFile* mapped_file_new_map (int fd, cint mode, const char* filename, CError** error);
 
 
 CMappedFile* c_mapped_file_new (const char* filename, bool writable, CError** error)
@@ -80,6 +90,57 @@ CMappedFile* c_mapped_file_new_from_fd (cint fd, bool writable, CError** error)
     return mapped_file_new_from_fd (fd, writable, NULL, error);
 }
 
+CMappedFile* c_mapped_file_new_shared (const char* filename, csize size, CError** error)
+{
+    int fd;
+    CMappedFile* file;
+
+    c_return_val_if_fail (filename != NULL, NULL);
+    c_return_val_if_fail (!error || *error == NULL, NULL);
+
+    fd = c_open (filename, O_RDWR | O_CREAT | _O_BINARY, 0666);
+    if (fd == -1) {
+        int save_errno = errno;
+        char* displayFilename = c_filename_display_name (filename);
+
+        c_set_error (error, C_FILE_ERROR,
+                        c_file_error_from_errno (save_errno),
+                        _("Failed to open file “%s”: open() failed: %s"),
+                        displayFilename,
+                        c_strerror (save_errno));
+        c_free (displayFilename);
+        return NULL;
+    }
+
+    file = mapped_file_new_shared_from_fd (fd, size, filename, error);
+
+    close (fd);
+
+    return file;
+}
+
+CMappedFile* c_mapped_file_new_shared_from_fd (cint fd, csize size, CError** error)
+{
+    return mapped_file_new_shared_from_fd (fd, size, NULL, error);
+}
+
+bool c_mapped_file_sync (CMappedFile* file, csize offset, csize length, bool wait)
+{
+    c_return_val_if_fail (file != NULL, false);
+    c_return_val_if_fail (file->shared, false);
+
+    if (offset >= file->length) {
+        return true;
+    }
+
+    // msync 要求起始地址按页对齐
+    const csize page = (csize) sysconf (_SC_PAGESIZE);
+    const csize start = offset / page * page;
+    const csize end = C_MIN (offset + length, file->length);
+
+    return 0 == msync (file->contents + start, end - start, wait ? MS_SYNC : MS_ASYNC);
+}
+
 csize c_mapped_file_get_length (CMappedFile* file)
 {
     c_return_val_if_fail (file != NULL, 0);
@@ -138,7 +199,46 @@ static void c_mapped_file_destroy (CMappedFile* file)
 }
 
 
+static CMappedFile* mapped_file_new_shared_from_fd (int fd, csize size, const char* filename, CError** error)
+{
+    int ret = 0;
+    struct stat st;
+    CMappedFile* file = NULL;
+
+    if (fstat (fd, &st) == -1) {
+        ret = errno;
+    }
+    else if ((csize) st.st_size < size) {
+        // 预先分配磁盘空间，避免写入映射区时因磁盘已满收到 SIGBUS
+        ret = posix_fallocate (fd, 0, (off_t) size);
+    }
+
+    if (0 != ret) {
+        char* displayFilename = filename ? c_filename_display_name (filename) : NULL;
+
+        c_set_error (error, C_FILE_ERROR,
+                        c_file_error_from_errno (ret),
+                        _("Failed to allocate “%s”: posix_fallocate() failed: %s"),
+                        displayFilename ? displayFilename : "fd",
+                        c_strerror (ret));
+        c_free (displayFilename);
+        return NULL;
+    }
+
+    file = mapped_file_new_map (fd, C_MAPPED_FILE_SHARED, filename, error);
+    if (NULL != file) {
+        file->shared = true;
+    }
+
+    return file;
+}
+
 static CMappedFile* mapped_file_new_from_fd (int fd, bool writable, const char* filename, CError** error)
+{
+    return mapped_file_new_map (fd, writable ? C_MAPPED_FILE_PRIVATE_RW : C_MAPPED_FILE_RDONLY, filename, error);
+}
+
+static CMappedFile* mapped_file_new_map (int fd, cint mode, const char* filename, CError** error)
 {
     CMappedFile *file;
     struct stat st;
@@ -175,7 +275,8 @@ static CMappedFile* mapped_file_new_from_fd (int fd, bool writable, const char*
     }
     else {
         file->length = (csize) st.st_size;
-        file->contents = (char*) mmap (NULL, file->length, writable ? PROT_READ|PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+        file->contents = (char*) mmap (NULL, file->length, (C_MAPPED_FILE_RDONLY != mode) ? PROT_READ|PROT_WRITE : PROT_READ,
+                                       (C_MAPPED_FILE_SHARED == mode) ? MAP_SHARED : MAP_PRIVATE, fd, 0);
     }
 
     if (file->contents == MAP_FAILED) {
@@ -26,6 +26,19 @@ typedef struct _CMappedFile         CMappedFile;
 
 CMappedFile*    c_mapped_file_new          (const char* filename, bool writable, CError** error);
 CMappedFile*    c_mapped_file_new_from_fd  (cint fd, bool writable, CError** error);
+
+/**
+ * @brief 以 MAP_SHARED 可写方式映射文件，写入映射区即写入文件(页缓存)，进程崩溃后数据仍然保留。
+ *        文件不足 size 字节时先用 posix_fallocate 扩展到 size；size 为 0 则按文件现有大小映射。
+ */
+CMappedFile*    c_mapped_file_new_shared          (const char* filename, csize size, CError** error);
+CMappedFile*    c_mapped_file_new_shared_from_fd  (cint fd, csize size, CError** error);
+
+/**
+ * @brief 将共享映射中 [offset, offset + length) 刷回磁盘，wait 为 true 时等待写盘完成(MS_SYNC)。
+ *        仅对 c_mapped_file_new_shared* 创建的映射有效。
+ */
+bool            c_mapped_file_sync         (CMappedFile* file, csize offset, csize length, bool wait);
 csize           c_mapped_file_get_length   (CMappedFile* file);
 char*           c_mapped_file_get_contents (CMappedFile* file);
 CBytes*         c_mapped_file_get_bytes    (CMappedFile* file);
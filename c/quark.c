@@ -14,14 +14,57 @@
 #include "quark.h"
 
 #include "str.h"
+#include "error.h"
 #include "atomic.h"
+#include "file-utils.h"
+#include "mapped-file.h"
 #include "c/thread.h"
 #include "c/hash-table.h"
 
 #define QUARK_BLOCK_SIZE            2048
 #define QUARK_STRING_BLOCK_SIZE     (4096 - sizeof (csize))
+#define QUARK_TABLE_MIN_SIZE        1024
+
+/**
+ * 字符串 -> quark 的只追加开放寻址表，查找不加锁:
+ * 每个槽位是一个 64 位整数(高 32 位 hash，低 32 位 quark，0 表示空)，整体原子读写；
+ * 插入与扩容持有 gsQuarkGlobal，先写入 gsQuarks[quark] 再发布槽位，扩容时复制槽位后发布新表；
+ * quark 永不释放，旧表可能仍有读者在使用，也不释放。
+ * 读者看到旧表或尚未发布的槽位时查找失败，加锁后在最新的表中重新查找。
+ */
+typedef struct _QuarkTable  QuarkTable;
+
+struct _QuarkTable
+{
+    cuint64             seed;
+    cuint               mask;
+    cuint               nnodes;     /* 持有 gsQuarkGlobal 时访问 */
+    QuarkTable*         prev;
+    cuint64             slots[];
+};
+
+/**
+ * c_quark_save 生成的快照: 文件头、QuarkTable(直接作为查找表使用)、每个 quark 的字符串偏移、字符串数据，各段 8 字节对齐
+ */
+#define QUARK_FILE_MAGIC            "CQUARK\0\1"
+
+typedef struct
+{
+    char                magic[8];
+    cuint32             headerSize;     /* 同时用来检查字长与对齐是否一致 */
+    cuint32             tableHeaderSize;
+    cuint32             nquarks;        /* 包括 quark 0 */
+    cuint32             tableSize;
+    cuint64             tableOffset;
+    cuint64             offsetsOffset;
+    cuint64             stringsOffset;
+    cuint64             stringsSize;
+} QuarkFileHeader;
 
 static CQuark quark_new (char* str);
+static QuarkTable* quark_table_new (cuint size, cuint64 seed);
+static CQuark quark_table_lookup (const char* str);
+static void quark_table_insert (const char* str, CQuark quark);
 static char* quark_strdup (const char* str);
 static CQuark quark_from_string (const char* str, bool duplicate);
 static CQuark quark_from_string_locked (const char* str, bool duplicate);
@@ -29,8 +72,9 @@ static const char* quark_intern_string_locked (const char* str, bool duplicate);
 
 C_LOCK_DEFINE_STATIC (gsQuarkGlobal);
 
-static CHashTable*      gsQuarkHt = NULL;
+static QuarkTable*      gsQuarkTable = NULL;
 static char**           gsQuarks = NULL;
+static CMappedFile*     gsQuarkFile = NULL;
 static int              gsQuarkSeqID = 0;
 static char*            gsQuarkBlock = NULL;
 static csize            gsQuarkBlockOffset = 0;
@@ -38,10 +82,10 @@ static csize            gsQuarkBlockOffset = 0;
 void c_quark_init (void)
 {
     c_assert (gsQuarkSeqID == 0);
-    gsQuarkHt = c_hash_table_new (c_str_hash, c_str_equal);
     gsQuarks = c_malloc0(sizeof (char*) * QUARK_BLOCK_SIZE);
     gsQuarks[0] = NULL;
     gsQuarkSeqID = 1;
+    __atomic_store_n (&gsQuarkTable, quark_table_new (QUARK_TABLE_MIN_SIZE, c_hash_get_seed ()), __ATOMIC_RELEASE);
 }
 
 CQuark c_quark_try_string (const char* str)
@@ -50,8 +94,14 @@ CQuark c_quark_try_string (const char* str)
         return 0;
     }
 
+    CQuark quark = quark_table_lookup (str);
+    if (C_LIKELY (quark)) {
+        return quark;
+    }
+
+    // 可能与插入同时发生，加锁后确认
     C_LOCK (gsQuarkGlobal);
-    CQuark quark = C_POINTER_TO_UINT(c_hash_table_lookup (gsQuarkHt, str));
+    quark = quark_table_lookup (str);
     C_UNLOCK (gsQuarkGlobal);
 
     return quark;
@@ -70,11 +120,11 @@ CQuark c_quark_from_string (const char* str)
 const char* c_quark_to_string (CQuark quark)
 {
     char* res= NULL;
-    cuint seqID = (cuint) c_atomic_int_get (&gsQuarkSeqID);
-    char** strT = c_atomic_pointer_get (&gsQuarks);
+    cuint seqID = (cuint) __atomic_load_n (&gsQuarkSeqID, __ATOMIC_ACQUIRE);
+    char** strT = __atomic_load_n (&gsQuarks, __ATOMIC_ACQUIRE);
 
     if (quark < seqID) {
-        res = strT[quark];
+        res = __atomic_load_n (&strT[quark], __ATOMIC_ACQUIRE);
     }
 
     return res;
@@ -112,7 +162,12 @@ static char* quark_strdup (const char* str)
 
 static CQuark quark_from_string (const char* str, bool duplicate)
 {
-    CQuark quark = C_POINTER_TO_UINT (c_hash_table_lookup (gsQuarkHt, str));
+    // 首次使用时初始化，调用时持有 gsQuarkGlobal
+    if (C_UNLIKELY (NULL == gsQuarkTable)) {
+        c_quark_init ();
+    }
+
+    CQuark quark = quark_table_lookup (str);
     if (!quark) {
         quark = quark_new (duplicate ? quark_strdup (str) : (char*) str);
     }
@@ -126,12 +181,18 @@ static CQuark quark_from_string_locked (const char* str, bool duplicate)
         return 0;
     }
 
+    CQuark quark = quark_table_lookup (str);
+    if (C_LIKELY (quark)) {
+        return quark;
+    }
+
     C_LOCK (gsQuarkGlobal);
-    CQuark quark = quark_from_string (str, duplicate);
+    quark = quark_from_string (str, duplicate);
     C_UNLOCK (gsQuarkGlobal);
 
     return quark;
 }
+
 static CQuark quark_new (char* str)
 {
     CQuark quark;
@@ -143,13 +204,13 @@ static CQuark quark_new (char* str)
             memcpy (quarksNew, gsQuarks, sizeof (char*) * gsQuarkSeqID);
         }
         memset (quarksNew + gsQuarkSeqID, 0, sizeof (char*) * QUARK_BLOCK_SIZE);
-        c_atomic_pointer_set (&gsQuarks, quarksNew);
+        __atomic_store_n (&gsQuarks, quarksNew, __ATOMIC_RELEASE);
     }
 
     quark = gsQuarkSeqID;
-    c_atomic_pointer_set (&gsQuarks[quark], str);
-    c_hash_table_insert (gsQuarkHt, str, C_UINT_TO_POINTER (quark));
-    c_atomic_int_inc (&gsQuarkSeqID);
+    __atomic_store_n (&gsQuarks[quark], str, __ATOMIC_RELEASE);
+    __atomic_store_n (&gsQuarkSeqID, gsQuarkSeqID + 1, __ATOMIC_RELEASE);
+    quark_table_insert (str, quark);
 
     return quark;
 }
@@ -163,6 +224,11 @@ static const char* quark_intern_string_locked (const char* str, bool duplicate)
         return NULL;
     }
 
+    quark = quark_table_lookup (str);
+    if (C_LIKELY (quark)) {
+        return c_quark_to_string (quark);
+    }
+
     C_LOCK (gsQuarkGlobal);
     quark = quark_from_string (str, duplicate);
     result = gsQuarks[quark];
@@ -170,3 +236,204 @@ static const char* quark_intern_string_locked (const char* str, bool duplicate)
 
     return result;
 }
+
+static QuarkTable* quark_table_new (cuint size, cuint64 seed)
+{
+    QuarkTable* table = c_malloc0 (sizeof (QuarkTable) + sizeof (cuint64) * size);
+
+    table->seed = seed;
+    table->mask = size - 1;
+
+    return table;
+}
+
+static CQuark quark_table_lookup (const char* str)
+{
+    const QuarkTable* table = __atomic_load_n (&gsQuarkTable, __ATOMIC_ACQUIRE);
+    if (C_UNLIKELY (NULL == table)) {
+        return 0;
+    }
+
+    const cuint hash = (cuint) c_hash_wy (str, strlen (str), table->seed);
+    cuint i = hash & table->mask;
+
+    for (;; i = (i + 1) & table->mask) {
+        const cuint64 slot = __atomic_load_n (&table->slots[i], __ATOMIC_ACQUIRE);
+        if (0 == slot) {
+            return 0;
+        }
+        if ((cuint) (slot >> 32) == hash) {
+            // 槽位发布之前 gsQuarks[quark] 已经写入
+            const CQuark quark = (CQuark) slot;
+            char** quarks = __atomic_load_n (&gsQuarks, __ATOMIC_ACQUIRE);
+            if (0 == strcmp (__atomic_load_n (&quarks[quark], __ATOMIC_ACQUIRE), str)) {
+                return quark;
+            }
+        }
+    }
+}
+
+static inline void quark_table_put (QuarkTable* table, cuint64 slot)
+{
+    cuint i = (cuint) (slot >> 32) & table->mask;
+
+    while (0 != table->slots[i]) {
+        i = (i + 1) & table->mask;
+    }
+    __atomic_store_n (&table->slots[i], slot, __ATOMIC_RELEASE);
+}
+
+/* 调用时持有 gsQuarkGlobal；负载因子不超过 1/2 */
+static void quark_table_insert (const char* str, CQuark quark)
+{
+    cuint i;
+    QuarkTable* table = gsQuarkTable;
+
+    if ((table->nnodes + 1) * 2 > table->mask + 1) {
+        QuarkTable* newTable = quark_table_new ((table->mask + 1) * 2, table->seed);
+        for (i = 0; i <= table->mask; ++i) {
+            if (table->slots[i]) {
+                quark_table_put (newTable, table->slots[i]);
+            }
+        }
+        newTable->nnodes = table->nnodes;
+        newTable->prev = table;
+        __atomic_store_n (&gsQuarkTable, newTable, __ATOMIC_RELEASE);
+        table = newTable;
+    }
+
+    const cuint hash = (cuint) c_hash_wy (str, strlen (str), table->seed);
+    quark_table_put (table, ((cuint64) hash << 32) | quark);
+    table->nnodes++;
+}
+
+#define QUARK_FILE_ALIGN(n_)        (((n_) + 7) & ~((cuint64) 7))
+
+bool c_quark_save (const char* filename, CError** error)
+{
+    cuint i;
+    QuarkFileHeader header;
+
+    c_return_val_if_fail (filename != NULL, false);
+
+    C_LOCK (gsQuarkGlobal);
+    if (C_UNLIKELY (NULL == gsQuarkTable)) {
+        c_quark_init ();
+    }
+
+    const QuarkTable* table = gsQuarkTable;
+    const cuint nquarks = (cuint) gsQuarkSeqID;
+    const cuint tableSize = table->mask + 1;
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, QUARK_FILE_MAGIC, sizeof (header.magic));
+    header.headerSize = sizeof (QuarkFileHeader);
+    header.tableHeaderSize = sizeof (QuarkTable);
+    header.nquarks = nquarks;
+    header.tableSize = tableSize;
+    header.tableOffset = QUARK_FILE_ALIGN (sizeof (QuarkFileHeader));
+    header.offsetsOffset = QUARK_FILE_ALIGN (header.tableOffset + sizeof (QuarkTable) + sizeof (cuint64) * tableSize);
+    header.stringsOffset = QUARK_FILE_ALIGN (header.offsetsOffset + sizeof (cuint32) * nquarks);
+    for (i = 1; i < nquarks; ++i) {
+        header.stringsSize += strlen (gsQuarks[i]) + 1;
+    }
+
+    const csize length = header.stringsOffset + header.stringsSize;
+    char* contents = c_malloc0 (length);
+    memcpy (contents, &header, sizeof (header));
+
+    QuarkTable* tableCopy = (QuarkTable*) (contents + header.tableOffset);
+    memcpy (tableCopy, table, sizeof (QuarkTable) + sizeof (cuint64) * tableSize);
+    tableCopy->prev = NULL;
+
+    cuint32* offsets = (cuint32*) (contents + header.offsetsOffset);
+    char* strings = contents + header.stringsOffset;
+    cuint64 offset = 0;
+    for (i = 1; i < nquarks; ++i) {
+        const csize len = strlen (gsQuarks[i]) + 1;
+        offsets[i] = (cuint32) offset;
+        memcpy (strings + offset, gsQuarks[i], len);
+        offset += len;
+    }
+    C_UNLOCK (gsQuarkGlobal);
+
+    const bool ret = c_file_set_contents (filename, contents, (cssize) length, error);
+    c_free (contents);
+
+    return ret;
+}
+
+bool c_quark_load (const char* filename, CError** error)
+{
+    cuint i;
+
+    c_return_val_if_fail (filename != NULL, false);
+
+    CMappedFile* file = c_mapped_file_new (filename, true, error);
+    if (NULL == file) {
+        return false;
+    }
+
+    char* contents = c_mapped_file_get_contents (file);
+    const csize length = c_mapped_file_get_length (file);
+    const QuarkFileHeader* header = (const QuarkFileHeader*) contents;
+
+    // 检查文件头与各段范围，映射内存之后直接作为查找表与字符串使用
+    bool valid = length >= sizeof (QuarkFileHeader)
+        && 0 == memcmp (header->magic, QUARK_FILE_MAGIC, sizeof (header->magic))
+        && header->headerSize == sizeof (QuarkFileHeader)
+        && header->tableHeaderSize == sizeof (QuarkTable)
+        && header->nquarks >= 1
+        && header->tableSize >= QUARK_TABLE_MIN_SIZE && 0 == (header->tableSize & (header->tableSize - 1))
+        && (cuint64) header->nquarks * 2 <= header->tableSize
+        && header->tableOffset % 8 == 0
+        && header->tableOffset + sizeof (QuarkTable) + sizeof (cuint64) * header->tableSize <= header->offsetsOffset
+        && header->offsetsOffset % 4 == 0
+        && header->offsetsOffset + sizeof (cuint32) * header->nquarks <= header->stringsOffset
+        && header->stringsOffset + header->stringsSize == length
+        && (header->nquarks == 1 || (header->stringsSize > 0 && '\0' == contents[length - 1]));
+
+    QuarkTable* table = valid ? (QuarkTable*) (contents + header->tableOffset) : NULL;
+    const cuint32* offsets = valid ? (const cuint32*) (contents + header->offsetsOffset) : NULL;
+    valid = valid && table->mask == header->tableSize - 1 && table->nnodes == header->nquarks - 1;
+    cuint used = 0;
+    for (i = 0; valid && i < header->tableSize; ++i) {
+        valid = (cuint32) table->slots[i] < header->nquarks && (0 == table->slots[i] || 0 != (cuint32) table->slots[i]);
+        used += (0 != table->slots[i]);
+    }
+    // 查找依赖空槽结束探测，占用数与 quark 个数不符或没有空槽时拒绝
+    valid = valid && used == header->nquarks - 1 && used < header->tableSize;
+    for (i = 1; valid && i < header->nquarks; ++i) {
+        valid = offsets[i] < header->stringsSize;
+    }
+
+    if (!valid) {
+        c_set_error (error, C_FILE_ERROR, C_FILE_ERROR_INVAL, "Invalid quark file “%s”", filename);
+        c_mapped_file_unref (file);
+        return false;
+    }
+
+    C_LOCK (gsQuarkGlobal);
+    if (gsQuarkSeqID > 1 || gsQuarkFile) {
+        C_UNLOCK (gsQuarkGlobal);
+        c_set_error (error, C_FILE_ERROR, C_FILE_ERROR_EXIST, "Quarks already exist, cannot load “%s”", filename);
+        c_mapped_file_unref (file);
+        return false;
+    }
+
+    // quark_new 在编号是 QUARK_BLOCK_SIZE 的倍数时扩展 gsQuarks，容量按块取整
+    const cuint nquarks = header->nquarks;
+    char** quarks = c_malloc0 (sizeof (char*) * ((nquarks + QUARK_BLOCK_SIZE - 1) / QUARK_BLOCK_SIZE * QUARK_BLOCK_SIZE));
+    for (i = 1; i < nquarks; ++i) {
+        quarks[i] = contents + header->stringsOffset + offsets[i];
+    }
+
+    table->prev = NULL;
+    gsQuarkFile = file;
+    __atomic_store_n (&gsQuarks, quarks, __ATOMIC_RELEASE);
+    __atomic_store_n (&gsQuarkTable, table, __ATOMIC_RELEASE);
+    __atomic_store_n (&gsQuarkSeqID, (cint) nquarks, __ATOMIC_RELEASE);
+    C_UNLOCK (gsQuarkGlobal);
+
+    return true;
+}
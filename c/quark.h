@@ -41,6 +41,19 @@ const char* c_quark_to_string           (CQuark quark) C_CONST;
 const char* c_intern_string         (const char* string);
 const char* c_intern_static_string  (const char* string);
 
+/**
+ * @brief 把当前所有 quark 及其字符串保存为快照文件，其它进程可以用 c_quark_load() 映射后直接使用
+ * @note 快照保存 quark 编号、字符串与查找表；文件格式与字长、字节序相关，只能在相同平台的进程之间共享
+ */
+bool        c_quark_save            (const char* filename, CError** error);
+
+/**
+ * @brief 以写时复制方式映射 c_quark_save() 生成的快照，预加载其中的所有 quark，编号与保存时相同
+ * @note 必须在创建任何 quark 之前调用，否则返回 false；字符串与查找表直接使用映射内存，不复制也不重新计算 hash，
+ *       之后新建的 quark 照常分配，编号接在快照之后
+ */
+bool        c_quark_load            (const char* filename, CError** error);
+
 
 
 #endif //CLIBRARY_QUARK_H
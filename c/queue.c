@@ -4,9 +4,11 @@
 
 #include "queue.h"
 
+#include "slice.h"
+
 CQueue * c_queue_new(void)
 {
-    return c_malloc0(sizeof(CQueue));
+    return c_slice_new0(CQueue);
 }
 
 void c_queue_free(CQueue* queue)
@@ -14,7 +16,7 @@ void c_queue_free(CQueue* queue)
     c_return_if_fail(NULL != queue);
 
     c_list_free(queue->head);
-    c_free0(queue);
+    c_slice_free(CQueue, queue);
 }
 
 void c_queue_free_full(CQueue * queue, CDestroyNotify freeFunc)
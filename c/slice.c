@@ -0,0 +1,383 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-29.
+//
+
+#include "slice.h"
+
+#include "thread.h"
+
+#define SLICE_ALIGN                 (2 * sizeof (void*))            // 空闲块至少能放下两个指针
+#define SLICE_MAX_SIZE              256
+#define SLICE_N_CLASSES             (SLICE_MAX_SIZE / SLICE_ALIGN)
+#define SLICE_MAGAZINE_SIZE         64
+#define SLICE_AREA_SIZE             (16 * 1024)
+
+#define SLICE_CLASS(size)           (((size) + SLICE_ALIGN - 1) / SLICE_ALIGN - 1)
+#define SLICE_CLASS_SIZE(ix)        (((ix) + 1) * SLICE_ALIGN)
+
+typedef struct _SliceChunk          SliceChunk;
+typedef struct _SliceArea           SliceArea;
+typedef struct _SliceMagazine       SliceMagazine;
+typedef struct _SliceDepot          SliceDepot;
+typedef struct _SliceThreadCache    SliceThreadCache;
+
+/**
+ * @brief 空闲块: next 串联 magazine 中的块，在仓库中时 magazine 的第一个块用 nextMagazine 串联其它 magazine
+ */
+struct _SliceChunk
+{
+    SliceChunk*         next;
+    SliceChunk*         nextMagazine;
+};
+
+/**
+ * @brief 从系统申请的内存，按块切分后不再归还
+ */
+struct _SliceArea
+{
+    SliceArea*          next;
+    void*               padding;
+};
+
+struct _SliceMagazine
+{
+    SliceChunk*         chain;
+    cuint               count;
+};
+
+/**
+ * @brief 全局仓库，每个大小分组一个
+ */
+struct _SliceDepot
+{
+    SliceChunk*         magazines;          // 装满的 magazine
+    SliceChunk*         loose;              // 线程退出时留下的零散空闲块
+    cuint8*             areaPos;            // 当前正在切分的内存
+    cuint8*             areaEnd;
+};
+
+/**
+ * @brief 每个线程的缓存: loaded 用于分配与释放，prev 要么为空要么是满的，
+ *        loaded 空了/满了先与 prev 交换，两个都不能用时才与仓库交换
+ */
+struct _SliceThreadCache
+{
+    SliceMagazine       loaded[SLICE_N_CLASSES];
+    SliceMagazine       prev[SLICE_N_CLASSES];
+};
+
+C_STATIC_ASSERT(sizeof (SliceChunk) <= SLICE_ALIGN);
+C_STATIC_ASSERT(sizeof (SliceArea) % SLICE_ALIGN == 0);
+
+static void slice_thread_cache_free (void* data);
+
+C_LOCK_DEFINE_STATIC (gsSliceDepot);
+static SliceDepot           gsSliceDepots[SLICE_N_CLASSES];
+static SliceArea*           gsSliceAreas = NULL;
+static cint                 gsSliceAlwaysMalloc = -1;
+static CPrivate             gsSliceThreadCachePrivate = C_PRIVATE_INIT (slice_thread_cache_free);
+static __thread SliceThreadCache*   gsSliceThreadCache = NULL;
+static __thread bool                gsSliceThreadCacheGone = false;
+
+
+static inline bool slice_always_malloc (void)
+{
+    cint mode = __atomic_load_n (&gsSliceAlwaysMalloc, __ATOMIC_RELAXED);
+
+    if (C_UNLIKELY (mode < 0)) {
+        // 每个线程得到的结果都相同，重复计算没有关系
+        const char* env = getenv ("C_SLICE");
+        mode = (env && strstr (env, "always-malloc")) ? 1 : 0;
+        __atomic_store_n (&gsSliceAlwaysMalloc, mode, __ATOMIC_RELAXED);
+    }
+
+    return mode;
+}
+
+/* 仓库已加锁: 切分出最多 SLICE_MAGAZINE_SIZE 个新块 */
+static void slice_depot_carve_locked (cuint ix, SliceMagazine* mag)
+{
+    cuint i;
+    SliceDepot* depot = &gsSliceDepots[ix];
+    const csize size = SLICE_CLASS_SIZE (ix);
+
+    if ((csize) (depot->areaEnd - depot->areaPos) < size) {
+        SliceArea* area = c_malloc0 (SLICE_AREA_SIZE);
+        area->next = gsSliceAreas;
+        gsSliceAreas = area;
+        depot->areaPos = (cuint8*) (area + 1);
+        depot->areaEnd = (cuint8*) area + SLICE_AREA_SIZE;
+    }
+
+    const cuint n = C_MIN (SLICE_MAGAZINE_SIZE, (cuint) ((depot->areaEnd - depot->areaPos) / size));
+    SliceChunk* chain = NULL;
+    for (i = n; i > 0; --i) {
+        SliceChunk* chunk = (SliceChunk*) (depot->areaPos + (csize) (i - 1) * size);
+        chunk->next = chain;
+        chain = chunk;
+    }
+    depot->areaPos += (csize) n * size;
+
+    mag->chain = chain;
+    mag->count = n;
+}
+
+/* 从仓库取一个 magazine，优先取满的，其次是零散块，最后切分新内存 */
+static void slice_depot_take (cuint ix, SliceMagazine* mag)
+{
+    SliceDepot* depot = &gsSliceDepots[ix];
+
+    C_LOCK (gsSliceDepot);
+    if (depot->magazines) {
+        mag->chain = depot->magazines;
+        mag->count = SLICE_MAGAZINE_SIZE;
+        depot->magazines = mag->chain->nextMagazine;
+    }
+    else if (depot->loose) {
+        SliceChunk* tail = depot->loose;
+        mag->chain = depot->loose;
+        mag->count = 1;
+        while (tail->next && mag->count < SLICE_MAGAZINE_SIZE) {
+            tail = tail->next;
+            mag->count++;
+        }
+        depot->loose = tail->next;
+        tail->next = NULL;
+    }
+    else {
+        slice_depot_carve_locked (ix, mag);
+    }
+    C_UNLOCK (gsSliceDepot);
+}
+
+/* 把满的 magazine 还给仓库 */
+static void slice_depot_put (cuint ix, SliceMagazine* mag)
+{
+    SliceDepot* depot = &gsSliceDepots[ix];
+
+    C_LOCK (gsSliceDepot);
+    mag->chain->nextMagazine = depot->magazines;
+    depot->magazines = mag->chain;
+    C_UNLOCK (gsSliceDepot);
+
+    mag->chain = NULL;
+    mag->count = 0;
+}
+
+/* 把任意数量的空闲块还给仓库 */
+static void slice_depot_put_loose (cuint ix, SliceMagazine* mag)
+{
+    SliceChunk* tail = mag->chain;
+    SliceDepot* depot = &gsSliceDepots[ix];
+
+    if (NULL == tail) {
+        return;
+    }
+
+    while (tail->next) {
+        tail = tail->next;
+    }
+
+    C_LOCK (gsSliceDepot);
+    tail->next = depot->loose;
+    depot->loose = mag->chain;
+    C_UNLOCK (gsSliceDepot);
+
+    mag->chain = NULL;
+    mag->count = 0;
+}
+
+static SliceThreadCache* slice_thread_cache (void)
+{
+    if (C_LIKELY (gsSliceThreadCache)) {
+        return gsSliceThreadCache;
+    }
+
+    // 线程退出时其它 TLS 析构函数还可能释放节点，这时直接使用仓库
+    if (gsSliceThreadCacheGone) {
+        return NULL;
+    }
+
+    gsSliceThreadCache = c_malloc0 (sizeof (SliceThreadCache));
+    c_private_set (&gsSliceThreadCachePrivate, gsSliceThreadCache);
+
+    return gsSliceThreadCache;
+}
+
+/* 线程退出: 满的 magazine 整体放回仓库，其余作为零散块 */
+static void slice_thread_cache_free (void* data)
+{
+    cuint ix;
+    SliceThreadCache* cache = data;
+
+    for (ix = 0; ix < SLICE_N_CLASSES; ++ix) {
+        if (SLICE_MAGAZINE_SIZE == cache->prev[ix].count) {
+            slice_depot_put (ix, &cache->prev[ix]);
+        }
+        if (SLICE_MAGAZINE_SIZE == cache->loaded[ix].count) {
+            slice_depot_put (ix, &cache->loaded[ix]);
+        }
+        slice_depot_put_loose (ix, &cache->prev[ix]);
+        slice_depot_put_loose (ix, &cache->loaded[ix]);
+    }
+
+    if (cache == gsSliceThreadCache) {
+        gsSliceThreadCache = NULL;
+        gsSliceThreadCacheGone = true;
+    }
+
+    c_free (cache);
+}
+
+static inline void slice_magazine_swap (SliceMagazine* a, SliceMagazine* b)
+{
+    const SliceMagazine tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void* slice_alloc_slow (cuint ix)
+{
+    SliceThreadCache* cache = slice_thread_cache ();
+
+    if (NULL == cache) {
+        SliceMagazine mag;
+        slice_depot_take (ix, &mag);
+        SliceChunk* chunk = mag.chain;
+        mag.chain = chunk->next;
+        mag.count--;
+        slice_depot_put_loose (ix, &mag);
+        return chunk;
+    }
+
+    SliceMagazine* loaded = &cache->loaded[ix];
+    if (0 == loaded->count) {
+        if (cache->prev[ix].count > 0) {
+            slice_magazine_swap (loaded, &cache->prev[ix]);
+        }
+        else {
+            slice_depot_take (ix, loaded);
+        }
+    }
+
+    SliceChunk* chunk = loaded->chain;
+    loaded->chain = chunk->next;
+    loaded->count--;
+
+    return chunk;
+}
+
+static void slice_free_slow (cuint ix, SliceChunk* chunk)
+{
+    SliceThreadCache* cache = slice_thread_cache ();
+
+    if (NULL == cache) {
+        SliceMagazine mag = { chunk, 1 };
+        chunk->next = NULL;
+        slice_depot_put_loose (ix, &mag);
+        return;
+    }
+
+    SliceMagazine* loaded = &cache->loaded[ix];
+    if (loaded->count >= SLICE_MAGAZINE_SIZE) {
+        if (0 == cache->prev[ix].count) {
+            slice_magazine_swap (loaded, &cache->prev[ix]);
+        }
+        else {
+            slice_depot_put (ix, &cache->prev[ix]);
+            slice_magazine_swap (loaded, &cache->prev[ix]);
+        }
+    }
+
+    chunk->next = loaded->chain;
+    loaded->chain = chunk;
+    loaded->count++;
+}
+
+void* c_slice_alloc (csize blockSize)
+{
+    c_return_val_if_fail (blockSize > 0, NULL);
+
+    if (C_UNLIKELY (blockSize > SLICE_MAX_SIZE || slice_always_malloc ())) {
+        return c_malloc0 (blockSize);
+    }
+
+    const cuint ix = SLICE_CLASS (blockSize);
+    SliceThreadCache* cache = gsSliceThreadCache;
+    if (C_LIKELY (cache && cache->loaded[ix].count > 0)) {
+        SliceMagazine* loaded = &cache->loaded[ix];
+        SliceChunk* chunk = loaded->chain;
+        loaded->chain = chunk->next;
+        loaded->count--;
+        return chunk;
+    }
+
+    return slice_alloc_slow (ix);
+}
+
+void* c_slice_alloc0 (csize blockSize)
+{
+    void* mem = c_slice_alloc (blockSize);
+
+    if (C_LIKELY (mem)) {
+        memset (mem, 0, blockSize);
+    }
+
+    return mem;
+}
+
+void* c_slice_copy (csize blockSize, const void* memBlock)
+{
+    void* mem = c_slice_alloc (blockSize);
+
+    if (C_LIKELY (mem && memBlock)) {
+        memcpy (mem, memBlock, blockSize);
+    }
+
+    return mem;
+}
+
+void c_slice_free1 (csize blockSize, void* memBlock)
+{
+    if (C_UNLIKELY (NULL == memBlock || 0 == blockSize)) {
+        return;
+    }
+
+    if (C_UNLIKELY (blockSize > SLICE_MAX_SIZE || slice_always_malloc ())) {
+        free (memBlock);
+        return;
+    }
+
+    const cuint ix = SLICE_CLASS (blockSize);
+    SliceThreadCache* cache = gsSliceThreadCache;
+    if (C_LIKELY (cache && cache->loaded[ix].count < SLICE_MAGAZINE_SIZE)) {
+        SliceMagazine* loaded = &cache->loaded[ix];
+        SliceChunk* chunk = memBlock;
+        chunk->next = loaded->chain;
+        loaded->chain = chunk;
+        loaded->count++;
+        return;
+    }
+
+    slice_free_slow (ix, memBlock);
+}
+
+void c_slice_free_chain_with_offset (csize blockSize, void* memChain, csize nextOffset)
+{
+    void* next = NULL;
+    void* mem = NULL;
+
+    for (mem = memChain; mem; mem = next) {
+        next = *(void**) C_STRUCT_MEMBER_P (mem, nextOffset);
+        c_slice_free1 (blockSize, mem);
+    }
+}
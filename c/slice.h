@@ -0,0 +1,52 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-29.
+//
+
+#ifndef CLIBRARY_SLICE_H
+#define CLIBRARY_SLICE_H
+
+#if !defined (__CLIB_H_INSIDE__) && !defined (CLIB_COMPILATION)
+#error "Only <clib.h> can be included directly."
+#endif
+
+#include <c/macros.h>
+
+C_BEGIN_EXTERN_C
+
+/**
+ * @brief 固定大小小块内存的分配器，CList/CSList/CQueue 的节点都从这里分配
+ * @note 不超过 256 字节的块按 16 字节取整分组，每个线程为每组缓存两个 magazine(最多 64 个空闲块的链表)，
+ *       分配与释放通常只操作本线程的 magazine，不加锁；magazine 空了/满了才与全局仓库整体交换。
+ *       更大的块直接使用 malloc。从这里分配的块必须用相同的 blockSize 调用 c_slice_free1 释放，
+ *       可以在其它线程释放；分配出的内存不会还给系统，而是留给之后的分配复用。
+ *       环境变量 C_SLICE=always-malloc 时所有块都直接使用 malloc/free，便于 valgrind/ASan 检查越界与重复释放，
+ *       必须在进程第一次分配之前设置
+ */
+#define c_slice_new(type)                           ((type*) c_slice_alloc (sizeof (type)))
+#define c_slice_new0(type)                          ((type*) c_slice_alloc0 (sizeof (type)))
+#define c_slice_dup(type, mem)                      ((type*) c_slice_copy (sizeof (type), (mem)))
+#define c_slice_free(type, mem)                     c_slice_free1 (sizeof (type), (mem))
+
+/**
+ * @brief 释放以 next 成员串联的整条链表，例如 c_slice_free_chain (CList, list, next)
+ */
+#define c_slice_free_chain(type, chain, next)       c_slice_free_chain_with_offset (sizeof (type), (chain), C_STRUCT_OFFSET (type, next))
+
+void*   c_slice_alloc                   (csize blockSize) C_MALLOC;
+void*   c_slice_alloc0                  (csize blockSize) C_MALLOC;
+void*   c_slice_copy                    (csize blockSize, const void* memBlock) C_MALLOC;
+void    c_slice_free1                   (csize blockSize, void* memBlock);
+void    c_slice_free_chain_with_offset  (csize blockSize, void* memChain, csize nextOffset);
+
+C_END_EXTERN_C
+
+#endif //CLIBRARY_SLICE_H
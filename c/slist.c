@@ -13,6 +13,8 @@
 
 #include "slist.h"
 
+#include "slice.h"
+
 
 static CSList* _c_slist_remove_link (CSList* list, CSList* link);
 static CSList* _c_slist_remove_data (CSList* list, const void* data, bool all);
@@ -23,27 +25,17 @@ static CSList* c_slist_insert_sorted_real (CSList* list, void* data, CFunc func,
 
 CSList* c_slist_alloc (void)
 {
-    CSList* ls = c_malloc0 (sizeof(CSList));
-
-    ls->next = NULL;
-    ls->data = NULL;
-
-    return ls;
+    return c_slice_new0 (CSList);
 }
 
 void c_slist_free (CSList* list)
 {
-    CSList* i = NULL;
-    CSList* k = NULL;
-    for (i = list; i; i = k) {
-        k = i->next;
-        c_free(i);
-    }
+    c_slice_free_chain (CSList, list, next);
 }
 
 void c_slist_free_1 (CSList* list)
 {
-    c_free(list);
+    c_slice_free (CSList, list);
 }
 
 void c_slist_free_full (CSList* list, CDestroyNotify freeFunc)
@@ -115,7 +107,7 @@ CSList* c_slist_insert (CSList* list, void* data, cint position)
         prevList->next = newList;
     }
     else {
-        c_free(newList);
+        c_slice_free (CSList, newList);
         c_assert(false);
     }
 
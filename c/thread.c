@@ -16,23 +16,17 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <stdatomic.h>
-#include <sys/syscall.h>
-#include <linux/futex.h>
 
 #include "log.h"
 #include "str.h"
 #include "error.h"
 #include "slist.h"
 #include "atomic.h"
+#include "futex-priv.h"
 
 
 C_DEFINE_QUARK (c_thread_error, c_thread_error)
 
-#ifndef FUTEX_WAIT_PRIVATE
-#define FUTEX_WAIT_PRIVATE FUTEX_WAIT
-#define FUTEX_WAKE_PRIVATE FUTEX_WAKE
-#endif
-
 #define posix_check_err(err, name) C_STMT_START{ \
     int posixCheckError_ = (err); \
     if (posixCheckError_) { \
@@ -67,27 +61,6 @@ C_DEFINE_QUARK (c_thread_error, c_thread_error)
 #endif
 
 
-#if defined(__NR_futex) && defined(__NR_futex_time64)
-#define c_futex_simple(uaddr, futex_op, ...) \
-    C_STMT_START { \
-        int res = syscall (__NR_futex_time64, uaddr, (csize) futex_op, __VA_ARGS__); \
-        if (res < 0 && errno == ENOSYS) { \
-            syscall (__NR_futex, uaddr, (csize) futex_op, __VA_ARGS__);              \
-        } \
-    } C_STMT_END
-#elif defined(__NR_futex_time64)
-#define c_futex_simple(uaddr, futex_op, ...) \
-    C_STMT_START { \
-        syscall (__NR_futex_time64, uaddr, (csize) futex_op, __VA_ARGS__); \
-    } C_STMT_END
-#elif defined(__NR_futex)
-#define c_futex_simple(uaddr, futex_op, ...) \
-    C_STMT_START { \
-        syscall (__NR_futex, uaddr, (csize) futex_op, __VA_ARGS__); \
-    } C_STMT_END
-#else /* !defined(__NR_futex) && !defined(__NR_futex_time64) */
-#error "Neither __NR_futex nor __NR_futex_time64 are defined but were found by meson"
-#endif /* defined(__NR_futex) && defined(__NR_futex_time64) */
 
 
 typedef enum
@@ -148,7 +121,6 @@ void*           c_thread_proxy                          (void* thread);
 void            c_system_thread_set_name                (const char* name);
 void            c_system_thread_wait                    (CRealThread* thread);
 void            c_system_thread_free                    (CRealThread* thread);
-void*           c_private_set_alloc0                    (CPrivate* key, csize size);
 bool            c_system_thread_get_scheduler_settings  (CThreadSchedulerSettings* schedulerSettings);
 bool            c_thread_get_scheduler_settings         (CThreadSchedulerSettings* schedulerSettings);
 CRealThread*    c_system_thread_new                     (CThreadFunc proxy, culong stackSize, const CThreadSchedulerSettings* scheduleSettings, const char* name, CThreadFunc func, void* data, CError** error);
@@ -590,7 +562,24 @@ void c_once_init_leave (volatile void* location, csize result)
 
 cuint c_get_num_processors (void)
 {
-    return 1;
+    csize i;
+    cuint n = 0;
+    culong mask[1024 / (8 * sizeof (culong))];
+
+    // 优先使用 CPU 亲和性掩码，容器/taskset 限制的 CPU 个数比在线 CPU 个数更准确
+    const long bytes = syscall (__NR_sched_getaffinity, 0, sizeof (mask), mask);
+    if (bytes > 0) {
+        for (i = 0; i < (csize) bytes / sizeof (culong); ++i) {
+            n += (cuint) __builtin_popcountl (mask[i]);
+        }
+    }
+
+    if (0 == n) {
+        const long online = sysconf (_SC_NPROCESSORS_ONLN);
+        n = (online > 0) ? (cuint) online : 1;
+    }
+
+    return n;
 }
 
 bool (c_once_init_enter_pointer) (void* location)
@@ -669,6 +658,7 @@ void* c_private_set_alloc0 (CPrivate* key, csize size)
 
 static void c_thread_cleanup (void* data)
 {
+    c_log_flush ();
     c_thread_unref (data);
 }
 
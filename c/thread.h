@@ -185,6 +185,7 @@ bool            c_cond_wait_until               (CCond* cond, CMutex* mutex, cin
 void*           c_private_get                   (CPrivate* key);
 void            c_private_set                   (CPrivate* key, void* value);
 void            c_private_replace               (CPrivate* key, void* value);
+void*           c_private_set_alloc0            (CPrivate* key, csize size);
 void*           c_once_impl                     (COnce* once, CThreadFunc func, void* arg);
 bool            c_once_init_enter               (volatile void* location);
 void            c_once_init_leave               (volatile void* location, csize result);
@@ -1357,7 +1357,7 @@ cchar* c_uri_to_strinc_partial(CUri* uri, CUriHideFlags flags)
                       hide_fragment ? NULL : uri->fragment);
 }
 
-/* This is just a copy of c_str_hash() with c_ascii_toupper() added */
+/* djb2 over c_ascii_toupper()'d bytes, so that keys equal under str_ascii_case_equal() hash equally */
 static cuint str_ascii_case_hash(const void* v)
 {
     const signed char * p;
@@ -0,0 +1,37 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-6-17.
+//
+#include <c/clib.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+/**
+ * 把 C_LOG_FORMAT_BINARY 写出的日志文件还原为文本日志，输出到标准输出
+ */
+int main (int argc, char* argv[])
+{
+    int i = 0;
+
+    if (argc < 2) {
+        fprintf (stderr, "usage: %s <binary log file>...\n", argv[0]);
+        return 1;
+    }
+
+    for (i = 1; i < argc; ++i) {
+        if (!c_log_decode (argv[i], STDOUT_FILENO)) {
+            fprintf (stderr, "decode '%s' failed\n", argv[i]);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -13,12 +13,27 @@
 #include <c/clib.h>
 
 #define DEMO_FILE 1
+#define DEMO_ASYNC 0
+#define DEMO_BINARY 0
+#define DEMO_MMAP 0
 
 int main (C_UNUSED int argc, C_UNUSED char* argv[])
 {
 #if !DEMO_FILE
     c_log_init (C_LOG_TYPE_CONSOLE, C_LOG_LEVEL_VERB, 10240, "/tmp/", "a", "log", true);
 
+    C_LOG_DEBUG("1111111");
+#elif DEMO_ASYNC
+    c_log_init_async (C_LOG_LEVEL_VERB, 10240, "/tmp/", "a", "log", true, 0, C_LOG_ASYNC_BLOCK);
+    C_LOG_DEBUG("1111111");
+#elif DEMO_BINARY
+    // 使用 demo-log-decode 查看日志内容
+    c_log_init (C_LOG_LEVEL_VERB, 10240, "/tmp/", "a", "log", true);
+    c_log_set_format (C_LOG_FORMAT_BINARY);
+    C_LOG_DEBUG("1111111 %d %s", 2, "3");
+#elif DEMO_MMAP
+    // 进程崩溃也不会丢失已输出的日志，使用 demo-log-decode 查看日志内容
+    c_log_init_mmap (C_LOG_LEVEL_VERB, 10240, "/tmp/", "a", "log", true);
     C_LOG_DEBUG("1111111");
 #else
     c_log_init (C_LOG_LEVEL_VERB, 10240, "/tmp/", "a", "log", true);
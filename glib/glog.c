@@ -19,13 +19,14 @@
 
 GLogWriterOutput c_glog_handler(GLogLevelFlags level, const GLogField *fields, gsize nFields, C_UNUSED gpointer udata)
 {
-    g_autofree char *msg = NULL;
-    g_autofree char *line = NULL;
+    gint line = 0;
+    gssize msgLen = 0;
+    const char *msg = NULL;
     const char *file = NULL;
     const char *func = NULL;
 
     CLogLevel logLevel;
-    switch (level) {
+    switch (level & G_LOG_LEVEL_MASK) {
         case G_LOG_LEVEL_MESSAGE:
         case G_LOG_LEVEL_INFO: {
             logLevel = C_LOG_LEVEL_INFO;
@@ -48,25 +49,48 @@ GLogWriterOutput c_glog_handler(GLogLevelFlags level, const GLogField *fields, g
             logLevel = C_LOG_LEVEL_DEBUG;
         }
     }
-    for (int i = 0; i < nFields; ++i) {
-        if (0 == g_ascii_strcasecmp ("file", fields[i].key)) {
-            file = fields[i].value;
-        } else if (0 == g_ascii_strcasecmp ("func", fields[i].key)) {
-            func = fields[i].value;
-        } else if (0 == g_ascii_strcasecmp ("line", fields[i].key)) {
-            line = g_strdup_printf ("%u", (*(const int*) (&(fields[i].value))));
-        } else if (0 == g_ascii_strcasecmp ("message", fields[i].key)) {
-            msg = g_strdup_printf ("%s", (char*) (fields[i].value ? fields[i].value : "<null>"));
+
+    if (!C_LOG_LEVEL_ENABLED(logLevel)) {
+        return G_LOG_WRITER_HANDLED;
+    }
+
+    // C_GLOG_* 使用 FILE/LINE/FUNC，glib 自带的宏使用 CODE_FILE/CODE_LINE/CODE_FUNC
+    for (gsize i = 0; i < nFields; ++i) {
+        const char *key = fields[i].key;
+        if (0 == g_ascii_strncasecmp (key, "CODE_", 5)) {
+            key += 5;
         }
-#if 0
-        else {
-            write (2, fields[i].key, strlen (fields[i].key));
-            write (2, "\n", 1);
+        switch (g_ascii_toupper (key[0])) {
+            case 'F': {
+                if (0 == g_ascii_strcasecmp ("file", key)) {
+                    file = fields[i].value;
+                } else if (0 == g_ascii_strcasecmp ("func", key)) {
+                    func = fields[i].value;
+                }
+                break;
+            }
+            case 'L': {
+                if (0 == g_ascii_strcasecmp ("line", key)) {
+                    // C_GLOG_* 直接传入 __LINE__，CODE_LINE 为字符串
+                    line = (key == fields[i].key) ? (*(const int*) (&(fields[i].value))) : (gint) strtol (fields[i].value, NULL, 10);
+                }
+                break;
+            }
+            case 'M': {
+                if (0 == g_ascii_strcasecmp ("message", key)) {
+                    msg = fields[i].value;
+                    msgLen = fields[i].length;
+                }
+                break;
+            }
+            default: {
+                break;
+            }
         }
-#endif
     }
 
-    C_LOG_RAW(logLevel, C_LOG_TAG, (file ? file : ""), line ? (strtol(line, NULL, 10)) : 0, (func ? func : ""), msg);
+    C_LOG_INIT_IF_NOT_INIT;
+    c_log_write_fields (logLevel, C_LOG_TAG, (file ? file : ""), line, (func ? func : ""), (msg ? msg : "<null>"), (msg ? msgLen : -1));
 
     return G_LOG_WRITER_HANDLED;
 }
@@ -100,7 +124,8 @@ void c_glog_handler(const char *logDomain, GLogLevelFlags level, const char *msg
         }
     }
 
-    C_LOG_RAW(logLevel, C_LOG_TAG, (""), 0, (""), msg);
+    C_LOG_INIT_IF_NOT_INIT;
+    c_log_write_fields (logLevel, C_LOG_TAG, "", 0, "", (msg ? msg : "<null>"), -1);
 }
 #endif
 
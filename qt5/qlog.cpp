@@ -13,62 +13,56 @@
 
 #include "qlog.h"
 
-#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
-void c_qlog_handler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+static CLogLevel c_qlog_level(QtMsgType type)
 {
-    QByteArray localMsg = msg.toLocal8Bit();
-    const char *file = context.file ? context.file : "";
-    const char *function = context.function ? context.function : "";
     switch (type) {
         default:
         case QtDebugMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_DEBUG, C_LOG_TAG, file, context.line, function, msg.toUtf8().constData());
-            break;
+            return C_LOG_LEVEL_DEBUG;
         }
         case QtInfoMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_INFO, C_LOG_TAG, file, context.line, function, msg.toUtf8().constData());
-            break;
+            return C_LOG_LEVEL_INFO;
         }
         case QtWarningMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_WARNING, C_LOG_TAG, file, context.line, function, msg.toUtf8().constData());
-            break;
+            return C_LOG_LEVEL_WARNING;
         }
         case QtCriticalMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_CRIT, C_LOG_TAG, file, context.line, function, msg.toUtf8().constData());
-            break;
+            return C_LOG_LEVEL_CRIT;
         }
         case QtFatalMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_ERROR, C_LOG_TAG, file, context.line, function, msg.toUtf8().constData());
-            break;
+            return C_LOG_LEVEL_ERROR;
         }
     }
 }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+void c_qlog_handler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    const CLogLevel level = c_qlog_level(type);
+    if (!C_LOG_LEVEL_ENABLED(level)) {
+        return;
+    }
+
+    // QString 为 UTF-16，只做一次 UTF-8 转换，不再经过 printf
+    const QByteArray utf8 = msg.toUtf8();
+    const char *file = context.file ? context.file : "";
+    const char *function = context.function ? context.function : "";
+
+    C_LOG_INIT_IF_NOT_INIT;
+    c_log_write_fields(level, C_LOG_TAG, file, context.line, function, utf8.constData(), utf8.size());
+}
 #else
 void c_qlog_handler(QtMsgType type, const QString &msg)
 {
-    switch (type) {
-        default:
-        case QtDebugMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_DEBUG, C_LOG_TAG, "", 0, "", msg.toUtf8().constData());
-            break;
-        }
-        case QtInfoMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_INFO, C_LOG_TAG, "", 0, "", msg.toUtf8().constData());
-            break;
-        }
-        case QtWarningMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_WARNING, C_LOG_TAG, "", 0, "", msg.toUtf8().constData());
-            break;
-        }
-        case QtCriticalMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_CRIT, C_LOG_TAG, "", 0, "", msg.toUtf8().constData());
-            break;
-        }
-        case QtFatalMsg: {
-            C_LOG_RAW(C_LOG_LEVEL_ERROR, C_LOG_TAG, "", 0, "", msg.toUtf8().constData());
-            break;
-        }
+    const CLogLevel level = c_qlog_level(type);
+    if (!C_LOG_LEVEL_ENABLED(level)) {
+        return;
     }
+
+    const QByteArray utf8 = msg.toUtf8();
+
+    C_LOG_INIT_IF_NOT_INIT;
+    c_log_write_fields(level, C_LOG_TAG, "", 0, "", utf8.constData(), utf8.size());
 }
 #endif
 
@@ -0,0 +1,194 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-12-3.
+//
+
+#include <c/clib.h>
+
+#include "c/test.h"
+
+#define N_ELEMENTS      1003            // 不是向量宽度的整数倍，覆盖尾部
+#define N_VALUES        10003           // 超过 8 位计数通道的刷新间隔
+
+static const cuint gsWidths[] = { 1, 2, 4, 8, 12 };
+
+static cuint gsFreed = 0;
+
+static void count_free (C_UNUSED void* data)
+{
+    gsFreed++;
+}
+
+/* 元素 i 的值只有几种，保证有重复 */
+static void fill_value (cuint8* value, cuint w, cuint i)
+{
+    memset (value, 0, w);
+    value[0] = (cuint8) (i % 7);
+    value[w - 1] |= (cuint8) ((i % 3) << 4);
+}
+
+static bool is_odd_first_byte (void* data, C_UNUSED void* udata)
+{
+    return ((cuint8*) data)[0] & 1;
+}
+
+static void test_find_count (cuint w)
+{
+    cuint i, j;
+    cuint8 value[12];
+    cuint8 needle[12];
+    bool ok = true;
+    CArray* array = c_array_new (false, false, w);
+
+    for (i = 0; i < N_VALUES; ++i) {
+        fill_value (value, w, i);
+        c_array_append_vals (array, value, 1);
+    }
+
+    for (j = 0; j < 21 && ok; ++j) {
+        cuint index = 0;
+        cuint expectIndex = N_VALUES;
+        cuint expectCount = 0;
+        fill_value (needle, w, j);
+        for (i = 0; i < N_VALUES; ++i) {
+            if (0 == memcmp (array->data + i * w, needle, w)) {
+                expectIndex = C_MIN (expectIndex, i);
+                expectCount++;
+            }
+        }
+        ok = (c_array_find (array, needle, &index) == (expectIndex < N_VALUES))
+            && (expectIndex == N_VALUES || index == expectIndex)
+            && c_array_count (array, needle) == expectCount;
+    }
+    c_test_true (ok, "find and count, element size %u", w);
+
+    // 只有最后一个元素匹配
+    memset (needle, 0xFF, w);
+    c_array_append_vals (array, needle, 1);
+    cuint index = 0;
+    c_test_true (c_array_find (array, needle, &index) && index == N_VALUES && 1 == c_array_count (array, needle), "match in tail, element size %u", w);
+
+    const cuint len = array->len;
+    cuint expect = 0;
+    for (i = 0; i < len; ++i) {
+        expect += !(array->data[i * w] & 1);
+    }
+    const cuint removed = c_array_remove_if (array, is_odd_first_byte, NULL);
+    ok = (removed == len - expect && array->len == expect);
+    for (i = 0; i < array->len && ok; ++i) {
+        ok = !(array->data[i * w] & 1);
+    }
+    c_test_true (ok, "remove_if, element size %u", w);
+
+    c_array_unref (array);
+}
+
+static cint uint32_compare (void* a, void* b)
+{
+    const cuint32 x = *(cuint32*) a;
+    const cuint32 y = *(cuint32*) b;
+
+    return (x > y) - (x < y);
+}
+
+static void test_search (void)
+{
+    cuint i, n;
+    bool ok = true;
+    CArray* sorted = c_array_new (false, false, sizeof (cuint32));
+
+    for (n = 0; n < 300 && ok; ++n) {
+        c_array_set_size (sorted, 0);
+        for (i = 0; i < n; ++i) {
+            const cuint32 v = (i / 2) * 3;          // 每个值出现两次
+            c_array_append_val (sorted, v);
+        }
+        CArray* eytzinger = c_array_new_eytzinger (sorted);
+        for (i = 0; i < n * 2 + 2 && ok; ++i) {
+            cuint32 target = (cuint32) i;
+            cuint index = 0;
+            cuint eIndex = 0;
+            const bool exist = (0 == target % 3) && target / 3 * 2 < n;
+            ok = (c_array_binary_search (sorted, &target, uint32_compare, &index) == exist)
+                && (!exist || index == target / 3 * 2)
+                && (c_array_eytzinger_search (eytzinger, &target, NULL, &eIndex) == exist)
+                && (!exist || c_array_index (eytzinger, cuint32, eIndex) == target)
+                && (c_array_eytzinger_search (eytzinger, &target, uint32_compare, NULL) == exist);
+        }
+        c_array_unref (eytzinger);
+    }
+    c_test_true (ok, "binary search and eytzinger search, 0 - 299 elements");
+
+    c_array_unref (sorted);
+}
+
+static void test_ptr_array (void)
+{
+    cuint i;
+    cuint index = 0;
+    bool ok = true;
+    CPtrArray* array = c_ptr_array_new_with_free_func (count_free);
+
+    for (i = 0; i < N_ELEMENTS; ++i) {
+        c_ptr_array_add (array, C_UINT_TO_POINTER (i % 5 + 1));
+    }
+    c_test_true (c_ptr_array_find (array, C_UINT_TO_POINTER (3), &index) && 2 == index, "ptr find");
+    c_test_true (!c_ptr_array_find (array, C_UINT_TO_POINTER (9), &index), "ptr find missing");
+    c_test_true (201 == c_ptr_array_count (array, C_UINT_TO_POINTER (1)) && 200 == c_ptr_array_count (array, C_UINT_TO_POINTER (5)), "ptr count");
+
+    c_test_true (c_ptr_array_remove (array, C_UINT_TO_POINTER (1)) && 1 == gsFreed && C_POINTER_TO_UINT (array->pdata[0]) == 2, "ptr remove");
+
+    c_test_true (200 == c_ptr_array_remove_all (array, C_UINT_TO_POINTER (1)) && 201 == gsFreed, "ptr remove_all");
+    for (i = 0; i < array->len && ok; ++i) {
+        ok = C_POINTER_TO_UINT (array->pdata[i]) == i % 4 + 2;
+    }
+    c_test_true (ok && 802 == array->len, "ptr remove_all keeps order");
+
+    c_ptr_array_unref (array);
+}
+
+static bool is_odd (void* data, C_UNUSED void* udata)
+{
+    return C_POINTER_TO_UINT (data) & 1;
+}
+
+static void test_ptr_remove_if (void)
+{
+    cuint i;
+    bool ok = true;
+    CPtrArray* array = c_ptr_array_new_null_terminated (0, count_free, true);
+
+    gsFreed = 0;
+    for (i = 1; i <= N_ELEMENTS; ++i) {
+        c_ptr_array_add (array, C_UINT_TO_POINTER (i));
+    }
+    c_test_true (502 == c_ptr_array_remove_if (array, is_odd, NULL) && 502 == gsFreed && 501 == array->len, "ptr remove_if");
+    for (i = 0; i < array->len && ok; ++i) {
+        ok = C_POINTER_TO_UINT (array->pdata[i]) == (i + 1) * 2;
+    }
+    c_test_true (ok && NULL == array->pdata[array->len], "ptr remove_if keeps order and null terminator");
+
+    c_ptr_array_unref (array);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    cuint i;
+
+    for (i = 0; i < C_N_ELEMENTS (gsWidths); ++i) {
+        test_find_count (gsWidths[i]);
+    }
+    test_search ();
+    test_ptr_array ();
+    test_ptr_remove_if ();
+
+    return c_test_result ();
+}
@@ -0,0 +1,177 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-12-1.
+//
+
+#include <c/clib.h>
+
+#include <unistd.h>
+
+#include "c/test.h"
+
+#define N_THREADS       3
+#define N_ITEMS         100000
+#define N_OVERFLOW      3000
+
+typedef struct
+{
+    void*           queue;
+    void            (*push) (void* queue, void* data);
+    void*           (*pop)  (void* queue);
+} Pipe;
+
+static cuint gsFreed = 0;
+
+static void mpmc_push (void* queue, void* data)         { c_mpmc_queue_push (queue, data); }
+static void* mpmc_pop (void* queue)                     { return c_mpmc_queue_pop (queue); }
+static void spsc_push (void* queue, void* data)         { c_spsc_ring_push (queue, data); }
+static void* spsc_pop (void* queue)                     { return c_spsc_ring_pop (queue); }
+static void async_push (void* queue, void* data)        { c_async_queue_push (queue, data); }
+static void* async_pop (void* queue)                    { return c_async_queue_pop (queue); }
+
+static void count_free (C_UNUSED void* data)
+{
+    gsFreed++;
+}
+
+static void* producer (void* data)
+{
+    cuint i;
+    Pipe* p = data;
+
+    for (i = 1; i <= N_ITEMS; ++i) {
+        p->push (p->queue, C_UINT_TO_POINTER (i));
+    }
+
+    return NULL;
+}
+
+/* 每个消费者取 N_ITEMS 个元素，返回元素之和 */
+static void* consumer (void* data)
+{
+    cuint i;
+    Pipe* p = data;
+    cuint64 sum = 0;
+
+    for (i = 0; i < N_ITEMS; ++i) {
+        sum += C_POINTER_TO_UINT (p->pop (p->queue));
+    }
+
+    return c_memdup (&sum, sizeof (sum));
+}
+
+static bool run_pipe (Pipe* p, cuint nThreads)
+{
+    cuint i;
+    cuint64 sum = 0;
+    CThread* producers[N_THREADS];
+    CThread* consumers[N_THREADS];
+
+    for (i = 0; i < nThreads; ++i) {
+        consumers[i] = c_thread_new ("consumer", consumer, p);
+        producers[i] = c_thread_new ("producer", producer, p);
+    }
+    for (i = 0; i < nThreads; ++i) {
+        c_thread_join (producers[i]);
+        cuint64* s = c_thread_join (consumers[i]);
+        sum += *s;
+        c_free (s);
+    }
+
+    return sum == (cuint64) nThreads * N_ITEMS * (N_ITEMS + 1) / 2;
+}
+
+static void test_mpmc_queue (void)
+{
+    cuint i;
+    void* data = NULL;
+    CMpmcQueue* queue = c_mpmc_queue_new (5);
+
+    c_test_true (c_mpmc_queue_get_capacity (queue) == 8, "capacity rounded up to power of two");
+    for (i = 1; c_mpmc_queue_try_push (queue, C_UINT_TO_POINTER (i)); ++i);
+    c_test_true (i == 9 && c_mpmc_queue_get_length (queue) == 8, "try_push fails when full");
+    for (i = 1; c_mpmc_queue_try_pop (queue, &data) && C_POINTER_TO_UINT (data) == i; ++i);
+    c_test_true (i == 9 && c_mpmc_queue_get_length (queue) == 0, "try_pop in order until empty");
+
+    Pipe p = { queue, mpmc_push, mpmc_pop };
+    c_test_true (run_pipe (&p, N_THREADS), "mpmc: %d producers and %d consumers", N_THREADS, N_THREADS);
+    c_mpmc_queue_free (queue);
+}
+
+static void test_spsc_ring (void)
+{
+    cuint i;
+    void* data = NULL;
+    CSpscRing* ring = c_spsc_ring_new (4);
+
+    for (i = 1; c_spsc_ring_try_push (ring, C_UINT_TO_POINTER (i)); ++i);
+    c_test_true (i == 5 && c_spsc_ring_get_length (ring) == 4, "try_push fails when full");
+    for (i = 1; c_spsc_ring_try_pop (ring, &data) && C_POINTER_TO_UINT (data) == i; ++i);
+    c_test_true (i == 5 && c_spsc_ring_get_length (ring) == 0, "try_pop in order until empty");
+
+    Pipe p = { ring, spsc_push, spsc_pop };
+    c_test_true (run_pipe (&p, 1), "spsc: 1 producer and 1 consumer");
+    c_spsc_ring_free (ring);
+}
+
+static void* delayed_push (void* data)
+{
+    usleep (20 * 1000);
+    c_async_queue_push (data, C_UINT_TO_POINTER (42));
+
+    return NULL;
+}
+
+static void test_async_queue (void)
+{
+    cuint i;
+    CAsyncQueue* queue = c_async_queue_new_full (count_free);
+
+    // 超出内部 ring 的元素进入溢出队列，仍按顺序取出
+    for (i = 1; i <= N_OVERFLOW; ++i) {
+        c_async_queue_push (queue, C_UINT_TO_POINTER (i));
+    }
+    c_test_true (c_async_queue_length (queue) == N_OVERFLOW, "length with overflow");
+    for (i = 1; i <= N_OVERFLOW && C_POINTER_TO_UINT (c_async_queue_try_pop (queue)) == i; ++i);
+    c_test_true (i == N_OVERFLOW + 1 && NULL == c_async_queue_try_pop (queue), "fifo across overflow");
+
+    const cint64 start = c_get_monotonic_time ();
+    c_test_true (NULL == c_async_queue_timeout_pop (queue, 50 * 1000) && c_get_monotonic_time () - start >= 50 * 1000, "timeout_pop returns NULL after timeout");
+
+    CThread* thread = c_thread_new ("push", delayed_push, queue);
+    c_test_true (C_POINTER_TO_UINT (c_async_queue_pop (queue)) == 42, "pop wakes up on push");
+    c_thread_join (thread);
+
+    thread = c_thread_new ("push", delayed_push, queue);
+    c_test_true (C_POINTER_TO_UINT (c_async_queue_timeout_pop (queue, 5 * 1000 * 1000)) == 42, "timeout_pop wakes up on push");
+    c_thread_join (thread);
+
+    Pipe p = { queue, async_push, async_pop };
+    c_test_true (run_pipe (&p, N_THREADS), "async queue: %d producers and %d consumers", N_THREADS, N_THREADS);
+
+    for (i = 1; i <= N_OVERFLOW; ++i) {
+        c_async_queue_push (queue, C_UINT_TO_POINTER (i));
+    }
+    c_async_queue_ref (queue);
+    c_async_queue_unref (queue);
+    c_test_true (0 == gsFreed, "ref keeps items alive");
+    c_async_queue_unref (queue);
+    c_test_true (N_OVERFLOW == gsFreed, "unref frees remaining items");
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    test_mpmc_queue ();
+    test_spsc_ring ();
+    test_async_queue ();
+
+    return c_test_result ();
+}
@@ -0,0 +1,236 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-28.
+//
+
+#include <c/clib.h>
+
+#include "c/test.h"
+
+#define N_KEYS          50000
+#define N_OPS           1000000
+
+static bool gsPresent[N_KEYS];
+static cuint gsValues[N_KEYS];
+static cuint gsDestroyed = 0;
+
+static cint uint_compare (void* a, void* b)
+{
+    const cuint x = C_POINTER_TO_UINT (a);
+    const cuint y = C_POINTER_TO_UINT (b);
+
+    return (x > y) - (x < y);
+}
+
+static cint uint_compare_data (void* a, void* b, C_UNUSED void* udata)
+{
+    return uint_compare (a, b);
+}
+
+static void value_destroy (C_UNUSED void* value)
+{
+    gsDestroyed++;
+}
+
+static void sum_keys (void* key, C_UNUSED void* value, void* udata)
+{
+    *(cuint64*) udata += C_POINTER_TO_UINT (key);
+}
+
+/* 随机插入/删除/查找，与数组对照，再检查顺序遍历与范围查询 */
+static void test_random (void)
+{
+    cint i;
+    cuint bad = 0;
+    cuint count = 0;
+    cuint32 seed = 1;
+    CBTree* tree = c_btree_new (uint_compare);
+
+    for (i = 0; i < N_OPS; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const cuint key = (seed >> 8) % N_KEYS;
+        switch ((seed >> 3) % 4) {
+            case 0:
+            case 1: {
+                gsValues[key]++;
+                if (c_btree_insert (tree, C_UINT_TO_POINTER (key), C_UINT_TO_POINTER (gsValues[key])) == gsPresent[key]) {
+                    bad++;
+                }
+                if (!gsPresent[key]) {
+                    count++;
+                }
+                gsPresent[key] = true;
+                break;
+            }
+            case 2: {
+                if (c_btree_remove (tree, C_UINT_TO_POINTER (key)) != gsPresent[key]) {
+                    bad++;
+                }
+                if (gsPresent[key]) {
+                    count--;
+                }
+                gsPresent[key] = false;
+                break;
+            }
+            default: {
+                void* value = NULL;
+                const bool found = c_btree_lookup_extended (tree, C_UINT_TO_POINTER (key), NULL, &value);
+                if (found != gsPresent[key] || (found && C_POINTER_TO_UINT (value) != gsValues[key])) {
+                    bad++;
+                }
+                break;
+            }
+        }
+    }
+    c_test_true (0 == bad && c_btree_nnodes (tree) == count, "random operations (%u entries)", count);
+    c_test_true (c_btree_height (tree) >= 2 && c_btree_height (tree) <= 4, "height %u", c_btree_height (tree));
+
+    void* key = NULL;
+    void* value = NULL;
+    CBTreeIter iter;
+    cuint n = 0;
+    cint last = -1;
+    bad = 0;
+    c_btree_iter_init (&iter, tree);
+    while (c_btree_iter_next (&iter, &key, &value)) {
+        const cuint k = C_POINTER_TO_UINT (key);
+        if ((cint) k <= last || !gsPresent[k] || C_POINTER_TO_UINT (value) != gsValues[k]) {
+            bad++;
+        }
+        last = (cint) k;
+        n++;
+    }
+    c_test_true (0 == bad && n == count, "ordered iteration (%u entries)", n);
+
+    n = 0;
+    bad = 0;
+    last = N_KEYS;
+    c_btree_iter_init_last (&iter, tree);
+    while (c_btree_iter_prev (&iter, &key, NULL)) {
+        if ((cint) C_POINTER_TO_UINT (key) >= last) {
+            bad++;
+        }
+        last = (cint) C_POINTER_TO_UINT (key);
+        n++;
+    }
+    c_test_true (0 == bad && n == count, "reverse iteration");
+
+    bad = 0;
+    for (i = 0; i < N_KEYS; i += 7) {
+        cint lower = i;
+        cint upper = i + 1;
+        while (lower < N_KEYS && !gsPresent[lower]) {
+            lower++;
+        }
+        while (upper < N_KEYS && !gsPresent[upper]) {
+            upper++;
+        }
+        c_btree_iter_init_lower_bound (&iter, tree, C_UINT_TO_POINTER (i));
+        if (c_btree_iter_next (&iter, &key, NULL) ? (cint) C_POINTER_TO_UINT (key) != lower : lower != N_KEYS) {
+            bad++;
+        }
+        c_btree_iter_init_upper_bound (&iter, tree, C_UINT_TO_POINTER (i));
+        if (c_btree_iter_next (&iter, &key, NULL) ? (cint) C_POINTER_TO_UINT (key) != upper : upper != N_KEYS) {
+            bad++;
+        }
+    }
+    c_test_true (0 == bad, "lower_bound/upper_bound");
+
+    cuint64 sum = 0;
+    cuint64 expected = 0;
+    c_btree_foreach (tree, sum_keys, &sum);
+    for (i = 0; i < N_KEYS; ++i) {
+        expected += gsPresent[i] ? (cuint64) i : 0;
+    }
+    c_test_true (sum == expected, "foreach");
+
+    for (i = 0; i < N_KEYS; ++i) {
+        c_btree_remove (tree, C_UINT_TO_POINTER (i));
+    }
+    c_btree_iter_init (&iter, tree);
+    c_test_true (0 == c_btree_nnodes (tree) && 0 == c_btree_height (tree) && !c_btree_iter_next (&iter, NULL, NULL), "remove everything");
+
+    c_btree_unref (tree);
+}
+
+static void test_sorted_array (void)
+{
+    cuint i;
+    cuint bad = 0;
+    CArray* entries = c_array_new (false, false, sizeof (CBTreeEntry));
+
+    for (i = 0; i < N_KEYS; ++i) {
+        const CBTreeEntry e = { C_UINT_TO_POINTER (i * 2), C_UINT_TO_POINTER (i) };
+        c_array_append_val (entries, e);
+    }
+
+    gsDestroyed = 0;
+    CBTree* tree = c_btree_new_from_sorted_array (entries, uint_compare_data, NULL, NULL, value_destroy);
+    for (i = 0; i < N_KEYS * 2; ++i) {
+        void* value = NULL;
+        const bool found = c_btree_lookup_extended (tree, C_UINT_TO_POINTER (i), NULL, &value);
+        if (found != (0 == i % 2) || (found && C_POINTER_TO_UINT (value) != i / 2)) {
+            bad++;
+        }
+    }
+    c_test_true (0 == bad && c_btree_nnodes (tree) == N_KEYS, "bulk build from sorted array");
+
+    // 建好的树可以继续插入/删除
+    for (i = 1; i < N_KEYS * 2; i += 2) {
+        c_btree_insert (tree, C_UINT_TO_POINTER (i), NULL);
+    }
+    for (i = 0; i < N_KEYS * 2; i += 4) {
+        c_btree_remove (tree, C_UINT_TO_POINTER (i));
+    }
+    bad = 0;
+    for (i = 0; i < N_KEYS * 2; ++i) {
+        if (c_btree_contains (tree, C_UINT_TO_POINTER (i)) != (0 != i % 4)) {
+            bad++;
+        }
+    }
+    c_test_true (0 == bad && gsDestroyed == N_KEYS / 2, "modify bulk built tree");
+
+    c_btree_destroy (tree);
+    c_test_true (gsDestroyed == N_KEYS * 2, "destroy notifies remaining values");
+
+    // 乱序输入退化为逐个插入
+    c_array_index (entries, CBTreeEntry, 10).key = C_UINT_TO_POINTER (0);
+    tree = c_btree_new_from_sorted_array (entries, uint_compare_data, NULL, NULL, NULL);
+    c_test_true (c_btree_nnodes (tree) == N_KEYS - 1 && c_btree_lookup (tree, C_UINT_TO_POINTER (0)) == C_UINT_TO_POINTER (10), "unsorted array falls back to insert");
+    c_btree_unref (tree);
+
+    c_array_unref (entries);
+}
+
+static void test_replace (void)
+{
+    void* key = NULL;
+    void* value = NULL;
+    CBTree* tree = c_btree_new_full (uint_compare_data, NULL, NULL, value_destroy);
+
+    gsDestroyed = 0;
+    c_test_true (c_btree_insert (tree, C_UINT_TO_POINTER (1), C_UINT_TO_POINTER (10)), "insert new key");
+    c_test_true (!c_btree_replace (tree, C_UINT_TO_POINTER (1), C_UINT_TO_POINTER (11)) && 1 == gsDestroyed, "replace existing key");
+    c_test_true (c_btree_steal_extended (tree, C_UINT_TO_POINTER (1), &key, &value)
+                 && C_POINTER_TO_UINT (value) == 11 && 1 == gsDestroyed && 0 == c_btree_nnodes (tree), "steal does not notify");
+    c_test_true (!c_btree_steal (tree, C_UINT_TO_POINTER (1)) && NULL == c_btree_lookup (tree, C_UINT_TO_POINTER (1)), "lookup in empty tree");
+
+    c_btree_unref (tree);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    test_random ();
+    test_sorted_array ();
+    test_replace ();
+
+    return c_test_result ();
+}
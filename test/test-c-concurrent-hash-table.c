@@ -0,0 +1,204 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-12-16.
+//
+
+#include <c/clib.h>
+
+#include "c/test.h"
+
+#define N_NODES         10000
+#define N_KEYS          1000                    /* 多线程共享的 key 个数 */
+#define N_WRITERS       4
+#define N_READERS       2
+#define N_ROUNDS        50
+
+typedef struct
+{
+    CConcurrentHashTable*   table;
+    cuint                   id;
+    cuint                   inserted;           /* insert_if_absent 成功的次数 */
+    cuint                   bad;
+} Worker;
+
+static bool gsDone = false;                     /* 写线程全部结束 */
+
+static bool add_one (C_UNUSED const void* key, void** value, C_UNUSED bool exists, C_UNUSED void* udata)
+{
+    *value = C_UINT_TO_POINTER (C_POINTER_TO_UINT (*value) + 1);
+
+    return true;
+}
+
+static bool drop_even (const void* key, void** value, C_UNUSED bool exists, C_UNUSED void* udata)
+{
+    // 偶数 key 删除，奇数 key 的 value 翻倍
+    if (0 == (C_POINTER_TO_UINT (key) & 1)) {
+        return false;
+    }
+    *value = C_UINT_TO_POINTER (C_POINTER_TO_UINT (*value) * 2);
+
+    return true;
+}
+
+static void test_single_thread (cuint shards)
+{
+    cuint i;
+    cuint bad = 0;
+    void* existing = NULL;
+
+    CConcurrentHashTable* table = c_concurrent_hash_table_new (c_direct_hash, c_direct_equal, shards);
+
+    for (i = 1; i <= N_NODES; ++i) {
+        bad += !c_concurrent_hash_table_insert (table, C_UINT_TO_POINTER (i), C_UINT_TO_POINTER (i * 3));
+    }
+    c_test_true (0 == bad && c_concurrent_hash_table_size (table) == N_NODES, "shards %u: insert", shards);
+
+    for (i = 1, bad = 0; i <= N_NODES; ++i) {
+        bad += (c_concurrent_hash_table_lookup (table, C_UINT_TO_POINTER (i)) != C_UINT_TO_POINTER (i * 3));
+    }
+    bad += c_concurrent_hash_table_contains (table, C_UINT_TO_POINTER (N_NODES + 1));
+    c_test_true (0 == bad, "shards %u: lookup", shards);
+
+    // key 已存在时 insert 只替换 value
+    c_test_true (!c_concurrent_hash_table_insert (table, C_UINT_TO_POINTER (1), C_UINT_TO_POINTER (7))
+        && c_concurrent_hash_table_lookup (table, C_UINT_TO_POINTER (1)) == C_UINT_TO_POINTER (7), "shards %u: insert existing", shards);
+
+    c_test_true (!c_concurrent_hash_table_insert_if_absent (table, C_UINT_TO_POINTER (2), C_UINT_TO_POINTER (9), &existing)
+        && existing == C_UINT_TO_POINTER (6) && c_concurrent_hash_table_lookup (table, C_UINT_TO_POINTER (2)) == C_UINT_TO_POINTER (6),
+        "shards %u: insert_if_absent existing", shards);
+    c_test_true (c_concurrent_hash_table_insert_if_absent (table, C_UINT_TO_POINTER (N_NODES + 1), C_UINT_TO_POINTER (9), &existing)
+        && c_concurrent_hash_table_lookup (table, C_UINT_TO_POINTER (N_NODES + 1)) == C_UINT_TO_POINTER (9),
+        "shards %u: insert_if_absent new", shards);
+
+    // compute 不存在时插入、存在时修改、返回 false 时删除
+    c_test_true (c_concurrent_hash_table_compute (table, C_UINT_TO_POINTER (N_NODES + 2), add_one, NULL)
+        && c_concurrent_hash_table_lookup (table, C_UINT_TO_POINTER (N_NODES + 2)) == C_UINT_TO_POINTER (1), "shards %u: compute insert", shards);
+    for (i = 1; i <= 100; ++i) {
+        c_concurrent_hash_table_compute (table, C_UINT_TO_POINTER (i), drop_even, NULL);
+    }
+    for (i = 1, bad = 0; i <= 100; ++i) {
+        void* expect = (i & 1) ? C_UINT_TO_POINTER (((1 == i) ? 7 : i * 3) * 2) : NULL;
+        bad += (c_concurrent_hash_table_lookup (table, C_UINT_TO_POINTER (i)) != expect);
+    }
+    c_test_true (0 == bad && c_concurrent_hash_table_size (table) == N_NODES + 2 - 50, "shards %u: compute update/remove", shards);
+
+    for (i = 101, bad = 0; i <= N_NODES; ++i) {
+        bad += !c_concurrent_hash_table_remove (table, C_UINT_TO_POINTER (i));
+    }
+    bad += c_concurrent_hash_table_remove (table, C_UINT_TO_POINTER (102));
+    c_test_true (0 == bad && c_concurrent_hash_table_size (table) == 52, "shards %u: remove", shards);
+
+    c_concurrent_hash_table_remove_all (table);
+    c_test_true (0 == c_concurrent_hash_table_size (table), "shards %u: remove_all", shards);
+
+    c_concurrent_hash_table_destroy (table);
+}
+
+static void* writer (void* data)
+{
+    cuint i, r;
+    Worker* w = data;
+    const cuint base = N_KEYS * (w->id + 2) + 1;
+
+    for (r = 0; r < N_ROUNDS; ++r) {
+        for (i = 1; i <= N_KEYS; ++i) {
+            // 共享 key 计数，同时争抢第二段 key 的首次插入
+            c_concurrent_hash_table_compute (w->table, C_UINT_TO_POINTER (i), add_one, NULL);
+            w->inserted += c_concurrent_hash_table_insert_if_absent (w->table, C_UINT_TO_POINTER (N_KEYS + i), C_UINT_TO_POINTER (w->id + 1), NULL);
+        }
+        // 独占的 key 段反复插入删除，制造扩容与收缩
+        for (i = 0; i < N_KEYS; ++i) {
+            c_concurrent_hash_table_insert (w->table, C_UINT_TO_POINTER (base + i), C_UINT_TO_POINTER (i));
+        }
+        for (i = 0; i < N_KEYS; ++i) {
+            w->bad += !c_concurrent_hash_table_remove (w->table, C_UINT_TO_POINTER (base + i));
+        }
+    }
+
+    return NULL;
+}
+
+static void* reader (void* data)
+{
+    cuint i;
+    Worker* w = data;
+    cuint* last = c_malloc0 (sizeof (cuint) * (N_KEYS + 1));
+
+    // 计数只增不减且不超过最终值
+    while (!__atomic_load_n (&gsDone, __ATOMIC_ACQUIRE)) {
+        for (i = 1; i <= N_KEYS; ++i) {
+            const cuint v = C_POINTER_TO_UINT (c_concurrent_hash_table_lookup (w->table, C_UINT_TO_POINTER (i)));
+            w->bad += (v < last[i] || v > N_WRITERS * N_ROUNDS);
+            last[i] = v;
+
+            const cuint owner = C_POINTER_TO_UINT (c_concurrent_hash_table_lookup (w->table, C_UINT_TO_POINTER (N_KEYS + i)));
+            w->bad += (owner > N_WRITERS);
+        }
+    }
+    c_free (last);
+
+    return NULL;
+}
+
+static void test_multi_thread (cuint shards)
+{
+    cuint i;
+    cuint bad = 0;
+    cuint inserted = 0;
+    CThread* writers[N_WRITERS];
+    CThread* readers[N_READERS];
+    Worker ws[N_WRITERS];
+    Worker rs[N_READERS];
+
+    CConcurrentHashTable* table = c_concurrent_hash_table_new (c_direct_hash, c_direct_equal, shards);
+
+    __atomic_store_n (&gsDone, false, __ATOMIC_RELAXED);
+    for (i = 0; i < N_READERS; ++i) {
+        rs[i] = (Worker) { .table = table, .id = i };
+        readers[i] = c_thread_new ("reader", reader, &rs[i]);
+    }
+    for (i = 0; i < N_WRITERS; ++i) {
+        ws[i] = (Worker) { .table = table, .id = i };
+        writers[i] = c_thread_new ("writer", writer, &ws[i]);
+    }
+    for (i = 0; i < N_WRITERS; ++i) {
+        c_thread_join (writers[i]);
+        inserted += ws[i].inserted;
+        bad += ws[i].bad;
+    }
+    __atomic_store_n (&gsDone, true, __ATOMIC_RELEASE);
+    for (i = 0; i < N_READERS; ++i) {
+        c_thread_join (readers[i]);
+        bad += rs[i].bad;
+    }
+
+    c_test_true (0 == bad, "shards %u: concurrent readers and writers", shards);
+    c_test_true (N_KEYS == inserted, "shards %u: insert_if_absent has one winner per key", shards);
+    c_test_true (2 * N_KEYS == c_concurrent_hash_table_size (table), "shards %u: final size", shards);
+
+    for (i = 1, bad = 0; i <= N_KEYS; ++i) {
+        bad += (c_concurrent_hash_table_lookup (table, C_UINT_TO_POINTER (i)) != C_UINT_TO_POINTER (N_WRITERS * N_ROUNDS));
+        bad += (NULL == c_concurrent_hash_table_lookup (table, C_UINT_TO_POINTER (N_KEYS + i)));
+    }
+    c_test_true (0 == bad, "shards %u: final values", shards);
+
+    c_concurrent_hash_table_destroy (table);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    test_single_thread (1);
+    test_single_thread (0);
+    test_multi_thread (1);
+    test_multi_thread (0);
+
+    return c_test_result ();
+}
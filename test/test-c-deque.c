@@ -0,0 +1,167 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-30.
+//
+
+#include <c/clib.h>
+
+#include "c/test.h"
+
+#define N_OPS           60000
+
+static cint uint_compare (void* a, void* b, C_UNUSED void* udata)
+{
+    const cuint x = C_POINTER_TO_UINT (a);
+    const cuint y = C_POINTER_TO_UINT (b);
+
+    return (x > y) - (x < y);
+}
+
+static cint uint_equal (void* a, void* b)
+{
+    return a != b;
+}
+
+static bool same_as_queue (CDeque* deque, CQueue* queue)
+{
+    cuint i = 0;
+    CList* l = NULL;
+
+    if (c_deque_get_length (deque) != c_queue_get_length (queue)) {
+        return false;
+    }
+
+    for (l = queue->head; l; l = l->next, ++i) {
+        if (c_deque_peek_nth (deque, i) != l->data) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* 随机操作，与 CQueue 的结果对照 */
+static void test_against_queue (void)
+{
+    cint i;
+    cuint bad = 0;
+    cuint32 seed = 1;
+    CQueue queue = C_QUEUE_INIT;
+    CDeque deque = C_DEQUE_INIT;
+
+    for (i = 0; i < N_OPS; ++i) {
+        seed = seed * 1103515245 + 12345;
+        void* data = C_UINT_TO_POINTER ((seed >> 8) % 1000 + 1);
+        const cuint len = c_queue_get_length (&queue);
+        const cuint n = len ? (seed >> 4) % len : 0;
+        switch ((seed >> 16) % 10) {
+            case 0:
+            case 1: {
+                c_queue_push_tail (&queue, data);
+                c_deque_push_tail (&deque, data);
+                break;
+            }
+            case 2:
+            case 3: {
+                c_queue_push_head (&queue, data);
+                c_deque_push_head (&deque, data);
+                break;
+            }
+            case 4: {
+                c_queue_push_nth (&queue, data, (cint) n);
+                c_deque_push_nth (&deque, data, (cint) n);
+                break;
+            }
+            case 5: {
+                bad += (c_queue_pop_head (&queue) != c_deque_pop_head (&deque));
+                break;
+            }
+            case 6: {
+                bad += (c_queue_pop_tail (&queue) != c_deque_pop_tail (&deque));
+                break;
+            }
+            case 7: {
+                bad += (c_queue_pop_nth (&queue, n) != c_deque_pop_nth (&deque, n));
+                break;
+            }
+            case 8: {
+                bad += (c_queue_remove (&queue, data) != c_deque_remove (&deque, data));
+                break;
+            }
+            default: {
+                bad += (c_queue_peek_nth (&queue, n) != c_deque_peek_nth (&deque, n));
+                bad += (c_queue_index (&queue, data) != c_deque_index (&deque, data));
+                break;
+            }
+        }
+        if (0 == i % 1000 && !same_as_queue (&deque, &queue)) {
+            bad++;
+        }
+    }
+    c_test_true (0 == bad && same_as_queue (&deque, &queue), "random operations match CQueue (%u elements)", c_deque_get_length (&deque));
+
+    c_queue_reverse (&queue);
+    c_deque_reverse (&deque);
+    c_test_true (same_as_queue (&deque, &queue), "reverse");
+
+    c_queue_sort (&queue, uint_compare, NULL);
+    c_deque_sort (&deque, uint_compare, NULL);
+    c_test_true (same_as_queue (&deque, &queue), "sort");
+
+    CDeque* copy = c_deque_copy (&deque);
+    c_test_true (same_as_queue (copy, &queue), "copy");
+    c_deque_free (copy);
+
+    void* data = c_deque_peek_nth (&deque, c_deque_get_length (&deque) / 2);
+    c_test_true (c_queue_remove_all (&queue, data) == c_deque_remove_all (&deque, data) && same_as_queue (&deque, &queue), "remove_all");
+    c_test_true (c_deque_find_custom (&deque, c_deque_peek_tail (&deque), uint_equal) == c_deque_index (&deque, c_deque_peek_tail (&deque)), "find_custom");
+
+    c_queue_clear (&queue);
+    c_deque_clear (&deque);
+    c_test_true (c_deque_is_empty (&deque) && NULL == c_deque_pop_head (&deque) && NULL == c_deque_peek_tail (&deque), "clear");
+}
+
+/* 头尾交替进出时在环形数组中回绕，扩容后顺序保持不变 */
+static void test_wrap_around (void)
+{
+    cuint i;
+    cuint bad = 0;
+    CDeque* deque = c_deque_sized_new (16);
+
+    for (i = 0; i < 12; ++i) {
+        c_deque_push_tail (deque, C_UINT_TO_POINTER (i));
+    }
+    for (i = 0; i < 10; ++i) {
+        c_deque_pop_head (deque);
+    }
+    for (i = 12; i < 1000; ++i) {
+        c_deque_push_tail (deque, C_UINT_TO_POINTER (i));
+    }
+    for (i = 0; i < c_deque_get_length (deque); ++i) {
+        if (C_POINTER_TO_UINT (c_deque_peek_nth (deque, i)) != i + 10) {
+            bad++;
+        }
+    }
+    c_test_true (0 == bad && c_deque_get_length (deque) == 990, "wrap around and grow");
+
+    c_test_true (C_POINTER_TO_UINT (c_deque_set_nth (deque, 5, C_UINT_TO_POINTER (1))) == 15
+                 && C_POINTER_TO_UINT (c_deque_peek_nth (deque, 5)) == 1 && NULL == c_deque_peek_nth (deque, 990), "indexed access");
+
+    c_deque_free (deque);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    test_against_queue ();
+    test_wrap_around ();
+
+    return c_test_result ();
+}
@@ -0,0 +1,157 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-26.
+//
+
+#include <c/clib.h>
+
+#include "c/test.h"
+
+#define N_KEYS          50000
+#define N_OPS           1000000
+
+typedef struct
+{
+    cint        x;
+    cint        y;
+} Point;
+
+static inline cuint point_hash (Point p)
+{
+    return (cuint) c_hash_map_mix64 (((cuint64) (cuint) p.x << 32) | (cuint) p.y);
+}
+
+static inline bool point_equal (Point a, Point b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+C_DEFINE_HASH_MAP (IntMap, int_map, cint, cint64, c_hash_map_int_hash, c_hash_map_int_equal)
+C_DEFINE_HASH_MAP (PointMap, point_map, Point, cuint, point_hash, point_equal)
+
+static cint64 gsValues[N_KEYS];
+static bool gsPresent[N_KEYS];
+
+/* 随机插入/删除/查找，与数组对照 */
+static void test_int_map (void)
+{
+    cint i;
+    cuint bad = 0;
+    cuint count = 0;
+    cuint32 seed = 1;
+    IntMap map = {0};
+
+    for (i = 0; i < N_OPS; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const cint key = (cint) ((seed >> 8) % N_KEYS) - N_KEYS / 2;
+        const cint idx = key + N_KEYS / 2;
+        switch ((seed >> 3) % 4) {
+            case 0:
+            case 1: {
+                gsValues[idx]++;
+                if (int_map_insert (&map, key, gsValues[idx]) == gsPresent[idx]) {
+                    bad++;
+                }
+                if (!gsPresent[idx]) {
+                    count++;
+                }
+                gsPresent[idx] = true;
+                break;
+            }
+            case 2: {
+                cint64 value = 0;
+                const bool removed = int_map_remove (&map, key, &value);
+                if (removed != gsPresent[idx] || (removed && value != gsValues[idx])) {
+                    bad++;
+                }
+                if (gsPresent[idx]) {
+                    count--;
+                }
+                gsPresent[idx] = false;
+                break;
+            }
+            default: {
+                const cint64* value = int_map_lookup (&map, key);
+                if ((NULL != value) != gsPresent[idx] || (value && *value != gsValues[idx])) {
+                    bad++;
+                }
+                break;
+            }
+        }
+    }
+    c_test_true (0 == bad && int_map_size (&map) == count, "int map: random operations (%u entries)", count);
+
+    cint key = 0;
+    cint64 value = 0;
+    cuint index = 0;
+    cuint n = 0;
+    bad = 0;
+    while (int_map_next (&map, &index, &key, &value)) {
+        n++;
+        if (!gsPresent[key + N_KEYS / 2] || value != gsValues[key + N_KEYS / 2]) {
+            bad++;
+        }
+    }
+    c_test_true (0 == bad && n == count, "int map: iterate %u entries", n);
+
+    int_map_remove_all (&map);
+    c_test_true (0 == int_map_size (&map) && !int_map_contains (&map, 0), "int map: remove_all");
+
+    int_map_reserve (&map, N_KEYS);
+    const cuint size = map.size;
+    for (i = 0; i < N_KEYS; ++i) {
+        int_map_insert (&map, i, i);
+    }
+    for (i = 0; i < N_KEYS; ++i) {
+        int_map_remove (&map, i, NULL);
+    }
+    c_test_true (map.size == size, "int map: reserve keeps capacity (%u)", size);
+
+    int_map_clear (&map);
+    c_test_true (NULL == map.ctrl && NULL == int_map_lookup (&map, 1) && !int_map_remove (&map, 1, NULL), "int map: clear");
+}
+
+static void test_point_map (void)
+{
+    cint x, y;
+    cuint bad = 0;
+    PointMap map;
+
+    point_map_init (&map);
+    for (x = 0; x < 200; ++x) {
+        for (y = 0; y < 200; ++y) {
+            const Point p = {x, y};
+            point_map_insert (&map, p, (cuint) (x * 1000 + y));
+        }
+    }
+
+    for (x = 0; x < 200; ++x) {
+        for (y = 0; y < 200; ++y) {
+            const Point p = {x, y};
+            const Point q = {y + 200, x};
+            const cuint* value = point_map_lookup (&map, p);
+            if (NULL == value || *value != (cuint) (x * 1000 + y) || point_map_contains (&map, q)) {
+                bad++;
+            }
+        }
+    }
+    c_test_true (0 == bad && point_map_size (&map) == 200 * 200, "point map: struct keys");
+
+    point_map_clear (&map);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    test_int_map ();
+    test_point_map ();
+
+    return c_test_result ();
+}
@@ -0,0 +1,475 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-22.
+//
+
+#include <c/clib.h>
+
+#include "c/test.h"
+
+#define N_NODES         100000
+#define N_COLLIDE       24                      /* flat 表测试中探测起点相同的元素个数，超过一组 */
+#define BIG_BASE        ((cuintptr) 1 << 40)    /* 高 32 位非 0，只用作 key/value，不会被解引用 */
+
+/* 必须最先执行: 进程中第一次计算 hash 之后种子不能再修改 */
+static void test_seed (void)
+{
+    const cuint64 seed = 0x5eed5eed12345678ULL;
+
+    c_hash_set_seed (seed);
+    c_test_true (seed == c_hash_get_seed (), "seed: set before first use");
+
+    const char* str = "hash-seed-test";
+    c_test_true (c_str_hash (str) == (cuint) c_hash_wy (str, strlen (str), seed), "seed: c_str_hash uses the seed");
+
+    c_hash_set_seed (seed + 1);
+    c_hash_set_random_seed ();
+    c_test_true (seed == c_hash_get_seed () && c_str_hash (str) == (cuint) c_hash_wy (str, strlen (str), seed),
+                 "seed: change rejected after use");
+}
+
+/* 相同的字节序列无论通过哪个接口计算，hash 值都相同 */
+static void test_hash_agree (void)
+{
+    cuint i;
+    cuint bad = 0;
+    char buf[64];
+
+    for (i = 0; i < 1000; ++i) {
+        const csize len = (csize) snprintf (buf, sizeof (buf), "%0*u", (int) (i % 40) + 1, i);
+        CBytes* bytes = c_bytes_new_static (buf, len);
+        const cuint h = c_str_hash (buf);
+        bad += (h != c_str_hash_len (buf, len) || h != c_data_hash (buf, len) || h != c_bytes_hash (bytes));
+        c_bytes_unref (bytes);
+    }
+    c_test_true (0 == bad, "c_str_hash, c_str_hash_len, c_data_hash and c_bytes_hash agree");
+}
+
+static void count_func (C_UNUSED void* key, void* value, void* udata)
+{
+    cuint64* sum = udata;
+    sum[0]++;
+    sum[1] += (cuint64) (cuintptr) value;
+}
+
+static bool remove_odd (void* key, C_UNUSED void* value, C_UNUSED void* udata)
+{
+    return C_POINTER_TO_UINT (key) & 1;
+}
+
+static void test_int_table (bool flat, bool incremental)
+{
+    cuint i;
+    cuint bad = 0;
+    cuint64 sum[2] = {0, 0};
+    const char* type = flat ? (incremental ? "flat+incr" : "flat") : (incremental ? "classic+incr" : "classic");
+
+    CHashTable* table = flat ? c_hash_table_new_flat (c_direct_hash, c_direct_equal) : c_hash_table_new (c_direct_hash, c_direct_equal);
+    c_hash_table_set_incremental_resize (table, incremental);
+
+    // 4 字节槽位下插入，经过多次扩容
+    for (i = 1; i <= N_NODES; ++i) {
+        c_hash_table_insert (table, C_UINT_TO_POINTER (i), C_UINT_TO_POINTER (i * 2));
+    }
+    c_test_true (c_hash_table_size (table) == N_NODES, "%s: size after insert %u", type, c_hash_table_size (table));
+
+    for (i = 1; i <= N_NODES; ++i) {
+        bad += (C_POINTER_TO_UINT (c_hash_table_lookup (table, C_UINT_TO_POINTER (i))) != i * 2);
+    }
+    bad += c_hash_table_contains (table, C_UINT_TO_POINTER (N_NODES + 1));
+    c_test_true (0 == bad, "%s: lookup small entries", type);
+
+    c_hash_table_foreach (table, count_func, sum);
+    c_test_true (sum[0] == N_NODES && sum[1] == (cuint64) N_NODES * (N_NODES + 1), "%s: foreach small entries", type);
+
+    // 存入高位非 0 的 value，values 扩展为 8 字节，已有元素保持不变
+    c_hash_table_insert (table, C_UINT_TO_POINTER (N_NODES + 1), (void*) (BIG_BASE + 1));
+    for (i = 1, bad = 0; i <= N_NODES; ++i) {
+        bad += (C_POINTER_TO_UINT (c_hash_table_lookup (table, C_UINT_TO_POINTER (i))) != i * 2);
+    }
+    bad += (c_hash_table_lookup (table, C_UINT_TO_POINTER (N_NODES + 1)) != (void*) (BIG_BASE + 1));
+    c_test_true (0 == bad, "%s: lookup after value upgrade", type);
+
+    // 存入高位非 0 的 key，keys 扩展为 8 字节
+    for (i = 0; i < 1000; ++i) {
+        c_hash_table_insert (table, (void*) (BIG_BASE + i), (void*) (BIG_BASE + i));
+    }
+    for (i = 1, bad = 0; i <= N_NODES; ++i) {
+        bad += (C_POINTER_TO_UINT (c_hash_table_lookup (table, C_UINT_TO_POINTER (i))) != i * 2);
+    }
+    for (i = 0; i < 1000; ++i) {
+        bad += (c_hash_table_lookup (table, (void*) (BIG_BASE + i)) != (void*) (BIG_BASE + i));
+    }
+    c_test_true (0 == bad && c_hash_table_size (table) == N_NODES + 1001, "%s: lookup after key upgrade", type);
+
+    // 迭代器遍历全部元素
+    void* key = NULL;
+    void* value = NULL;
+    CHashTableIter iter;
+    cuint n = 0;
+    c_hash_table_iter_init (&iter, table);
+    for (bad = 0; c_hash_table_iter_next (&iter, &key, &value); ++n) {
+        const cuintptr k = (cuintptr) key;
+        if (k == N_NODES + 1) {
+            bad += ((cuintptr) value != BIG_BASE + 1);
+        }
+        else {
+            bad += (k >= BIG_BASE) ? ((cuintptr) value != k) : ((cuintptr) value != k * 2);
+        }
+    }
+    c_test_true (0 == bad && n == N_NODES + 1001, "%s: iterate %u entries", type, n);
+
+    // 删除一半后收缩
+    c_test_true (c_hash_table_foreach_remove (table, remove_odd, NULL) == N_NODES / 2 + 501, "%s: foreach_remove", type);
+    for (i = 1, bad = 0; i <= N_NODES; ++i) {
+        bad += (c_hash_table_contains (table, C_UINT_TO_POINTER (i)) != !(i & 1));
+    }
+    c_test_true (0 == bad, "%s: lookup after shrink", type);
+
+    c_hash_table_remove_all (table);
+    c_test_true (0 == c_hash_table_size (table), "%s: remove_all", type);
+
+    // 清空后重新从 4 字节槽位开始
+    for (i = 1; i <= 1000; ++i) {
+        c_hash_table_insert (table, C_UINT_TO_POINTER (i), C_UINT_TO_POINTER (i));
+    }
+    for (i = 1, bad = 0; i <= 1000; ++i) {
+        bad += (C_POINTER_TO_UINT (c_hash_table_lookup (table, C_UINT_TO_POINTER (i))) != i);
+    }
+    c_test_true (0 == bad, "%s: reuse after remove_all", type);
+
+    c_hash_table_unref (table);
+}
+
+static void test_stats (bool flat, bool incremental)
+{
+    cuint i;
+    cuint bad = 0;
+    cuint histogram = 0;
+    CHashTableStats stats;
+    const char* type = flat ? (incremental ? "flat+incr" : "flat") : (incremental ? "classic+incr" : "classic");
+
+    CHashTable* table = flat ? c_hash_table_new_flat (c_direct_hash, c_direct_equal) : c_hash_table_new (c_direct_hash, c_direct_equal);
+    c_hash_table_set_incremental_resize (table, incremental);
+    for (i = 1; i <= N_NODES; ++i) {
+        c_hash_table_insert (table, C_UINT_TO_POINTER (i), C_UINT_TO_POINTER (i));
+    }
+    for (i = 1; i <= N_NODES; i += 3) {
+        c_hash_table_remove (table, C_UINT_TO_POINTER (i));
+    }
+
+    c_hash_table_get_stats (table, &stats);
+    for (i = 0; i < C_HASH_TABLE_PROBE_HISTOGRAM_SIZE; ++i) {
+        histogram += stats.probeHistogram[i];
+    }
+    c_test_true (stats.nnodes == c_hash_table_size (table) && histogram == stats.nnodes && stats.resizeCount > 0
+                 && stats.avgProbeLength <= stats.maxProbeLength && stats.loadFactor > 0 && stats.loadFactor < 1,
+                 "%s: stats (load %.2f, avg probe %.2f, max probe %u)", type, stats.loadFactor, stats.avgProbeLength, stats.maxProbeLength);
+    c_test_true (stats.ntombstones > 0 && stats.tombstoneRatio > 0, "%s: %u tombstones after remove", type, stats.ntombstones);
+
+    const cuint size = stats.size;
+    c_hash_table_purge_tombstones (table);
+    c_hash_table_get_stats (table, &stats);
+    c_test_true (0 == stats.ntombstones && stats.size == size, "%s: purge tombstones in place", type);
+
+    for (i = 1; i <= N_NODES; ++i) {
+        void* value = c_hash_table_lookup (table, C_UINT_TO_POINTER (i));
+        if ((i - 1) % 3 == 0 ? (value != NULL) : (value != C_UINT_TO_POINTER (i))) {
+            bad++;
+        }
+    }
+    c_test_true (0 == bad && c_hash_table_size (table) == N_NODES - (N_NODES + 2) / 3, "%s: lookup after purge", type);
+
+    c_hash_table_unref (table);
+}
+
+static void test_set (bool flat)
+{
+    cuint i;
+    cuint bad = 0;
+    const char* type = flat ? "flat" : "classic";
+
+    CHashTable* set = flat ? c_hash_table_new_flat (c_direct_hash, c_direct_equal) : c_hash_table_new (c_direct_hash, c_direct_equal);
+    for (i = 1; i <= N_NODES; ++i) {
+        c_hash_table_add (set, C_UINT_TO_POINTER (i));
+    }
+
+    // set 中插入高位非 0 的 key，keys 与 values 共用的数组一起扩展
+    c_hash_table_add (set, (void*) BIG_BASE);
+    for (i = 1; i <= N_NODES; ++i) {
+        bad += (c_hash_table_lookup (set, C_UINT_TO_POINTER (i)) != C_UINT_TO_POINTER (i));
+    }
+    bad += (c_hash_table_lookup (set, (void*) BIG_BASE) != (void*) BIG_BASE);
+    c_test_true (0 == bad, "%s: set after key upgrade", type);
+
+    // key 与 value 不同，set 转为 map
+    c_hash_table_insert (set, C_UINT_TO_POINTER (1), C_UINT_TO_POINTER (7));
+    for (i = 2, bad = 0; i <= N_NODES; ++i) {
+        bad += (c_hash_table_lookup (set, C_UINT_TO_POINTER (i)) != C_UINT_TO_POINTER (i));
+    }
+    bad += (c_hash_table_lookup (set, C_UINT_TO_POINTER (1)) != C_UINT_TO_POINTER (7));
+    c_test_true (0 == bad && c_hash_table_size (set) == N_NODES + 1, "%s: set converted to map", type);
+
+    c_hash_table_unref (set);
+}
+
+static void test_bulk (bool flat, bool incremental)
+{
+    cuint i;
+    cuint bad = 0;
+    const cuint n = N_NODES;
+    const char* type = flat ? (incremental ? "flat+incr" : "flat") : (incremental ? "classic+incr" : "classic");
+    void** keys = c_malloc0 (sizeof (void*) * n * 2);
+    void** values = c_malloc0 (sizeof (void*) * n * 2);
+    void** out = c_malloc0 (sizeof (void*) * n * 2);
+
+    for (i = 0; i < n * 2; ++i) {
+        keys[i] = C_UINT_TO_POINTER (i + 1);
+        values[i] = C_UINT_TO_POINTER ((i + 1) * 3);
+    }
+
+    CHashTable* table = flat ? c_hash_table_new_flat (c_direct_hash, c_direct_equal) : c_hash_table_new (c_direct_hash, c_direct_equal);
+    c_hash_table_set_incremental_resize (table, incremental);
+
+    c_hash_table_reserve (table, n);
+    c_test_true (c_hash_table_insert_many (table, keys, values, n) == n, "%s: insert_many", type);
+    // 与已有 key 重叠的一半只替换 value
+    c_test_true (c_hash_table_insert_many (table, keys + n / 2, values + n / 2, n) == n / 2, "%s: insert_many overlap", type);
+    c_test_true (c_hash_table_size (table) == n + n / 2, "%s: size after insert_many", type);
+
+    c_test_true (c_hash_table_lookup_many (table, keys, n * 2, out) == n + n / 2, "%s: lookup_many found", type);
+    for (i = 0; i < n * 2; ++i) {
+        bad += (out[i] != ((i < n + n / 2) ? values[i] : NULL));
+    }
+    c_test_true (0 == bad, "%s: lookup_many values", type);
+
+    // new_similar 继承预留，新表一开始就能容纳 n 个元素
+    CHashTableStats stats;
+    CHashTable* similar = c_hash_table_new_similar (table);
+    c_hash_table_get_stats (similar, &stats);
+    c_test_true (0 == stats.nnodes && stats.size >= n, "%s: new_similar keeps reserve", type);
+    c_hash_table_unref (similar);
+
+    // 预留之后删除元素不会收缩到预留值以下，取消预留后恢复
+    for (i = 0; i < n + n / 2; ++i) {
+        c_hash_table_remove (table, keys[i]);
+    }
+    c_hash_table_reserve (table, 0);
+    c_hash_table_insert_many (table, keys, NULL, 100);
+    for (i = 0, bad = 0; i < 100; ++i) {
+        bad += (c_hash_table_lookup (table, keys[i]) != keys[i]);
+    }
+    c_test_true (0 == bad && c_hash_table_size (table) == 100, "%s: insert_many as set", type);
+
+    c_hash_table_unref (table);
+    c_free (keys);
+    c_free (values);
+    c_free (out);
+}
+
+static bool keep_small (void* key, C_UNUSED void* value, C_UNUSED void* udata)
+{
+    return C_POINTER_TO_UINT (key) > 10;
+}
+
+static void test_incremental_shrink (bool flat)
+{
+    cuint i;
+    cuint bad = 0;
+    const char* type = flat ? "flat+incr" : "classic+incr";
+
+    CHashTable* table = flat ? c_hash_table_new_flat (c_direct_hash, c_direct_equal) : c_hash_table_new (c_direct_hash, c_direct_equal);
+    c_hash_table_set_incremental_resize (table, true);
+
+    for (i = 1; i <= 2 * N_NODES; ++i) {
+        c_hash_table_insert (table, C_UINT_TO_POINTER (i), C_UINT_TO_POINTER (i));
+    }
+    // 只剩 10 个元素后收缩，再插入足以装满小表的元素
+    c_hash_table_foreach_remove (table, keep_small, NULL);
+    for (i = 1; i <= N_NODES; ++i) {
+        c_hash_table_insert (table, C_UINT_TO_POINTER (4 * N_NODES + i), C_UINT_TO_POINTER (i));
+    }
+    for (i = 1; i <= 10; ++i) {
+        bad += (c_hash_table_lookup (table, C_UINT_TO_POINTER (i)) != C_UINT_TO_POINTER (i));
+    }
+    for (i = 1; i <= N_NODES; ++i) {
+        bad += (c_hash_table_lookup (table, C_UINT_TO_POINTER (4 * N_NODES + i)) != C_UINT_TO_POINTER (i));
+    }
+    c_test_true (0 == bad && c_hash_table_size (table) == N_NODES + 10, "%s: insert after shrink", type);
+
+    c_hash_table_unref (table);
+}
+
+static cuint identity_hash (const void* key)
+{
+    return C_POINTER_TO_UINT (key);
+}
+
+/* 选出 n 个在 flat 表中从 pos 开始探测的 hash 值，key 与 hash 相同 */
+static void colliding_keys (cuint mask, cuint pos, cuint n, cuint* keys)
+{
+    cuint h;
+    cuint i = 0;
+
+    for (h = 2; i < n; ++h) {
+        if ((C_HASH_MAP_H1 (h) & mask) == pos) {
+            keys[i++] = h;
+        }
+    }
+}
+
+/* 预留足够的容量，之后的插入删除既不扩容也不收缩 */
+static CHashTable* flat_table_new (cuint* mask)
+{
+    CHashTableStats stats;
+    CHashTable* table = c_hash_table_new_flat (identity_hash, c_direct_equal);
+
+    c_hash_table_reserve (table, 100);
+    c_hash_table_get_stats (table, &stats);
+    *mask = stats.size - 1;
+
+    return table;
+}
+
+static void flat_insert (CHashTable* table, const cuint* keys, cuint n)
+{
+    cuint i;
+
+    for (i = 0; i < n; ++i) {
+        c_hash_table_insert (table, C_UINT_TO_POINTER (keys[i]), C_UINT_TO_POINTER (keys[i]));
+    }
+}
+
+/* keys 中查不到或值不对的个数 */
+static cuint flat_missing (CHashTable* table, const cuint* keys, cuint n)
+{
+    cuint i;
+    cuint bad = 0;
+
+    for (i = 0; i < n; ++i) {
+        bad += (c_hash_table_lookup (table, C_UINT_TO_POINTER (keys[i])) != C_UINT_TO_POINTER (keys[i]));
+    }
+
+    return bad;
+}
+
+static void test_flat_mirror (void)
+{
+    cuint mask;
+    cuint keys[N_COLLIDE + 1];
+
+    // 从最后一个槽位开始探测，第一组读取末尾复制的控制位，之后的元素落在下标 0..15
+    CHashTable* table = flat_table_new (&mask);
+    colliding_keys (mask, mask, N_COLLIDE + 1, keys);
+    flat_insert (table, keys, N_COLLIDE);
+    c_test_true (0 == flat_missing (table, keys, N_COLLIDE), "flat: probe group wraps through mirrored control bytes");
+
+    // 删除下标 0 的元素再插入新元素，开头的控制位与末尾副本必须一起修改
+    c_hash_table_remove (table, C_UINT_TO_POINTER (keys[1]));
+    flat_insert (table, keys + N_COLLIDE, 1);
+    c_test_true (!c_hash_table_contains (table, C_UINT_TO_POINTER (keys[1])) && 0 == flat_missing (table, keys + 2, N_COLLIDE - 1)
+                 && 0 == flat_missing (table, keys, 1), "flat: remove and insert below index 16");
+
+    c_hash_table_unref (table);
+}
+
+static void test_flat_tombstone (void)
+{
+    cuint mask;
+    cuint keys[N_COLLIDE + 1];
+    CHashTableStats stats;
+
+    CHashTable* table = flat_table_new (&mask);
+    colliding_keys (mask, 5, N_COLLIDE + 1, keys);
+    flat_insert (table, keys, 8);
+    c_hash_table_remove (table, C_UINT_TO_POINTER (keys[3]));
+    c_hash_table_get_stats (table, &stats);
+    const cuint size = stats.size;
+    const cuint tombstones = stats.ntombstones;
+
+    // 同一探测序列上的新元素放进墓碑，而不是占用新的空槽位
+    flat_insert (table, keys + N_COLLIDE, 1);
+    c_hash_table_get_stats (table, &stats);
+    c_test_true (1 == tombstones && 0 == stats.ntombstones && size == stats.size && 8 == c_hash_table_size (table)
+                 && 0 == flat_missing (table, keys + N_COLLIDE, 1) && 0 == flat_missing (table, keys + 4, 4),
+                 "flat: insert reuses tombstone after remove");
+
+    c_hash_table_unref (table);
+}
+
+static void test_flat_deleted_in_full_group (void)
+{
+    cuint i;
+    cuint mask;
+    cuint keys[N_COLLIDE + 1];
+
+    // 第一组全部占满，其余元素在下一组；删除第一组的部分元素后它们变成墓碑而不是空槽位，查找必须继续探测
+    CHashTable* table = flat_table_new (&mask);
+    colliding_keys (mask, 32, N_COLLIDE + 1, keys);
+    flat_insert (table, keys, N_COLLIDE);
+    for (i = 0; i < C_HASH_MAP_GROUP_WIDTH; i += 2) {
+        c_hash_table_remove (table, C_UINT_TO_POINTER (keys[i]));
+    }
+    c_test_true (0 == flat_missing (table, keys + C_HASH_MAP_GROUP_WIDTH, N_COLLIDE - C_HASH_MAP_GROUP_WIDTH)
+                 && !c_hash_table_contains (table, C_UINT_TO_POINTER (keys[N_COLLIDE])) && !c_hash_table_contains (table, C_UINT_TO_POINTER (keys[0])),
+                 "flat: lookup continues past deleted slots in a full group");
+
+    c_hash_table_unref (table);
+}
+
+static void test_str_table (void)
+{
+    cuint i;
+    cuint bad = 0;
+    char buf[32];
+
+    // 普通指针 key/value 的表第一次插入就扩展为 8 字节槽位
+    CHashTable* table = c_hash_table_new_full (c_str_hash, c_str_equal, c_free0, c_free0);
+    for (i = 0; i < 10000; ++i) {
+        snprintf (buf, sizeof (buf), "key-%u", i);
+        c_hash_table_insert (table, c_strdup (buf), c_strdup_printf ("%u", i));
+    }
+    for (i = 0; i < 10000; ++i) {
+        snprintf (buf, sizeof (buf), "key-%u", i);
+        const char* value = c_hash_table_lookup (table, buf);
+        bad += (NULL == value || (cuint) atoi (value) != i);
+    }
+    c_test_true (0 == bad, "string table");
+    c_hash_table_unref (table);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    test_seed ();
+    test_hash_agree ();
+    test_int_table (false, false);
+    test_int_table (true, false);
+    test_int_table (false, true);
+    test_int_table (true, true);
+    test_bulk (false, false);
+    test_bulk (true, false);
+    test_bulk (false, true);
+    test_bulk (true, true);
+    test_stats (false, false);
+    test_stats (true, false);
+    test_stats (false, true);
+    test_stats (true, true);
+    test_set (false);
+    test_set (true);
+    test_incremental_shrink (false);
+    test_incremental_shrink (true);
+    test_flat_mirror ();
+    test_flat_tombstone ();
+    test_flat_deleted_in_full_group ();
+    test_str_table ();
+
+    return c_test_result ();
+}
@@ -0,0 +1,540 @@
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-12-16.
+//
+
+#include <c/clib.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "c/test.h"
+
+#define N_THREADS       4
+#define N_RECORDS       5000
+#define LOG_SIZE        (64 << 20)              /* 足够大，不触发切分 */
+
+typedef struct
+{
+    cuint           id;
+    cuint           n;
+} Producer;
+
+static char gsDir[128];
+static char gsPath[256];
+
+/* 删除测试目录中的文件后重新创建，返回 prefix 对应的日志文件路径 */
+static const char* log_reset (const char* prefix)
+{
+    DIR* d = NULL;
+    struct dirent* ent = NULL;
+    char path[512];
+
+    if (NULL != (d = opendir (gsDir))) {
+        while (NULL != (ent = readdir (d))) {
+            if ('.' != ent->d_name[0]) {
+                snprintf (path, sizeof (path), "%s/%s", gsDir, ent->d_name);
+                unlink (path);
+            }
+        }
+        closedir (d);
+        rmdir (gsDir);
+    }
+    c_mkdir_with_parents (gsDir, 0755);
+    snprintf (gsPath, sizeof (gsPath), "%s/%s.log", gsDir, prefix);
+
+    return gsPath;
+}
+
+/* 文件中包含 needle 的行数 */
+static cuint count_lines (const char* path, const char* needle)
+{
+    cuint n = 0;
+    csize len = 0;
+    char* buf = NULL;
+    char* line = NULL;
+    char* end = NULL;
+
+    if (!c_file_get_contents (path, &buf, &len, NULL)) {
+        return 0;
+    }
+    for (line = buf; line < buf + len; line = end + 1) {
+        if (NULL == (end = memchr (line, '\n', (csize) (buf + len - line)))) {
+            end = buf + len;
+        }
+        n += (NULL != c_strstr_len (line, end - line, needle));
+    }
+    c_free (buf);
+
+    return n;
+}
+
+/* 测试目录中以 prefix 开头的文件个数 */
+static cuint count_files (const char* prefix)
+{
+    cuint n = 0;
+    DIR* d = NULL;
+    struct dirent* ent = NULL;
+
+    if (NULL != (d = opendir (gsDir))) {
+        while (NULL != (ent = readdir (d))) {
+            n += (0 == strncmp (ent->d_name, prefix, strlen (prefix)));
+        }
+        closedir (d);
+    }
+
+    return n;
+}
+
+static cint64 file_size (const char* path)
+{
+    struct stat buf;
+
+    return (0 == stat (path, &buf)) ? (cint64) buf.st_size : -1;
+}
+
+static void* log_producer (void* data)
+{
+    cuint i;
+    const Producer* p = data;
+
+    for (i = 0; i < p->n; ++i) {
+        C_LOG_INFO ("record %u-%u", p->id, i);
+    }
+
+    return NULL;
+}
+
+static void run_producers (cuint nThreads, cuint n)
+{
+    cuint i;
+    CThread* threads[N_THREADS];
+    Producer ps[N_THREADS];
+
+    for (i = 0; i < nThreads; ++i) {
+        ps[i] = (Producer) { .id = i, .n = n };
+        threads[i] = c_thread_new ("producer", log_producer, &ps[i]);
+    }
+    for (i = 0; i < nThreads; ++i) {
+        c_thread_join (threads[i]);
+    }
+}
+
+static void test_async (CLogAsyncPolicy policy)
+{
+    const char* name = (C_LOG_ASYNC_DROP == policy) ? "drop" : "block";
+    const char* path = log_reset ("async");
+
+    // 队列很小，生产者一定会追上写线程
+    c_log_init_async (C_LOG_LEVEL_DEBUG, LOG_SIZE, gsDir, "async", "log", false, 8, policy);
+    run_producers (N_THREADS, N_RECORDS);
+    c_log_destroy ();
+
+    const cuint written = count_lines (path, "record ");
+    const cuint64 dropped = c_log_async_dropped ();
+    if (C_LOG_ASYNC_DROP == policy) {
+        c_test_true (written + dropped == N_THREADS * N_RECORDS, "async %s: written %u + dropped %llu", name, written, (unsigned long long) dropped);
+    }
+    else {
+        c_test_true (written == N_THREADS * N_RECORDS && 0 == dropped, "async %s: written %u, dropped %llu", name, written, (unsigned long long) dropped);
+    }
+}
+
+static void test_rotate_numbered (void)
+{
+    cuint i;
+    cuint bad = 0;
+    char path[512];
+
+    log_reset ("num");
+    c_log_set_rotate (C_LOG_ROTATE_NUMBERED, 3, false);
+    c_log_init (C_LOG_LEVEL_DEBUG, 4096, gsDir, "num", "log", false);
+    run_producers (1, 2000);
+    c_log_destroy ();
+
+    // 只保留 3 个备份，每个备份写满 logSize 才切分
+    for (i = 1; i <= 3; ++i) {
+        snprintf (path, sizeof (path), "%s/num.log.%u", gsDir, i);
+        bad += (file_size (path) < 4096);
+    }
+    snprintf (path, sizeof (path), "%s/num.log.4", gsDir);
+    c_test_true (0 == bad && -1 == file_size (path) && 4 == count_files ("num.log"), "rotate numbered: keeps 3 backups");
+}
+
+static void test_rotate_timestamp (void)
+{
+    char path[512];
+
+    log_reset ("ts");
+    snprintf (path, sizeof (path), "%s/ts.log.conf", gsDir);
+    c_file_set_contents (path, "keep", 4, NULL);
+    snprintf (path, sizeof (path), "%s/ts.log.20000101-000000.gz", gsDir);
+    c_file_set_contents (path, "old", 3, NULL);
+
+    c_log_set_rotate (C_LOG_ROTATE_TIMESTAMP, 2, false);
+    c_log_init (C_LOG_LEVEL_DEBUG, 4096, gsDir, "ts", "log", false);
+    run_producers (1, 2000);
+    c_log_destroy ();
+
+    // 最旧的时间戳备份被删除，其它 ts.log.* 文件不受影响
+    c_test_true (2 == count_files ("ts.log.2") && -1 == file_size (path), "rotate timestamp: keeps 2 newest backups");
+    snprintf (path, sizeof (path), "%s/ts.log.conf", gsDir);
+    c_test_true (4 == file_size (path), "rotate timestamp: unrelated file kept");
+}
+
+static void test_rotate_truncated (void)
+{
+    char path[512];
+    const char* logPath = log_reset ("trunc");
+
+    // 文件被外部截断后，内存中的计数偏大也不能切分
+    c_log_set_rotate (C_LOG_ROTATE_NUMBERED, 3, false);
+    c_log_init (C_LOG_LEVEL_DEBUG, 8192, gsDir, "trunc", "log", false);
+    run_producers (1, 60);
+    truncate (logPath, 0);
+    run_producers (1, 60);
+    c_log_destroy ();
+
+    snprintf (path, sizeof (path), "%s/trunc.log.1", gsDir);
+    c_test_true (-1 == file_size (path) && 60 == count_lines (logPath, "record "), "rotate: external truncation does not rotate");
+}
+
+/* 文件中第一个包含 needle 的行，复制到 line */
+static bool find_line (const char* path, const char* needle, char* line, csize size)
+{
+    csize len = 0;
+    char* buf = NULL;
+
+    if (!c_file_get_contents (path, &buf, &len, NULL)) {
+        return false;
+    }
+    char* hit = c_strstr_len (buf, (cint64) len, needle);
+    if (NULL != hit) {
+        char* start = hit;
+        char* end = strchr (hit, '\n');
+        while (start > buf && '\n' != start[-1]) {
+            --start;
+        }
+        snprintf (line, size, "%.*s", (int) ((NULL != end ? end : buf + len) - start), start);
+    }
+    c_free (buf);
+
+    return NULL != hit;
+}
+
+static void test_text_prefix (void)
+{
+    int ms = 0;
+    pid_t pid = 0;
+    char line[512];
+    char expect[256];
+    struct tm tm = {0};
+    const char* path = log_reset ("text");
+
+    c_log_init (C_LOG_LEVEL_DEBUG, LOG_SIZE, gsDir, "text", "log", false);
+    c_log_print (C_LOG_LEVEL_INFO, "tag3", "src/dir/file.c", 42, "func", "hello %d", 7);
+
+    // fork 之后子进程的日志使用子进程自己的 pid
+    if (0 == (pid = fork ())) {
+        c_log_print (C_LOG_LEVEL_WARNING, "tag3", "child.c", 1, "child", "from child");
+        _exit (0);
+    }
+    waitpid (pid, NULL, 0);
+    c_log_destroy ();
+
+    snprintf (expect, sizeof (expect), "] [tag3] [INFO] [pid:%d file.c:42: func] hello 7", (int) getpid ());
+    const bool found = find_line (path, "hello 7", line, sizeof (line));
+    const int n = sscanf (line, "[%4d-%2d-%2d %2d:%2d:%2d.%3d]", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &ms);
+    c_test_true (found && 7 == n && NULL != strstr (line, expect), "text prefix: %s", line);
+
+    snprintf (expect, sizeof (expect), "[WARN] [pid:%d child.c:1: child] from child", (int) pid);
+    c_test_true (find_line (path, "from child", line, sizeof (line)) && NULL != strstr (line, expect), "text prefix after fork: %s", line);
+}
+
+static void test_binary_decode (void)
+{
+    char line[512];
+    char out[256];
+    const char* path = log_reset ("bin");
+
+    c_log_set_format (C_LOG_FORMAT_BINARY);
+    c_log_init (C_LOG_LEVEL_DEBUG, LOG_SIZE, gsDir, "bin", "log", false);
+    // 同一调用点输出两次，第二次只记录调用点 id 与参数
+    for (int i = 0; i < 2; ++i) {
+        C_LOG_INFO ("site %d s=%s d=%d ld=%ld f=%f w=[%-6s|%5.2f]", i, "str", -5, 1234567890123L, 3.25, "ab", 2.5);
+    }
+    c_log_print (C_LOG_LEVEL_WARNING, "tag4", "bin.c", 7, "func", "print %u %c", 42U, 'x');
+    c_log_write_fields (C_LOG_LEVEL_ERROR, "tag4", "bin.c", 8, "func", "fields", -1);
+    c_log_raw (C_LOG_LEVEL_INFO, "raw %s", "line");
+    c_log_destroy ();
+    c_log_set_format (C_LOG_FORMAT_TEXT);
+
+    snprintf (out, sizeof (out), "%s/bin.txt", gsDir);
+    const int fd = open (out, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    const bool decoded = c_log_decode (path, fd);
+    close (fd);
+    c_test_true (decoded && 1 == count_lines (out, "site 0 s=str d=-5 ld=1234567890123 f=3.250000 w=[ab    | 2.50]")
+        && 1 == count_lines (out, "site 1 s=str"), "binary decode: C_LOG_* arguments");
+    c_test_true (find_line (out, "print 42 x", line, sizeof (line)) && NULL != strstr (line, "[tag4] [WARN] [pid:")
+        && NULL != strstr (line, "bin.c:7: func] print 42 x"), "binary decode: c_log_print %s", line);
+    c_test_true (1 == count_lines (out, "[ERROR]") && 1 == count_lines (out, "] fields")
+        && find_line (out, "raw line", line, sizeof (line)) && 0 == strcmp (line, "raw line"), "binary decode: write_fields and raw");
+
+    // 文本文件不是二进制日志
+    c_test_true (!c_log_decode (out, STDERR_FILENO), "binary decode: rejects text file");
+}
+
+static void log_site (cuint i)
+{
+    C_LOG_INFO ("site-info %u", i);
+}
+
+static void test_tag_level (void)
+{
+    const char* path = log_reset ("tag");
+
+    c_log_init (C_LOG_LEVEL_INFO, LOG_SIZE, gsDir, "tag", "log", false);
+    c_test_true (C_LOG_LEVEL_INFO == c_log_get_level_max (), "tag level: max is global level");
+
+    c_log_set_tag_level ("quiet", C_LOG_LEVEL_ERROR);
+    c_log_set_tag_level ("loud", C_LOG_LEVEL_VERB);
+    c_test_true (C_LOG_LEVEL_VERB == c_log_get_level_max (), "tag level: max follows loudest tag");
+
+    c_log_print (C_LOG_LEVEL_INFO, "quiet", "tag.c", 1, "f", "quiet-info");
+    c_log_print (C_LOG_LEVEL_ERROR, "quiet", "tag.c", 2, "f", "quiet-error");
+    c_log_print (C_LOG_LEVEL_VERB, "loud", "tag.c", 3, "f", "loud-verb");
+    c_log_print (C_LOG_LEVEL_DEBUG, "other", "tag.c", 4, "f", "other-debug");
+    c_log_print (C_LOG_LEVEL_INFO, "other", "tag.c", 5, "f", "other-info");
+
+    // 调用点缓存了 tag，之后修改该 tag 的级别仍然生效
+    log_site (0);
+    c_log_set_tag_level (C_LOG_TAG, C_LOG_LEVEL_WARNING);
+    log_site (1);
+    c_log_unset_tag_level (C_LOG_TAG);
+    log_site (2);
+
+    c_log_unset_tag_level ("quiet");
+    c_log_unset_tag_level ("loud");
+    c_log_print (C_LOG_LEVEL_INFO, "quiet", "tag.c", 6, "f", "quiet-unset");
+    c_log_print (C_LOG_LEVEL_VERB, "loud", "tag.c", 7, "f", "loud-unset");
+    c_log_destroy ();
+
+    c_test_true (0 == count_lines (path, "quiet-info") && 1 == count_lines (path, "quiet-error")
+        && 1 == count_lines (path, "loud-verb"), "tag level: per-tag level overrides global");
+    c_test_true (0 == count_lines (path, "other-debug") && 1 == count_lines (path, "other-info"), "tag level: other tags use global level");
+    c_test_true (1 == count_lines (path, "site-info 0") && 0 == count_lines (path, "site-info 1")
+        && 1 == count_lines (path, "site-info 2"), "tag level: C_LOG_* site follows tag changes");
+    c_test_true (1 == count_lines (path, "quiet-unset") && 0 == count_lines (path, "loud-unset"), "tag level: unset restores global level");
+}
+
+static void test_buffered (void)
+{
+    cuint i;
+    const char* path = log_reset ("buf");
+
+    // 刷新间隔很长，日志只能在线程退出和 c_log_destroy() 时写出
+    c_log_init_buffered (C_LOG_LEVEL_DEBUG, LOG_SIZE, gsDir, "buf", "log", false, 60000);
+    run_producers (N_THREADS, N_RECORDS);
+    const cuint afterExit = count_lines (path, "record ");
+
+    for (i = 0; i < 100; ++i) {
+        C_LOG_INFO ("main %u", i);
+    }
+    c_log_destroy ();
+
+    c_test_true (N_THREADS * N_RECORDS == afterExit, "buffered: thread exit flushes %u records", afterExit);
+    c_test_true (N_THREADS * N_RECORDS == count_lines (path, "record ") && 100 == count_lines (path, "main "), "buffered: destroy flushes the rest");
+}
+
+static void* log_endless_producer (void* data)
+{
+    cuint i;
+    const Producer* p = data;
+
+    for (i = 0; c_log_is_inited (); ++i) {
+        C_LOG_INFO ("endless %u-%u", p->id, i);
+    }
+
+    return NULL;
+}
+
+static void test_buffered_destroy (void)
+{
+    cuint i;
+    char other[256];
+    CThread* threads[N_THREADS];
+    Producer ps[N_THREADS];
+    const char* path = log_reset ("bufdestroy");
+
+    // 生产者仍在不持锁写文件时销毁日志，关闭 fd 前必须等它们写完
+    c_log_init_buffered (C_LOG_LEVEL_DEBUG, LOG_SIZE, gsDir, "bufdestroy", "log", false, 1);
+    for (i = 0; i < N_THREADS; ++i) {
+        ps[i] = (Producer) { .id = i, .n = 0 };
+        threads[i] = c_thread_new ("producer", log_endless_producer, &ps[i]);
+    }
+    while (count_lines (path, "endless ") < N_RECORDS) {
+        usleep (1000);
+    }
+    c_log_destroy ();
+
+    // fd 关闭后立即被复用，迟到的写入会落到这个文件里
+    snprintf (other, sizeof (other), "%s/reuse", gsDir);
+    const int fd = open (other, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    usleep (20000);
+    for (i = 0; i < N_THREADS; ++i) {
+        c_thread_join (threads[i]);
+    }
+    close (fd);
+
+    c_test_true (0 == file_size (other), "buffered destroy: no write after the log fd is closed");
+    unlink (other);
+}
+
+static void test_write_fields (void)
+{
+    char line[512];
+    const char msg[] = { 'f', 'i', 'e', 'l', 'd', 'X' };        /* 不以 '\0' 结尾 */
+    const char* path = log_reset ("fields");
+
+    c_log_init (C_LOG_LEVEL_INFO, LOG_SIZE, gsDir, "fields", "log", false);
+    c_log_write_fields (C_LOG_LEVEL_WARNING, "bridge", "/src/qt/widget.cpp", 12, "paint", msg, 5);
+    c_log_write_fields (C_LOG_LEVEL_INFO, "bridge", NULL, 0, NULL, "no %s site", -1);
+    c_log_write_fields (C_LOG_LEVEL_DEBUG, "bridge", NULL, 0, NULL, "filtered", -1);
+    c_log_destroy ();
+
+    c_test_true (find_line (path, "field", line, sizeof (line)) && NULL != strstr (line, "[bridge] [WARN] [pid:")
+        && NULL != strstr (line, " widget.cpp:12: paint] field") && NULL == strstr (line, "fieldX"), "write_fields: msgLen bounds the message: %s", line);
+    // 消息不经过 printf 格式化，没有文件名时省略位置信息
+    c_test_true (find_line (path, "no %s site", line, sizeof (line)) && NULL != strstr (line, "[INFO] [pid:")
+        && NULL == strstr (line, ".c:"), "write_fields: no location: %s", line);
+    c_test_true (0 == count_lines (path, "filtered"), "write_fields: level filtered");
+}
+
+/* 解码日志段并统计包含 needle 的行数 */
+static cuint count_decoded (const char* path, const char* needle)
+{
+    char out[256];
+
+    snprintf (out, sizeof (out), "%s/decoded.txt", gsDir);
+    const int fd = open (out, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    const bool ok = c_log_decode (path, fd);
+    close (fd);
+
+    return ok ? count_lines (out, needle) : 0;
+}
+
+static void test_mmap (void)
+{
+    cuint i;
+    cuint n = 0;
+    pid_t pid = 0;
+    char path[512];
+    const char* logPath = log_reset ("mmap");
+
+    c_log_init_mmap (C_LOG_LEVEL_DEBUG, LOG_SIZE, gsDir, "mmap", "log", false);
+    run_producers (N_THREADS, N_RECORDS);
+    c_log_destroy ();
+    c_test_true (N_THREADS * N_RECORDS == count_decoded (logPath, "record "), "mmap: no records lost");
+
+    // 段写满后切分，所有段合起来不丢日志
+    log_reset ("mmap");
+    c_log_set_rotate (C_LOG_ROTATE_NUMBERED, 100, false);
+    c_log_init_mmap (C_LOG_LEVEL_DEBUG, 64 << 10, gsDir, "mmap", "log", false);
+    run_producers (N_THREADS, N_RECORDS);
+    c_log_destroy ();
+    n = count_decoded (logPath, "record ");
+    for (i = 1; i <= 100; ++i) {
+        snprintf (path, sizeof (path), "%s/mmap.log.%u", gsDir, i);
+        n += count_decoded (path, "record ");
+    }
+    c_test_true (N_THREADS * N_RECORDS == n && count_files ("mmap.log.") > 1, "mmap: no records lost across segments (%u)", n);
+
+    // 进程没有调用 c_log_destroy() 就退出，已写入的日志仍然在文件中
+    log_reset ("mmap");
+    if (0 == (pid = fork ())) {
+        c_log_init_mmap (C_LOG_LEVEL_DEBUG, LOG_SIZE, gsDir, "mmap", "log", false);
+        run_producers (1, N_RECORDS);
+        _exit (0);
+    }
+    waitpid (pid, NULL, 0);
+    c_test_true (N_RECORDS == count_decoded (logPath, "record "), "mmap: records survive exit without destroy");
+}
+
+static void* log_sites_producer (void* data)
+{
+    cuint i;
+    const Producer* p = data;
+
+    // 前一半只用一个调用点把队列写满，之后再第一次使用其它调用点，此时写入它们的定义
+    for (i = 0; i < p->n; ++i) {
+        switch ((i < p->n / 2) ? 0 : i % 4) {
+            case 0: C_LOG_INFO ("site-a %u-%u", p->id, i); break;
+            case 1: C_LOG_INFO ("site-b %u-%u %s", p->id, i, "s"); break;
+            case 2: C_LOG_INFO ("site-c %u-%u %d", p->id, i, -1); break;
+            default: C_LOG_INFO ("site-d %u-%u %f", p->id, i, 0.5); break;
+        }
+    }
+
+    return NULL;
+}
+
+static void test_binary_async_drop (void)
+{
+    cuint i;
+    CThread* threads[N_THREADS];
+    Producer ps[N_THREADS];
+    const char* path = log_reset ("bindrop");
+
+    // 队列满时丢弃的日志不能包括调用点定义，否则之后该调用点的日志都无法解码
+    c_log_set_format (C_LOG_FORMAT_BINARY);
+    c_log_init_async (C_LOG_LEVEL_DEBUG, LOG_SIZE, gsDir, "bindrop", "log", false, 8, C_LOG_ASYNC_DROP);
+    for (i = 0; i < N_THREADS; ++i) {
+        ps[i] = (Producer) { .id = i, .n = N_RECORDS };
+        threads[i] = c_thread_new ("producer", log_sites_producer, &ps[i]);
+    }
+    for (i = 0; i < N_THREADS; ++i) {
+        c_thread_join (threads[i]);
+    }
+    c_log_destroy ();
+    c_log_set_format (C_LOG_FORMAT_TEXT);
+
+    const cuint64 dropped = c_log_async_dropped ();
+    const cuint written = count_decoded (path, "site-");
+    c_test_true (0 == count_decoded (path, "unknown log site") && written + dropped == N_THREADS * N_RECORDS,
+        "binary async drop: written %u + dropped %llu, all sites decode", written, (unsigned long long) dropped);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    snprintf (gsDir, sizeof (gsDir), "/tmp/test-c-log-%d", (int) getpid ());
+
+    test_async (C_LOG_ASYNC_DROP);
+    test_async (C_LOG_ASYNC_BLOCK);
+    test_rotate_numbered ();
+    test_rotate_timestamp ();
+    test_rotate_truncated ();
+    test_text_prefix ();
+    test_binary_decode ();
+    test_tag_level ();
+    test_buffered ();
+    test_buffered_destroy ();
+    test_write_fields ();
+    test_mmap ();
+    test_binary_async_drop ();
+
+    log_reset ("");
+    rmdir (gsDir);
+
+    return c_test_result ();
+}
@@ -0,0 +1,194 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-27.
+//
+
+#include <c/clib.h>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "c/test.h"
+
+#define N_THREADS       4
+#define N_STRINGS       20000
+
+static CQuark gsQuarks[N_THREADS][N_STRINGS];
+
+/* 每个线程以不同顺序插入同一组字符串，同时查找已有的字符串 */
+static void* intern_thread (void* data)
+{
+    cint i;
+    char buf[64];
+    const cint id = (cint) C_POINTER_TO_UINT (data);
+
+    for (i = 0; i < N_STRINGS; ++i) {
+        const cint k = (id & 1) ? N_STRINGS - 1 - i : i;
+        snprintf (buf, sizeof (buf), "test-quark-%d", k);
+        gsQuarks[id][k] = c_quark_from_string (buf);
+        if (c_quark_try_string ("test-quark-static") == 0) {
+            gsQuarks[id][k] = 0;
+        }
+    }
+
+    return NULL;
+}
+
+/* 与 c/quark.c 中快照文件头及 QuarkTable 的布局一致 */
+typedef struct
+{
+    char                magic[8];
+    cuint32             headerSize;
+    cuint32             tableHeaderSize;
+    cuint32             nquarks;
+    cuint32             tableSize;
+    cuint64             tableOffset;
+    cuint64             offsetsOffset;
+    cuint64             stringsOffset;
+    cuint64             stringsSize;
+} FileHeader;
+
+/* 子进程: 空槽全部被填上的快照必须拒绝，否则查找未知字符串会一直探测 */
+static int test_load_full_table (const char* filename)
+{
+    c_test_true (!c_quark_load (filename, NULL), "full quark table is rejected");
+    c_test_true (0 == c_quark_try_string ("test-quark-none"), "lookup after rejected load");
+
+    return c_test_result ();
+}
+
+/* 把快照的空槽全部填上已有的项，计数字段保持不变 */
+static char* make_full_table (const char* filename)
+{
+    cuint i;
+    char* contents = NULL;
+    csize length = 0;
+    char* corrupt = c_strdup_printf ("%s.full", filename);
+
+    c_file_get_contents (filename, &contents, &length, NULL);
+    const FileHeader* header = (const FileHeader*) contents;
+    cuint64* slots = (cuint64*) (contents + header->tableOffset + header->tableHeaderSize);
+    cuint64 fill = 0;
+    for (i = 0; i < header->tableSize; ++i) {
+        fill = (0 != slots[i]) ? slots[i] : fill;
+    }
+    for (i = 0; i < header->tableSize; ++i) {
+        slots[i] = (0 != slots[i]) ? slots[i] : fill;
+    }
+    c_file_set_contents (corrupt, contents, (cssize) length, NULL);
+    c_free (contents);
+
+    return corrupt;
+}
+
+/* 在新进程中执行本程序，返回是否正常退出且所有检查通过 */
+static bool run_self (const char* self, const char* filename, const char* arg)
+{
+    const pid_t pid = fork ();
+    if (0 == pid) {
+        execl (self, self, filename, arg, (char*) NULL);
+        _exit (127);
+    }
+    int status = -1;
+    waitpid (pid, &status, 0);
+
+    return WIFEXITED (status) && 0 == WEXITSTATUS (status);
+}
+
+/* 子进程: 最先加载快照，检查编号与字符串保持不变 */
+static int test_load (const char* filename, CQuark staticQuark)
+{
+    cint i;
+    cuint bad = 0;
+    char buf[64];
+    CError* error = NULL;
+
+    c_test_true (c_quark_load (filename, &error), "load quark file: %s", error ? error->message : "ok");
+    c_test_true (c_quark_try_string ("test-quark-static") == staticQuark, "quark id is stable across processes");
+
+    CQuark max = staticQuark;
+    for (i = 0; i < N_STRINGS; ++i) {
+        snprintf (buf, sizeof (buf), "test-quark-%d", i);
+        const CQuark q = c_quark_try_string (buf);
+        if (0 == q || 0 != strcmp (c_quark_to_string (q), buf) || c_intern_string (buf) != c_quark_to_string (q)) {
+            bad++;
+        }
+        max = C_MAX (max, q);
+    }
+    c_test_true (0 == bad, "preloaded strings round trip");
+
+    const CQuark q = c_quark_from_string ("test-quark-after-load");
+    c_test_true (q > max && c_quark_try_string ("test-quark-after-load") == q, "new quark after load");
+    c_test_true (!c_quark_load (filename, NULL), "second load is rejected");
+
+    return c_test_result ();
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    cint i, t;
+    cuint bad = 0;
+    char buf[64];
+    CThread* threads[N_THREADS];
+
+    if (argc == 3) {
+        return test_load (argv[1], (CQuark) atoi (argv[2]));
+    }
+    if (argc == 2) {
+        return test_load_full_table (argv[1]);
+    }
+
+    c_test_true (c_quark_try_string ("test-quark-none") == 0, "try_string on unknown string");
+
+    const CQuark q = c_quark_from_static_string ("test-quark-static");
+    c_test_true (q != 0 && c_quark_try_string ("test-quark-static") == q
+                 && 0 == strcmp (c_quark_to_string (q), "test-quark-static"), "static string round trip");
+    c_test_true (c_intern_string ("test-quark-static") == c_quark_to_string (q), "intern string returns the quark string");
+
+    for (t = 0; t < N_THREADS; ++t) {
+        threads[t] = c_thread_new ("quark", intern_thread, C_UINT_TO_POINTER (t));
+    }
+    for (t = 0; t < N_THREADS; ++t) {
+        c_thread_join (threads[t]);
+    }
+
+    for (i = 0; i < N_STRINGS; ++i) {
+        snprintf (buf, sizeof (buf), "test-quark-%d", i);
+        for (t = 0; t < N_THREADS; ++t) {
+            if (gsQuarks[t][i] == 0 || gsQuarks[t][i] != gsQuarks[0][i]) {
+                bad++;
+            }
+        }
+        if (c_quark_try_string (buf) != gsQuarks[0][i] || 0 != strcmp (c_quark_to_string (gsQuarks[0][i]), buf)) {
+            bad++;
+        }
+    }
+    c_test_true (0 == bad, "concurrent interning from %d threads", N_THREADS);
+
+    // 保存快照，由新进程加载
+    CError* error = NULL;
+    char* filename = c_strdup_printf ("/tmp/test-c-quark-%d.bin", (int) getpid ());
+    char* quarkArg = c_strdup_printf ("%u", q);
+    c_test_true (c_quark_save (filename, &error), "save quark file: %s", error ? error->message : "ok");
+
+    c_test_true (run_self (argv[0], filename, quarkArg), "load quark file in a new process");
+
+    char* corrupt = make_full_table (filename);
+    c_test_true (run_self (argv[0], corrupt, NULL), "reject full quark table in a new process");
+    unlink (corrupt);
+    c_free (corrupt);
+
+    unlink (filename);
+    c_free (filename);
+    c_free (quarkArg);
+
+    return c_test_result ();
+}
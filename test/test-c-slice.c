@@ -0,0 +1,145 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-11-29.
+//
+
+#include <c/clib.h>
+
+#include "c/test.h"
+
+#define N_BLOCKS        1000
+#define N_PRODUCERS     2
+#define N_ITEMS         200000
+
+typedef struct
+{
+    CMutex          mutex;
+    CQueue          queue;
+    cuint           done;
+} Pipeline;
+
+/* 不同大小的块互不重叠，alloc0 返回全 0 的内存 */
+static void test_sizes (void)
+{
+    csize size;
+    cuint i;
+    cuint bad = 0;
+    cuint8* blocks[N_BLOCKS];
+
+    for (size = 1; size <= 300; size += 7) {
+        for (i = 0; i < N_BLOCKS; ++i) {
+            blocks[i] = c_slice_alloc0 (size);
+            if (blocks[i][0] != 0 || blocks[i][size - 1] != 0) {
+                bad++;
+            }
+            memset (blocks[i], (int) (i & 0xFF), size);
+        }
+        for (i = 0; i < N_BLOCKS; ++i) {
+            if (blocks[i][0] != (cuint8) (i & 0xFF) || blocks[i][size - 1] != (cuint8) (i & 0xFF)) {
+                bad++;
+            }
+            c_slice_free1 (size, blocks[i]);
+        }
+    }
+    c_test_true (0 == bad, "blocks of size 1..300 do not overlap");
+
+    const char str[] = "slice copy";
+    char* copy = c_slice_copy (sizeof (str), str);
+    c_test_true (0 == strcmp (copy, str), "c_slice_copy");
+    c_slice_free1 (sizeof (str), copy);
+
+    CList* list = NULL;
+    for (i = 0; i < N_BLOCKS; ++i) {
+        list = c_list_prepend (list, C_UINT_TO_POINTER (i));
+    }
+    c_test_true (c_list_length (list) == N_BLOCKS, "list nodes from slices");
+    c_slice_free_chain (CList, list, next);
+}
+
+/* 节点在生产者线程中分配，在消费者线程中释放 */
+static void* producer (void* data)
+{
+    cuint i;
+    Pipeline* p = data;
+
+    for (i = 1; i <= N_ITEMS; ++i) {
+        c_mutex_lock (&p->mutex);
+        c_queue_push_tail (&p->queue, C_UINT_TO_POINTER (i));
+        c_mutex_unlock (&p->mutex);
+    }
+
+    c_mutex_lock (&p->mutex);
+    p->done++;
+    c_mutex_unlock (&p->mutex);
+
+    return NULL;
+}
+
+static void* consumer (void* data)
+{
+    Pipeline* p = data;
+    cuint64 sum = 0;
+
+    while (true) {
+        c_mutex_lock (&p->mutex);
+        const bool done = (N_PRODUCERS == p->done);
+        void* item = c_queue_pop_head (&p->queue);
+        c_mutex_unlock (&p->mutex);
+        if (item) {
+            sum += C_POINTER_TO_UINT (item);
+        }
+        else if (done) {
+            break;
+        }
+    }
+
+    return c_memdup (&sum, sizeof (sum));
+}
+
+static void test_threads (void)
+{
+    cuint i;
+    Pipeline p;
+    CThread* threads[N_PRODUCERS];
+
+    c_mutex_init (&p.mutex);
+    c_queue_init (&p.queue);
+    p.done = 0;
+
+    CThread* c = c_thread_new ("consumer", consumer, &p);
+    for (i = 0; i < N_PRODUCERS; ++i) {
+        threads[i] = c_thread_new ("producer", producer, &p);
+    }
+    for (i = 0; i < N_PRODUCERS; ++i) {
+        c_thread_join (threads[i]);
+    }
+    cuint64* sum = c_thread_join (c);
+
+    c_test_true (*sum == (cuint64) N_PRODUCERS * N_ITEMS * (N_ITEMS + 1) / 2 && c_queue_is_empty (&p.queue), "nodes freed by another thread");
+    c_free (sum);
+    c_mutex_clear (&p.mutex);
+
+    // 线程退出后留在仓库中的块可以继续使用
+    CQueue* queue = c_queue_new ();
+    for (i = 0; i < N_ITEMS; ++i) {
+        c_queue_push_head (queue, C_UINT_TO_POINTER (i));
+    }
+    c_test_true (c_queue_get_length (queue) == N_ITEMS, "reuse blocks of exited threads");
+    c_queue_free (queue);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    test_sizes ();
+    test_threads ();
+
+    return c_test_result ();
+}
@@ -0,0 +1,200 @@
+
+/*
+ * Copyright © 2024 <dingjing@live.cn>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the “Software”), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Created by dingjing on 24-12-2.
+//
+
+#include <c/clib.h>
+
+#include "c/test.h"
+
+#define N_SMALL         1000
+#define N_LARGE         100000
+
+typedef struct
+{
+    cuint32         key;
+    cuint32         seq;                // 原来的位置，用于检查稳定性
+    char            pad[40];
+} Record;
+
+typedef enum
+{
+    PATTERN_RANDOM,
+    PATTERN_FEW_KEYS,
+    PATTERN_SORTED,
+    PATTERN_REVERSE,
+    PATTERN_EQUAL,
+    PATTERN_ORGAN_PIPE,
+    PATTERN_NUM
+} Pattern;
+
+static const char* gsPatternNames[] = { "random", "few keys", "sorted", "reverse", "equal", "organ pipe" };
+
+static cint record_compare (void* a, void* b, C_UNUSED void* udata)
+{
+    const Record* x = a;
+    const Record* y = b;
+
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static cuint64 record_key (const void* data, C_UNUSED void* udata)
+{
+    return ((const Record*) data)->key;
+}
+
+static cuint64 record_seq (const void* data, C_UNUSED void* udata)
+{
+    return ((const Record*) data)->seq;
+}
+
+static cint uint32_compare (void* a, void* b, C_UNUSED void* udata)
+{
+    const cuint32 x = *(cuint32*) a;
+    const cuint32 y = *(cuint32*) b;
+
+    return (x > y) - (x < y);
+}
+
+static cint pointer_compare (void* a, void* b, C_UNUSED void* udata)
+{
+    const cuintptr x = (cuintptr) *(void**) a;
+    const cuintptr y = (cuintptr) *(void**) b;
+
+    return (x > y) - (x < y);
+}
+
+static void fill (Record* records, cuint n, Pattern pattern)
+{
+    cuint i;
+    cuint32 seed = 7;
+
+    memset (records, 0, n * sizeof (Record));
+    for (i = 0; i < n; ++i) {
+        seed = seed * 1103515245 + 12345;
+        switch (pattern) {
+            case PATTERN_RANDOM:        records[i].key = seed;                                  break;
+            case PATTERN_FEW_KEYS:      records[i].key = (seed >> 16) % 16;                     break;
+            case PATTERN_SORTED:        records[i].key = i;                                     break;
+            case PATTERN_REVERSE:       records[i].key = n - i;                                 break;
+            case PATTERN_EQUAL:         records[i].key = 42;                                    break;
+            default:                    records[i].key = (i < n / 2) ? i : n - i;               break;
+        }
+        records[i].seq = i;
+    }
+}
+
+static bool is_sorted (const Record* records, cuint n, bool stable)
+{
+    cuint i;
+
+    for (i = 1; i < n; ++i) {
+        if (records[i - 1].key > records[i].key) {
+            return false;
+        }
+        if (stable && records[i - 1].key == records[i].key && records[i - 1].seq > records[i].seq) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* 按 seq 排回原来的顺序后，检查每个元素都还在 */
+static bool is_permutation (Record* records, cuint n)
+{
+    cuint i;
+
+    c_radix_sort (records, (cint) n, sizeof (Record), record_seq, NULL);
+    for (i = 0; i < n; ++i) {
+        if (records[i].seq != i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void test_records (cuint n)
+{
+    Pattern pattern;
+    Record* expected = c_malloc0 (n * sizeof (Record));
+    Record* records = c_malloc0 (n * sizeof (Record));
+
+    for (pattern = 0; pattern < PATTERN_NUM; ++pattern) {
+        fill (expected, n, pattern);
+        c_qsort_with_data (expected, (cint) n, sizeof (Record), record_compare, NULL);
+        c_test_true (is_sorted (expected, n, true), "stable sort, %s, %u records", gsPatternNames[pattern], n);
+
+        fill (records, n, pattern);
+        c_qsort_parallel_with_data (records, (cint) n, sizeof (Record), record_compare, NULL);
+        c_test_true (0 == memcmp (records, expected, n * sizeof (Record)), "parallel sort, %s, %u records", gsPatternNames[pattern], n);
+
+        fill (records, n, pattern);
+        c_radix_sort (records, (cint) n, sizeof (Record), record_key, NULL);
+        c_test_true (0 == memcmp (records, expected, n * sizeof (Record)), "radix sort, %s, %u records", gsPatternNames[pattern], n);
+
+        fill (records, n, pattern);
+        c_qsort_unstable_with_data (records, (cint) n, sizeof (Record), record_compare, NULL);
+        c_test_true (is_sorted (records, n, false) && is_permutation (records, n), "unstable sort, %s, %u records", gsPatternNames[pattern], n);
+    }
+
+    c_free (records);
+    c_free (expected);
+}
+
+static void test_integers (void)
+{
+    cuint i;
+    cuint32 seed = 3;
+    CArray* expected = c_array_new (false, false, sizeof (cuint32));
+    CArray* array = c_array_new (false, false, sizeof (cuint32));
+    CPtrArray* ptrArray = c_ptr_array_new ();
+    CPtrArray* ptrExpected = c_ptr_array_new ();
+
+    for (i = 0; i < N_LARGE; ++i) {
+        seed = seed * 1103515245 + 12345;
+        c_array_append_val (expected, seed);
+        c_array_append_val (array, seed);
+        c_ptr_array_add (ptrArray, (void*) (cuintptr) ((cuint64) seed << 20 | i));
+        c_ptr_array_add (ptrExpected, ptrArray->pdata[i]);
+    }
+
+    c_array_sort_with_data (expected, uint32_compare, NULL);
+    c_array_sort_by_key (array, NULL, NULL);
+    c_test_true (0 == memcmp (array->data, expected->data, N_LARGE * sizeof (cuint32)), "radix sort of cuint32 keys");
+
+    c_ptr_array_sort_with_data (ptrExpected, pointer_compare, NULL);
+    c_ptr_array_sort_by_key (ptrArray, NULL, NULL);
+    c_test_true (0 == memcmp (ptrArray->pdata, ptrExpected->pdata, N_LARGE * sizeof (void*)), "radix sort of pointers");
+
+    c_ptr_array_sort_unstable_with_data (ptrArray, pointer_compare, NULL);
+    c_test_true (0 == memcmp (ptrArray->pdata, ptrExpected->pdata, N_LARGE * sizeof (void*)), "unstable sort of pointers");
+
+    c_array_sort_parallel_with_data (array, uint32_compare, NULL);
+    c_test_true (0 == memcmp (array->data, expected->data, N_LARGE * sizeof (cuint32)), "parallel sort of sorted array");
+
+    c_test_true (c_get_num_processors () >= 1, "c_get_num_processors: %u", c_get_num_processors ());
+
+    c_ptr_array_unref (ptrExpected);
+    c_ptr_array_unref (ptrArray);
+    c_array_unref (array);
+    c_array_unref (expected);
+}
+
+int main (C_UNUSED int argc, C_UNUSED char* argv[])
+{
+    test_records (N_SMALL);
+    test_records (N_LARGE);
+    test_integers ();
+
+    return c_test_result ();
+}